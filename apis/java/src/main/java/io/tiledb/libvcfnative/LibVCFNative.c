@@ -351,6 +351,87 @@ Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1buffer_1valid
   return rc;
 }
 
+JNIEXPORT jint JNICALL
+Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1dictionary_1encoding(
+    JNIEnv* env,
+    jclass self,
+    jlong readerPtr,
+    jstring attribute,
+    jboolean dictionary) {
+  (void)self;
+  tiledb_vcf_reader_t* reader = (tiledb_vcf_reader_t*)readerPtr;
+  if (reader == 0) {
+    return TILEDB_VCF_ERR;
+  }
+
+  const char* c_attribute = (*env)->GetStringUTFChars(env, attribute, 0);
+  if (c_attribute == NULL) {
+    return TILEDB_VCF_ERR;
+  }
+
+  int rc = tiledb_vcf_reader_set_dictionary_encoding(
+      reader, c_attribute, dictionary ? 1 : 0);
+  (*env)->ReleaseStringUTFChars(env, attribute, c_attribute);
+
+  return rc;
+}
+
+JNIEXPORT jint JNICALL
+Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1buffer_1dictionary_1values(
+    JNIEnv* env,
+    jclass self,
+    jlong readerPtr,
+    jstring attribute,
+    jobject buffer) {
+  (void)self;
+  tiledb_vcf_reader_t* reader = (tiledb_vcf_reader_t*)readerPtr;
+  if (reader == 0) {
+    return TILEDB_VCF_ERR;
+  }
+
+  jlong buffer_size = (*env)->GetDirectBufferCapacity(env, buffer);
+  if (buffer_size == -1) {
+    return -1;
+  }
+  int64_t c_buffer_size = (int64_t)buffer_size;
+  char* c_buffer = (char*)(*env)->GetDirectBufferAddress(env, buffer);
+
+  const char* c_attribute = (*env)->GetStringUTFChars(env, attribute, 0);
+  int rc = tiledb_vcf_reader_set_buffer_dictionary_values(
+      reader, c_attribute, c_buffer_size, c_buffer);
+  (*env)->ReleaseStringUTFChars(env, attribute, c_attribute);
+
+  return rc;
+}
+
+JNIEXPORT jint JNICALL
+Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1buffer_1dictionary_1offsets(
+    JNIEnv* env,
+    jclass self,
+    jlong readerPtr,
+    jstring attribute,
+    jobject buffer) {
+  (void)self;
+  tiledb_vcf_reader_t* reader = (tiledb_vcf_reader_t*)readerPtr;
+  if (reader == 0) {
+    return TILEDB_VCF_ERR;
+  }
+
+  jlong buffer_size = (*env)->GetDirectBufferCapacity(env, buffer);
+  if (buffer_size == -1) {
+    return -1;
+  }
+  int64_t c_buffer_size = (int64_t)buffer_size;
+  int32_t* c_buffer = (int32_t*)(*env)->GetDirectBufferAddress(env, buffer);
+
+  const char* c_attribute = (*env)->GetStringUTFChars(env, attribute, 0);
+  int rc = tiledb_vcf_reader_set_buffer_dictionary_offsets(
+      reader, c_attribute, c_buffer_size, c_buffer);
+  (*env)->ReleaseStringUTFChars(env, attribute, c_attribute);
+
+  return rc;
+}
+
 JNIEXPORT jint JNICALL
 Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1memory_1budget(
     JNIEnv* env, jclass self, jlong readerPtr, jint memoryBudget) {
@@ -375,6 +456,18 @@ Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1max_1num_1rec
   return tiledb_vcf_reader_set_max_num_records(reader, maxNumRecords);
 }
 
+JNIEXPORT jint JNICALL
+Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1batch_1num_1records(
+    JNIEnv* env, jclass self, jlong readerPtr, jlong numRecords) {
+  (void)self;
+  tiledb_vcf_reader_t* reader = (tiledb_vcf_reader_t*)readerPtr;
+  if (reader == 0) {
+    return TILEDB_VCF_ERR;
+  }
+
+  return tiledb_vcf_reader_set_batch_num_records(reader, numRecords);
+}
+
 JNIEXPORT jint JNICALL
 Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1tiledb_1config(
     JNIEnv* env, jclass self, jlong readerPtr, jstring config) {
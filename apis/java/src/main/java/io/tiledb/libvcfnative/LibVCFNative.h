@@ -133,6 +133,33 @@ JNIEXPORT jint JNICALL
 Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1buffer_1validity_1bitmap(
     JNIEnv*, jclass, jlong, jstring, jobject);
 
+/*
+ * Class:     io_tiledb_libvcfnative_LibVCFNative
+ * Method:    tiledb_vcf_reader_set_dictionary_encoding
+ * Signature: (JLjava/lang/String;Z)I
+ */
+JNIEXPORT jint JNICALL
+Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1dictionary_1encoding(
+    JNIEnv*, jclass, jlong, jstring, jboolean);
+
+/*
+ * Class:     io_tiledb_libvcfnative_LibVCFNative
+ * Method:    tiledb_vcf_reader_set_buffer_dictionary_values
+ * Signature: (JLjava/lang/String;Ljava/nio/ByteBuffer;)I
+ */
+JNIEXPORT jint JNICALL
+Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1buffer_1dictionary_1values(
+    JNIEnv*, jclass, jlong, jstring, jobject);
+
+/*
+ * Class:     io_tiledb_libvcfnative_LibVCFNative
+ * Method:    tiledb_vcf_reader_set_buffer_dictionary_offsets
+ * Signature: (JLjava/lang/String;Ljava/nio/ByteBuffer;)I
+ */
+JNIEXPORT jint JNICALL
+Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1buffer_1dictionary_1offsets(
+    JNIEnv*, jclass, jlong, jstring, jobject);
+
 /*
  * Class:     io_tiledb_libvcfnative_LibVCFNative
  * Method:    tiledb_vcf_reader_set_memory_budget
@@ -151,6 +178,15 @@ JNIEXPORT jint JNICALL
 Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1max_1num_1records(
     JNIEnv*, jclass, jlong, jlong);
 
+/*
+ * Class:     io_tiledb_libvcfnative_LibVCFNative
+ * Method:    tiledb_vcf_reader_set_batch_num_records
+ * Signature: (JJ)I
+ */
+JNIEXPORT jint JNICALL
+Java_io_tiledb_libvcfnative_LibVCFNative_tiledb_1vcf_1reader_1set_1batch_1num_1records(
+    JNIEnv*, jclass, jlong, jlong);
+
 /*
  * Class:     io_tiledb_libvcfnative_LibVCFNative
  * Method:    tiledb_vcf_reader_set_tiledb_config
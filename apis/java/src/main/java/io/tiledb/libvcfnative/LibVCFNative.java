@@ -63,11 +63,23 @@ public class LibVCFNative {
   public static final native int tiledb_vcf_reader_set_buffer_validity_bitmap(
       long queryPtr, String attribute, ByteBuffer buffer);
 
+  public static final native int tiledb_vcf_reader_set_dictionary_encoding(
+      long readerPtr, String attribute, boolean dictionary);
+
+  public static final native int tiledb_vcf_reader_set_buffer_dictionary_values(
+      long queryPtr, String attribute, ByteBuffer buffer);
+
+  public static final native int tiledb_vcf_reader_set_buffer_dictionary_offsets(
+      long queryPtr, String attribute, ByteBuffer buffer);
+
   public static final native int tiledb_vcf_reader_set_memory_budget(long readerPtr, int memoryMB);
 
   public static final native int tiledb_vcf_reader_set_max_num_records(
       long readerPtr, long maxNumRecords);
 
+  public static final native int tiledb_vcf_reader_set_batch_num_records(
+      long readerPtr, long numRecords);
+
   public static final native int tiledb_vcf_reader_set_tiledb_config(
       long readerPtr, String configCSV);
 
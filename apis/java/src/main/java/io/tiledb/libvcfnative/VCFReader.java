@@ -19,6 +19,8 @@ public class VCFReader implements AutoCloseable {
     public ByteBuffer offsets;
     public ByteBuffer listOffsets;
     public ByteBuffer bitmap;
+    public ByteBuffer dictionaryValues;
+    public ByteBuffer dictionaryOffsets;
 
     public BufferInfo(
         ByteBuffer values, ByteBuffer offsets, ByteBuffer listOffsets, ByteBuffer bitmap) {
@@ -345,6 +347,19 @@ public class VCFReader implements AutoCloseable {
     return this;
   }
 
+  /**
+   * Sets the maximum number of records returned by each read operation, so that results come in
+   * batches of that many records as long as the buffers are large enough. 0 removes the limit.
+   */
+  public VCFReader setBatchNumRecords(long numRecords) {
+    int rc = LibVCFNative.tiledb_vcf_reader_set_batch_num_records(this.readerPtr, numRecords);
+    if (rc != 0) {
+      String msg = getLastErrorMessage();
+      throw new RuntimeException("Error setting batch num records: " + msg);
+    }
+    return this;
+  }
+
   public VCFReader setBuffer(String attribute, java.nio.ByteBuffer buffer) {
     if (!buffer.isDirect()) {
       throw new RuntimeException("Error setting buffer, buffer not a direct ByteBuffer");
@@ -449,6 +464,81 @@ public class VCFReader implements AutoCloseable {
     return this;
   }
 
+  /**
+   * Sets whether the given attribute ("sample_name", "contig" or "alleles") is read as int32
+   * indices into a dictionary of its values. The dictionary is read into the buffers set with
+   * setBufferDictionaryValues() and setBufferDictionaryOffsets().
+   */
+  public VCFReader setDictionaryEncoding(String attribute, boolean dictionary) {
+    int rc =
+        LibVCFNative.tiledb_vcf_reader_set_dictionary_encoding(
+            this.readerPtr, attribute, dictionary);
+    if (rc != 0) {
+      String msg = getLastErrorMessage();
+      throw new RuntimeException(
+          "Error setting dictionary encoding (attribute: " + attribute + "): " + msg);
+    }
+    return this;
+  }
+
+  public VCFReader setBufferDictionaryValues(String attribute, java.nio.ByteBuffer buffer) {
+    if (!buffer.isDirect()) {
+      throw new RuntimeException(
+          "Error setting dictionary values buffer, buffer not a direct ByteBuffer");
+    }
+    if (buffer.capacity() == 0) {
+      throw new RuntimeException("Error setting dictionary values buffer, buffer has 0 capacity");
+    }
+    int rc =
+        LibVCFNative.tiledb_vcf_reader_set_buffer_dictionary_values(
+            this.readerPtr, attribute, buffer);
+    if (rc != 0) {
+      String msg = getLastErrorMessage();
+      throw new RuntimeException(
+          "Error setting dictionary values buffer (attribute: " + attribute + "): " + msg);
+    }
+
+    BufferInfo info;
+    if (buffers.containsKey(attribute)) info = buffers.get(attribute);
+    else {
+      info = new BufferInfo(null, null, null, null);
+      buffers.put(attribute, info);
+    }
+
+    info.dictionaryValues = buffer;
+
+    return this;
+  }
+
+  public VCFReader setBufferDictionaryOffsets(String attribute, java.nio.ByteBuffer buffer) {
+    if (!buffer.isDirect()) {
+      throw new RuntimeException(
+          "Error setting dictionary offsets buffer, buffer not a direct ByteBuffer");
+    }
+    if (buffer.capacity() == 0) {
+      throw new RuntimeException("Error setting dictionary offsets buffer, buffer has 0 capacity");
+    }
+    int rc =
+        LibVCFNative.tiledb_vcf_reader_set_buffer_dictionary_offsets(
+            this.readerPtr, attribute, buffer);
+    if (rc != 0) {
+      String msg = getLastErrorMessage();
+      throw new RuntimeException(
+          "Error setting dictionary offsets buffer (attribute: " + attribute + "): " + msg);
+    }
+
+    BufferInfo info;
+    if (buffers.containsKey(attribute)) info = buffers.get(attribute);
+    else {
+      info = new BufferInfo(null, null, null, null);
+      buffers.put(attribute, info);
+    }
+
+    info.dictionaryOffsets = buffer;
+
+    return this;
+  }
+
   public ByteBuffer getBuffer(String attribute) {
     return this.buffers.get(attribute).values;
   }
@@ -640,6 +730,8 @@ public class VCFReader implements AutoCloseable {
       if (info.offsets != null) info.offsets.position(0);
       if (info.listOffsets != null) info.listOffsets.position(0);
       if (info.bitmap != null) info.bitmap.position(0);
+      if (info.dictionaryValues != null) info.dictionaryValues.position(0);
+      if (info.dictionaryOffsets != null) info.dictionaryOffsets.position(0);
     }
     return this;
   }
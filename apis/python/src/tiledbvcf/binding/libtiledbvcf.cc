@@ -27,6 +27,8 @@ PYBIND11_MODULE(libtiledbvcf, m) {
       .def("set_sample_partition", &Reader::set_sample_partition)
       .def("set_memory_budget", &Reader::set_memory_budget)
       .def("set_max_num_records", &Reader::set_max_num_records)
+      .def("set_batch_num_records", &Reader::set_batch_num_records)
+      .def("set_dictionary_encoding", &Reader::set_dictionary_encoding)
       .def("set_tiledb_config", &Reader::set_tiledb_config)
       .def("set_attributes", &Reader::set_attributes)
       .def("set_tiledb_stats_enabled", &Reader::set_tiledb_stats_enabled)
@@ -35,6 +37,10 @@ PYBIND11_MODULE(libtiledbvcf, m) {
       .def("get_results_arrow", &Reader::get_results_arrow)
       .def("completed", &Reader::completed)
       .def("result_num_records", &Reader::result_num_records)
+      .def("get_count_groups", &Reader::get_count_groups)
+      .def("get_variant_stats", &Reader::get_variant_stats)
+      .def("get_genotype_matrix", &Reader::get_genotype_matrix)
+      .def("get_vcf_header_cache_stats", &Reader::get_vcf_header_cache_stats)
       .def("get_tiledb_stats_enabled", &Reader::get_tiledb_stats_enabled)
       .def("get_tiledb_stats", &Reader::get_tiledb_stats)
       .def("get_schema_version", &Reader::get_schema_version)
@@ -49,6 +55,15 @@ PYBIND11_MODULE(libtiledbvcf, m) {
           "set_tiledb_tile_cache_percentage",
           &Reader::set_tiledb_tile_cache_percentage)
       .def("set_check_samples_exist", &Reader::set_check_samples_exist)
+      .def(
+          "set_contig_batch_concurrency", &Reader::set_contig_batch_concurrency)
+      .def("set_late_materialization", &Reader::set_late_materialization)
+      .def("set_count_group_by", &Reader::set_count_group_by)
+      .def("set_variant_stats", &Reader::set_variant_stats)
+      .def("set_genotype_matrix", &Reader::set_genotype_matrix)
+      .def("set_genotype_matrix_buffer", &Reader::set_genotype_matrix_buffer)
+      .def("set_genotype_matrix_file", &Reader::set_genotype_matrix_file)
+      .def("set_vcf_header_cache_size", &Reader::set_vcf_header_cache_size)
       .def("version", &Reader::version)
       .def(
           "set_enable_progress_estimation",
@@ -66,6 +81,7 @@ PYBIND11_MODULE(libtiledbvcf, m) {
       .def("set_samples", &Writer::set_samples)
       .def("set_extra_attributes", &Writer::set_extra_attributes)
       .def("set_vcf_attributes", &Writer::set_vcf_attributes)
+      .def("set_typed_attributes", &Writer::set_typed_attributes)
       .def("set_checksum", &Writer::set_checksum)
       .def("set_allow_duplicates", &Writer::set_allow_duplicates)
       .def("set_tile_capacity", &Writer::set_tile_capacity)
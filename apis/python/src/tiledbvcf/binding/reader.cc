@@ -28,6 +28,7 @@
 
 #include <arrow/python/pyarrow.h>
 #include <tiledbvcf/arrow.h>
+#include <array>
 #include <stdexcept>
 
 #include "reader.h"
@@ -49,6 +50,15 @@ void check_error(tiledb_vcf_reader_t* reader, int32_t rc) {
   }
 }
 
+bool dictionary_encoded(tiledb_vcf_reader_t* reader, const std::string& attr) {
+  int32_t dictionary = 0;
+  check_error(
+      reader,
+      tiledb_vcf_reader_get_dictionary_encoding(
+          reader, attr.c_str(), &dictionary));
+  return dictionary != 0;
+}
+
 void check_arrow_error(const arrow::Status& st) {
   if (!st.ok()) {
     std::string msg_str = "TileDB-VCF-Py Arrow error: " + st.message();
@@ -61,7 +71,8 @@ namespace tiledbvcfpy {
 
 Reader::Reader()
     : ptr(nullptr, deleter)
-    , mem_budget_mb_(2 * 1024) {
+    , mem_budget_mb_(2 * 1024)
+    , batch_num_records_(0) {
   tiledb_vcf_reader_t* r;
   if (tiledb_vcf_reader_alloc(&r) != TILEDB_VCF_OK)
     throw std::runtime_error(
@@ -150,6 +161,22 @@ void Reader::set_max_num_records(int64_t max_num_records) {
       reader, tiledb_vcf_reader_set_max_num_records(reader, max_num_records));
 }
 
+void Reader::set_batch_num_records(int64_t num_records) {
+  auto reader = ptr.get();
+  check_error(
+      reader, tiledb_vcf_reader_set_batch_num_records(reader, num_records));
+  batch_num_records_ = num_records;
+}
+
+void Reader::set_dictionary_encoding(
+    const std::string& attribute, bool dictionary) {
+  auto reader = ptr.get();
+  check_error(
+      reader,
+      tiledb_vcf_reader_set_dictionary_encoding(
+          reader, attribute.c_str(), dictionary ? 1 : 0));
+}
+
 void Reader::set_tiledb_config(const std::string& config_str) {
   auto reader = ptr.get();
   check_error(
@@ -166,7 +193,14 @@ void Reader::read(const bool release_buffs) {
   alloc_buffers(release_buffs);
   set_buffers();
 
-  check_error(reader, tiledb_vcf_reader_read(reader));
+  // Let other Python threads run during the read, which does not touch any
+  // Python object.
+  int32_t rc;
+  {
+    py::gil_scoped_release release;
+    rc = tiledb_vcf_reader_read(reader);
+  }
+  check_error(reader, rc);
   tiledb_vcf_read_status_t status;
   check_error(reader, tiledb_vcf_reader_get_status(reader, &status));
   if (status != TILEDB_VCF_COMPLETED && status != TILEDB_VCF_INCOMPLETE)
@@ -177,6 +211,25 @@ void Reader::read(const bool release_buffs) {
 void Reader::alloc_buffers(const bool release_buffs) {
   auto reader = ptr.get();
 
+  // With a number of records per read, size the buffers from their use by the
+  // previous read. This must be done before the old buffers are released.
+  std::map<std::string, std::array<int64_t, 4>> estimates;
+  if (batch_num_records_ > 0 && !buffers_.empty()) {
+    for (const auto& attr : attributes_) {
+      auto& sizes = estimates[attr];
+      check_error(
+          reader,
+          tiledb_vcf_reader_get_buffer_size_estimate(
+              reader,
+              attr.c_str(),
+              batch_num_records_,
+              &sizes[0],
+              &sizes[1],
+              &sizes[2],
+              &sizes[3]));
+    }
+  }
+
   // Release old buffers. TODO: reuse when possible
   if (release_buffs)
     release_buffers();
@@ -194,6 +247,7 @@ void Reader::alloc_buffers(const bool release_buffs) {
     num_buffers += var_len ? 1 : 0;
     num_buffers += nullable ? 1 : 0;
     num_buffers += list ? 1 : 0;
+    num_buffers += dictionary_encoded(reader, attr) ? 2 : 0;
   }
 
   if (num_buffers == 0)
@@ -226,9 +280,16 @@ void Reader::alloc_buffers(const bool release_buffs) {
     buffer.datatype = datatype;
     buffer.arrow_datatype = to_arrow_datatype(datatype);
     buffer.arrow_array_datatype = to_arrow_datatype(datatype);
-    size_t count = alloc_size_bytes / dtype.itemsize();
 
-    auto maybe_buffer = arrow::AllocateBuffer(alloc_size_bytes);
+    // Sizes of the data, offsets, list offsets and bitmap buffers.
+    std::array<int64_t, 4> sizes = {
+        alloc_size_bytes, alloc_size_bytes, alloc_size_bytes, alloc_size_bytes};
+    auto estimate = estimates.find(attr);
+    if (estimate != estimates.end())
+      sizes = estimate->second;
+    size_t count = sizes[0] / dtype.itemsize();
+
+    auto maybe_buffer = arrow::AllocateBuffer(sizes[0]);
     if (!maybe_buffer.ok()) {
       throw std::runtime_error(
           "TileDB-VCF-Py: nullable bitmap buffer allocation failed");
@@ -237,7 +298,7 @@ void Reader::alloc_buffers(const bool release_buffs) {
     }
 
     if (var_len == 1) {
-      auto maybe_buffer = arrow::AllocateBuffer(alloc_size_bytes);
+      auto maybe_buffer = arrow::AllocateBuffer(sizes[1]);
       if (!maybe_buffer.ok()) {
         throw std::runtime_error(
             "TileDB-VCF-Py: offset buffer allocation failed");
@@ -252,7 +313,7 @@ void Reader::alloc_buffers(const bool release_buffs) {
     }
 
     if (list == 1) {
-      auto maybe_buffer = arrow::AllocateBuffer(alloc_size_bytes);
+      auto maybe_buffer = arrow::AllocateBuffer(sizes[2]);
       if (!maybe_buffer.ok()) {
         throw std::runtime_error(
             "TileDB-VCF-Py: list offset buffer allocation failed");
@@ -265,7 +326,7 @@ void Reader::alloc_buffers(const bool release_buffs) {
     }
 
     if (nullable == 1) {
-      auto maybe_buffer = arrow::AllocateBuffer(alloc_size_bytes);
+      auto maybe_buffer = arrow::AllocateBuffer(sizes[3]);
       if (!maybe_buffer.ok()) {
         throw std::runtime_error(
             "TileDB-VCF-Py: nullable bitmap buffer allocation failed");
@@ -274,10 +335,64 @@ void Reader::alloc_buffers(const bool release_buffs) {
       }
     }
 
+    // Dictionary-encoded attributes read int32 indices into a string
+    // dictionary; alleles keep their offsets to the indices of each record.
+    if (dictionary_encoded(reader, attr)) {
+      auto maybe_buffer = arrow::AllocateBuffer(alloc_size_bytes);
+      if (!maybe_buffer.ok()) {
+        throw std::runtime_error(
+            "TileDB-VCF-Py: dictionary buffer allocation failed");
+      } else {
+        buffer.dict_data = std::move(*maybe_buffer);
+      }
+      maybe_buffer = arrow::AllocateBuffer(alloc_size_bytes);
+      if (!maybe_buffer.ok()) {
+        throw std::runtime_error(
+            "TileDB-VCF-Py: dictionary offset buffer allocation failed");
+      } else {
+        buffer.dict_offsets = std::move(*maybe_buffer);
+      }
+
+      buffer.arrow_datatype = arrow::dictionary(arrow::int32(), arrow::utf8());
+      buffer.arrow_array_datatype = buffer.arrow_datatype;
+      if (var_len == 1)
+        buffer.arrow_array_datatype = arrow::list(buffer.arrow_datatype);
+      continue;
+    }
+
     buffer.array = build_arrow_array_from_buffer(buffer, count, count, count);
   }
 }
 
+std::shared_ptr<arrow::Array> Reader::build_dictionary_array(
+    BufferInfo& buffer,
+    const uint64_t& count,
+    const uint64_t& num_data_elements,
+    const uint64_t& num_dict_offsets) {
+  // An empty dictionary still needs its first offset.
+  auto dict_offsets =
+      reinterpret_cast<int32_t*>(buffer.dict_offsets->mutable_data());
+  if (num_dict_offsets == 0)
+    dict_offsets[0] = 0;
+  auto dictionary = std::make_shared<arrow::StringArray>(
+      num_dict_offsets == 0 ? 0 : num_dict_offsets - 1,
+      buffer.dict_offsets,
+      buffer.dict_data);
+
+  if (buffer.offsets == nullptr) {
+    auto indices = std::make_shared<arrow::Int32Array>(count, buffer.data);
+    return std::make_shared<arrow::DictionaryArray>(
+        buffer.arrow_datatype, indices, dictionary);
+  }
+
+  auto indices =
+      std::make_shared<arrow::Int32Array>(num_data_elements, buffer.data);
+  auto values = std::make_shared<arrow::DictionaryArray>(
+      buffer.arrow_datatype, indices, dictionary);
+  return std::make_shared<arrow::ListArray>(
+      buffer.arrow_array_datatype, count, buffer.offsets, values);
+}
+
 std::shared_ptr<arrow::Array> Reader::build_arrow_array_from_buffer(
     BufferInfo& buffer,
     const uint64_t& count,
@@ -323,6 +438,8 @@ void Reader::set_buffers() {
     auto list_offsets = buff.list_offsets;
     auto data = buff.data;
     auto bitmap = buff.bitmap;
+    auto dict_data = buff.dict_data;
+    auto dict_offsets = buff.dict_offsets;
 
     check_error(
         reader,
@@ -352,6 +469,23 @@ void Reader::set_buffers() {
           reader,
           tiledb_vcf_reader_set_buffer_validity_bitmap(
               reader, attr.c_str(), bitmap->size(), bitmap->mutable_data()));
+
+    if (dict_data != nullptr) {
+      check_error(
+          reader,
+          tiledb_vcf_reader_set_buffer_dictionary_values(
+              reader,
+              attr.c_str(),
+              dict_data->size(),
+              reinterpret_cast<char*>(dict_data->mutable_data())));
+      check_error(
+          reader,
+          tiledb_vcf_reader_set_buffer_dictionary_offsets(
+              reader,
+              attr.c_str(),
+              dict_offsets->size(),
+              reinterpret_cast<int32_t*>(dict_offsets->mutable_data())));
+    }
   }
 }
 
@@ -385,8 +519,19 @@ py::object Reader::get_results_arrow() {
             &num_data_elements,
             &num_data_bytes));
 
-    std::shared_ptr<arrow::Array> array = build_arrow_array_from_buffer(
-        buffer, num_records, num_offsets, num_data_elements);
+    std::shared_ptr<arrow::Array> array;
+    if (buffer.dict_data != nullptr) {
+      int64_t num_dict_offsets = 0;
+      check_error(
+          reader,
+          tiledb_vcf_reader_get_dictionary_result_size(
+              reader, buffer.attr_name.c_str(), &num_dict_offsets, nullptr));
+      array = build_dictionary_array(
+          buffer, num_records, num_data_elements, num_dict_offsets);
+    } else {
+      array = build_arrow_array_from_buffer(
+          buffer, num_records, num_offsets, num_data_elements);
+    }
     arrays.push_back(array);
   }
 
@@ -411,6 +556,146 @@ int64_t Reader::result_num_records() {
   return result;
 }
 
+std::vector<std::pair<std::string, int64_t>> Reader::get_count_groups() {
+  auto reader = ptr.get();
+  int64_t num_groups = 0;
+  check_error(
+      reader, tiledb_vcf_reader_get_count_num_groups(reader, &num_groups));
+
+  std::vector<std::pair<std::string, int64_t>> result;
+  result.reserve(num_groups);
+  for (int64_t i = 0; i < num_groups; i++) {
+    const char* name = nullptr;
+    int64_t count = 0;
+    check_error(
+        reader, tiledb_vcf_reader_get_count_group(reader, i, &name, &count));
+    result.emplace_back(name, count);
+  }
+  return result;
+}
+
+py::dict Reader::get_variant_stats() {
+  auto reader = ptr.get();
+  int64_t num_rows = 0;
+  check_error(
+      reader, tiledb_vcf_reader_get_variant_stats_num_rows(reader, &num_rows));
+
+  py::list contigs, positions, alleles, allele_counts, num_alleles_called,
+      num_called, num_het, num_hom_alt, num_missing;
+  for (int64_t i = 0; i < num_rows; i++) {
+    const char* contig = nullptr;
+    uint32_t pos = 0;
+    const char* row_alleles = nullptr;
+    const int32_t* counts = nullptr;
+    int32_t num_alleles = 0, an = 0, called = 0, het = 0, hom_alt = 0,
+            missing = 0;
+    check_error(
+        reader,
+        tiledb_vcf_reader_get_variant_stats_row(
+            reader,
+            i,
+            &contig,
+            &pos,
+            &row_alleles,
+            &counts,
+            &num_alleles,
+            &an,
+            &called,
+            &het,
+            &hom_alt,
+            &missing));
+
+    py::list ac;
+    for (int32_t j = 0; j < num_alleles; j++)
+      ac.append(counts[j]);
+
+    contigs.append(contig);
+    positions.append(pos);
+    alleles.append(row_alleles);
+    allele_counts.append(ac);
+    num_alleles_called.append(an);
+    num_called.append(called);
+    num_het.append(het);
+    num_hom_alt.append(hom_alt);
+    num_missing.append(missing);
+  }
+
+  py::dict result;
+  result["contig"] = contigs;
+  result["pos"] = positions;
+  result["alleles"] = alleles;
+  result["ac"] = allele_counts;
+  result["an"] = num_alleles_called;
+  result["n_called"] = num_called;
+  result["n_het"] = num_het;
+  result["n_hom_alt"] = num_hom_alt;
+  result["n_missing"] = num_missing;
+  return result;
+}
+
+py::dict Reader::get_genotype_matrix() {
+  auto reader = ptr.get();
+  int64_t num_rows = 0, row_bytes = 0;
+  int32_t num_samples = 0;
+  check_error(
+      reader,
+      tiledb_vcf_reader_get_genotype_matrix_shape(
+          reader, &num_rows, &num_samples, &row_bytes));
+
+  py::list samples;
+  for (int32_t i = 0; i < num_samples; i++) {
+    const char* sample = nullptr;
+    check_error(
+        reader,
+        tiledb_vcf_reader_get_genotype_matrix_sample(reader, i, &sample));
+    samples.append(sample);
+  }
+
+  py::list contigs, positions, alleles;
+  for (int64_t i = 0; i < num_rows; i++) {
+    const char* contig = nullptr;
+    uint32_t pos = 0;
+    const char* row_alleles = nullptr;
+    check_error(
+        reader,
+        tiledb_vcf_reader_get_genotype_matrix_row(
+            reader, i, &contig, &pos, &row_alleles));
+    contigs.append(contig);
+    positions.append(pos);
+    alleles.append(row_alleles);
+  }
+
+  py::dict variants;
+  variants["contig"] = contigs;
+  variants["pos"] = positions;
+  variants["alleles"] = alleles;
+
+  py::dict result;
+  result["samples"] = samples;
+  result["num_rows"] = num_rows;
+  result["row_bytes"] = row_bytes;
+  result["variants"] = variants;
+  return result;
+}
+
+py::dict Reader::get_vcf_header_cache_stats() {
+  auto reader = ptr.get();
+  uint64_t hits = 0, misses = 0, evictions = 0, num_entries = 0,
+           size_bytes = 0;
+  check_error(
+      reader,
+      tiledb_vcf_reader_get_vcf_header_cache_stats(
+          reader, &hits, &misses, &evictions, &num_entries, &size_bytes));
+
+  py::dict result;
+  result["hits"] = hits;
+  result["misses"] = misses;
+  result["evictions"] = evictions;
+  result["num_entries"] = num_entries;
+  result["size_bytes"] = size_bytes;
+  return result;
+}
+
 bool Reader::completed() {
   auto reader = ptr.get();
   tiledb_vcf_read_status_t status;
@@ -583,6 +868,80 @@ void Reader::set_buffer_percentage(float buffer_percentage) {
       tiledb_vcf_reader_set_buffer_percentage(reader, buffer_percentage));
 }
 
+void Reader::set_contig_batch_concurrency(int32_t concurrency) {
+  auto reader = ptr.get();
+  check_error(
+      reader,
+      tiledb_vcf_reader_set_contig_batch_concurrency(reader, concurrency));
+}
+
+void Reader::set_late_materialization(bool late_materialization) {
+  auto reader = ptr.get();
+  check_error(
+      reader,
+      tiledb_vcf_reader_set_late_materialization(
+          reader, late_materialization));
+}
+
+void Reader::set_count_group_by(const std::string& group_by) {
+  tiledb_vcf_count_group_by_t value;
+  if (group_by.empty())
+    value = TILEDB_VCF_COUNT_NONE;
+  else if (group_by == "region")
+    value = TILEDB_VCF_COUNT_BY_REGION;
+  else if (group_by == "sample")
+    value = TILEDB_VCF_COUNT_BY_SAMPLE;
+  else if (group_by == "contig")
+    value = TILEDB_VCF_COUNT_BY_CONTIG;
+  else
+    throw std::runtime_error(
+        "TileDB-VCF-Py: Error setting count grouping; unknown grouping '" +
+        group_by + "'.");
+
+  auto reader = ptr.get();
+  check_error(reader, tiledb_vcf_reader_set_count_group_by(reader, value));
+}
+
+void Reader::set_variant_stats(bool variant_stats) {
+  auto reader = ptr.get();
+  check_error(
+      reader, tiledb_vcf_reader_set_variant_stats(reader, variant_stats));
+}
+
+void Reader::set_genotype_matrix(bool genotype_matrix) {
+  auto reader = ptr.get();
+  check_error(
+      reader, tiledb_vcf_reader_set_genotype_matrix(reader, genotype_matrix));
+}
+
+void Reader::set_genotype_matrix_buffer(py::array buffer) {
+  auto reader = ptr.get();
+  // The matrix is written in place, so the array must not be converted.
+  if (!py::isinstance<py::array_t<uint8_t, py::array::c_style>>(buffer))
+    throw std::runtime_error(
+        "TileDB-VCF-Py: Error setting genotype matrix buffer; must be a "
+        "C-contiguous uint8 array.");
+  py::buffer_info info = buffer.request(true);
+  check_error(
+      reader,
+      tiledb_vcf_reader_set_genotype_matrix_buffer(
+          reader, info.size, info.ptr));
+  genotype_matrix_buffer_ = buffer;
+}
+
+void Reader::set_genotype_matrix_file(const std::string& path) {
+  auto reader = ptr.get();
+  check_error(
+      reader, tiledb_vcf_reader_set_genotype_matrix_file(reader, path.c_str()));
+  genotype_matrix_buffer_ = py::none();
+}
+
+void Reader::set_vcf_header_cache_size(int32_t memory_mb) {
+  auto reader = ptr.get();
+  check_error(
+      reader, tiledb_vcf_reader_set_vcf_header_cache_size(reader, memory_mb));
+}
+
 void Reader::set_tiledb_tile_cache_percentage(float tile_percentage) {
   auto reader = ptr.get();
   check_error(
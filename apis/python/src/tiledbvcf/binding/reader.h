@@ -83,6 +83,18 @@ class Reader {
   /** Sets the max number of records that will be read. */
   void set_max_num_records(int64_t max_num_records);
 
+  /**
+   * Sets the max number of records of each read operation. Buffers of the
+   * following read operations are then sized to hold that many records.
+   */
+  void set_batch_num_records(int64_t num_records);
+
+  /**
+   * Sets whether the given attribute ("sample_name", "contig" or "alleles") is
+   * read as an Arrow dictionary array.
+   */
+  void set_dictionary_encoding(const std::string& attribute, bool dictionary);
+
   /** Sets CSV TileDB config parameters. */
   void set_tiledb_config(const std::string& config_str);
 
@@ -101,6 +113,29 @@ class Reader {
   /** Returns the number of records in the last read operation's results. */
   int64_t result_num_records();
 
+  /**
+   * Returns the (group, count) pairs of the last read operation, which must
+   * have been a count query (see set_count_group_by()).
+   */
+  std::vector<std::pair<std::string, int64_t>> get_count_groups();
+
+  /**
+   * Returns a dict of columns holding the statistics of each variant of the
+   * last read operation, which must have been a variant stats query (see
+   * set_variant_stats()).
+   */
+  py::dict get_variant_stats();
+
+  /**
+   * Returns a dict holding the samples, shape and row variants of the
+   * genotype matrix of the last read operation, which must have been a
+   * genotype matrix query (see set_genotype_matrix()).
+   */
+  py::dict get_genotype_matrix();
+
+  /** Returns a dict of the counters of the VCF header cache. */
+  py::dict get_vcf_header_cache_stats();
+
   /** Returns true if the last read operation was complete. */
   bool completed();
 
@@ -147,6 +182,33 @@ class Reader {
   /** Set to check if samples requested exist and error if not. */
   void set_check_samples_exist(bool check_samples_exist);
 
+  /** Set the number of contig batches queried concurrently. */
+  void set_contig_batch_concurrency(int32_t concurrency);
+
+  /** Set whether reads run in two phases (late materialization). */
+  void set_late_materialization(bool late_materialization);
+
+  /**
+   * Set the grouping of count queries: "region", "sample", "contig", or an
+   * empty string to export the records rather than count them.
+   */
+  void set_count_group_by(const std::string& group_by);
+
+  /** Set whether reads compute variant stats instead of exporting records. */
+  void set_variant_stats(bool variant_stats);
+
+  /** Set whether reads build a genotype matrix instead of exporting records. */
+  void set_genotype_matrix(bool genotype_matrix);
+
+  /** Set the numpy uint8 array the genotype matrix is written to. */
+  void set_genotype_matrix_buffer(py::array buffer);
+
+  /** Set the local file the genotype matrix is memory-mapped to. */
+  void set_genotype_matrix_file(const std::string& path);
+
+  /** Set the memory cap (MB) of the VCF header cache; 0 disables it. */
+  void set_vcf_header_cache_size(int32_t memory_mb);
+
   /** Get Version info for TileDB VCF and TileDB. */
   std::string version();
 
@@ -177,6 +239,10 @@ class Reader {
     std::shared_ptr<arrow::Buffer> data;
     /** Null-value bitmap, for nullable attributes. */
     std::shared_ptr<arrow::Buffer> bitmap;
+    /** Dictionary values buffer, for dictionary-encoded attributes. */
+    std::shared_ptr<arrow::Buffer> dict_data;
+    /** Dictionary offsets buffer, for dictionary-encoded attributes. */
+    std::shared_ptr<arrow::Buffer> dict_offsets;
     /** Array array wrapping array buffers. */
     std::shared_ptr<arrow::Array> array;
     /** Arrow datatype. */
@@ -201,12 +267,18 @@ class Reader {
   /** The size (in MB) of the memory budget parameter. */
   int64_t mem_budget_mb_;
 
+  /** The max number of records of each read operation, or 0 if unset. */
+  int64_t batch_num_records_;
+
   /** The set of attribute names included in the read query. */
   std::vector<std::string> attributes_;
 
   /** List of attribute buffers. */
   std::vector<BufferInfo> buffers_;
 
+  /** Array the genotype matrix is written to, kept alive while set. */
+  py::object genotype_matrix_buffer_;
+
   /** Allocate buffers for the read. */
   void alloc_buffers(const bool release_buffs = true);
 
@@ -223,6 +295,13 @@ class Reader {
       const uint64_t& num_offsets,
       const uint64_t& num_data_elements);
 
+  /** Build arrow dictionary array from a dictionary-encoded bufferInfo. */
+  std::shared_ptr<arrow::Array> build_dictionary_array(
+      BufferInfo& buffer,
+      const uint64_t& count,
+      const uint64_t& num_data_elements,
+      const uint64_t& num_dict_offsets);
+
   template <typename T>
   std::shared_ptr<arrow::Array> build_arrow_array(
       const BufferInfo& buffer,
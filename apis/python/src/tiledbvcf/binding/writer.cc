@@ -95,6 +95,13 @@ void Writer::set_vcf_attributes(const std::string& vcf_uri) {
       writer, tiledb_vcf_writer_set_vcf_attributes(writer, vcf_uri.c_str()));
 }
 
+void Writer::set_typed_attributes(const std::string& attributes) {
+  auto writer = ptr.get();
+  check_error(
+      writer,
+      tiledb_vcf_writer_set_typed_attributes(writer, attributes.c_str()));
+}
+
 void Writer::set_checksum(const std::string& checksum) {
   auto writer = ptr.get();
   tiledb_vcf_checksum_type_t checksum_type = TILEDB_VCF_CHECKSUM_SHA256;
@@ -67,6 +67,12 @@ class Writer {
    */
   void set_vcf_attributes(const std::string& vcf_uri);
 
+  /**
+   * Sets the extracted info/fmt fields stored as natively typed attributes.
+   * Expects a CSV string.
+   */
+  void set_typed_attributes(const std::string& attributes);
+
   /**
     [Creation only] Sets the checksum type to be used of the arrays
   */
@@ -1,9 +1,11 @@
+import numpy as np
 import pandas as pd
 import pyarrow as pa
 import sys
 import warnings
 
 from collections import namedtuple
+from concurrent.futures import ThreadPoolExecutor
 from . import libtiledbvcf
 
 ReadConfig = namedtuple(
@@ -25,9 +27,36 @@ ReadConfig = namedtuple(
         "buffer_percentage",
         # Percentage of memory to dedicate to TileDB Tile Cache (default: 10)
         "tiledb_tile_cache_percentage",
+        # Number of contigs whose TileDB queries run concurrently (default: 1)
+        "contig_batch_concurrency",
+        # Read in two phases, fetching attributes only for intersecting
+        # records (default: False)
+        "late_materialization",
+        # Memory cap (MB) of the cache of parsed VCF headers reused by
+        # successive reads (default: 128, 0 disables it)
+        "vcf_header_cache_mb",
+        # Max number of records of each batch of read_iter() or
+        # continue_read(); buffers are then sized from the previous batch
+        "batch_num_records",
+        # List of attributes ("sample_name", "contig", "alleles") read as
+        # Arrow dictionary arrays of int32 indices into a per-batch dictionary
+        "dictionary_encoded",
+    ],
+)
+ReadConfig.__new__.__defaults__ = (None,) * 13  # len(ReadConfig._fields)
+
+GenotypeMatrix = namedtuple(
+    "GenotypeMatrix",
+    [
+        # Sample names of the columns
+        "samples",
+        # Pandas DataFrame with the contig, pos (1-based) and alleles of the
+        # variant of each row
+        "variants",
+        # uint8 numpy array (or numpy memmap) of shape (rows, row bytes)
+        "matrix",
     ],
 )
-ReadConfig.__new__.__defaults__ = (None,) * 8  # len(ReadConfig._fields)
 
 
 class Dataset(object):
@@ -80,6 +109,17 @@ class Dataset(object):
             self.reader.set_tiledb_tile_cache_percentage(
                 cfg.tiledb_tile_cache_percentage
             )
+        if cfg.contig_batch_concurrency is not None:
+            self.reader.set_contig_batch_concurrency(cfg.contig_batch_concurrency)
+        if cfg.late_materialization is not None:
+            self.reader.set_late_materialization(cfg.late_materialization)
+        if cfg.vcf_header_cache_mb is not None:
+            self.reader.set_vcf_header_cache_size(cfg.vcf_header_cache_mb)
+        if cfg.batch_num_records is not None:
+            self.reader.set_batch_num_records(cfg.batch_num_records)
+        if cfg.dictionary_encoded is not None:
+            for attr in cfg.dictionary_encoded:
+                self.reader.set_dictionary_encoding(attr, True)
         if cfg.tiledb_config is not None:
             tiledb_config_list = list()
             if isinstance(cfg.tiledb_config, list):
@@ -226,15 +266,45 @@ class Dataset(object):
         return self.continue_read()
 
     def read_iter(
-        self, attrs, samples=None, regions=None, samples_file=None, bed_file=None
+        self,
+        attrs,
+        samples=None,
+        regions=None,
+        samples_file=None,
+        bed_file=None,
+        prefetch=False,
     ):
+        """Generator version of `read()`, yielding the results of the read and
+        of each `continue_read()` as Pandas DataFrames.
+
+        :param bool prefetch: Read the next batch in a background thread while
+            the caller processes the current one. The dataset must not be used
+            otherwise until the generator is exhausted or closed.
+        """
         if self.mode != "r":
             raise Exception("Dataset not open in read mode")
 
-        if not self.read_completed():
-            yield self.read(attrs, samples, regions, samples_file, bed_file)
-        while not self.read_completed():
-            yield self.continue_read()
+        if not prefetch:
+            if not self.read_completed():
+                yield self.read(attrs, samples, regions, samples_file, bed_file)
+            while not self.read_completed():
+                yield self.continue_read()
+            return
+
+        if self.read_completed():
+            return
+        table = self.read_arrow(attrs, samples, regions, samples_file, bed_file)
+        # Exiting the executor waits for a pending read, so that a closed
+        # generator leaves the reader idle.
+        with ThreadPoolExecutor(max_workers=1) as executor:
+            while not self.read_completed():
+                # The next read allocates new buffers, leaving the current
+                # table untouched.
+                pending = executor.submit(self.reader.read, True)
+                yield table.to_pandas()
+                pending.result()
+                table = self._get_results_arrow()
+        yield table.to_pandas()
 
     def continue_read(self, release_buffers=True):
         """
@@ -254,6 +324,9 @@ class Dataset(object):
             raise Exception("Dataset not open in read mode")
 
         self.reader.read(release_buffers)
+        return self._get_results_arrow()
+
+    def _get_results_arrow(self):
         try:
             table = self.reader.get_results_arrow()
         except:
@@ -268,14 +341,19 @@ class Dataset(object):
             raise Exception("Dataset not open in read mode")
         return self.reader.completed()
 
-    def count(self, samples=None, regions=None):
+    def count(self, samples=None, regions=None, group_by=None):
         """Counts data in a TileDB-VCF dataset.
 
         :param list of str samples: CSV list of sample names to include in
             the count.
         :param list of str regions: CSV list of genomic regions include in
             the count
-        :return: Number of intersecting records in the dataset
+        :param str group_by: Count the records per 'region', 'sample' or
+            'contig' instead of in total. Only the position attributes are
+            read.
+        :return: Number of intersecting records in the dataset, or if
+            group_by is set, a Pandas DataFrame with the group and count of
+            each group having intersecting records
         """
         if self.mode != "r":
             raise Exception("Dataset not open in read mode")
@@ -286,11 +364,128 @@ class Dataset(object):
         self.reader.set_samples(",".join(samples))
         self.reader.set_regions(",".join(regions))
 
-        self.reader.read()
-        if not self.read_completed():
-            raise Exception("Unexpected read status during count.")
+        self.reader.set_count_group_by("" if group_by is None else group_by)
+        try:
+            self.reader.read()
+            if not self.read_completed():
+                raise Exception("Unexpected read status during count.")
+
+            if group_by is None:
+                return self.reader.result_num_records()
+            return pd.DataFrame(
+                self.reader.get_count_groups(), columns=[group_by, "count"]
+            )
+        finally:
+            self.reader.set_count_group_by("")
 
-        return self.reader.result_num_records()
+    def variant_stats(self, samples=None, regions=None):
+        """Computes the allele counts and genotype classes of each variant
+        across the samples of a TileDB-VCF dataset (v4 only).
+
+        Records are aggregated by contig, position and alleles without being
+        exported; only the position, alleles and GT attributes are read. Each
+        record is counted once, even if it intersects several regions.
+
+        :param list of str samples: CSV list of sample names to include in
+            the stats.
+        :param list of str regions: CSV list of genomic regions to include
+            in the stats
+        :return: Pandas DataFrame with one row per variant: contig, pos
+            (1-based), alleles, ac (called allele counts, REF first), an
+            (number of called alleles), af (ALT allele frequencies), the
+            number of called, heterozygous, homozygous ALT and missing
+            genotypes, and missing_rate
+        """
+        if self.mode != "r":
+            raise Exception("Dataset not open in read mode")
+        self.reader.reset()
+
+        samples = "" if samples is None else samples
+        regions = "" if regions is None else regions
+        self.reader.set_samples(",".join(samples))
+        self.reader.set_regions(",".join(regions))
+
+        self.reader.set_variant_stats(True)
+        try:
+            self.reader.read()
+            if not self.read_completed():
+                raise Exception("Unexpected read status during variant stats.")
+            df = pd.DataFrame(self.reader.get_variant_stats())
+        finally:
+            self.reader.set_variant_stats(False)
+
+        df.insert(
+            df.columns.get_loc("an") + 1,
+            "af",
+            [
+                [c / an for c in ac[1:]] if an > 0 else None
+                for ac, an in zip(df["ac"], df["an"])
+            ],
+        )
+        total = df["n_called"] + df["n_missing"]
+        df["missing_rate"] = df["n_missing"] / total.where(total > 0)
+        return df
+
+    def read_genotype_matrix(
+        self, samples=None, regions=None, path=None, max_variants=100000
+    ):
+        """Reads the genotypes of each variant across the samples of a
+        TileDB-VCF dataset into a bit-packed matrix (v4 only).
+
+        The matrix has one row per variant (contig, position, alleles) and
+        one column per sample. A row holds 2 bits per sample with the number
+        of ALT alleles of its genotype, followed, from the next byte, by 1 bit
+        per sample set if the genotype is missing. Sample i is at bits
+        2 * (i % 4) of byte i // 4, and at bit i % 8 of byte i // 8 of the
+        missing bits. Only the position, alleles and GT attributes are read.
+
+        :param list of str samples: CSV list of sample names of the columns,
+            all samples (sorted by name) if unset
+        :param list of str regions: CSV list of genomic regions to read
+        :param str path: Local file the matrix is memory-mapped to. If unset,
+            the matrix is read into memory.
+        :param int max_variants: Number of rows of the in-memory matrix; the
+            read fails if more variants intersect the regions
+        :return: GenotypeMatrix tuple of the samples, a Pandas DataFrame of
+            the variants, and the matrix
+        """
+        if self.mode != "r":
+            raise Exception("Dataset not open in read mode")
+        self.reader.reset()
+
+        samples = "" if samples is None else samples
+        regions = "" if regions is None else regions
+        self.reader.set_samples(",".join(samples))
+        self.reader.set_regions(",".join(regions))
+
+        buffer = None
+        if path is None:
+            n = len(samples) if samples else self.sample_count()
+            row_bytes = (2 * n + 7) // 8 + (n + 7) // 8
+            buffer = np.empty(max_variants * row_bytes, dtype=np.uint8)
+            self.reader.set_genotype_matrix_buffer(buffer)
+        else:
+            self.reader.set_genotype_matrix_file(path)
+
+        self.reader.set_genotype_matrix(True)
+        try:
+            self.reader.read()
+            if not self.read_completed():
+                raise Exception("Unexpected read status during genotype matrix.")
+            result = self.reader.get_genotype_matrix()
+        finally:
+            self.reader.set_genotype_matrix(False)
+
+        shape = (result["num_rows"], result["row_bytes"])
+        if buffer is not None:
+            matrix = buffer[: shape[0] * shape[1]].reshape(shape)
+        elif shape[0] * shape[1] > 0:
+            matrix = np.memmap(path, dtype=np.uint8, mode="r+", shape=shape)
+        else:
+            matrix = np.empty(shape, dtype=np.uint8)
+        return GenotypeMatrix(
+            result["samples"], pd.DataFrame(result["variants"]), matrix
+        )
 
     def create_dataset(
         self,
@@ -300,6 +495,7 @@ class Dataset(object):
         anchor_gap=None,
         checksum_type=None,
         allow_duplicates=True,
+        typed_attrs=None,
     ):
         """Create a new dataset
 
@@ -315,6 +511,8 @@ class Dataset(object):
             new dataset valid values are sha256, md5 or none.
         :param bool allow_duplicates: Allow records with duplicate start
             positions to be written to the array.
+        :param list of str typed_attrs: Fields of vcf_attrs to store as typed,
+            nullable Integer or Float attributes instead of blobs.
         """
         if self.mode != "w":
             raise Exception("Dataset not open in write mode")
@@ -328,6 +526,9 @@ class Dataset(object):
         if vcf_attrs is not None:
             self.writer.set_vcf_attributes(vcf_attrs)
 
+        if typed_attrs is not None:
+            self.writer.set_typed_attributes(",".join(typed_attrs))
+
         if tile_capacity is not None:
             self.writer.set_tile_capacity(tile_capacity)
 
@@ -393,8 +594,8 @@ class Dataset(object):
         :param int thread_task_size: Set the max length (# columns) of an
             ingestion task. Affects load balancing of ingestion work across
             threads, and total memory consumption. (Legacy option)
-        :param int memory_budget_mb: Set the max size (MB) of TileDB buffers before flushing
-            (Legacy option)
+        :param int memory_budget_mb: Set the max size (MB) of TileDB buffers per thread
+            before flushing. V4 datasets split it across two buffer sets. (Legacy option)
         :param int record_limit: Limit the number of VCF records read into memory
             per file (Legacy option)
         """
@@ -486,6 +687,16 @@ class Dataset(object):
                 raise Exception("TileDB write stats not enabled")
             return self.writer.get_tiledb_stats()
 
+    def vcf_header_cache_stats(self):
+        """Retrieve the counters of the cache of parsed VCF headers
+
+        :return: dict with the number of cache hits, misses and evictions, and
+            the number of cached headers and their estimated size in bytes
+        """
+        if self.mode != "r":
+            raise Exception("VCF header cache stats only available in read mode")
+        return self.reader.get_vcf_header_cache_stats()
+
     def schema_version(self):
         """Retrieve the VCF dataset's schema version"""
         if self.mode != "r":
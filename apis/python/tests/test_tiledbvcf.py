@@ -2,6 +2,7 @@ import numpy as np
 import os
 import pandas as pd
 import pytest
+import pyarrow as pa
 import tiledbvcf
 
 # Directory containing this file
@@ -255,6 +256,23 @@ def test_multiple_counts(test_ds):
     assert test_ds.count(samples=["HG00280"]) == 11
 
 
+def test_grouped_counts(test_ds):
+    df = test_ds.count(group_by="sample")
+    assert df["sample"].tolist() == ["HG00280", "HG01762"]
+    assert df["count"].tolist() == [11, 3]
+
+    df = test_ds.count(regions=["1:17000-18000", "1:12700-13400"], group_by="region")
+    assert df["region"].tolist() == ["1:12700-13400", "1:17000-18000"]
+    assert df["count"].tolist() == [6, 2]
+
+    df = test_ds.count(samples=["HG01762"], group_by="contig")
+    assert df["contig"].tolist() == ["1"]
+    assert df["count"].tolist() == [3]
+
+    # The grouping only applies to the count it was passed to
+    assert test_ds.count() == 14
+
+
 def test_empty_region(test_ds):
     assert test_ds.count(regions=["12:1-1000000"]) == 0
 
@@ -381,6 +399,78 @@ def test_incomplete_read_generator():
     )
 
 
+def test_incomplete_read_generator_prefetch():
+    # Using undocumented "0 MB" budget to test incomplete reads.
+    uri = os.path.join(TESTS_INPUT_DIR, "arrays/v3/ingested_2samples")
+    cfg = tiledbvcf.ReadConfig(memory_budget_mb=0)
+    test_ds = tiledbvcf.Dataset(uri, mode="r", cfg=cfg)
+
+    dfs = list(
+        test_ds.read_iter(attrs=["pos_end"], regions=["1:12700-13400"], prefetch=True)
+    )
+    assert len(dfs) > 1
+    _check_dfs(
+        pd.DataFrame.from_dict(
+            {
+                "pos_end": np.array(
+                    [12771, 12771, 13374, 13389, 13395, 13413], dtype=np.int32
+                )
+            }
+        ),
+        pd.concat(dfs, ignore_index=True),
+    )
+
+    # Closing the generator early leaves the dataset usable.
+    test_ds = tiledbvcf.Dataset(uri, mode="r", cfg=cfg)
+    it = test_ds.read_iter(attrs=["pos_end"], regions=["1:12700-13400"], prefetch=True)
+    next(it)
+    it.close()
+    assert test_ds.count(regions=["1:12700-13400"]) == 6
+
+
+def test_batch_num_records():
+    uri = os.path.join(TESTS_INPUT_DIR, "arrays/v3/ingested_2samples")
+    test_ds = tiledbvcf.Dataset(uri, mode="r")
+    expected_df = test_ds.read(
+        attrs=["sample_name", "pos_start", "alleles"], regions=["1:12000-13400"]
+    )
+
+    # Every batch but the last one holds the requested number of records
+    cfg = tiledbvcf.ReadConfig(batch_num_records=2)
+    test_ds = tiledbvcf.Dataset(uri, mode="r", cfg=cfg)
+    dfs = list(
+        test_ds.read_iter(
+            attrs=["sample_name", "pos_start", "alleles"],
+            regions=["1:12000-13400"],
+        )
+    )
+    assert [len(df) for df in dfs[:-1]] == [2] * (len(dfs) - 1)
+    assert len(dfs[-1]) <= 2
+    _check_dfs(expected_df, pd.concat(dfs, ignore_index=True))
+
+
+def test_dictionary_encoded():
+    uri = os.path.join(TESTS_INPUT_DIR, "arrays/v4/ingested_2samples")
+    attrs = ["sample_name", "contig", "pos_start", "alleles"]
+    test_ds = tiledbvcf.Dataset(uri, mode="r")
+    expected = test_ds.read_arrow(attrs=attrs, regions=["1:12000-13400"])
+
+    cfg = tiledbvcf.ReadConfig(dictionary_encoded=["sample_name", "contig", "alleles"])
+    test_ds = tiledbvcf.Dataset(uri, mode="r", cfg=cfg)
+    table = test_ds.read_arrow(attrs=attrs, regions=["1:12000-13400"])
+    assert pa.types.is_dictionary(table.schema.field("sample_name").type)
+    assert pa.types.is_dictionary(table.schema.field("contig").type)
+    assert pa.types.is_dictionary(table.schema.field("alleles").type.value_type)
+    assert len(table.column("sample_name").chunk(0).dictionary) == 2
+    assert len(table.column("contig").chunk(0).dictionary) == 1
+    for attr in attrs:
+        assert table.column(attr).to_pylist() == expected.column(attr).to_pylist()
+
+    with pytest.raises(RuntimeError):
+        cfg = tiledbvcf.ReadConfig(dictionary_encoded=["pos_start"])
+        tiledbvcf.Dataset(uri, mode="r", cfg=cfg)
+
+
 def test_read_filters(test_ds):
     df = test_ds.read(
         attrs=["sample_name", "pos_start", "pos_end", "filters"],
@@ -943,6 +1033,106 @@ def test_incremental_ingest(tmp_path):
     assert ds.count(samples=["HG00280"], regions=["1:12700-13400"]) == 4
 
 
+def test_variant_stats(tmp_path):
+    uri = os.path.join(tmp_path, "dataset")
+    ds = tiledbvcf.Dataset(uri, mode="w")
+    samples = [os.path.join(TESTS_INPUT_DIR, s) for s in ["small.bcf", "small2.bcf"]]
+    ds.create_dataset()
+    ds.ingest_samples(samples)
+
+    ds = tiledbvcf.Dataset(uri, mode="r")
+    # Records intersecting both (overlapping) regions are counted once
+    df = ds.variant_stats(regions=["1:12700-13360", "1:13350-13400"])
+    assert df["pos"].tolist() == [12546, 13354, 13375, 13396]
+    assert df["alleles"].tolist() == [
+        "G,<NON_REF>",
+        "T,<NON_REF>",
+        "G,<NON_REF>",
+        "T,<NON_REF>",
+    ]
+    assert df["ac"].tolist() == [[4, 0], [4, 0], [2, 0], [2, 0]]
+    assert df["an"].tolist() == [4, 4, 2, 2]
+    assert df["af"].tolist() == [[0.0], [0.0], [0.0], [0.0]]
+    assert df["n_called"].tolist() == [2, 2, 1, 1]
+    assert df["n_het"].tolist() == [0, 0, 0, 0]
+    assert df["n_hom_alt"].tolist() == [0, 0, 0, 0]
+    assert df["missing_rate"].tolist() == [0.0, 0.0, 0.0, 0.0]
+
+    df = ds.variant_stats(samples=["HG01762"], regions=["1:12700-13400"])
+    assert df["pos"].tolist() == [12546, 13354]
+    assert df["an"].tolist() == [2, 2]
+
+    # Variant stats do not affect later counts
+    assert ds.count(regions=["1:12700-13400"]) == 6
+
+
+def test_genotype_matrix(tmp_path):
+    uri = os.path.join(tmp_path, "dataset")
+    ds = tiledbvcf.Dataset(uri, mode="w")
+    samples = [os.path.join(TESTS_INPUT_DIR, s) for s in ["small.bcf", "small2.bcf"]]
+    ds.create_dataset()
+    ds.ingest_samples(samples)
+
+    ds = tiledbvcf.Dataset(uri, mode="r")
+    regions = ["1:12700-13360", "1:13350-13400"]
+    result = ds.read_genotype_matrix(regions=regions)
+    assert result.samples == ["HG00280", "HG01762"]
+    assert result.variants["pos"].tolist() == [12546, 13354, 13375, 13396]
+    # All genotypes are 0/0; HG01762 has no record at 13375 and 13396
+    assert result.matrix.shape == (4, 2)
+    assert result.matrix[:, 0].tolist() == [0, 0, 0, 0]
+    assert result.matrix[:, 1].tolist() == [0, 0, 2, 2]
+
+    # The same matrix memory-mapped to a file
+    path = os.path.join(tmp_path, "gt.bin")
+    mapped = ds.read_genotype_matrix(regions=regions, path=path)
+    assert os.path.getsize(path) == 8
+    assert np.array_equal(mapped.matrix, result.matrix)
+    assert mapped.variants.equals(result.variants)
+
+    result = ds.read_genotype_matrix(samples=["HG01762"], regions=regions)
+    assert result.variants["pos"].tolist() == [12546, 13354]
+    assert result.matrix.tolist() == [[0, 0], [0, 0]]
+
+    # The read fails if the matrix does not fit
+    with pytest.raises(RuntimeError):
+        ds.read_genotype_matrix(regions=regions, max_variants=3)
+
+    # Genotype matrices do not affect later counts
+    assert ds.count(regions=["1:12700-13400"]) == 6
+
+
+def test_vcf_header_cache(tmp_path):
+    uri = os.path.join(tmp_path, "dataset")
+    ds = tiledbvcf.Dataset(uri, mode="w")
+    samples = [os.path.join(TESTS_INPUT_DIR, s) for s in ["small.bcf", "small2.bcf"]]
+    ds.create_dataset()
+    ds.ingest_samples(samples)
+
+    # Exporting filters requires the sample headers
+    ds = tiledbvcf.Dataset(uri, mode="r")
+    df = ds.read(attrs=["sample_name", "filters"], regions=["1:12700-13400"])
+    stats = ds.vcf_header_cache_stats()
+    assert stats["hits"] == 0
+    assert stats["num_entries"] == 2
+
+    # A second read takes the headers from the cache
+    df2 = ds.read(attrs=["sample_name", "filters"], regions=["1:12700-13400"])
+    _check_dfs(df, df2)
+    stats = ds.vcf_header_cache_stats()
+    assert stats["hits"] >= 2
+    assert stats["evictions"] == 0
+
+    # The cache can be disabled
+    cfg = tiledbvcf.ReadConfig(vcf_header_cache_mb=0)
+    ds = tiledbvcf.Dataset(uri, mode="r", cfg=cfg)
+    ds.read(attrs=["sample_name", "filters"], regions=["1:12700-13400"])
+    ds.read(attrs=["sample_name", "filters"], regions=["1:12700-13400"])
+    stats = ds.vcf_header_cache_stats()
+    assert stats["hits"] == 0
+    assert stats["num_entries"] == 0
+
+
 def test_ingest_disable_merging(tmp_path):
     # Create the dataset
     uri = os.path.join(tmp_path, "dataset_disable_merging")
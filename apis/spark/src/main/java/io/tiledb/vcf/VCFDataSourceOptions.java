@@ -217,6 +217,22 @@ public class VCFDataSourceOptions implements Serializable {
     return Optional.empty();
   }
 
+  /** @return Optional array of columns read as dictionary-encoded strings */
+  public Optional<String[]> getDictionaryEncoded() {
+    if (options.containsKey("dictionary_encoded")) {
+      return Optional.of(options.get("dictionary_encoded").split("\\s*,[,\\s]*"));
+    }
+    return Optional.empty();
+  }
+
+  /** @return Optional maximum number of records read into each batch */
+  public Optional<Long> getBatchNumRecords() {
+    if (options.containsKey("batch_num_records")) {
+      return Optional.of(Long.parseLong(options.get("batch_num_records")));
+    }
+    return Optional.empty();
+  }
+
   /** @return Optional CSV String of config parameters */
   public Optional<String> getConfigCSV() {
     return getConfigCSV(options);
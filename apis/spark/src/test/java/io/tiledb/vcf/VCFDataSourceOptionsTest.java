@@ -42,6 +42,26 @@ public class VCFDataSourceOptionsTest {
         new String[] {"sample1", "sample2", "sample3", "sample4"}, samples.get());
   }
 
+  @Test
+  public void testDictionaryEncodedOption() {
+    HashMap<String, String> optionMap = new HashMap<>();
+    optionMap.put("dictionary_encoded", "sampleName, contig");
+    VCFDataSourceOptions options = new VCFDataSourceOptions(new DataSourceOptions(optionMap));
+    Optional<String[]> fields = options.getDictionaryEncoded();
+    Assert.assertTrue(fields.isPresent());
+    Assert.assertArrayEquals(new String[] {"sampleName", "contig"}, fields.get());
+  }
+
+  @Test
+  public void testBatchNumRecordsOption() {
+    HashMap<String, String> optionMap = new HashMap<>();
+    optionMap.put("batch_num_records", "1000");
+    VCFDataSourceOptions options = new VCFDataSourceOptions(new DataSourceOptions(optionMap));
+    Optional<Long> batchNumRecords = options.getBatchNumRecords();
+    Assert.assertTrue(batchNumRecords.isPresent());
+    Assert.assertEquals(1000L, (long) batchNumRecords.get());
+  }
+
   @Test
   public void testRangesOptionMissing() {
     VCFDataSourceOptions options = new VCFDataSourceOptions(new DataSourceOptions(new HashMap<>()));
@@ -668,6 +668,50 @@ public class VCFDatasourceTest extends SharedJavaSparkSession {
     }
   }
 
+  @Test
+  public void testDictionaryEncoded() {
+    Dataset<Row> dfRead =
+        session()
+            .read()
+            .format("io.tiledb.vcf")
+            .option("uri", testSampleGroupURI("ingested_2samples"))
+            .option("samples", "HG01762,HG00280")
+            .option("ranges", "1:12100-13360,1:13500-17350")
+            .option("dictionary_encoded", "sampleName,contig,alleles")
+            .load();
+    List<Row> rows = dfRead.select("sampleName", "contig", "alleles").collectAsList();
+    List<Row> expectedRows =
+        testSampleDataset().select("sampleName", "contig", "alleles").collectAsList();
+    Assert.assertEquals(10, rows.size());
+    for (int i = 0; i < rows.size(); i++) {
+      Assert.assertEquals(expectedRows.get(i).getString(0), rows.get(i).getString(0));
+      Assert.assertEquals(expectedRows.get(i).getString(1), rows.get(i).getString(1));
+      Assert.assertEquals(expectedRows.get(i).getList(2), rows.get(i).getList(2));
+    }
+  }
+
+  @Test
+  public void testBatchNumRecords() {
+    Dataset<Row> dfRead =
+        session()
+            .read()
+            .format("io.tiledb.vcf")
+            .option("uri", testSampleGroupURI("ingested_2samples"))
+            .option("samples", "HG01762,HG00280")
+            .option("ranges", "1:12100-13360,1:13500-17350")
+            .option("batch_num_records", "3")
+            .load();
+    List<Row> rows = dfRead.select("sampleName", "contig", "posStart").collectAsList();
+    List<Row> expectedRows =
+        testSampleDataset().select("sampleName", "contig", "posStart").collectAsList();
+    Assert.assertEquals(10, rows.size());
+    for (int i = 0; i < rows.size(); i++) {
+      Assert.assertEquals(expectedRows.get(i).getString(0), rows.get(i).getString(0));
+      Assert.assertEquals(expectedRows.get(i).getString(1), rows.get(i).getString(1));
+      Assert.assertEquals(expectedRows.get(i).getInt(2), rows.get(i).getInt(2));
+    }
+  }
+
   @Test
   public void testFilter() {
     Dataset<Row> dfRead = testSampleDataset();
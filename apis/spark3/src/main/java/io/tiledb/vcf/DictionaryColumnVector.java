@@ -0,0 +1,154 @@
+package io.tiledb.vcf;
+
+import org.apache.arrow.vector.IntVector;
+import org.apache.arrow.vector.ValueVector;
+import org.apache.arrow.vector.VarCharVector;
+import org.apache.arrow.vector.complex.ListVector;
+import org.apache.arrow.vector.holders.NullableVarCharHolder;
+import org.apache.spark.sql.types.DataTypes;
+import org.apache.spark.sql.types.Decimal;
+import org.apache.spark.sql.vectorized.ColumnVector;
+import org.apache.spark.sql.vectorized.ColumnarArray;
+import org.apache.spark.sql.vectorized.ColumnarMap;
+import org.apache.spark.unsafe.types.UTF8String;
+
+/**
+ * A Spark string column read from TileDB-VCF as int32 indices into a dictionary of strings. A
+ * column of string lists (alleles) is read as a list of indices per row.
+ */
+public class DictionaryColumnVector extends ColumnVector {
+  /** Indices of the rows: an IntVector, or a ListVector of int32 for list columns. */
+  private final ValueVector indices;
+
+  /** Dictionary holding the strings the indices refer to. */
+  private final VarCharVector dictionary;
+
+  /** For list columns, the column of the list elements. */
+  private final DictionaryColumnVector elements;
+
+  /** Whether closing this column closes the vectors, false for the elements column. */
+  private final boolean owner;
+
+  /** Reusable holder of a dictionary string. */
+  private final NullableVarCharHolder stringResult = new NullableVarCharHolder();
+
+  /** Creates a string column from the given indices and dictionary. */
+  public DictionaryColumnVector(IntVector indices, VarCharVector dictionary) {
+    this(indices, dictionary, true);
+  }
+
+  /** Creates a column of string lists from the given lists of indices and dictionary. */
+  public DictionaryColumnVector(ListVector indices, VarCharVector dictionary) {
+    super(DataTypes.createArrayType(DataTypes.StringType, false));
+    this.indices = indices;
+    this.dictionary = dictionary;
+    this.elements =
+        new DictionaryColumnVector((IntVector) indices.getDataVector(), dictionary, false);
+    this.owner = true;
+  }
+
+  private DictionaryColumnVector(IntVector indices, VarCharVector dictionary, boolean owner) {
+    super(DataTypes.StringType);
+    this.indices = indices;
+    this.dictionary = dictionary;
+    this.elements = null;
+    this.owner = owner;
+  }
+
+  @Override
+  public void close() {
+    if (owner) {
+      indices.close();
+      dictionary.close();
+    }
+  }
+
+  @Override
+  public boolean hasNull() {
+    return false;
+  }
+
+  @Override
+  public int numNulls() {
+    return 0;
+  }
+
+  @Override
+  public boolean isNullAt(int rowId) {
+    return false;
+  }
+
+  @Override
+  public UTF8String getUTF8String(int rowId) {
+    int index = ((IntVector) indices).get(rowId);
+    dictionary.get(index, stringResult);
+    return UTF8String.fromAddress(
+        null,
+        stringResult.buffer.memoryAddress() + stringResult.start,
+        stringResult.end - stringResult.start);
+  }
+
+  @Override
+  public ColumnarArray getArray(int rowId) {
+    if (elements == null) throw new UnsupportedOperationException();
+    ListVector lv = (ListVector) indices;
+    int start = lv.getOffsetBuffer().getInt(rowId * ListVector.OFFSET_WIDTH);
+    int end = lv.getOffsetBuffer().getInt((rowId + 1) * ListVector.OFFSET_WIDTH);
+    return new ColumnarArray(elements, start, end - start);
+  }
+
+  @Override
+  public boolean getBoolean(int rowId) {
+    throw new UnsupportedOperationException();
+  }
+
+  @Override
+  public byte getByte(int rowId) {
+    throw new UnsupportedOperationException();
+  }
+
+  @Override
+  public short getShort(int rowId) {
+    throw new UnsupportedOperationException();
+  }
+
+  @Override
+  public int getInt(int rowId) {
+    throw new UnsupportedOperationException();
+  }
+
+  @Override
+  public long getLong(int rowId) {
+    throw new UnsupportedOperationException();
+  }
+
+  @Override
+  public float getFloat(int rowId) {
+    throw new UnsupportedOperationException();
+  }
+
+  @Override
+  public double getDouble(int rowId) {
+    throw new UnsupportedOperationException();
+  }
+
+  @Override
+  public ColumnarMap getMap(int ordinal) {
+    throw new UnsupportedOperationException();
+  }
+
+  @Override
+  public Decimal getDecimal(int rowId, int precision, int scale) {
+    throw new UnsupportedOperationException();
+  }
+
+  @Override
+  public byte[] getBinary(int rowId) {
+    throw new UnsupportedOperationException();
+  }
+
+  @Override
+  public ColumnVector getChild(int ordinal) {
+    throw new UnsupportedOperationException();
+  }
+}
@@ -6,8 +6,11 @@ import io.tiledb.util.CredentialProviderUtils;
 import java.net.URI;
 import java.nio.ByteBuffer;
 import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashSet;
 import java.util.List;
 import java.util.Optional;
+import java.util.Set;
 import org.apache.arrow.memory.ArrowBuf;
 import org.apache.arrow.memory.RootAllocator;
 import org.apache.arrow.vector.Float4Vector;
@@ -52,7 +55,10 @@ public class VCFPartitionReader implements PartitionReader<ColumnarBatch> {
   private VCFReader vcfReader;
 
   /** List of the allocated Arrow vectors used to hold columnar data. */
-  private List<ArrowColumnVector> arrowVectors;
+  private List<ColumnVector> arrowVectors;
+
+  /** Names of the TileDB-VCF attributes read as dictionary-encoded columns. */
+  private Set<String> dictionaryAttributes;
 
   /** The current batch of results. */
   private ColumnarBatch resultBatch;
@@ -103,6 +109,7 @@ public class VCFPartitionReader implements PartitionReader<ColumnarBatch> {
     this.datasetURI = uri;
     this.schema = schema;
     this.arrowVectors = new ArrayList<>();
+    this.dictionaryAttributes = new HashSet<>();
     this.options = options;
     this.rangePartitionInfo = rangePartitionInfo;
     this.samplePartitionInfo = samplePartitionInfo;
@@ -249,7 +256,7 @@ public class VCFPartitionReader implements PartitionReader<ColumnarBatch> {
   /** Closes any allocated Arrow vectors and clears the list. */
   private void releaseArrowVectors() {
     if (arrowVectors != null) {
-      for (ArrowColumnVector v : arrowVectors) v.close();
+      for (ColumnVector v : arrowVectors) v.close();
       arrowVectors.clear();
     }
   }
@@ -370,8 +377,14 @@ public class VCFPartitionReader implements PartitionReader<ColumnarBatch> {
     StructField[] sparkFields = schema.getSparkFields();
     String[] attrNames = schema.getVCFAttributes();
     int numColumns = schema.getNumColumns();
+    Set<String> dictionaryFields =
+        new HashSet<>(Arrays.asList(options.getDictionaryEncoded().orElse(new String[0])));
     int nBuffers = 0;
     for (int idx = 0; idx < numColumns; idx++) {
+      if (dictionaryFields.contains(sparkFields[idx].name())) {
+        vcfReader.setDictionaryEncoding(attrNames[idx], true);
+        dictionaryAttributes.add(attrNames[idx]);
+      }
       nBuffers += numBuffersForField(attrNames[idx]);
     }
 
@@ -440,6 +453,12 @@ public class VCFPartitionReader implements PartitionReader<ColumnarBatch> {
     // Set the VCF c++ memory budget to 2/3rds of total budget
     vcfReader.setMemoryBudget(Util.longToInt(vcfMemBudgetMB));
 
+    // Cap the number of records read into each batch, if specified.
+    Optional<Long> batchNumRecords = options.getBatchNumRecords();
+    if (batchNumRecords.isPresent()) {
+      vcfReader.setBatchNumRecords(batchNumRecords.get());
+    }
+
     if (enableStatsLogging) {
       log.info(
           "STATS Partition "
@@ -528,6 +547,30 @@ public class VCFPartitionReader implements PartitionReader<ColumnarBatch> {
       }
     }
 
+    // Read dictionary-encoded attributes as indices into a dictionary of strings.
+    if (dictionaryAttributes.contains(attrName)) {
+      VarCharVector dictionary =
+          new VarCharVector(fieldName + "_dictionary", ArrowUtils.rootAllocator());
+      dictionary.setInitialCapacity(maxNumRows);
+      dictionary.allocateNew();
+      ArrowBuf dictionaryBitmap = dictionary.getValidityBuffer();
+      int nbytes = (int) dictionaryBitmap.capacity();
+      for (int i = 0; i < nbytes; i++) {
+        dictionaryBitmap.setByte(i, 0xff);
+      }
+      ArrowBuf dictionaryData = dictionary.getDataBuffer();
+      ArrowBuf dictionaryOffsets = dictionary.getOffsetBuffer();
+      vcfReader.setBufferDictionaryValues(
+          attrName, dictionaryData.nioBuffer(0, (int) dictionaryData.capacity()));
+      vcfReader.setBufferDictionaryOffsets(
+          attrName, dictionaryOffsets.nioBuffer(0, (int) dictionaryOffsets.capacity()));
+
+      if (valueVector instanceof ListVector)
+        this.arrowVectors.add(new DictionaryColumnVector((ListVector) valueVector, dictionary));
+      else this.arrowVectors.add(new DictionaryColumnVector((IntVector) valueVector, dictionary));
+      return;
+    }
+
     this.arrowVectors.add(new ArrowColumnVector(valueVector));
   }
 
@@ -611,6 +654,7 @@ public class VCFPartitionReader implements PartitionReader<ColumnarBatch> {
     numBuffers += info.isVarLen ? 1 : 0; // Offsets buffer
     numBuffers += info.isNullable ? 1 : 0; // Nullable bitmap
     numBuffers += info.isList ? 1 : 0; // List offsets bitmap
+    numBuffers += dictionaryAttributes.contains(attrName) ? 2 : 0; // Dictionary buffers
     return numBuffers;
   }
 }
@@ -0,0 +1,511 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+#include "c_api/arrow_stream.h"
+
+namespace tiledb {
+namespace vcf {
+
+namespace {
+
+/** Private data of an exported schema. */
+struct SchemaData {
+  std::string format;
+  std::string name;
+  std::vector<ArrowSchema> children;
+  std::vector<ArrowSchema*> child_ptrs;
+  ArrowSchema dictionary{};
+};
+
+/** Private data of an exported array. */
+struct ArrayData {
+  /** Keeps the buffers of the batch alive. */
+  std::shared_ptr<void> owner;
+  std::vector<const void*> buffers;
+  std::vector<ArrowArray> children;
+  std::vector<ArrowArray*> child_ptrs;
+  ArrowArray dictionary{};
+};
+
+void release_schema(ArrowSchema* schema) {
+  auto data = static_cast<SchemaData*>(schema->private_data);
+  for (ArrowSchema* child : data->child_ptrs) {
+    if (child->release != nullptr)
+      child->release(child);
+  }
+  if (data->dictionary.release != nullptr)
+    data->dictionary.release(&data->dictionary);
+  delete data;
+  schema->release = nullptr;
+}
+
+void release_array(ArrowArray* array) {
+  auto data = static_cast<ArrayData*>(array->private_data);
+  for (ArrowArray* child : data->child_ptrs) {
+    if (child->release != nullptr)
+      child->release(child);
+  }
+  if (data->dictionary.release != nullptr)
+    data->dictionary.release(&data->dictionary);
+  delete data;
+  array->release = nullptr;
+}
+
+/**
+ * Initializes a (nullable) schema node with the given number of children, to
+ * be initialized by the caller.
+ */
+SchemaData* init_schema(
+    ArrowSchema* out,
+    const std::string& format,
+    const std::string& name,
+    size_t num_children) {
+  auto data = new SchemaData;
+  data->format = format;
+  data->name = name;
+  // Value-initialized children have a null release callback until set.
+  data->children.resize(num_children);
+  for (ArrowSchema& child : data->children)
+    data->child_ptrs.push_back(&child);
+
+  out->format = data->format.c_str();
+  out->name = data->name.c_str();
+  out->metadata = nullptr;
+  out->flags = ARROW_FLAG_NULLABLE;
+  out->n_children = num_children;
+  out->children = data->child_ptrs.data();
+  out->dictionary = nullptr;
+  out->release = release_schema;
+  out->private_data = data;
+  return data;
+}
+
+/**
+ * Initializes an array node with the given buffers and number of children, to
+ * be initialized by the caller.
+ */
+ArrayData* init_array(
+    ArrowArray* out,
+    const std::shared_ptr<void>& owner,
+    int64_t length,
+    int64_t null_count,
+    std::vector<const void*> buffers,
+    size_t num_children) {
+  auto data = new ArrayData;
+  data->owner = owner;
+  data->buffers = std::move(buffers);
+  data->children.resize(num_children);
+  for (ArrowArray& child : data->children)
+    data->child_ptrs.push_back(&child);
+
+  out->length = length;
+  out->null_count = null_count;
+  out->offset = 0;
+  out->n_buffers = data->buffers.size();
+  out->n_children = num_children;
+  out->buffers = data->buffers.data();
+  out->children = data->child_ptrs.data();
+  out->dictionary = nullptr;
+  out->release = release_array;
+  out->private_data = data;
+  return data;
+}
+
+/** Returns the innermost (values) node of a schema. */
+ArrowSchema* values_node(ArrowSchema* schema) {
+  while (schema->n_children > 0)
+    schema = schema->children[0];
+  return schema;
+}
+
+/** Returns the innermost (values) node of an array. */
+ArrowArray* values_node(ArrowArray* array) {
+  while (array->n_children > 0)
+    array = array->children[0];
+  return array;
+}
+
+/** Returns the Arrow format string of values of the given datatype. */
+std::string arrow_format(AttrDatatype datatype) {
+  switch (datatype) {
+    case AttrDatatype::CHAR:
+      return "u";
+    case AttrDatatype::UINT8:
+      return "C";
+    case AttrDatatype::INT32:
+      return "i";
+    case AttrDatatype::FLOAT32:
+      return "f";
+    default:
+      throw std::runtime_error(
+          "Error exporting Arrow stream; unknown datatype.");
+  }
+}
+
+}  // namespace
+
+ArrowStream::ArrowStream(Reader* reader)
+    : reader_(reader)
+    , done_(false) {
+  int32_t num_buffers = 0;
+  reader_->num_buffers(&num_buffers);
+  if (num_buffers == 0)
+    throw std::runtime_error(
+        "Error exporting Arrow stream; no buffers set on the reader.");
+
+  for (int32_t i = 0; i < num_buffers; i++) {
+    Column column;
+    const char* name = nullptr;
+    reader_->get_buffer_values(i, &name, &column.user_data);
+    reader_->get_buffer_offsets(i, &name, &column.user_offsets);
+    reader_->get_buffer_list_offsets(i, &name, &column.user_list_offsets);
+    reader_->get_buffer_validity_bitmap(i, &name, &column.user_bitmap);
+    reader_->get_buffer_sizes(
+        i,
+        &column.data_bytes,
+        &column.offsets_bytes,
+        &column.list_offsets_bytes,
+        &column.bitmap_bytes);
+    column.user_data_bytes = column.data_bytes;
+    column.user_offsets_bytes = column.offsets_bytes;
+    column.user_list_offsets_bytes = column.list_offsets_bytes;
+    column.user_bitmap_bytes = column.bitmap_bytes;
+    column.name = name;
+    reader_->attribute_datatype(
+        column.name,
+        &column.datatype,
+        &column.var_len,
+        &column.nullable,
+        &column.list);
+    column.dictionary = reader_->dictionary_encoding(column.name);
+    reader_->get_buffer_dictionary(
+        i,
+        &column.dict_data,
+        &column.dict_data_bytes,
+        &column.dict_offsets,
+        &column.dict_offsets_bytes);
+
+    if (column.user_data == nullptr ||
+        (column.var_len && column.user_offsets == nullptr) ||
+        (column.list && column.user_list_offsets == nullptr) ||
+        (column.nullable && column.user_bitmap == nullptr) ||
+        (column.dictionary &&
+         (column.dict_data == nullptr || column.dict_offsets == nullptr)))
+      throw std::runtime_error(
+          "Error exporting Arrow stream; missing buffer for attribute '" +
+          column.name + "'.");
+    columns_.push_back(column);
+  }
+}
+
+ArrowStream::~ArrowStream() {
+  // Set the reader's own buffers back.
+  try {
+    for (const Column& column : columns_) {
+      reader_->set_buffer_values(
+          column.name, column.user_data, column.user_data_bytes);
+      if (column.var_len)
+        reader_->set_buffer_offsets(
+            column.name, column.user_offsets, column.user_offsets_bytes);
+      if (column.list)
+        reader_->set_buffer_list_offsets(
+            column.name,
+            column.user_list_offsets,
+            column.user_list_offsets_bytes);
+      if (column.nullable)
+        reader_->set_buffer_validity_bitmap(
+            column.name, column.user_bitmap, column.user_bitmap_bytes);
+      if (column.dictionary) {
+        reader_->set_buffer_dictionary_values(
+            column.name, column.dict_data, column.dict_data_bytes);
+        reader_->set_buffer_dictionary_offsets(
+            column.name, column.dict_offsets, column.dict_offsets_bytes);
+      }
+    }
+  } catch (const std::exception&) {
+  }
+}
+
+void ArrowStream::export_stream(Reader* reader, ArrowArrayStream* stream) {
+  auto arrow_stream = new ArrowStream(reader);
+  stream->get_schema = get_schema;
+  stream->get_next = get_next;
+  stream->get_last_error = get_last_error;
+  stream->release = release;
+  stream->private_data = arrow_stream;
+}
+
+void ArrowStream::export_schema(ArrowSchema* out) const {
+  SchemaData* data = init_schema(out, "+s", "", columns_.size());
+  try {
+    for (size_t i = 0; i < columns_.size(); i++) {
+      const Column& column = columns_[i];
+      ArrowSchema* child = &data->children[i];
+      const std::string format = arrow_format(column.datatype);
+      std::string name = column.name;
+      if (column.list) {
+        // The records are lists of cells.
+        child = &init_schema(child, "+l", name, 1)->children[0];
+        name = "item";
+      }
+      if (column.var_len && column.datatype != AttrDatatype::CHAR) {
+        // The cells are lists of values.
+        child = &init_schema(child, "+l", name, 1)->children[0];
+        name = "item";
+      }
+      init_schema(child, format, name, 0);
+      if (column.dictionary) {
+        // The values are indices into a dictionary of strings.
+        ArrowSchema* values = values_node(&data->children[i]);
+        auto values_data = static_cast<SchemaData*>(values->private_data);
+        init_schema(&values_data->dictionary, "u", "", 0);
+        values->dictionary = &values_data->dictionary;
+      }
+    }
+  } catch (...) {
+    out->release(out);
+    throw;
+  }
+}
+
+std::shared_ptr<ArrowStream::BatchBuffers> ArrowStream::alloc_batch_buffers() {
+  auto buffers = std::make_shared<BatchBuffers>();
+  auto alloc = [&buffers](int64_t bytes) {
+    // The reader rejects null buffers, even when empty.
+    buffers->allocations.emplace_back(new char[std::max<int64_t>(bytes, 1)]);
+    return buffers->allocations.back().get();
+  };
+
+  const uint64_t batch_num_records = reader_->batch_num_records();
+  for (Column& column : columns_) {
+    // Size the buffers from the records of the previous batch.
+    if (batch_num_records > 0)
+      reader_->buffer_size_estimate(
+          column.name,
+          batch_num_records,
+          &column.data_bytes,
+          &column.offsets_bytes,
+          &column.list_offsets_bytes,
+          &column.bitmap_bytes);
+
+    void* data = alloc(column.data_bytes);
+    int32_t* offsets = nullptr;
+    int32_t* list_offsets = nullptr;
+    uint8_t* bitmap = nullptr;
+    reader_->set_buffer_values(column.name, data, column.data_bytes);
+    if (column.var_len) {
+      offsets = reinterpret_cast<int32_t*>(alloc(column.offsets_bytes));
+      reader_->set_buffer_offsets(column.name, offsets, column.offsets_bytes);
+    }
+    if (column.list) {
+      list_offsets =
+          reinterpret_cast<int32_t*>(alloc(column.list_offsets_bytes));
+      reader_->set_buffer_list_offsets(
+          column.name, list_offsets, column.list_offsets_bytes);
+    }
+    if (column.nullable) {
+      bitmap = reinterpret_cast<uint8_t*>(alloc(column.bitmap_bytes));
+      reader_->set_buffer_validity_bitmap(
+          column.name, bitmap, column.bitmap_bytes);
+    }
+    char* dict_data = nullptr;
+    int32_t* dict_offsets = nullptr;
+    if (column.dictionary) {
+      dict_data = alloc(column.dict_data_bytes);
+      dict_offsets =
+          reinterpret_cast<int32_t*>(alloc(column.dict_offsets_bytes));
+      reader_->set_buffer_dictionary_values(
+          column.name, dict_data, column.dict_data_bytes);
+      reader_->set_buffer_dictionary_offsets(
+          column.name, dict_offsets, column.dict_offsets_bytes);
+    }
+    buffers->data.push_back(data);
+    buffers->offsets.push_back(offsets);
+    buffers->list_offsets.push_back(list_offsets);
+    buffers->bitmap.push_back(bitmap);
+    buffers->dict_data.push_back(dict_data);
+    buffers->dict_offsets.push_back(dict_offsets);
+  }
+
+  return buffers;
+}
+
+void ArrowStream::export_next(ArrowArray* out) {
+  out->release = nullptr;
+  if (done_)
+    return;
+
+  auto buffers = alloc_batch_buffers();
+  reader_->read();
+  const ReadStatus status = reader_->read_status();
+  if (status == ReadStatus::FAILED)
+    throw std::runtime_error("Error exporting Arrow stream; read failed.");
+  done_ = status != ReadStatus::INCOMPLETE;
+
+  const int64_t num_records = reader_->num_records_exported();
+  if (num_records == 0) {
+    if (!done_)
+      throw std::runtime_error(
+          "Error exporting Arrow stream; buffers are too small to hold a "
+          "single record.");
+    return;
+  }
+
+  ArrayData* data = init_array(
+      out, buffers, num_records, 0, {nullptr}, columns_.size());
+  try {
+    for (size_t i = 0; i < columns_.size(); i++) {
+      export_column(buffers, i, num_records, &data->children[i]);
+      if (columns_[i].dictionary)
+        export_dictionary(buffers, i, &data->children[i]);
+    }
+  } catch (...) {
+    out->release(out);
+    throw;
+  }
+}
+
+void ArrowStream::export_column(
+    const std::shared_ptr<BatchBuffers>& buffers,
+    size_t column_idx,
+    int64_t num_records,
+    ArrowArray* out) const {
+  const Column& column = columns_[column_idx];
+  int64_t num_offsets = 0, num_data_elements = 0, num_data_bytes = 0;
+  reader_->result_size(
+      column.name, &num_offsets, &num_data_elements, &num_data_bytes);
+
+  const void* data = buffers->data[column_idx];
+  const void* offsets = buffers->offsets[column_idx];
+  const void* list_offsets = buffers->list_offsets[column_idx];
+  const void* bitmap = buffers->bitmap[column_idx];
+  const int64_t null_count = column.nullable ? -1 : 0;
+  const int64_t num_cells = num_offsets == 0 ? 0 : num_offsets - 1;
+
+  if (!column.var_len) {
+    init_array(out, buffers, num_records, null_count, {bitmap, data}, 0);
+    return;
+  }
+
+  if (column.list) {
+    // The records are lists of cells.
+    ArrayData* list = init_array(
+        out, buffers, num_records, null_count, {bitmap, list_offsets}, 1);
+    out = &list->children[0];
+    bitmap = nullptr;
+  }
+
+  if (column.datatype == AttrDatatype::CHAR) {
+    init_array(
+        out,
+        buffers,
+        column.list ? num_cells : num_records,
+        column.list ? 0 : null_count,
+        {bitmap, offsets, data},
+        0);
+  } else {
+    ArrayData* cells = init_array(
+        out,
+        buffers,
+        column.list ? num_cells : num_records,
+        column.list ? 0 : null_count,
+        {bitmap, offsets},
+        1);
+    init_array(
+        &cells->children[0],
+        buffers,
+        num_data_elements,
+        0,
+        {nullptr, data},
+        0);
+  }
+}
+
+void ArrowStream::export_dictionary(
+    const std::shared_ptr<BatchBuffers>& buffers,
+    size_t column_idx,
+    ArrowArray* out) const {
+  const Column& column = columns_[column_idx];
+  int64_t num_offsets = 0, num_data_bytes = 0;
+  reader_->dictionary_result_size(column.name, &num_offsets, &num_data_bytes);
+  int32_t* offsets = buffers->dict_offsets[column_idx];
+  const int64_t num_entries = num_offsets == 0 ? 0 : num_offsets - 1;
+  if (num_entries == 0)
+    offsets[0] = 0;
+
+  // The values are indices into the dictionary, a string array.
+  ArrowArray* values = values_node(out);
+  auto values_data = static_cast<ArrayData*>(values->private_data);
+  init_array(
+      &values_data->dictionary,
+      buffers,
+      num_entries,
+      0,
+      {nullptr, offsets, buffers->dict_data[column_idx]},
+      0);
+  values->dictionary = &values_data->dictionary;
+}
+
+int ArrowStream::get_schema(ArrowArrayStream* stream, ArrowSchema* out) {
+  auto arrow_stream = static_cast<ArrowStream*>(stream->private_data);
+  try {
+    arrow_stream->export_schema(out);
+  } catch (const std::exception& e) {
+    arrow_stream->last_error_ = e.what();
+    return EINVAL;
+  }
+  return 0;
+}
+
+int ArrowStream::get_next(ArrowArrayStream* stream, ArrowArray* out) {
+  auto arrow_stream = static_cast<ArrowStream*>(stream->private_data);
+  try {
+    arrow_stream->export_next(out);
+  } catch (const std::exception& e) {
+    arrow_stream->last_error_ = e.what();
+    return EIO;
+  }
+  return 0;
+}
+
+const char* ArrowStream::get_last_error(ArrowArrayStream* stream) {
+  auto arrow_stream = static_cast<ArrowStream*>(stream->private_data);
+  if (arrow_stream->last_error_.empty())
+    return nullptr;
+  return arrow_stream->last_error_.c_str();
+}
+
+void ArrowStream::release(ArrowArrayStream* stream) {
+  delete static_cast<ArrowStream*>(stream->private_data);
+  stream->release = nullptr;
+}
+
+}  // namespace vcf
+}  // namespace tiledb
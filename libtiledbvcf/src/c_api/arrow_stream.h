@@ -0,0 +1,177 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TILEDB_VCF_ARROW_STREAM_H
+#define TILEDB_VCF_ARROW_STREAM_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "c_api/tiledbvcf.h"
+#include "read/reader.h"
+
+namespace tiledb {
+namespace vcf {
+
+/**
+ * Producer of an Arrow C stream (ArrowArrayStream) of the results of a Reader.
+ *
+ * Every batch is read into a new set of buffers. The exported arrays take over
+ * these buffers, which are freed once all the arrays of the batch have been
+ * released, so consumers can keep a batch while reading the next ones.
+ *
+ * Dictionary-encoded columns are exported as dictionary arrays, each batch
+ * carrying its own dictionary.
+ *
+ * The first batch uses the sizes of the buffers set on the reader. If the
+ * reader has a number of records per batch, the buffers of the next batches
+ * are sized from the bytes per record of the previous batch, growing the
+ * buffers that overflowed, so batches hold that many records; otherwise all
+ * batches use the sizes of the first one.
+ */
+class ArrowStream {
+ public:
+  /**
+   * Initializes the given stream to export the results of the reader. The
+   * stream owns the new ArrowStream, which is deleted by its release callback.
+   *
+   * @param reader Reader whose results to export; must outlive the stream
+   * @param stream Stream to initialize
+   */
+  static void export_stream(Reader* reader, ArrowArrayStream* stream);
+
+  /** Destructor; sets the reader's own buffers back. */
+  ~ArrowStream();
+
+ private:
+  /** An attribute exported by the stream. */
+  struct Column {
+    std::string name;
+    AttrDatatype datatype = AttrDatatype::UINT8;
+    bool var_len = false;
+    bool nullable = false;
+    bool list = false;
+    bool dictionary = false;
+
+    /** Sizes (in bytes) of the buffers of the next batch. */
+    int64_t data_bytes = 0;
+    int64_t offsets_bytes = 0;
+    int64_t list_offsets_bytes = 0;
+    int64_t bitmap_bytes = 0;
+
+    /** Buffers that were set on the reader, or null if not set. */
+    void* user_data = nullptr;
+    int32_t* user_offsets = nullptr;
+    int32_t* user_list_offsets = nullptr;
+    uint8_t* user_bitmap = nullptr;
+
+    /** Sizes (in bytes) of the buffers that were set on the reader. */
+    int64_t user_data_bytes = 0;
+    int64_t user_offsets_bytes = 0;
+    int64_t user_list_offsets_bytes = 0;
+    int64_t user_bitmap_bytes = 0;
+
+    /**
+     * Dictionary buffers set on the reader, for dictionary-encoded columns,
+     * and their sizes (in bytes), also used for every batch.
+     */
+    char* dict_data = nullptr;
+    int32_t* dict_offsets = nullptr;
+    int64_t dict_data_bytes = 0;
+    int64_t dict_offsets_bytes = 0;
+  };
+
+  /** The buffers of a batch, shared by all arrays of the batch. */
+  struct BatchBuffers {
+    /** Allocations backing the buffers. */
+    std::vector<std::unique_ptr<char[]>> allocations;
+
+    /** Per column, the values/offsets/list offsets/bitmap buffers. */
+    std::vector<void*> data;
+    std::vector<int32_t*> offsets;
+    std::vector<int32_t*> list_offsets;
+    std::vector<uint8_t*> bitmap;
+
+    /** Per column, the dictionary values/offsets buffers, or null. */
+    std::vector<char*> dict_data;
+    std::vector<int32_t*> dict_offsets;
+  };
+
+  /** The reader. */
+  Reader* reader_;
+
+  /** The exported attributes, in buffer order. */
+  std::vector<Column> columns_;
+
+  /** True once the read is complete. */
+  bool done_;
+
+  /** Message of the last error. */
+  std::string last_error_;
+
+  /** Constructor; captures the buffers set on the reader. */
+  explicit ArrowStream(Reader* reader);
+
+  /** Exports the schema of the batches. */
+  void export_schema(ArrowSchema* out) const;
+
+  /**
+   * Reads the next batch and exports it, or sets out->release to null at the
+   * end of the stream.
+   */
+  void export_next(ArrowArray* out);
+
+  /**
+   * Sizes and allocates the buffers of the next batch, and sets them on the
+   * reader.
+   */
+  std::shared_ptr<BatchBuffers> alloc_batch_buffers();
+
+  /** Exports a column of a batch. */
+  void export_column(
+      const std::shared_ptr<BatchBuffers>& buffers,
+      size_t column_idx,
+      int64_t num_records,
+      ArrowArray* out) const;
+
+  /** Exports the dictionary of a dictionary-encoded column of a batch. */
+  void export_dictionary(
+      const std::shared_ptr<BatchBuffers>& buffers,
+      size_t column_idx,
+      ArrowArray* out) const;
+
+  /** Stream callbacks. */
+  static int get_schema(ArrowArrayStream* stream, ArrowSchema* out);
+  static int get_next(ArrowArrayStream* stream, ArrowArray* out);
+  static const char* get_last_error(ArrowArrayStream* stream);
+  static void release(ArrowArrayStream* stream);
+};
+
+}  // namespace vcf
+}  // namespace tiledb
+
+#endif  // TILEDB_VCF_ARROW_STREAM_H
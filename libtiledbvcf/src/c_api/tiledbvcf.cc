@@ -31,6 +31,7 @@
  */
 
 #include "c_api/tiledbvcf.h"
+#include "c_api/arrow_stream.h"
 #include "read/reader.h"
 #include "utils/logger_public.h"
 #include "utils/utils.h"
@@ -349,6 +350,53 @@ int32_t tiledb_vcf_reader_set_buffer_validity_bitmap(
   return TILEDB_VCF_OK;
 }
 
+int32_t tiledb_vcf_reader_set_dictionary_encoding(
+    tiledb_vcf_reader_t* reader, const char* attribute, int32_t dictionary) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader,
+          reader->reader_->set_dictionary_encoding(attribute, dictionary != 0)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_set_buffer_dictionary_values(
+    tiledb_vcf_reader_t* reader,
+    const char* attribute,
+    int64_t buff_size,
+    char* buff) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader,
+          reader->reader_->set_buffer_dictionary_values(
+              attribute, buff, buff_size)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_set_buffer_dictionary_offsets(
+    tiledb_vcf_reader_t* reader,
+    const char* attribute,
+    int64_t buff_size,
+    int32_t* buff) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader,
+          reader->reader_->set_buffer_dictionary_offsets(
+              attribute, buff, buff_size)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
 int32_t tiledb_vcf_reader_set_memory_budget(
     tiledb_vcf_reader_t* reader, int32_t memory_mb) {
   if (sanity_check(reader) == TILEDB_VCF_ERR)
@@ -372,6 +420,53 @@ int32_t tiledb_vcf_reader_set_max_num_records(
   return TILEDB_VCF_OK;
 }
 
+int32_t tiledb_vcf_reader_set_batch_num_records(
+    tiledb_vcf_reader_t* reader, int64_t num_records) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (num_records < 0) {
+    save_error(
+        reader,
+        "Error setting batch number of records; number must not be "
+        "negative.");
+    return TILEDB_VCF_ERR;
+  }
+
+  if (SAVE_ERROR_CATCH(
+          reader, reader->reader_->set_batch_num_records(num_records)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_get_buffer_size_estimate(
+    tiledb_vcf_reader_t* reader,
+    const char* attribute,
+    int64_t num_records,
+    int64_t* data_bytes,
+    int64_t* offsets_bytes,
+    int64_t* list_offsets_bytes,
+    int64_t* bitmap_bytes) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || attribute == nullptr ||
+      num_records < 0 || data_bytes == nullptr || offsets_bytes == nullptr ||
+      list_offsets_bytes == nullptr || bitmap_bytes == nullptr)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader,
+          reader->reader_->buffer_size_estimate(
+              attribute,
+              num_records,
+              data_bytes,
+              offsets_bytes,
+              list_offsets_bytes,
+              bitmap_bytes)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
 int32_t tiledb_vcf_reader_set_tiledb_config(
     tiledb_vcf_reader_t* reader, const char* config) {
   if (sanity_check(reader) == TILEDB_VCF_ERR)
@@ -454,6 +549,19 @@ int32_t tiledb_vcf_reader_read(tiledb_vcf_reader_t* reader) {
   return TILEDB_VCF_OK;
 }
 
+int32_t tiledb_vcf_reader_read_arrow_stream(
+    tiledb_vcf_reader_t* reader, struct ArrowArrayStream* stream) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || stream == nullptr)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader,
+          ArrowStream::export_stream(reader->reader_.get(), stream)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
 int32_t tiledb_vcf_reader_get_status(
     tiledb_vcf_reader_t* reader, tiledb_vcf_read_status_t* status) {
   if (sanity_check(reader) == TILEDB_VCF_ERR || status == nullptr)
@@ -493,6 +601,23 @@ int32_t tiledb_vcf_reader_get_result_size(
   return TILEDB_VCF_OK;
 }
 
+int32_t tiledb_vcf_reader_get_dictionary_result_size(
+    tiledb_vcf_reader_t* reader,
+    const char* attribute,
+    int64_t* num_offsets,
+    int64_t* num_data_bytes) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader,
+          reader->reader_->dictionary_result_size(
+              attribute, num_offsets, num_data_bytes)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
 int32_t tiledb_vcf_reader_get_num_buffers(
     tiledb_vcf_reader_t* reader, int32_t* num_buffers) {
   if (sanity_check(reader) == TILEDB_VCF_ERR || num_buffers == nullptr)
@@ -593,6 +718,17 @@ int32_t tiledb_vcf_reader_get_attribute_type(
   return TILEDB_VCF_OK;
 }
 
+int32_t tiledb_vcf_reader_get_dictionary_encoding(
+    tiledb_vcf_reader_t* reader, const char* attribute, int32_t* dictionary) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || attribute == nullptr ||
+      dictionary == nullptr)
+    return TILEDB_VCF_ERR;
+
+  *dictionary = reader->reader_->dictionary_encoding(attribute) ? 1 : 0;
+
+  return TILEDB_VCF_OK;
+}
+
 int32_t tiledb_vcf_reader_get_dataset_version(
     tiledb_vcf_reader_t* reader, int32_t* version) {
   if (sanity_check(reader) == TILEDB_VCF_ERR || version == nullptr)
@@ -821,6 +957,330 @@ int32_t tiledb_vcf_reader_set_check_samples_exist(
   return TILEDB_VCF_OK;
 }
 
+int32_t tiledb_vcf_reader_set_contig_batch_concurrency(
+    tiledb_vcf_reader_t* reader, int32_t concurrency) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (concurrency < 1) {
+    auto err = std::string(
+        "Error setting contig batch concurrency; must be at least 1.");
+    save_error(reader, err);
+    return TILEDB_VCF_ERR;
+  }
+
+  if (SAVE_ERROR_CATCH(
+          reader, reader->reader_->set_contig_batch_concurrency(concurrency)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_set_late_materialization(
+    tiledb_vcf_reader_t* reader, bool late_materialization) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader,
+          reader->reader_->set_late_materialization(late_materialization)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_set_filter_expression(
+    tiledb_vcf_reader_t* reader, const char* expression) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || expression == nullptr)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader, reader->reader_->set_filter_expression(expression)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_set_count_group_by(
+    tiledb_vcf_reader_t* reader, tiledb_vcf_count_group_by_t group_by) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader,
+          reader->reader_->set_count_group_by(
+              static_cast<tiledb::vcf::CountGroupBy>(group_by))))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_get_count_num_groups(
+    tiledb_vcf_reader_t* reader, int64_t* num_groups) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || num_groups == nullptr)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader, *num_groups = reader->reader_->count_groups().size()))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_get_count_group(
+    tiledb_vcf_reader_t* reader,
+    int64_t index,
+    const char** name,
+    int64_t* count) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || name == nullptr ||
+      count == nullptr)
+    return TILEDB_VCF_ERR;
+
+  const std::vector<tiledb::vcf::RecordCounter::Group>* groups = nullptr;
+  if (SAVE_ERROR_CATCH(reader, groups = &reader->reader_->count_groups()))
+    return TILEDB_VCF_ERR;
+
+  if (index < 0 || static_cast<uint64_t>(index) >= groups->size()) {
+    auto err = "Error getting count group; index " + std::to_string(index) +
+               " is out of bounds.";
+    save_error(reader, err);
+    return TILEDB_VCF_ERR;
+  }
+
+  *name = (*groups)[index].first.c_str();
+  *count = (*groups)[index].second;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_set_variant_stats(
+    tiledb_vcf_reader_t* reader, bool variant_stats) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader, reader->reader_->set_variant_stats(variant_stats)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_get_variant_stats_num_rows(
+    tiledb_vcf_reader_t* reader, int64_t* num_rows) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || num_rows == nullptr)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader, *num_rows = reader->reader_->variant_stats().size()))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_get_variant_stats_row(
+    tiledb_vcf_reader_t* reader,
+    int64_t index,
+    const char** contig,
+    uint32_t* pos,
+    const char** alleles,
+    const int32_t** allele_counts,
+    int32_t* num_alleles,
+    int32_t* num_alleles_called,
+    int32_t* num_called,
+    int32_t* num_het,
+    int32_t* num_hom_alt,
+    int32_t* num_missing) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || contig == nullptr ||
+      pos == nullptr || alleles == nullptr || allele_counts == nullptr ||
+      num_alleles == nullptr || num_alleles_called == nullptr ||
+      num_called == nullptr || num_het == nullptr || num_hom_alt == nullptr ||
+      num_missing == nullptr)
+    return TILEDB_VCF_ERR;
+
+  const std::vector<tiledb::vcf::VariantStats::Variant>* variants = nullptr;
+  if (SAVE_ERROR_CATCH(reader, variants = &reader->reader_->variant_stats()))
+    return TILEDB_VCF_ERR;
+
+  if (index < 0 || static_cast<uint64_t>(index) >= variants->size()) {
+    auto err = "Error getting variant stats row; index " +
+               std::to_string(index) + " is out of bounds.";
+    save_error(reader, err);
+    return TILEDB_VCF_ERR;
+  }
+
+  const auto& variant = (*variants)[index];
+  *contig = variant.contig.c_str();
+  *pos = variant.pos;
+  *alleles = variant.alleles.c_str();
+  *allele_counts = variant.allele_counts.data();
+  *num_alleles = static_cast<int32_t>(variant.allele_counts.size());
+  *num_alleles_called = variant.num_alleles_called;
+  *num_called = variant.num_called;
+  *num_het = variant.num_het;
+  *num_hom_alt = variant.num_hom_alt;
+  *num_missing = variant.num_missing;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_set_genotype_matrix(
+    tiledb_vcf_reader_t* reader, bool genotype_matrix) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          reader, reader->reader_->set_genotype_matrix(genotype_matrix)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_set_genotype_matrix_buffer(
+    tiledb_vcf_reader_t* reader, int64_t size, void* buffer) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (size < 0 || (buffer == nullptr && size > 0)) {
+    save_error(
+        reader,
+        "Error setting genotype matrix buffer; invalid buffer of size " +
+            std::to_string(size) + ".");
+    return TILEDB_VCF_ERR;
+  }
+
+  if (SAVE_ERROR_CATCH(
+          reader, reader->reader_->set_genotype_matrix_buffer(buffer, size)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_set_genotype_matrix_file(
+    tiledb_vcf_reader_t* reader, const char* path) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || path == nullptr)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(reader, reader->reader_->set_genotype_matrix_file(path)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_get_genotype_matrix_shape(
+    tiledb_vcf_reader_t* reader,
+    int64_t* num_rows,
+    int32_t* num_samples,
+    int64_t* row_bytes) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || num_rows == nullptr ||
+      num_samples == nullptr || row_bytes == nullptr)
+    return TILEDB_VCF_ERR;
+
+  const tiledb::vcf::GenotypeMatrix* matrix = nullptr;
+  if (SAVE_ERROR_CATCH(reader, matrix = &reader->reader_->genotype_matrix()))
+    return TILEDB_VCF_ERR;
+
+  *num_rows = matrix->num_rows();
+  *num_samples = static_cast<int32_t>(matrix->samples().size());
+  *row_bytes = matrix->row_bytes();
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_get_genotype_matrix_sample(
+    tiledb_vcf_reader_t* reader, int32_t index, const char** sample) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || sample == nullptr)
+    return TILEDB_VCF_ERR;
+
+  const tiledb::vcf::GenotypeMatrix* matrix = nullptr;
+  if (SAVE_ERROR_CATCH(reader, matrix = &reader->reader_->genotype_matrix()))
+    return TILEDB_VCF_ERR;
+
+  if (index < 0 || static_cast<uint64_t>(index) >= matrix->samples().size()) {
+    auto err = "Error getting genotype matrix sample; index " +
+               std::to_string(index) + " is out of bounds.";
+    save_error(reader, err);
+    return TILEDB_VCF_ERR;
+  }
+
+  *sample = matrix->samples()[index].c_str();
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_get_genotype_matrix_row(
+    tiledb_vcf_reader_t* reader,
+    int64_t index,
+    const char** contig,
+    uint32_t* pos,
+    const char** alleles) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || contig == nullptr ||
+      pos == nullptr || alleles == nullptr)
+    return TILEDB_VCF_ERR;
+
+  const tiledb::vcf::GenotypeMatrix* matrix = nullptr;
+  if (SAVE_ERROR_CATCH(reader, matrix = &reader->reader_->genotype_matrix()))
+    return TILEDB_VCF_ERR;
+
+  if (index < 0 || static_cast<uint64_t>(index) >= matrix->num_rows()) {
+    auto err = "Error getting genotype matrix row; index " +
+               std::to_string(index) + " is out of bounds.";
+    save_error(reader, err);
+    return TILEDB_VCF_ERR;
+  }
+
+  const auto& variant = matrix->variants()[index];
+  *contig = variant.contig.c_str();
+  *pos = variant.pos;
+  *alleles = variant.alleles.c_str();
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_set_vcf_header_cache_size(
+    tiledb_vcf_reader_t* reader, int32_t memory_mb) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR)
+    return TILEDB_VCF_ERR;
+
+  if (memory_mb < 0) {
+    save_error(
+        reader,
+        "Error setting VCF header cache size; size must not be negative.");
+    return TILEDB_VCF_ERR;
+  }
+
+  if (SAVE_ERROR_CATCH(
+          reader, reader->reader_->set_vcf_header_cache_size(memory_mb)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
+int32_t tiledb_vcf_reader_get_vcf_header_cache_stats(
+    tiledb_vcf_reader_t* reader,
+    uint64_t* hits,
+    uint64_t* misses,
+    uint64_t* evictions,
+    uint64_t* num_entries,
+    uint64_t* size_bytes) {
+  if (sanity_check(reader) == TILEDB_VCF_ERR || hits == nullptr ||
+      misses == nullptr || evictions == nullptr || num_entries == nullptr ||
+      size_bytes == nullptr)
+    return TILEDB_VCF_ERR;
+
+  tiledb::vcf::VCFHeaderCache::Stats stats;
+  if (SAVE_ERROR_CATCH(
+          reader, stats = reader->reader_->vcf_header_cache_stats()))
+    return TILEDB_VCF_ERR;
+
+  *hits = stats.hits;
+  *misses = stats.misses;
+  *evictions = stats.evictions;
+  *num_entries = stats.num_entries;
+  *size_bytes = stats.size_bytes;
+
+  return TILEDB_VCF_OK;
+}
+
 int32_t tiledb_vcf_reader_set_debug_print_vcf_regions(
     tiledb_vcf_reader_t* reader, const bool print_vcf_regions) {
   if (sanity_check(reader) == TILEDB_VCF_ERR)
@@ -1104,6 +1564,18 @@ int32_t tiledb_vcf_writer_set_vcf_attributes(
   return TILEDB_VCF_OK;
 }
 
+int32_t tiledb_vcf_writer_set_typed_attributes(
+    tiledb_vcf_writer_t* writer, const char* attributes) {
+  if (sanity_check(writer) == TILEDB_VCF_ERR || attributes == nullptr)
+    return TILEDB_VCF_ERR;
+
+  if (SAVE_ERROR_CATCH(
+          writer, writer->writer_->set_typed_attributes(attributes)))
+    return TILEDB_VCF_ERR;
+
+  return TILEDB_VCF_OK;
+}
+
 int32_t tiledb_vcf_writer_set_checksum_type(
     tiledb_vcf_writer_t* writer, tiledb_vcf_checksum_type_t checksum_type) {
   if (sanity_check(writer) == TILEDB_VCF_ERR)
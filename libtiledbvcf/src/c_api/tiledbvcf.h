@@ -80,6 +80,14 @@ typedef enum {
 #undef TILEDB_VCF_CHECKSUM_TYPE_ENUM
 } tiledb_vcf_checksum_type_t;
 
+/** Grouping of the record counts of a count query. */
+typedef enum {
+/** Helper macro for defining count grouping enums. */
+#define TILEDB_VCF_COUNT_GROUP_BY_ENUM(id) TILEDB_VCF_##id
+#include "tiledbvcf_enum.h"
+#undef TILEDB_VCF_COUNT_GROUP_BY_ENUM
+} tiledb_vcf_count_group_by_t;
+
 /* ********************************* */
 /*           STRUCT TYPES            */
 /* ********************************* */
@@ -96,6 +104,71 @@ typedef struct tiledb_vcf_error_t tiledb_vcf_error_t;
 /** Bed file object. */
 typedef struct tiledb_vcf_bed_file_t tiledb_vcf_bed_file_t;
 
+/*
+ * Apache Arrow C data and C stream interfaces. These definitions are part of
+ * the stable Arrow ABI and are guarded so they can coexist with the copies in
+ * Arrow, nanoarrow and other consumers.
+ */
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+struct ArrowArrayStream {
+  // Callbacks providing stream functionality
+  int (*get_schema)(struct ArrowArrayStream*, struct ArrowSchema* out);
+  int (*get_next)(struct ArrowArrayStream*, struct ArrowArray* out);
+  const char* (*get_last_error)(struct ArrowArrayStream*);
+
+  // Release callback
+  void (*release)(struct ArrowArrayStream*);
+
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+#endif  // ARROW_C_STREAM_INTERFACE
+
 /* ********************************* */
 /*              MISC                 */
 /* ********************************* */
@@ -502,6 +575,68 @@ TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_buffer_validity_bitmap(
     int64_t buff_size,
     uint8_t* buff);
 
+/**
+ * Sets whether an attribute is exported dictionary-encoded. Only the
+ * "sample_name", "contig" and "alleles" attributes can be dictionary-encoded.
+ *
+ * The values of a dictionary-encoded attribute are `int32` indices into a
+ * dictionary of the distinct strings exported by the read operation, in the
+ * order they were first exported. The dictionary is rebuilt by every read
+ * operation, and is retrieved with its own values and offsets buffers, set
+ * with `tiledb_vcf_reader_set_buffer_dictionary_values` and
+ * `tiledb_vcf_reader_set_buffer_dictionary_offsets`.
+ *
+ * - "sample_name" and "contig" hold one index per record, and have no offsets
+ *   buffer.
+ * - "alleles" holds one index per allele, with an offsets buffer (in number of
+ *   indices) delimiting the alleles of each record, and no list offsets
+ *   buffer.
+ *
+ * `tiledb_vcf_reader_get_attribute_type` reports the type of the indices for
+ * dictionary-encoded attributes.
+ *
+ * @param reader VCF reader object
+ * @param attribute Name of attribute
+ * @param dictionary `1` to export the attribute dictionary-encoded, `0` to
+ *      export its values
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_dictionary_encoding(
+    tiledb_vcf_reader_t* reader, const char* attribute, int32_t dictionary);
+
+/**
+ * Sets the buffer receiving the dictionary values (the concatenated strings)
+ * of a dictionary-encoded attribute.
+ *
+ * @param reader VCF reader object
+ * @param attribute Name of attribute
+ * @param buff_size Size (in bytes) of `buff`.
+ * @param buff Buffer to receive the dictionary values.
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_buffer_dictionary_values(
+    tiledb_vcf_reader_t* reader,
+    const char* attribute,
+    int64_t buff_size,
+    char* buff);
+
+/**
+ * Sets the buffer receiving the dictionary offsets of a dictionary-encoded
+ * attribute. As for other offsets buffers, an extra final offset holds the
+ * total size of the dictionary values.
+ *
+ * @param reader VCF reader object
+ * @param attribute Name of attribute
+ * @param buff_size Size (in bytes) of `buff`.
+ * @param buff Buffer to receive the dictionary offsets.
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_buffer_dictionary_offsets(
+    tiledb_vcf_reader_t* reader,
+    const char* attribute,
+    int64_t buff_size,
+    int32_t* buff);
+
 /**
  * Sets a rough memory budget for the reader's internal allocations. This budget
  * is divided up equally between attribute buffers used for internal TileDB
@@ -545,6 +680,52 @@ TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_memory_budget(
 TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_max_num_records(
     tiledb_vcf_reader_t* reader, int64_t max_num_records);
 
+/**
+ * Sets the maximum number of records returned by each read operation. Reads
+ * stop with an incomplete status once that many records were returned, as if
+ * the buffers were full, so that results come in batches of a fixed number of
+ * records (except for the last one) as long as the buffers are large enough.
+ * See `tiledb_vcf_reader_get_buffer_size_estimate` to size the buffers.
+ *
+ * @param reader VCF reader object
+ * @param num_records Max number of records per read; 0 for no limit
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_batch_num_records(
+    tiledb_vcf_reader_t* reader, int64_t num_records);
+
+/**
+ * Estimates the buffer sizes needed for an attribute to hold the given number
+ * of records, from the bytes per record observed in the results of the last
+ * read operation. Buffers that were full when the last read stopped early
+ * are at least doubled. Before any record was read, the sizes of the buffers
+ * currently set are returned.
+ *
+ * This lets callers that reallocate their buffers between reads grow or
+ * shrink each buffer to the records actually read, rather than dividing a
+ * fixed budget evenly across buffers.
+ *
+ * @param reader VCF reader object
+ * @param attribute Name of attribute, whose buffers must have been set
+ * @param num_records Number of records to size the buffers for
+ * @param data_bytes Set to the size of the values buffer, in bytes
+ * @param offsets_bytes Set to the size of the offsets buffer, in bytes (0 if
+ *      the attribute has no offsets buffer)
+ * @param list_offsets_bytes Set to the size of the list offsets buffer, in
+ *      bytes (0 if the attribute has no list offsets buffer)
+ * @param bitmap_bytes Set to the size of the validity bitmap buffer, in bytes
+ *      (0 if the attribute has no validity bitmap buffer)
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_buffer_size_estimate(
+    tiledb_vcf_reader_t* reader,
+    const char* attribute,
+    int64_t num_records,
+    int64_t* data_bytes,
+    int64_t* offsets_bytes,
+    int64_t* list_offsets_bytes,
+    int64_t* bitmap_bytes);
+
 /**
  * Sets configuration parameters on the TileDB context used for internal
  * processing.
@@ -631,6 +812,49 @@ tiledb_vcf_reader_get_samples(tiledb_vcf_reader_t* reader, const char* samples);
  */
 TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_read(tiledb_vcf_reader_t* reader);
 
+/**
+ * Exports the results of the read as an Arrow C stream of record batches,
+ * using only the ABI-stable Arrow C data interface.
+ *
+ * Each record batch is a struct array with one child per buffer set on the
+ * reader, in the order the buffers were set, with the same types as the
+ * tables of `tiledbvcf/arrow.h`.
+ * The buffers set on the reader only select the attributes and the size of the
+ * first batch: every batch is read into buffers allocated and owned by the
+ * library, which stay valid until the release callback of the batch (or of
+ * any of its children) has been called. The reader's own buffers are not
+ * written to, and are set back on the reader when the stream is released.
+ *
+ * If a number of records per batch was set with
+ * `tiledb_vcf_reader_set_batch_num_records`, the library sizes the buffers of
+ * each batch from the bytes per record of the previous batches, so that the
+ * batches hold that many records. Otherwise all batches use the sizes of the
+ * buffers set on the reader.
+ *
+ * Each call to the stream's `get_next` performs a read operation, and the
+ * stream ends once the read is complete. The reader must outlive the stream
+ * and must not be used while the stream is open.
+ *
+ * **Example:**
+ *
+ * @code{.c}
+ * struct ArrowArrayStream stream;
+ * tiledb_vcf_reader_read_arrow_stream(reader, &stream);
+ * struct ArrowArray batch;
+ * while (stream.get_next(&stream, &batch) == 0 && batch.release != NULL) {
+ *   // Process the batch...
+ *   batch.release(&batch);
+ * }
+ * stream.release(&stream);
+ * @endcode
+ *
+ * @param reader VCF reader object
+ * @param stream Uninitialized stream, set to the stream of results
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_read_arrow_stream(
+    tiledb_vcf_reader_t* reader, struct ArrowArrayStream* stream);
+
 /**
  * Get the read status of the given reader.
  *
@@ -671,6 +895,25 @@ TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_result_size(
     int64_t* num_data_elements,
     int64_t* num_data_bytes);
 
+/**
+ * After reading some data, gets the size of the dictionary of a
+ * dictionary-encoded attribute.
+ *
+ * @param reader VCF reader object
+ * @param attribute Name of attribute
+ * @param num_offsets Set to the number of offsets in the dictionary offsets
+ *      buffer, i.e. the number of dictionary entries plus one, or 0 if the
+ *      dictionary is empty.
+ * @param num_data_bytes Set to the number of bytes in the dictionary values
+ *      buffer.
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_dictionary_result_size(
+    tiledb_vcf_reader_t* reader,
+    const char* attribute,
+    int64_t* num_offsets,
+    int64_t* num_data_bytes);
+
 /**
  * Gets the number of buffers that have been set on the reader.
  *
@@ -762,6 +1005,17 @@ TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_attribute_type(
     int32_t* nullable,
     int32_t* list);
 
+/**
+ * Gets whether an attribute is exported dictionary-encoded.
+ *
+ * @param reader VCF reader object
+ * @param attribute Name of attribute
+ * @param dictionary Set to `1` if the attribute is dictionary-encoded, else `0`
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_dictionary_encoding(
+    tiledb_vcf_reader_t* reader, const char* attribute, int32_t* dictionary);
+
 /**
  * Get count of queryable attributes in the array
  * @param reader VCF reader object
@@ -898,6 +1152,294 @@ TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_tiledb_tile_cache_percentage(
 TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_check_samples_exist(
     tiledb_vcf_reader_t* reader, bool check_samples_exist);
 
+/**
+ * Sets the number of contig batches whose TileDB queries run concurrently
+ * (v4 datasets only). Records are still exported in contig order. The
+ * default of 1 queries one contig at a time. The memory budget is shared by
+ * the concurrent queries, so each gets a smaller share of it.
+ *
+ * @param reader VCF reader object
+ * @param concurrency Number of concurrent contig batch queries (>= 1)
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_contig_batch_concurrency(
+    tiledb_vcf_reader_t* reader, int32_t concurrency);
+
+/**
+ * Sets whether reads run in two phases (v4 datasets only). The first phase
+ * reads only the position columns to find the records intersecting the
+ * regions. The second phase reads the remaining attributes only at the start
+ * positions of those records. This reduces the data read for narrow regions
+ * at the cost of an additional TileDB query per contig. Disabled by default.
+ *
+ * @param reader VCF reader object
+ * @param late_materialization setting
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_late_materialization(
+    tiledb_vcf_reader_t* reader, bool late_materialization);
+
+/**
+ * Sets an expression filtering the exported records on their values (v4
+ * datasets only). The expression is a conjunction of predicates joined with
+ * `&&`, each comparing a field with a value using one of `==`, `!=`, `<`,
+ * `<=`, `>` or `>=`. Supported fields are `QUAL`, `FILTER` and the extracted
+ * `info_*`/`fmt_*` attributes, e.g. `QUAL>=30 && FILTER==PASS && fmt_DP>10`.
+ * Predicates on QUAL are evaluated by TileDB, the others on the query
+ * results before the records are exported.
+ *
+ * An empty expression disables filtering.
+ *
+ * @param reader VCF reader object
+ * @param expression Filter expression
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_filter_expression(
+    tiledb_vcf_reader_t* reader, const char* expression);
+
+/**
+ * Sets the grouping of a count query. Unless `TILEDB_VCF_COUNT_NONE`, reads
+ * only count the intersecting records per query region, sample or contig,
+ * reading the position attributes only; any buffers set on the reader are
+ * left untouched. The counts are retrieved with
+ * `tiledb_vcf_reader_get_count_num_groups` and
+ * `tiledb_vcf_reader_get_count_group`.
+ *
+ * @param reader VCF reader object
+ * @param group_by Grouping of the counts
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_count_group_by(
+    tiledb_vcf_reader_t* reader, tiledb_vcf_count_group_by_t group_by);
+
+/**
+ * Gets the number of groups counted by the previous count query. Only groups
+ * with at least one record are reported.
+ *
+ * @param reader VCF reader object
+ * @param num_groups Set to the number of groups
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_count_num_groups(
+    tiledb_vcf_reader_t* reader, int64_t* num_groups);
+
+/**
+ * Gets a group counted by the previous count query. Regions are named
+ * `contig:start-end` (1-indexed, inclusive) and ordered by BED line and
+ * position; samples and contigs are ordered by name.
+ *
+ * The name pointer is valid until the next read operation or reset.
+ *
+ * @param reader VCF reader object
+ * @param index Index of the group
+ * @param name Set to the name of the group
+ * @param count Set to the number of records in the group
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_count_group(
+    tiledb_vcf_reader_t* reader,
+    int64_t index,
+    const char** name,
+    int64_t* count);
+
+/**
+ * Sets whether reads aggregate the statistics of each variant across the
+ * samples instead of exporting the records (v4 only). Variants are keyed by
+ * contig, position and alleles; each record is counted once, even if it
+ * intersects several query regions. Only the position, alleles and GT
+ * attributes are read; any buffers set on the reader are left untouched. The
+ * statistics are retrieved with `tiledb_vcf_reader_get_variant_stats_num_rows`
+ * and `tiledb_vcf_reader_get_variant_stats_row`.
+ *
+ * @param reader VCF reader object
+ * @param variant_stats True to compute variant stats
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_variant_stats(
+    tiledb_vcf_reader_t* reader, bool variant_stats);
+
+/**
+ * Gets the number of variants aggregated by the previous variant stats query.
+ *
+ * @param reader VCF reader object
+ * @param num_rows Set to the number of variants
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_variant_stats_num_rows(
+    tiledb_vcf_reader_t* reader, int64_t* num_rows);
+
+/**
+ * Gets the statistics of a variant aggregated by the previous variant stats
+ * query. Variants are ordered by contig (in query order), position and
+ * alleles.
+ *
+ * Allele counts follow the bcftools AC/AN semantics: every called allele is
+ * counted, including those of partially called genotypes. Only fully called
+ * genotypes are classified as called, heterozygous or homozygous ALT; the
+ * others count as missing.
+ *
+ * The pointers are valid until the next read operation or reset.
+ *
+ * @param reader VCF reader object
+ * @param index Index of the variant
+ * @param contig Set to the contig of the variant
+ * @param pos Set to the 1-based position of the variant
+ * @param alleles Set to the CSV list of alleles, REF first
+ * @param allele_counts Set to the number of called alleles of each allele
+ * @param num_alleles Set to the number of alleles
+ * @param num_alleles_called Set to the total number of called alleles (AN)
+ * @param num_called Set to the number of fully called genotypes
+ * @param num_het Set to the number of heterozygous genotypes
+ * @param num_hom_alt Set to the number of homozygous ALT genotypes
+ * @param num_missing Set to the number of missing or partial genotypes
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_variant_stats_row(
+    tiledb_vcf_reader_t* reader,
+    int64_t index,
+    const char** contig,
+    uint32_t* pos,
+    const char** alleles,
+    const int32_t** allele_counts,
+    int32_t* num_alleles,
+    int32_t* num_alleles_called,
+    int32_t* num_called,
+    int32_t* num_het,
+    int32_t* num_hom_alt,
+    int32_t* num_missing);
+
+/**
+ * Sets whether reads build a bit-packed matrix of the genotypes of each
+ * variant across the samples instead of exporting the records (v4 only).
+ *
+ * The matrix has one row per variant, keyed by contig, position and alleles,
+ * and one column per queried sample (all samples in name order if none were
+ * set). A row holds 2 bits per sample with the number of ALT alleles of its
+ * genotype, followed, from the next byte, by 1 bit per sample set if the
+ * sample has no record of the variant or a missing allele. Sample `i` is at
+ * bits `2 * (i % 4)` of byte `i / 4`, and at bit `i % 8` of byte `i / 8` of
+ * the missing bits, so a row spans `ceil(2 * n / 8) + ceil(n / 8)` bytes for
+ * `n` samples.
+ *
+ * Rows are added as the variants are first read, in position order within
+ * each query contig. The matrix is written to the memory set with
+ * `tiledb_vcf_reader_set_genotype_matrix_buffer`, or to a file set with
+ * `tiledb_vcf_reader_set_genotype_matrix_file`. Only the position, alleles
+ * and GT attributes are read; any buffers set on the reader are left
+ * untouched.
+ *
+ * @param reader VCF reader object
+ * @param genotype_matrix True to build a genotype matrix
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_genotype_matrix(
+    tiledb_vcf_reader_t* reader, bool genotype_matrix);
+
+/**
+ * Sets the memory the rows of the genotype matrix are written to. A read
+ * adding more rows than fit in the buffer fails.
+ *
+ * @param reader VCF reader object
+ * @param size Size of the buffer in bytes
+ * @param buffer Buffer the rows are written to
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_genotype_matrix_buffer(
+    tiledb_vcf_reader_t* reader, int64_t size, void* buffer);
+
+/**
+ * Sets the local path of a file the rows of the genotype matrix are written
+ * to instead of a buffer. The file is created or truncated, memory-mapped and
+ * grown as rows are added, and truncated to the size of the rows when the
+ * read completes.
+ *
+ * @param reader VCF reader object
+ * @param path Path of the file
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_genotype_matrix_file(
+    tiledb_vcf_reader_t* reader, const char* path);
+
+/**
+ * Gets the shape of the genotype matrix built by the previous genotype matrix
+ * query.
+ *
+ * @param reader VCF reader object
+ * @param num_rows Set to the number of rows (variants)
+ * @param num_samples Set to the number of columns (samples)
+ * @param row_bytes Set to the number of bytes of a row
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_genotype_matrix_shape(
+    tiledb_vcf_reader_t* reader,
+    int64_t* num_rows,
+    int32_t* num_samples,
+    int64_t* row_bytes);
+
+/**
+ * Gets the name of the sample of a column of the genotype matrix built by the
+ * previous genotype matrix query.
+ *
+ * @param reader VCF reader object
+ * @param index Index of the column
+ * @param sample Set to the sample name
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_genotype_matrix_sample(
+    tiledb_vcf_reader_t* reader, int32_t index, const char** sample);
+
+/**
+ * Gets the variant of a row of the genotype matrix built by the previous
+ * genotype matrix query.
+ *
+ * The pointers are valid until the next read operation or reset.
+ *
+ * @param reader VCF reader object
+ * @param index Index of the row
+ * @param contig Set to the contig of the variant
+ * @param pos Set to the 1-based position of the variant
+ * @param alleles Set to the CSV list of alleles, REF first
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_genotype_matrix_row(
+    tiledb_vcf_reader_t* reader,
+    int64_t index,
+    const char** contig,
+    uint32_t* pos,
+    const char** alleles);
+
+/**
+ * Sets the memory cap of the cache of parsed VCF headers of the open dataset
+ * (v4 only). Successive reads, e.g. after `tiledb_vcf_reader_reset`, take the
+ * headers of the samples they already read from the cache instead of fetching
+ * and parsing them again. Defaults to 128 MB.
+ *
+ * @param reader VCF reader object
+ * @param memory_mb Memory cap in MB; 0 disables the cache
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_set_vcf_header_cache_size(
+    tiledb_vcf_reader_t* reader, int32_t memory_mb);
+
+/**
+ * Gets the counters of the VCF header cache of the open dataset.
+ *
+ * @param reader VCF reader object
+ * @param hits Set to the number of headers found in the cache
+ * @param misses Set to the number of headers not found in the cache
+ * @param evictions Set to the number of headers evicted from the cache
+ * @param num_entries Set to the number of cached headers
+ * @param size_bytes Set to the estimated size of the cache, in bytes
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_reader_get_vcf_header_cache_stats(
+    tiledb_vcf_reader_t* reader,
+    uint64_t* hits,
+    uint64_t* misses,
+    uint64_t* evictions,
+    uint64_t* num_entries,
+    uint64_t* size_bytes);
+
 /**
  * Returns the version number of the TileDB VCF dataset.
  *
@@ -1120,6 +1662,19 @@ TILEDBVCF_EXPORT int32_t tiledb_vcf_writer_set_extra_attributes(
 TILEDBVCF_EXPORT int32_t tiledb_vcf_writer_set_vcf_attributes(
     tiledb_vcf_writer_t* writer, const char* vcf_uri);
 
+/**
+ * [Creation only] Sets the extracted info and fmt fields that should be stored
+ * as natively typed attributes: nullable, variable-length Integer or Float
+ * values rather than encoded blobs. The field types are read from the VCF
+ * file set with `tiledb_vcf_writer_set_vcf_attributes`.
+ *
+ * @param writer VCF writer object
+ * @param attributes CSV list of fields in the format `info_*` or `fmt_*`.
+ * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
+ */
+TILEDBVCF_EXPORT int32_t tiledb_vcf_writer_set_typed_attributes(
+    tiledb_vcf_writer_t* writer, const char* attributes);
+
 /**
  * [Creation only] Sets the checksum type to be used for the underlying arrays
  *
@@ -1321,7 +1876,9 @@ TILEDBVCF_EXPORT int32_t tiledb_vcf_writer_set_thread_task_size(
  * Set memory budget for ingestion
  *
  * @param writer VCF writer object
- * @param size The max size of TileDB buffers before flushing. Defaults to 1GB.
+ * @param size The max size of TileDB buffers per thread before flushing.
+ *     Defaults to 1GB. V4 datasets split it across two buffer sets, each
+ *     flushed at half this size.
  * @return `TILEDB_VCF_OK` for success or `TILEDB_VCF_ERR` for error.
  */
 
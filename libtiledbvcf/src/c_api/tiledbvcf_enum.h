@@ -51,4 +51,14 @@ TILEDB_VCF_READ_STATUS_ENUM(FAILED) = 0,
     TILEDB_VCF_CHECKSUM_TYPE_ENUM(CHECKSUM_MD5) = 12,
     /** SHA256 checksum filter. */
     TILEDB_VCF_CHECKSUM_TYPE_ENUM(CHECKSUM_SHA256) = 13,
-#endif
\ No newline at end of file
+#endif
+#ifdef TILEDB_VCF_COUNT_GROUP_BY_ENUM
+    /** Records are exported, not counted */
+    TILEDB_VCF_COUNT_GROUP_BY_ENUM(COUNT_NONE) = 0,
+    /** Count records per query region */
+    TILEDB_VCF_COUNT_GROUP_BY_ENUM(COUNT_BY_REGION) = 1,
+    /** Count records per sample */
+    TILEDB_VCF_COUNT_GROUP_BY_ENUM(COUNT_BY_SAMPLE) = 2,
+    /** Count records per contig */
+    TILEDB_VCF_COUNT_GROUP_BY_ENUM(COUNT_BY_CONTIG) = 3,
+#endif
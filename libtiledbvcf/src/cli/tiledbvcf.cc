@@ -190,6 +190,19 @@ void do_utils_consolidate_fragment_metadata(
   LOG_TRACE("Finished utils consolidate fragment metadata command.");
 }
 
+void do_utils_consolidate_array_metadata(
+    const UtilsParams& args, const CLI::App& cmd) {
+  LOG_TRACE("Starting utils consolidate array metadata command.");
+  config_to_log(cmd);
+  utils::set_htslib_tiledb_context(args.tiledb_config);
+  tiledb::Config cfg;
+  utils::set_tiledb_config(args.tiledb_config, &cfg);
+  TileDBVCFDataset dataset(cfg);
+  dataset.open(args.uri, args.tiledb_config);
+  dataset.consolidate_vcf_header_array_metadata(args);
+  LOG_TRACE("Finished utils consolidate array metadata command.");
+}
+
 void do_utils_vacuum_fragments(const UtilsParams& args, const CLI::App& cmd) {
   LOG_TRACE("Starting utils vacuum fragments command.");
   config_to_log(cmd);
@@ -215,6 +228,19 @@ void do_utils_vacuum_fragment_metadata(
   LOG_TRACE("Finished utils vacuum fragment metadata command.");
 }
 
+void do_utils_vacuum_array_metadata(
+    const UtilsParams& args, const CLI::App& cmd) {
+  LOG_TRACE("Starting utils vacuum array metadata command.");
+  config_to_log(cmd);
+  utils::set_htslib_tiledb_context(args.tiledb_config);
+  tiledb::Config cfg;
+  utils::set_tiledb_config(args.tiledb_config, &cfg);
+  TileDBVCFDataset dataset(cfg);
+  dataset.open(args.uri, args.tiledb_config);
+  dataset.vacuum_vcf_header_array_metadata(args);
+  LOG_TRACE("Finished utils vacuum array metadata command.");
+}
+
 //==================================================================
 // cli parser helpers
 //==================================================================
@@ -232,6 +258,11 @@ std::map<std::string, ExportFormat> format_map{
     {"v", ExportFormat::VCF},
     {"t", ExportFormat::TSV}};
 
+std::map<std::string, CountGroupBy> count_group_by_map{
+    {"region", CountGroupBy::COUNT_BY_REGION},
+    {"sample", CountGroupBy::COUNT_BY_SAMPLE},
+    {"contig", CountGroupBy::COUNT_BY_CONTIG}};
+
 std::map<std::string, IngestionParams::ContigMode> contig_mode_map{
     {"all", IngestionParams::ContigMode::ALL},
     {"separate", IngestionParams::ContigMode::SEPARATE},
@@ -388,6 +419,14 @@ void add_create(CLI::App& app) {
          "Create separate attributes for all INFO and FORMAT fields in the "
          "provided VCF file.")
       ->excludes("--attributes");
+  cmd->add_option(
+         "--typed-attributes",
+         args->typed_attributes,
+         "INFO and/or FORMAT field names (comma-delimited) to store as "
+         "typed, nullable Integer or Float attributes instead of blobs. "
+         "Field types are read from the --vcf-attributes VCF file.")
+      ->delimiter(',')
+      ->needs("--vcf-attributes");
   cmd->add_option(
       "-g,--anchor-gap", args->anchor_gap, "Anchor gap size to use");
   cmd->add_flag_function(
@@ -606,7 +645,9 @@ void add_store(CLI::App& app) {
         args->max_tiledb_buffer_size_mb = value;
         args->use_legacy_max_tiledb_buffer_size_mb = true;
       },
-      "The maximum size of TileDB buffers before flushing (MiB)");
+      "The maximum size of TileDB buffers per thread before flushing (MiB). "
+      "V4 datasets split it across two buffer sets, each flushed at half "
+      "this size.");
 
   // register function to implement this command
   cmd->callback([args, cmd]() { do_store(*args, *cmd); });
@@ -645,6 +686,21 @@ void add_export(CLI::App& app) {
          "row in the output, use the field names 'Q:POS', 'Q:END' and "
          "'Q:LINE'.")
       ->delimiter(',');
+  cmd->add_option(
+         "--include",
+         args->include_fields,
+         "[VCF/BCF export only] CSV list of the INFO/FMT fields to export, "
+         "e.g. 'info_DP,fmt_GT'. Use 'info' or 'fmt' to select all INFO or "
+         "FMT fields. Attributes of other fields are not read.")
+      ->delimiter(',');
+  cmd->add_option(
+         "--exclude",
+         args->exclude_fields,
+         "[VCF/BCF export only] CSV list of the INFO/FMT fields not to "
+         "export, e.g. 'fmt' for a sites-only export. Same format as "
+         "--include.")
+      ->delimiter(',')
+      ->excludes("--include");
   cmd->add_option(
       "-n,--limit",
       args->max_num_records,
@@ -663,6 +719,14 @@ void add_export(CLI::App& app) {
       args->cli_count_only,
       "Don't write output files, only print the count of the resulting "
       "number of intersecting records.");
+  cmd->add_option(
+         "--count-by",
+         args->count_group_by,
+         "With --count-only, print the number of intersecting records per "
+         "group instead of the total. Options are: 'region', 'sample', "
+         "'contig'.")
+      ->transform(CLI::CheckedTransformer(count_group_by_map))
+      ->needs("--count-only");
 
   cmd->option_defaults()->group("Region options");
   cmd->add_option(
@@ -730,6 +794,23 @@ void add_export(CLI::App& app) {
       "The memory budget (MB) used when submitting TileDB "
       "queries.");
 
+  cmd->add_option(
+         "--contig-batch-concurrency",
+         args->contig_batch_concurrency,
+         "Number of contigs whose TileDB queries run concurrently. Records "
+         "are still exported in contig order.")
+      ->check(CLI::PositiveNumber);
+  cmd->add_flag(
+      "--late-materialization",
+      args->late_materialization,
+      "Read in two phases: first find the records intersecting the regions "
+      "using the position columns only, then read all other attributes for "
+      "those records only.");
+  cmd->add_option(
+      "--filter",
+      args->filter_expression,
+      "Only export records matching this expression, e.g. "
+      "'QUAL>=30 && FILTER==PASS && fmt_DP>10' (v4 datasets only)");
   cmd->add_flag("--stats", args->tiledb_stats_enabled, "Enable TileDB stats");
   cmd->add_flag(
       "--stats-vcf-header-array",
@@ -821,6 +902,13 @@ void add_utils(CLI::App& app) {
   c_m_cmd->callback(
       [args, cmd]() { do_utils_consolidate_fragment_metadata(*args, *cmd); });
 
+  auto c_a_cmd = c_cmd->add_subcommand(
+      "array_meta",
+      "Consolidate TileDB-VCF dataset array metadata (sample directory)");
+  add_util_options(c_a_cmd, *args);
+  c_a_cmd->callback(
+      [args, cmd]() { do_utils_consolidate_array_metadata(*args, *cmd); });
+
   auto v_cmd = cmd->add_subcommand("vacuum", "Vacuum TileDB-VCF dataset");
   v_cmd->require_subcommand(1, 1);
 
@@ -834,6 +922,13 @@ void add_utils(CLI::App& app) {
   add_util_options(v_m_cmd, *args);
   v_m_cmd->callback(
       [args, cmd]() { do_utils_vacuum_fragment_metadata(*args, *cmd); });
+
+  auto v_a_cmd = v_cmd->add_subcommand(
+      "array_meta",
+      "Vacuum TileDB-VCF dataset array metadata (sample directory)");
+  add_util_options(v_a_cmd, *args);
+  v_a_cmd->callback(
+      [args, cmd]() { do_utils_vacuum_array_metadata(*args, *cmd); });
 }
 
 //==================================================================
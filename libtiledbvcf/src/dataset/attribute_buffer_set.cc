@@ -254,7 +254,15 @@ void AttributeBufferSet::allocate_fixed(
       Buffer& buff = extra_attrs_[s];
       buff.resize(buffer_size_by_type_.var_length_uint8_buffer_size);
       buff.offsets().resize(num_offsets);
-      fixed_alloc_.emplace_back(true, s, &buff, sizeof(char));
+      tiledb_datatype_t datatype;
+      if (dataset->is_attribute_typed(s, &datatype)) {
+        const unsigned datatype_size = tiledb_datatype_size(datatype);
+        buff.set_nullable(datatype_size);
+        buff.validity().resize(num_offsets);
+        fixed_alloc_.emplace_back(true, s, &buff, datatype_size);
+      } else {
+        fixed_alloc_.emplace_back(true, s, &buff, sizeof(char));
+      }
     }
   }
 }
@@ -292,6 +300,7 @@ uint64_t AttributeBufferSet::total_size() const {
     const Buffer& buff = it.second;
     total_size += buff.size();
     total_size += buff.offsets().size() * sizeof(uint64_t);
+    total_size += buff.validity().size();
   }
 
   return total_size;
@@ -500,12 +509,24 @@ void AttributeBufferSet::set_buffers(
     }
 
     for (const auto& it : extra_attrs()) {
-      query->set_buffer(
-          it.first,
-          (uint64_t*)it.second.offsets().data(),
-          it.second.offsets().size(),
-          it.second.data<void>(),
-          it.second.nelts<uint8_t>());
+      const Buffer& buff = it.second;
+      if (buff.nullable()) {
+        query->set_buffer_nullable(
+            it.first,
+            (uint64_t*)buff.offsets().data(),
+            buff.offsets().size(),
+            buff.data<void>(),
+            buff.size() / buff.value_size(),
+            (uint8_t*)buff.validity().data(),
+            buff.validity().size());
+      } else {
+        query->set_buffer(
+            it.first,
+            (uint64_t*)buff.offsets().data(),
+            buff.offsets().size(),
+            buff.data<void>(),
+            buff.nelts<uint8_t>());
+      }
     }
   } else {
     // For fixed-alloc, set only the allocated buffers.
@@ -514,7 +535,16 @@ void AttributeBufferSet::set_buffers(
       const std::string& name = std::get<1>(p);
       Buffer* buff = std::get<2>(p);
       unsigned datatype_size = std::get<3>(p);
-      if (var_num) {
+      if (var_num && buff->nullable()) {
+        query->set_buffer_nullable(
+            name,
+            (uint64_t*)buff->offsets().data(),
+            buff->offsets().size(),
+            buff->data<void>(),
+            buff->size() / datatype_size,
+            buff->validity().data(),
+            buff->validity().size());
+      } else if (var_num) {
         query->set_buffer(
             name,
             (uint64_t*)buff->offsets().data(),
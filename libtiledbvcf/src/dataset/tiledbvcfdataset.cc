@@ -96,6 +96,16 @@ FilterList default_offsets_filter_list(const Context& ctx) {
       .add_filter({ctx, TILEDB_FILTER_ZSTD});
   return offsets_filters;
 }
+
+/**
+ * The sample directory is stored as metadata of the VCF header array. Each
+ * header fragment has an item, named after the fragment, listing its
+ * (NUL-separated) sample names. The version item identifies the format of the
+ * items.
+ */
+const std::string sample_directory_version_key = "sample_directory_version";
+const std::string sample_directory_key_prefix = "sample_directory.";
+const uint32_t sample_directory_version = 2;
 }  // namespace
 
 TileDBVCFDataset::TileDBVCFDataset(std::shared_ptr<Context> ctx)
@@ -193,6 +203,11 @@ void TileDBVCFDataset::create(const CreationParams& params) {
   VFS vfs(ctx);
 
   check_attribute_names(params.extra_attributes);
+  check_attribute_names(params.typed_attributes);
+  if (!params.typed_attributes.empty() && params.vcf_uri.empty())
+    throw std::runtime_error(
+        "Cannot create TileDB-VCF dataset; typed attributes require a VCF "
+        "file to read the field types from.");
 
   if (vfs.is_dir(params.uri)) {
     // If the directory exists, check if it's a dataset. If so, return with no
@@ -216,14 +231,22 @@ void TileDBVCFDataset::create(const CreationParams& params) {
   metadata.free_sample_id = 0;
 
   // Materialize all attributes in the provided VCF file
+  std::map<std::string, tiledb_datatype_t> typed_attributes;
   if (!params.vcf_uri.empty()) {
     metadata.extra_attributes = get_vcf_attributes(params.vcf_uri);
     check_attribute_names(metadata.extra_attributes);
+    typed_attributes =
+        typed_attribute_datatypes(params.vcf_uri, params.typed_attributes);
   }
 
   create_empty_metadata(ctx, params.uri, metadata, params.checksum);
   create_empty_data_array(
-      ctx, params.uri, metadata, params.checksum, params.allow_duplicates);
+      ctx,
+      params.uri,
+      metadata,
+      params.checksum,
+      params.allow_duplicates,
+      typed_attributes);
   write_metadata_v4(ctx, params.uri, metadata);
 }
 
@@ -254,6 +277,42 @@ void TileDBVCFDataset::check_attribute_names(
   }
 }
 
+std::map<std::string, tiledb_datatype_t>
+TileDBVCFDataset::typed_attribute_datatypes(
+    const std::string& vcf_uri, const std::vector<std::string>& attributes) {
+  std::map<std::string, tiledb_datatype_t> result;
+  if (attributes.empty())
+    return result;
+
+  SafeBCFHdr hdr(VCFUtils::hdr_read_header(vcf_uri), bcf_hdr_destroy);
+  for (const auto& attr : attributes) {
+    auto parts = split_info_fmt_attr_name(attr);
+    const bool is_info = parts.first == "info";
+    const int hl_type = is_info ? BCF_HL_INFO : BCF_HL_FMT;
+    const int id = bcf_hdr_id2int(hdr.get(), BCF_DT_ID, parts.second.c_str());
+    if (id < 0 || !bcf_hdr_idinfo_exists(hdr.get(), hl_type, id))
+      throw std::runtime_error(
+          "Cannot create typed attribute '" + attr + "'; field not found in " +
+          vcf_uri + ".");
+
+    // Header says GT is str, but it's encoded as an int (index into alleles)
+    const int type = !is_info && parts.second == "GT" ?
+                         BCF_HT_INT :
+                         bcf_hdr_id2type(hdr.get(), hl_type, id);
+    if (type == BCF_HT_INT) {
+      result[attr] = TILEDB_INT32;
+    } else if (type == BCF_HT_REAL) {
+      result[attr] = TILEDB_FLOAT32;
+    } else {
+      throw std::runtime_error(
+          "Cannot create typed attribute '" + attr +
+          "'; only Integer and Float fields can be typed.");
+    }
+  }
+
+  return result;
+}
+
 void TileDBVCFDataset::create_empty_metadata(
     const Context& ctx,
     const std::string& root_uri,
@@ -268,7 +327,8 @@ void TileDBVCFDataset::create_empty_data_array(
     const std::string& root_uri,
     const Metadata& metadata,
     const tiledb_filter_type_t& checksum,
-    const bool allow_duplicates) {
+    const bool allow_duplicates,
+    const std::map<std::string, tiledb_datatype_t>& typed_attributes) {
   ArraySchema schema(ctx, TILEDB_SPARSE);
   schema.set_capacity(metadata.tile_capacity);
   schema.set_order({{TILEDB_ROW_MAJOR, TILEDB_ROW_MAJOR}});
@@ -340,6 +400,18 @@ void TileDBVCFDataset::create_empty_data_array(
     if (used.count(attr))
       continue;
     used.insert(attr);
+
+    // Typed attributes store the raw values, with a null for missing fields
+    auto typed = typed_attributes.find(attr);
+    if (typed != typed_attributes.end()) {
+      Attribute typed_attr(ctx, attr, typed->second);
+      typed_attr.set_cell_val_num(TILEDB_VAR_NUM);
+      typed_attr.set_nullable(true);
+      typed_attr.set_filter_list(byteshuffle_zstd_filters);
+      schema.add_attribute(typed_attr);
+      continue;
+    }
+
     schema.add_attribute(Attribute::create<std::vector<uint8_t>>(
         ctx, attr, attribute_filter_list));
   }
@@ -381,6 +453,14 @@ void TileDBVCFDataset::create_sample_header_array(
   schema.add_attributes(attr_header);
 
   Array::create(vcf_headers_uri(root_uri), schema);
+
+  // Mark the (empty) sample directory as complete
+  Array array(ctx, vcf_headers_uri(root_uri), TILEDB_WRITE);
+  array.put_metadata(
+      sample_directory_version_key,
+      TILEDB_UINT32,
+      1,
+      &sample_directory_version);
 }
 
 void TileDBVCFDataset::open(
@@ -408,6 +488,7 @@ void TileDBVCFDataset::open(
   data_array_ = open_data_array(TILEDB_READ);
   vcf_header_array_ = open_vcf_array(TILEDB_READ);
   read_metadata();
+  load_typed_attributes();
 
   // We support V2, V3 and V4 (current) formats.
   if (metadata_.version != Version::V2 && metadata_.version != Version::V3 &&
@@ -576,7 +657,7 @@ void TileDBVCFDataset::load_field_type_maps() const {
   uint32_t first_sample_id = metadata_.sample_ids.at(first_sample_name);
   SampleAndId first_sample = {first_sample_name, first_sample_id};
 
-  std::unordered_map<uint32_t, SafeBCFHdr> hdrs;
+  std::unordered_map<uint32_t, SharedBCFHdr> hdrs;
   hdrs = fetch_vcf_headers({first_sample});
   if (hdrs.size() != 1)
     throw std::runtime_error(
@@ -618,7 +699,7 @@ void TileDBVCFDataset::load_field_type_maps_v4(const bcf_hdr_t* hdr) const {
   if (info_fmt_field_types_loaded_)
     return;
 
-  std::unordered_map<uint32_t, SafeBCFHdr> hdrs;
+  std::unordered_map<uint32_t, SharedBCFHdr> hdrs;
   if (hdr == nullptr) {
     hdrs = fetch_vcf_headers_v4({}, nullptr, false, true);
 
@@ -825,7 +906,8 @@ std::shared_ptr<tiledb::Array> TileDBVCFDataset::open_data_array(
   return array;
 }
 
-std::unordered_map<uint32_t, SafeBCFHdr> TileDBVCFDataset::fetch_vcf_headers_v4(
+std::unordered_map<uint32_t, SharedBCFHdr>
+TileDBVCFDataset::fetch_vcf_headers_v4(
     const std::vector<SampleAndId>& samples,
     std::unordered_map<std::string, size_t>* lookup_map,
     const bool all_samples,
@@ -848,23 +930,48 @@ std::unordered_map<uint32_t, SafeBCFHdr> TileDBVCFDataset::fetch_vcf_headers_v4(
         "Cannot set first_sample and samples list in same fetch vcf headers "
         "request");
 
-  std::unordered_map<uint32_t, SafeBCFHdr> result;
+  std::unordered_map<uint32_t, SharedBCFHdr> result;
+  uint32_t sample_idx = 0;
 
   if (vcf_header_array_ == nullptr)
     throw std::runtime_error(
         "Cannot fetch TileDB-VCF vcf headers; Array object unexpectedly null");
 
+  // Take the cached headers, and only fetch the others.
+  const bool use_cache = !samples.empty() && vcf_header_cache_.enabled();
+  const uint64_t timestamp =
+      use_cache ? vcf_header_array_->open_timestamp_end() : 0;
+  std::vector<const SampleAndId*> missing_samples;
+  for (const auto& sample : samples) {
+    SharedBCFHdr hdr =
+        use_cache ? vcf_header_cache_.get(sample.sample_name, timestamp) :
+                    nullptr;
+    if (hdr == nullptr) {
+      missing_samples.push_back(&sample);
+      continue;
+    }
+    result.emplace(sample_idx, std::move(hdr));
+    if (lookup_map != nullptr)
+      (*lookup_map)[sample.sample_name] = sample_idx;
+    ++sample_idx;
+  }
+  if (!samples.empty() && missing_samples.empty()) {
+    if (tiledb_stats_enabled_)
+      tiledb::Stats::enable();
+    return result;
+  }
+
   Query query(*ctx_, *vcf_header_array_);
 
   if (!samples.empty()) {
     // If all samples but we have a sample list we know its sorted and can use
     // the min/max
-    if (all_samples) {
+    if (all_samples && missing_samples.size() == samples.size()) {
       query.add_range(
           0, samples[0].sample_name, samples[samples.size() - 1].sample_name);
     } else {
-      for (const auto& sample : samples) {
-        query.add_range(0, sample.sample_name, sample.sample_name);
+      for (const auto* sample : missing_samples) {
+        query.add_range(0, sample->sample_name, sample->sample_name);
       }
     }
   } else if (all_samples) {
@@ -920,7 +1027,11 @@ std::unordered_map<uint32_t, SafeBCFHdr> TileDBVCFDataset::fetch_vcf_headers_v4(
   std::vector<char> sample_data(sample_data_element);
 
   Query::Status status;
-  uint32_t sample_idx = 0;
+
+  // Parsed headers by (has no sample name, header text). Cohorts are usually
+  // ingested from VCFs with identical headers, which are then only parsed
+  // once.
+  std::map<std::pair<bool, std::string>, SharedBCFHdr> parsed_hdrs;
 
   do {
     // Always reset buffer to avoid issue with core library and REST not using
@@ -972,36 +1083,44 @@ std::unordered_map<uint32_t, SafeBCFHdr> TileDBVCFDataset::fetch_vcf_headers_v4(
         uint64_t start = offsets[offset_idx];
         uint64_t hdr_size = end - start;
 
-        std::string hdr_str(beg_hdr, hdr_size);
-
-        bcf_hdr_t* hdr = bcf_hdr_init("r");
-        if (!hdr)
-          throw std::runtime_error(
-              "Error fetching VCF header data; error allocating VCF header.");
-
-        if (0 != bcf_hdr_parse(hdr, const_cast<char*>(hdr_str.c_str()))) {
-          throw std::runtime_error(
-              "TileDBVCFDataset::fetch_vcf_headers_v4: Error parsing the BCF "
-              "header for sample " +
-              sample + ".");
-        }
+        auto& shared_hdr = parsed_hdrs[std::make_pair(
+            sample.empty(), std::string(beg_hdr, hdr_size))];
+        if (shared_hdr == nullptr) {
+          bcf_hdr_t* hdr = bcf_hdr_init("r");
+          if (!hdr)
+            throw std::runtime_error(
+                "Error fetching VCF header data; error allocating VCF "
+                "header.");
+          shared_hdr.reset(hdr, bcf_hdr_destroy);
 
-        if (!sample.empty()) {
-          if (0 != bcf_hdr_add_sample(hdr, sample.c_str())) {
+          std::string hdr_str(beg_hdr, hdr_size);
+          if (0 != bcf_hdr_parse(hdr, const_cast<char*>(hdr_str.c_str()))) {
             throw std::runtime_error(
-                "TileDBVCFDataset::fetch_vcf_headers_v4: Error adding sample "
-                "to "
+                "TileDBVCFDataset::fetch_vcf_headers_v4: Error parsing the "
                 "BCF header for sample " +
                 sample + ".");
           }
+
+          // Records are recovered with one sample column, so the shared
+          // header gets the name of the first sample using it.
+          if (!sample.empty()) {
+            if (0 != bcf_hdr_add_sample(hdr, sample.c_str())) {
+              throw std::runtime_error(
+                  "TileDBVCFDataset::fetch_vcf_headers_v4: Error adding "
+                  "sample to BCF header for sample " +
+                  sample + ".");
+            }
+          }
+
+          if (bcf_hdr_sync(hdr) < 0)
+            throw std::runtime_error(
+                "Error in bcftools: failed to update VCF header.");
         }
 
-        if (bcf_hdr_sync(hdr) < 0)
-          throw std::runtime_error(
-              "Error in bcftools: failed to update VCF header.");
+        if (use_cache)
+          vcf_header_cache_.put(sample, timestamp, shared_hdr, hdr_size);
 
-        result.emplace(
-            std::make_pair(sample_idx, SafeBCFHdr(hdr, bcf_hdr_destroy)));
+        result.emplace(std::make_pair(sample_idx, shared_hdr));
         if (lookup_map != nullptr)
           (*lookup_map)[sample] = sample_idx;
 
@@ -1015,7 +1134,8 @@ std::unordered_map<uint32_t, SafeBCFHdr> TileDBVCFDataset::fetch_vcf_headers_v4(
   return result;
 }  // namespace vcf
 
-std::unordered_map<uint32_t, SafeBCFHdr> TileDBVCFDataset::fetch_vcf_headers(
+std::unordered_map<uint32_t, SharedBCFHdr>
+TileDBVCFDataset::fetch_vcf_headers(
     const std::vector<SampleAndId>& samples) const {
   // Grab a read lock of concurrency so we don't destroy the vcf_header_array
   // during fetching
@@ -1025,7 +1145,7 @@ std::unordered_map<uint32_t, SafeBCFHdr> TileDBVCFDataset::fetch_vcf_headers(
   if (!tiledb_stats_enabled_vcf_header_)
     tiledb::Stats::disable();
 
-  std::unordered_map<uint32_t, SafeBCFHdr> result;
+  std::unordered_map<uint32_t, SharedBCFHdr> result;
 
   if (vcf_header_array_ == nullptr)
     throw std::runtime_error(
@@ -1132,7 +1252,7 @@ std::unordered_map<uint32_t, SafeBCFHdr> TileDBVCFDataset::fetch_vcf_headers(
               "Error in bcftools: failed to update VCF header.");
 
         result.emplace(
-            std::make_pair(sample, SafeBCFHdr(hdr, bcf_hdr_destroy)));
+            std::make_pair(sample, SharedBCFHdr(hdr, bcf_hdr_destroy)));
       }
     }
   } while (status == Query::Status::INCOMPLETE);
@@ -1203,7 +1323,7 @@ std::list<Region> TileDBVCFDataset::all_contigs_list() const {
 }
 
 std::vector<Region> TileDBVCFDataset::all_contigs_v4() const {
-  std::unordered_map<uint32_t, SafeBCFHdr> hdrs =
+  std::unordered_map<uint32_t, SharedBCFHdr> hdrs =
       fetch_vcf_headers_v4({}, nullptr, false, true);
 
   if (hdrs.empty())
@@ -1553,6 +1673,20 @@ void TileDBVCFDataset::write_vcf_headers_v4(
   if (st != Query::Status::COMPLETE)
     throw std::runtime_error(
         "Error writing VCF header data; unexpected TileDB query status.");
+
+  // Add the samples to the sample directory, under the name of the fragment
+  // just written.
+  if (query.fragment_num() != 1)
+    throw std::runtime_error(
+        "Error writing VCF header data; unexpected number of fragments.");
+  std::string directory;
+  for (const auto& sample : samples) {
+    directory.append(sample);
+    directory.push_back('\0');
+  }
+  const std::string key =
+      sample_directory_key_prefix + utils::uri_filename(query.fragment_uri(0));
+  array.put_metadata(key, TILEDB_CHAR, directory.size(), directory.data());
 }
 
 void TileDBVCFDataset::write_vcf_headers_v2(
@@ -1819,6 +1953,32 @@ const char* TileDBVCFDataset::materialized_attribute_name(
   return this->materialized_vcf_attributes_[index].data();
 }
 
+void TileDBVCFDataset::load_typed_attributes() {
+  typed_attributes_.clear();
+  if (metadata_.version != Version::V4)
+    return;
+
+  // Blob attributes are uint8; typed attributes have the field's type
+  auto schema = data_array_->schema();
+  for (const auto& attr : metadata_.extra_attributes) {
+    if (!schema.has_attribute(attr))
+      continue;
+    const tiledb_datatype_t datatype = schema.attribute(attr).type();
+    if (datatype != TILEDB_UINT8)
+      typed_attributes_[attr] = datatype;
+  }
+}
+
+bool TileDBVCFDataset::is_attribute_typed(
+    const std::string& attr, tiledb_datatype_t* datatype) const {
+  auto it = typed_attributes_.find(attr);
+  if (it == typed_attributes_.end())
+    return false;
+  if (datatype != nullptr)
+    *datatype = it->second;
+  return true;
+}
+
 bool TileDBVCFDataset::is_attribute_materialized(
     const std::string& attr) const {
   utils::UniqueReadLock lck_(
@@ -1925,6 +2085,12 @@ std::vector<std::string> TileDBVCFDataset::get_all_samples_from_vcf_headers()
         "Cannot fetch TileDB-VCF samples from vcf header array; Array object "
         "unexpectedly null");
 
+  if (load_sample_directory(&result)) {
+    if (tiledb_stats_enabled_)
+      tiledb::Stats::enable();
+    return result;
+  }
+
   Query query(*ctx_, *vcf_header_array_);
 
   auto non_empty_domain = vcf_header_array_->non_empty_domain_var(0);
@@ -2022,6 +2188,14 @@ void TileDBVCFDataset::set_tiledb_stats_enabled_vcf_header(
   tiledb_stats_enabled_vcf_header_ = stats_enabled;
 }
 
+void TileDBVCFDataset::set_vcf_header_cache_size(uint64_t max_bytes) {
+  vcf_header_cache_.set_max_bytes(max_bytes);
+}
+
+VCFHeaderCache::Stats TileDBVCFDataset::vcf_header_cache_stats() const {
+  return vcf_header_cache_.stats();
+}
+
 void TileDBVCFDataset::consolidate_vcf_header_array_fragment_metadata(
     const UtilsParams& params) {
   Config cfg;
@@ -2065,6 +2239,13 @@ void TileDBVCFDataset::consolidate_fragments(const UtilsParams& params) {
   consolidate_vcf_header_array_fragments(params);
 }
 
+void TileDBVCFDataset::consolidate_vcf_header_array_metadata(
+    const UtilsParams& params) {
+  Config cfg;
+  utils::set_tiledb_config(params.tiledb_config, &cfg);
+  tiledb::Array::consolidate_metadata(*ctx_, vcf_headers_uri(root_uri_), &cfg);
+}
+
 void TileDBVCFDataset::vacuum_vcf_header_array_fragment_metadata(
     const UtilsParams& params) {
   Config cfg;
@@ -2123,6 +2304,88 @@ void TileDBVCFDataset::vacuum_fragments(const UtilsParams& params) {
   vacuum_vcf_header_array_fragments(params);
 }
 
+void TileDBVCFDataset::vacuum_vcf_header_array_metadata(
+    const UtilsParams& params) {
+  Config cfg;
+  utils::set_tiledb_config(params.tiledb_config, &cfg);
+  cfg["sm.vacuum.mode"] = "array_meta";
+  // block until it's safe to close the array
+  lock_and_join_vcf_header_array();
+  vcf_header_array_->close();
+  tiledb::Array::vacuum(*ctx_, vcf_headers_uri(root_uri_), &cfg);
+  vcf_header_array_ = open_vcf_array(TILEDB_READ);
+}
+
+bool TileDBVCFDataset::load_sample_directory(
+    std::vector<std::string>* samples) const {
+  tiledb_datatype_t dtype;
+  uint32_t value_num = 0;
+  const void* ptr = nullptr;
+  if (!vcf_header_array_->has_metadata(sample_directory_version_key, &dtype))
+    return false;
+  vcf_header_array_->get_metadata(
+      sample_directory_version_key, &dtype, &value_num, &ptr);
+  if (dtype != TILEDB_UINT32 || value_num != 1 ||
+      *static_cast<const uint32_t*>(ptr) != sample_directory_version)
+    return false;
+
+  samples->clear();
+  std::unordered_set<std::string> fragments;
+  const uint64_t num_items = vcf_header_array_->metadata_num();
+  for (uint64_t i = 0; i < num_items; i++) {
+    std::string key;
+    vcf_header_array_->get_metadata_from_index(
+        i, &key, &dtype, &value_num, &ptr);
+    if (!utils::starts_with(key, sample_directory_key_prefix))
+      continue;
+    if (dtype != TILEDB_CHAR || ptr == nullptr)
+      throw std::runtime_error(
+          "Error loading sample directory; '" + key +
+          "' item has invalid value.");
+    fragments.insert(key.substr(sample_directory_key_prefix.size()));
+
+    const char* data = static_cast<const char*>(ptr);
+    const char* end = data + value_num;
+    while (data < end) {
+      const char* sep = std::find(data, end, '\0');
+      samples->emplace_back(data, sep);
+      data = sep + 1;
+    }
+  }
+
+  // The directory is only complete if every visible header fragment has an
+  // item. Fragments written by an older version or by an ingestion that failed
+  // before adding its item, and consolidated fragments, are only found by
+  // scanning the header array.
+  try {
+    tiledb::FragmentInfo fragment_info(*ctx_, vcf_header_array_->uri());
+    fragment_info.load();
+    const uint64_t start = vcf_header_array_->open_timestamp_start();
+    const uint64_t end = vcf_header_array_->open_timestamp_end();
+    for (uint32_t i = 0; i < fragment_info.fragment_num(); i++) {
+      const auto range = fragment_info.timestamp_range(i);
+      if (range.first < start || range.second > end)
+        continue;
+      const auto name = utils::uri_filename(fragment_info.fragment_uri(i));
+      if (fragments.count(name) == 0) {
+        LOG_DEBUG(
+            "Sample directory does not cover VCF header fragment {}", name);
+        return false;
+      }
+    }
+  } catch (const tiledb::TileDBError& ex) {
+    LOG_DEBUG("Cannot check the sample directory: {}", ex.what());
+    return false;
+  }
+
+  // Sort as the header array would return them. Batches may overlap if
+  // samples were re-ingested.
+  std::sort(samples->begin(), samples->end());
+  samples->erase(
+      std::unique(samples->begin(), samples->end()), samples->end());
+  return true;
+}
+
 void TileDBVCFDataset::load_sample_names_v4() const {
   utils::UniqueWriteLock lck_(&metadata_.sample_names_rw_lock_);
   // After the lock is acquired we need to make sure a different thread hasn't
@@ -2180,7 +2443,7 @@ void TileDBVCFDataset::attribute_datatype_non_fmt_info(
   *var_len = !fixed_len;
   *var_len = !fixed_len;
 
-  *nullable = attribute_is_nullable(attribute);
+  *nullable = attribute_is_nullable(attribute) || is_attribute_typed(attribute);
   *list = attribute_is_list(attribute);
   *var_len = !fixed_len;
 
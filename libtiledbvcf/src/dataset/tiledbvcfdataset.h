@@ -38,6 +38,7 @@
 #include <future>
 #include <tiledb/tiledb>
 
+#include "dataset/vcf_header_cache.h"
 #include "utils/rwlock.h"
 #include "utils/sample_utils.h"
 #include "utils/unique_rwlock.h"
@@ -62,6 +63,10 @@ struct CreationParams {
   tiledb_filter_type_t checksum = TILEDB_FILTER_CHECKSUM_SHA256;
   bool allow_duplicates = true;
   std::string vcf_uri;
+  // Extracted attributes to store as natively typed, nullable var-length
+  // values instead of encoded blobs. Their types are read from the header of
+  // `vcf_uri`.
+  std::vector<std::string> typed_attributes;
 };
 
 /** Arguments/params for dataset registration. */
@@ -312,16 +317,22 @@ class TileDBVCFDataset {
 
   std::string root_uri() const;
 
-  std::unordered_map<uint32_t, SafeBCFHdr> fetch_vcf_headers(
+  std::unordered_map<uint32_t, SharedBCFHdr> fetch_vcf_headers(
       const std::vector<SampleAndId>& samples) const;
 
   /**
    * Fetch VCF headers
+   *
+   * Samples whose stored headers are identical share a single parsed header,
+   * which holds one sample column named after the first of these samples.
+   * Callers must therefore take sample names from the lookup map, not from
+   * the header.
+   *
    * @param samples List of samples, if list is empty then we'll fetch just one
    * @param lookup_map
    * @return
    */
-  std::unordered_map<uint32_t, SafeBCFHdr> fetch_vcf_headers_v4(
+  std::unordered_map<uint32_t, SharedBCFHdr> fetch_vcf_headers_v4(
       const std::vector<SampleAndId>& samples,
       std::unordered_map<std::string, size_t>* lookup_map,
       bool all_samples,
@@ -430,6 +441,16 @@ class TileDBVCFDataset {
 
   bool is_attribute_materialized(const std::string& attr) const;
 
+  /**
+   * Returns true if the given extracted attribute stores natively typed
+   * values (see CreationParams::typed_attributes) rather than encoded blobs.
+   *
+   * @param attr Attribute name
+   * @param datatype If not null, set to the TileDB datatype of the attribute
+   */
+  bool is_attribute_typed(
+      const std::string& attr, tiledb_datatype_t* datatype = nullptr) const;
+
   /**
    * Get sample name by index
    * @param index
@@ -449,7 +470,9 @@ class TileDBVCFDataset {
       const std::map<std::string, std::string>& vcf_headers) const;
 
   /**
-   * Fetch all sample ids from the vcf header array
+   * Fetch all sample ids from the vcf header array. The names are taken from
+   * the sample directory if the dataset has one, which avoids scanning the
+   * header array.
    *
    * @return vector of all sample names
    */
@@ -494,6 +517,17 @@ class TileDBVCFDataset {
    */
   void set_tiledb_stats_enabled_vcf_header(const bool stats_enabled);
 
+  /**
+   * Sets the memory cap of the cache of parsed VCF headers used by
+   * fetch_vcf_headers_v4(). 0 disables the cache.
+   *
+   * @param max_bytes Cap in bytes
+   */
+  void set_vcf_header_cache_size(uint64_t max_bytes);
+
+  /** Returns the counters of the VCF header cache. */
+  VCFHeaderCache::Stats vcf_header_cache_stats() const;
+
   /**
    * Consolidate fragment metadata of the vcf header array
    * @param params
@@ -532,6 +566,13 @@ class TileDBVCFDataset {
    */
   void consolidate_fragments(const UtilsParams& params);
 
+  /**
+   * Consolidate the array metadata of the vcf header array, which holds the
+   * sample directory
+   * @param params
+   */
+  void consolidate_vcf_header_array_metadata(const UtilsParams& params);
+
   /**
    * Vacuum fragment metadata of the vcf header array
    * @param params
@@ -568,6 +609,13 @@ class TileDBVCFDataset {
    */
   void vacuum_fragments(const UtilsParams& params);
 
+  /**
+   * Vacuum the array metadata of the vcf header array consolidated by
+   * consolidate_vcf_header_array_metadata()
+   * @param params
+   */
+  void vacuum_vcf_header_array_metadata(const UtilsParams& params);
+
   /**
    * Return sample name vector
    * @return
@@ -579,6 +627,16 @@ class TileDBVCFDataset {
    */
   void load_sample_names_v4() const;
 
+  /**
+   * Loads the sorted sample names from the sample directory kept in the
+   * metadata of the VCF header array.
+   *
+   * @param samples Set to the sample names
+   * @return False if the dataset has no sample directory, or if some VCF
+   *     header fragment has no directory item
+   */
+  bool load_sample_directory(std::vector<std::string>* samples) const;
+
   /**
    * Check if a attr is an info field or not
    * @param attr
@@ -670,6 +728,9 @@ class TileDBVCFDataset {
   /** Map of fmt field name -> hstlib type. */
   mutable std::map<std::string, int> fmt_field_types_;
 
+  /** Map of typed extracted attribute name -> TileDB datatype. */
+  std::map<std::string, tiledb_datatype_t> typed_attributes_;
+
   /** List of all attributes of vcf for querying */
   mutable std::vector<std::vector<char>> vcf_attributes_;
 
@@ -739,6 +800,9 @@ class TileDBVCFDataset {
   /** RWLock for vcf header array to prevent destruction if in use */
   utils::RWLock vcf_header_array_lock_;
 
+  /** Parsed VCF headers of previously fetched samples. */
+  mutable VCFHeaderCache vcf_header_cache_;
+
   /** Future for preloading non_empty_domain of data array */
   std::future<void> data_array_preload_non_empty_domain_thread_;
 
@@ -763,6 +827,14 @@ class TileDBVCFDataset {
    */
   static void check_attribute_names(const std::vector<std::string>& attribues);
 
+  /**
+   * Returns the TileDB datatype of each of the given typed attributes, from
+   * the type of its field in the header of the given VCF file. Only Integer
+   * and Float fields can be typed.
+   */
+  static std::map<std::string, tiledb_datatype_t> typed_attribute_datatypes(
+      const std::string& vcf_uri, const std::vector<std::string>& attributes);
+
   /**
    * Creates the metadata for a new dataset.
    *
@@ -784,13 +856,15 @@ class TileDBVCFDataset {
    * @param root_uri Root URI of the dataset
    * @param metadata Dataset metadata containing tile capacity etc. to use
    * @param checksum optional checksum filter
+   * @param typed_attributes Datatypes of the typed extracted attributes
    */
   static void create_empty_data_array(
       const Context& ctx,
       const std::string& root_uri,
       const Metadata& metadata,
       const tiledb_filter_type_t& checksum,
-      const bool allow_duplicates);
+      const bool allow_duplicates,
+      const std::map<std::string, tiledb_datatype_t>& typed_attributes);
 
   /**
    * Creates the empty sample header array for a new dataset.
@@ -937,6 +1011,9 @@ class TileDBVCFDataset {
    */
   void read_metadata_v4();
 
+  /** Populates the map of typed extracted attributes from the schema. */
+  void load_typed_attributes();
+
   /**
    * Build list of queryable attributes
    */
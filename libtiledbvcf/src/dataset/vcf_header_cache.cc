@@ -0,0 +1,132 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <iterator>
+
+#include "dataset/vcf_header_cache.h"
+
+namespace tiledb {
+namespace vcf {
+
+VCFHeaderCache::VCFHeaderCache(uint64_t max_bytes)
+    : max_bytes_(max_bytes) {
+}
+
+void VCFHeaderCache::set_max_bytes(uint64_t max_bytes) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  max_bytes_ = max_bytes;
+  evict();
+}
+
+bool VCFHeaderCache::enabled() const {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return max_bytes_ > 0;
+}
+
+SharedBCFHdr VCFHeaderCache::get(
+    const std::string& sample, uint64_t timestamp) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  auto it = index_.find(sample);
+  if (it == index_.end()) {
+    stats_.misses++;
+    return nullptr;
+  }
+
+  // The header array was reopened at another timestamp since the header was
+  // cached, so it may have changed.
+  if (it->second->timestamp != timestamp) {
+    erase(it->second);
+    stats_.misses++;
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, it->second);
+  stats_.hits++;
+  return it->second->hdr;
+}
+
+void VCFHeaderCache::put(
+    const std::string& sample,
+    uint64_t timestamp,
+    const SharedBCFHdr& hdr,
+    uint64_t hdr_bytes) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  if (max_bytes_ == 0 || hdr == nullptr)
+    return;
+
+  auto it = index_.find(sample);
+  if (it != index_.end())
+    erase(it->second);
+
+  entries_.push_front(Entry{sample, timestamp, hdr});
+  index_[sample] = entries_.begin();
+  stats_.num_entries++;
+  stats_.size_bytes += sample.size() + ENTRY_OVERHEAD;
+
+  auto& use = header_uses_[hdr.get()];
+  if (use.num_entries++ == 0) {
+    use.bytes = hdr_bytes;
+    stats_.size_bytes += hdr_bytes;
+  }
+
+  evict();
+}
+
+void VCFHeaderCache::clear() {
+  std::lock_guard<std::mutex> lck(mtx_);
+  entries_.clear();
+  index_.clear();
+  header_uses_.clear();
+  stats_.num_entries = 0;
+  stats_.size_bytes = 0;
+}
+
+VCFHeaderCache::Stats VCFHeaderCache::stats() const {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return stats_;
+}
+
+void VCFHeaderCache::erase(std::list<Entry>::iterator it) {
+  auto use = header_uses_.find(it->hdr.get());
+  if (--use->second.num_entries == 0) {
+    stats_.size_bytes -= use->second.bytes;
+    header_uses_.erase(use);
+  }
+  stats_.num_entries--;
+  stats_.size_bytes -= it->sample.size() + ENTRY_OVERHEAD;
+  index_.erase(it->sample);
+  entries_.erase(it);
+}
+
+void VCFHeaderCache::evict() {
+  while (!entries_.empty() && stats_.size_bytes > max_bytes_) {
+    erase(std::prev(entries_.end()));
+    stats_.evictions++;
+  }
+}
+
+}  // namespace vcf
+}  // namespace tiledb
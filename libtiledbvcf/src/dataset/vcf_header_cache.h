@@ -0,0 +1,156 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TILEDB_VCF_VCF_HEADER_CACHE_H
+#define TILEDB_VCF_VCF_HEADER_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "vcf/vcf_utils.h"
+
+namespace tiledb {
+namespace vcf {
+
+/**
+ * LRU cache of parsed VCF headers, keyed by sample name and the timestamp the
+ * VCF header array was opened at. It lets successive reads on an open dataset
+ * skip fetching and parsing the headers of the samples they already read.
+ *
+ * The memory cap is enforced on an estimate: each cached header is charged
+ * the size of its text once, however many samples share it, and each entry
+ * is charged its sample name plus a fixed overhead.
+ *
+ * This class is threadsafe.
+ */
+class VCFHeaderCache {
+ public:
+  /** Counters of the cache. */
+  struct Stats {
+    /** Number of lookups that found a header. */
+    uint64_t hits = 0;
+
+    /** Number of lookups that did not find a header. */
+    uint64_t misses = 0;
+
+    /** Number of entries evicted to respect the memory cap. */
+    uint64_t evictions = 0;
+
+    /** Number of cached samples. */
+    uint64_t num_entries = 0;
+
+    /** Estimated size of the cached entries, in bytes. */
+    uint64_t size_bytes = 0;
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param max_bytes Memory cap of the cache; 0 disables caching.
+   */
+  explicit VCFHeaderCache(uint64_t max_bytes = 0);
+
+  /** Sets the memory cap, evicting entries as needed. 0 disables caching. */
+  void set_max_bytes(uint64_t max_bytes);
+
+  /** Returns true if caching is enabled. */
+  bool enabled() const;
+
+  /**
+   * Returns the header of a sample, or nullptr if it is not cached for the
+   * given header array timestamp.
+   */
+  SharedBCFHdr get(const std::string& sample, uint64_t timestamp);
+
+  /**
+   * Adds the header of a sample, replacing any cached header of the sample.
+   *
+   * @param sample Sample name
+   * @param timestamp Timestamp the VCF header array was opened at
+   * @param hdr Parsed header, which may be shared with other samples
+   * @param hdr_bytes Size of the header text
+   */
+  void put(
+      const std::string& sample,
+      uint64_t timestamp,
+      const SharedBCFHdr& hdr,
+      uint64_t hdr_bytes);
+
+  /** Removes all entries. The counters are kept. */
+  void clear();
+
+  /** Returns the counters of the cache. */
+  Stats stats() const;
+
+ private:
+  /** Estimated fixed cost of an entry, in bytes. */
+  static const uint64_t ENTRY_OVERHEAD = 128;
+
+  /** A cached header. */
+  struct Entry {
+    std::string sample;
+    uint64_t timestamp;
+    SharedBCFHdr hdr;
+  };
+
+  /** Number of entries and size of the text of a cached header. */
+  struct HeaderUse {
+    uint64_t num_entries = 0;
+    uint64_t bytes = 0;
+  };
+
+  /** Memory cap. */
+  uint64_t max_bytes_;
+
+  /** Entries, most recently used first. */
+  std::list<Entry> entries_;
+
+  /** Map of sample name -> entry. */
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+
+  /** Entries referencing each cached header. */
+  std::unordered_map<const bcf_hdr_t*, HeaderUse> header_uses_;
+
+  /** Counters. */
+  Stats stats_;
+
+  /** Protects all members. */
+  mutable std::mutex mtx_;
+
+  /** Removes an entry. */
+  void erase(std::list<Entry>::iterator it);
+
+  /** Evicts the least recently used entries until the cap is respected. */
+  void evict();
+};
+
+}  // namespace vcf
+}  // namespace tiledb
+
+#endif  // TILEDB_VCF_VCF_HEADER_CACHE_H
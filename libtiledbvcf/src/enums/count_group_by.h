@@ -0,0 +1,66 @@
+/**
+ * @file count_group_by.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef TILEDB_VCF_COUNT_GROUP_BY_H
+#define TILEDB_VCF_COUNT_GROUP_BY_H
+
+#include <stdexcept>
+#include <string>
+
+namespace tiledb {
+namespace vcf {
+
+/** Defines how the records of a count query are grouped. */
+enum class CountGroupBy {
+#define TILEDB_VCF_COUNT_GROUP_BY_ENUM(id) id
+#include "c_api/tiledbvcf_enum.h"
+#undef TILEDB_VCF_COUNT_GROUP_BY_ENUM
+};
+
+/** Returns the count grouping given a string representation. */
+inline void count_group_by_enum(
+    const std::string& group_by_str, CountGroupBy* group_by) {
+  if (group_by_str.empty() || group_by_str == "none")
+    *group_by = CountGroupBy::COUNT_NONE;
+  else if (group_by_str == "region")
+    *group_by = CountGroupBy::COUNT_BY_REGION;
+  else if (group_by_str == "sample")
+    *group_by = CountGroupBy::COUNT_BY_SAMPLE;
+  else if (group_by_str == "contig")
+    *group_by = CountGroupBy::COUNT_BY_CONTIG;
+  else
+    throw std::runtime_error(
+        "Error converting string '" + group_by_str +
+        "' to count grouping; expected 'region', 'sample' or 'contig'.");
+}
+
+}  // namespace vcf
+}  // namespace tiledb
+
+#endif  // TILEDB_VCF_COUNT_GROUP_BY_H
@@ -101,8 +101,7 @@ void BCFExporter::finalize_export(
 }
 
 std::set<std::string> BCFExporter::array_attributes_required() const {
-  // TODO: currently we require all attributes for record recovery.
-  return dataset_->all_attributes();
+  return record_attributes_required();
 }
 
 void BCFExporter::buffer_record(
@@ -158,7 +157,18 @@ void BCFExporter::init_export_for_sample(
   // Using hts_close because bcf_close is a macro.
   std::unique_ptr<htsFile, decltype(&hts_close)> fp_ptr(fp, hts_close);
 
-  int rc = bcf_hdr_write(fp, const_cast<bcf_hdr_t*>(hdr));
+  // The header may be shared by samples with identical headers, so its
+  // sample column is renamed for the output file.
+  SafeBCFHdr sample_hdr(
+      bcf_hdr_subset(hdr, 0, nullptr, nullptr), bcf_hdr_destroy);
+  if (sample_hdr == nullptr ||
+      bcf_hdr_add_sample(sample_hdr.get(), sample.sample_name.c_str()) < 0 ||
+      bcf_hdr_sync(sample_hdr.get()) < 0)
+    throw std::runtime_error(
+        "Error creating BCF output file '" + path +
+        "'; error creating header for sample " + sample.sample_name + ".");
+
+  int rc = bcf_hdr_write(fp, sample_hdr.get());
   if (rc < 0)
     throw std::runtime_error(
         "Error creating BCF output file '" + path +
@@ -0,0 +1,221 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TILEDB_VCF_CELL_FILTER_AVX2
+#include <immintrin.h>
+#endif
+
+#include "read/cell_filter.h"
+
+namespace tiledb {
+namespace vcf {
+
+CellFilter::CellFilter(
+    const std::vector<uint32_t>& region_mins,
+    const std::vector<uint32_t>& region_maxes,
+    uint32_t anchor_gap)
+    : region_mins_(region_mins)
+    , region_maxes_(region_maxes)
+    , anchor_gap_(anchor_gap) {
+  if (region_mins.size() != region_maxes.size())
+    throw std::runtime_error(
+        "Error creating cell filter; region start and end counts differ.");
+
+  const size_t num_regions = region_mins.size();
+  next_region_mins_.resize(num_regions + 1, UINT32_MAX);
+  for (size_t i = 0; i + 1 < num_regions; i++)
+    next_region_mins_[i] = region_mins[i + 1];
+
+  // Sentinel entries for cells without a candidate region
+  region_mins_.push_back(UINT32_MAX);
+  region_maxes_.push_back(0);
+
+  set_avx2_enabled(true);
+}
+
+void CellFilter::select(
+    const uint32_t* start_pos,
+    const uint32_t* real_start_pos,
+    const uint32_t* end_pos,
+    const size_t* order,
+    uint64_t begin,
+    uint64_t end,
+    RegionIntersector* intersector) {
+  const size_t n = end > begin ? end - begin : 0;
+  start_.resize(n);
+  real_start_.resize(n);
+  end_.resize(n);
+  first_region_.resize(n);
+  result_.resize(n);
+
+  // Gather the columns in visit order and find each cell's first candidate
+  // region. The intersector sweeps forward when real_start is sorted.
+  for (size_t k = 0; k < n; k++) {
+    const uint64_t i = order != nullptr ? order[begin + k] : begin + k;
+    start_[k] = start_pos[i];
+    real_start_[k] = real_start_pos[i];
+    end_[k] = end_pos[i];
+    first_region_[k] =
+        static_cast<uint32_t>(intersector->first_intersecting(real_start_[k]));
+  }
+
+  size_t k = 0;
+  if (use_avx2_)
+    k = kernel_avx2(n);
+  kernel_scalar(k, n);
+
+  selected_.clear();
+  for (k = 0; k < n; k++) {
+    if (result_[k] != DISCARD)
+      selected_.push_back(
+          {begin + k, first_region_[k], result_[k] == SCAN_REGIONS});
+  }
+}
+
+const std::vector<CellFilter::SelectedCell>& CellFilter::selected() const {
+  return selected_;
+}
+
+void CellFilter::set_avx2_enabled(bool enabled) {
+#ifdef TILEDB_VCF_CELL_FILTER_AVX2
+  use_avx2_ = enabled && __builtin_cpu_supports("avx2");
+#else
+  (void)enabled;
+  use_avx2_ = false;
+#endif
+}
+
+bool CellFilter::avx2_enabled() const {
+  return use_avx2_;
+}
+
+void CellFilter::kernel_scalar(size_t begin, size_t n) {
+  const uint32_t num_regions = region_mins_.size() - 1;
+  const uint32_t g = anchor_gap_;
+
+  for (size_t k = begin; k < n; k++) {
+    const uint32_t j = first_region_[k];
+    const uint32_t reg_min = region_mins_[j];
+    const uint32_t reg_max = region_maxes_[j];
+    const uint32_t start = start_[k];
+    const uint32_t real_start = real_start_[k];
+    const uint32_t end = end_[k];
+
+    // Same checks as the region loop in Reader::process_query_results_v4
+    const bool match = (real_start <= reg_max) & (end >= reg_min) &
+                       ((start == real_start) | (start < reg_min)) &
+                       ((reg_min <= g) | (start >= reg_min - g));
+
+    // Regions are sorted on start, so only a cell reaching the next region
+    // can intersect more than one.
+    const bool scan = end >= next_region_mins_[j];
+
+    const uint8_t result = scan ? SCAN_REGIONS : match ? FIRST_REGION : DISCARD;
+    result_[k] = j < num_regions ? result : DISCARD;
+  }
+}
+
+#ifdef TILEDB_VCF_CELL_FILTER_AVX2
+
+namespace {
+
+/** Unsigned a <= b for each 32-bit lane. */
+__attribute__((target("avx2"))) inline __m256i le_epu32(__m256i a, __m256i b) {
+  return _mm256_cmpeq_epi32(_mm256_max_epu32(a, b), b);
+}
+
+}  // namespace
+
+__attribute__((target("avx2"))) size_t CellFilter::kernel_avx2(size_t n) {
+  const int num_regions = static_cast<int>(region_mins_.size() - 1);
+  const int* mins = reinterpret_cast<const int*>(region_mins_.data());
+  const int* maxes = reinterpret_cast<const int*>(region_maxes_.data());
+  const int* next_mins = reinterpret_cast<const int*>(next_region_mins_.data());
+
+  const __m256i g = _mm256_set1_epi32(static_cast<int>(anchor_gap_));
+  const __m256i nreg = _mm256_set1_epi32(num_regions);
+  const __m256i ones = _mm256_set1_epi32(-1);
+  const __m256i first_region_code = _mm256_set1_epi32(FIRST_REGION);
+  const __m256i scan_regions_code = _mm256_set1_epi32(SCAN_REGIONS);
+  alignas(32) int32_t results[8];
+
+  size_t k = 0;
+  for (; k + 8 <= n; k += 8) {
+    const __m256i j = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(first_region_.data() + k));
+    const __m256i start = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(start_.data() + k));
+    const __m256i real_start = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(real_start_.data() + k));
+    const __m256i end =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(end_.data() + k));
+
+    const __m256i reg_min = _mm256_i32gather_epi32(mins, j, 4);
+    const __m256i reg_max = _mm256_i32gather_epi32(maxes, j, 4);
+    const __m256i next_min = _mm256_i32gather_epi32(next_mins, j, 4);
+
+    __m256i match = _mm256_and_si256(
+        le_epu32(real_start, reg_max), le_epu32(reg_min, end));
+    match = _mm256_and_si256(
+        match,
+        _mm256_or_si256(
+            _mm256_cmpeq_epi32(start, real_start),
+            _mm256_xor_si256(le_epu32(reg_min, start), ones)));
+    match = _mm256_and_si256(
+        match,
+        _mm256_or_si256(
+            le_epu32(reg_min, g),
+            le_epu32(_mm256_sub_epi32(reg_min, g), start)));
+
+    const __m256i scan = le_epu32(next_min, end);
+    const __m256i valid = _mm256_cmpgt_epi32(nreg, j);
+
+    __m256i result = _mm256_or_si256(
+        _mm256_and_si256(scan, scan_regions_code),
+        _mm256_and_si256(_mm256_andnot_si256(scan, match), first_region_code));
+    result = _mm256_and_si256(result, valid);
+
+    _mm256_store_si256(reinterpret_cast<__m256i*>(results), result);
+    for (int l = 0; l < 8; l++)
+      result_[k + l] = static_cast<uint8_t>(results[l]);
+  }
+
+  return k;
+}
+
+#else
+
+size_t CellFilter::kernel_avx2(size_t) {
+  return 0;
+}
+
+#endif
+
+}  // namespace vcf
+}  // namespace tiledb
@@ -0,0 +1,187 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TILEDB_VCF_CELL_FILTER_H
+#define TILEDB_VCF_CELL_FILTER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "read/region_intersector.h"
+
+namespace tiledb {
+namespace vcf {
+
+/**
+ * Batch filter deciding which v4 result cells intersect the regions of their
+ * contig, and how they must be reported.
+ *
+ * Filtering runs in two passes over the position columns. The first pass
+ * finds each cell's first candidate region with a RegionIntersector. The
+ * second, branch-free pass evaluates the region and anchor gap checks against
+ * that candidate region, using AVX2 when the CPU supports it. Most cells
+ * intersect at most one region, so the report loop only needs to walk the
+ * selected cells, and only scans further regions for cells whose end position
+ * reaches the next region.
+ */
+class CellFilter {
+ public:
+  /** A cell that passed the filter. */
+  struct SelectedCell {
+    /** Position of the cell in the visit order. */
+    uint64_t pos;
+
+    /** Index (relative to the contig's regions) of the first region. */
+    uint32_t first_region;
+
+    /**
+     * If false, the cell intersects only first_region. If true, the cell may
+     * intersect first_region and later regions, which must be checked.
+     */
+    bool scan_regions;
+  };
+
+  /** Constructor. */
+  CellFilter() = default;
+
+  /**
+   * Constructor.
+   *
+   * @param region_mins Start positions of the contig's regions, in region
+   *    order.
+   * @param region_maxes End positions of the contig's regions, in region order.
+   * @param anchor_gap Anchor gap of the dataset.
+   */
+  CellFilter(
+      const std::vector<uint32_t>& region_mins,
+      const std::vector<uint32_t>& region_maxes,
+      uint32_t anchor_gap);
+
+  /**
+   * Filters the cells at positions [begin, end) of the visit order. The
+   * selected cells are available from selected() afterwards, in visit order.
+   *
+   * @param start_pos start_pos column
+   * @param real_start_pos real_start_pos column
+   * @param end_pos end_pos column
+   * @param order Cell index for each visit position, or nullptr to visit the
+   *    cells in column order.
+   * @param begin First visit position to filter
+   * @param end One past the last visit position to filter
+   * @param intersector Intersector for the contig's regions
+   */
+  void select(
+      const uint32_t* start_pos,
+      const uint32_t* real_start_pos,
+      const uint32_t* end_pos,
+      const size_t* order,
+      uint64_t begin,
+      uint64_t end,
+      RegionIntersector* intersector);
+
+  /** Returns the cells selected by the last call to select(). */
+  const std::vector<SelectedCell>& selected() const;
+
+  /** Removes the selected cells for which `keep` returns false. */
+  template <typename F>
+  void retain(F keep) {
+    selected_.erase(
+        std::remove_if(
+            selected_.begin(),
+            selected_.end(),
+            [&keep](const SelectedCell& cell) { return !keep(cell); }),
+        selected_.end());
+  }
+
+  /**
+   * Enables or disables the AVX2 kernel. It is only enabled if the CPU
+   * supports it.
+   */
+  void set_avx2_enabled(bool enabled);
+
+  /** Returns true if the AVX2 kernel is in use. */
+  bool avx2_enabled() const;
+
+ private:
+  /** Result of the kernel: the cell does not intersect any region. */
+  static const uint8_t DISCARD = 0;
+
+  /** Result of the kernel: the cell intersects only its first region. */
+  static const uint8_t FIRST_REGION = 1;
+
+  /** Result of the kernel: the cell may intersect several regions. */
+  static const uint8_t SCAN_REGIONS = 2;
+
+  /**
+   * Region start positions, followed by a sentinel entry for cells without
+   * a candidate region.
+   */
+  std::vector<uint32_t> region_mins_;
+
+  /** Region end positions, followed by a sentinel entry. */
+  std::vector<uint32_t> region_maxes_;
+
+  /**
+   * Start position of the region following each region (UINT32_MAX for the
+   * last region), followed by a sentinel entry.
+   */
+  std::vector<uint32_t> next_region_mins_;
+
+  /** Anchor gap of the dataset. */
+  uint32_t anchor_gap_ = 0;
+
+  /** True if the AVX2 kernel is in use. */
+  bool use_avx2_ = false;
+
+  /** Position columns gathered in visit order for the current batch. */
+  std::vector<uint32_t> start_;
+  std::vector<uint32_t> real_start_;
+  std::vector<uint32_t> end_;
+
+  /** First candidate region of each cell in the current batch. */
+  std::vector<uint32_t> first_region_;
+
+  /** Kernel result for each cell in the current batch. */
+  std::vector<uint8_t> result_;
+
+  /** Cells selected in the current batch. */
+  std::vector<SelectedCell> selected_;
+
+  /** Portable kernel, evaluating cells [begin, n) of the current batch. */
+  void kernel_scalar(size_t begin, size_t n);
+
+  /**
+   * AVX2 kernel, evaluating cells [0, n) of the current batch. Returns the
+   * number of cells evaluated, which is a multiple of the vector width.
+   */
+  size_t kernel_avx2(size_t n);
+};
+
+}  // namespace vcf
+}  // namespace tiledb
+
+#endif  // TILEDB_VCF_CELL_FILTER_H
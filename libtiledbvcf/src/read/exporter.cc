@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "read/exporter.h"
 
 namespace tiledb {
@@ -16,6 +18,84 @@ void Exporter::set_dataset(const TileDBVCFDataset* dataset) {
   dataset_ = dataset;
 }
 
+void Exporter::set_field_selection(
+    const std::vector<std::string>& include,
+    const std::vector<std::string>& exclude) {
+  if (!include.empty() && !exclude.empty())
+    throw std::runtime_error(
+        "Error setting exported fields; cannot both include and exclude "
+        "fields.");
+
+  const auto& fields = include.empty() ? exclude : include;
+  select_fields_ = !fields.empty();
+  exclude_fields_ = !exclude.empty();
+  all_info_fields_ = false;
+  all_fmt_fields_ = false;
+  info_fields_.clear();
+  fmt_fields_.clear();
+  for (const auto& field : fields) {
+    if (field == "info") {
+      all_info_fields_ = true;
+    } else if (field == "fmt") {
+      all_fmt_fields_ = true;
+    } else {
+      auto parts = TileDBVCFDataset::split_info_fmt_attr_name(field);
+      if (parts.first == "info")
+        info_fields_.insert(parts.second);
+      else
+        fmt_fields_.insert(parts.second);
+    }
+  }
+}
+
+bool Exporter::field_selected(bool is_info, std::string_view name) const {
+  if (!select_fields_)
+    return true;
+  const bool listed = is_info ?
+                          all_info_fields_ || info_fields_.count(name) > 0 :
+                          all_fmt_fields_ || fmt_fields_.count(name) > 0;
+  return listed != exclude_fields_;
+}
+
+bool Exporter::blob_required(bool is_info) const {
+  if (!select_fields_)
+    return true;
+  const bool all = is_info ? all_info_fields_ : all_fmt_fields_;
+  if (exclude_fields_)
+    return !all;
+  if (all)
+    return true;
+
+  // Included fields that are extracted attributes are not in the blob.
+  const auto& extracted = dataset_->metadata().extra_attributes;
+  const std::string prefix = is_info ? "info_" : "fmt_";
+  for (const auto& name : is_info ? info_fields_ : fmt_fields_) {
+    if (std::find(extracted.begin(), extracted.end(), prefix + name) ==
+        extracted.end())
+      return true;
+  }
+  return false;
+}
+
+std::set<std::string> Exporter::record_attributes_required() const {
+  std::set<std::string> result = dataset_->all_attributes();
+  if (!select_fields_)
+    return result;
+
+  // The blob attribute names are the same in all dataset versions.
+  if (!blob_required(true))
+    result.erase(TileDBVCFDataset::AttrNames::V4::info);
+  if (!blob_required(false))
+    result.erase(TileDBVCFDataset::AttrNames::V4::fmt);
+
+  for (const auto& attr : dataset_->metadata().extra_attributes) {
+    auto parts = TileDBVCFDataset::split_info_fmt_attr_name(attr);
+    if (!field_selected(parts.first == "info", parts.second))
+      result.erase(attr);
+  }
+  return result;
+}
+
 void Exporter::upload_exported_files(
     const VFS& vfs, const std::string& upload_dir) const {
   if (upload_dir.empty())
@@ -90,7 +170,8 @@ void Exporter::recover_record(
 
   // Only update the END field if it exists in the header
   int inf_id = bcf_hdr_id2int(hdr, BCF_DT_ID, "END");
-  if (bcf_hdr_idinfo_exists(hdr, BCF_HL_INFO, inf_id)) {
+  if (bcf_hdr_idinfo_exists(hdr, BCF_HL_INFO, inf_id) &&
+      field_selected(true, "END")) {
     end += 1;
     st = bcf_update_info(hdr, dst, "END", &end, 1, BCF_HT_INT);
     if (st < 0)
@@ -104,12 +185,20 @@ void Exporter::recover_record(
     throw std::runtime_error(
         "Record recovery error; Error adding ID, " + std::to_string(st));
 
-  const uint64_t info_offset = buffers->info().offsets()[cell_idx];
-  const char* info_ptr = buffers->info().data<char>() + info_offset;
-  unsigned num_info_fields = *(uint32_t*)info_ptr;
-  info_ptr += sizeof(uint32_t);
+  // The blobs are not read if none of their fields are exported.
+  const bool read_info = blob_required(true);
+  const bool read_fmt = blob_required(false);
+
   // Reusable buffer for string-valued fields.
   std::string str_buffer;
+  const char* info_ptr = nullptr;
+  unsigned num_info_fields = 0;
+  if (read_info) {
+    const uint64_t info_offset = buffers->info().offsets()[cell_idx];
+    info_ptr = buffers->info().data<char>() + info_offset;
+    num_info_fields = *(uint32_t*)info_ptr;
+    info_ptr += sizeof(uint32_t);
+  }
   for (unsigned i = 0; i < num_info_fields; ++i) {
     const char* key = info_ptr;
     size_t key_nbytes = strlen(key) + 1;
@@ -120,6 +209,11 @@ void Exporter::recover_record(
     int nvalues = *(int*)(info_ptr);
     info_ptr += sizeof(int);
 
+    if (!field_selected(true, key)) {
+      info_ptr += nvalues * utils::bcf_type_size(type);
+      continue;
+    }
+
     // For string types, bcf_update_info requires null-termination.
     if (type == BCF_HT_STR) {
       str_buffer.clear();
@@ -140,10 +234,14 @@ void Exporter::recover_record(
     info_ptr += nvalues * utils::bcf_type_size(type);
   }
 
-  const uint64_t fmt_offset = buffers->fmt().offsets()[cell_idx];
-  const char* fmt_ptr = buffers->fmt().data<char>() + fmt_offset;
-  unsigned num_fmt_fields = *(uint32_t*)fmt_ptr;
-  fmt_ptr += sizeof(uint32_t);
+  const char* fmt_ptr = nullptr;
+  unsigned num_fmt_fields = 0;
+  if (read_fmt) {
+    const uint64_t fmt_offset = buffers->fmt().offsets()[cell_idx];
+    fmt_ptr = buffers->fmt().data<char>() + fmt_offset;
+    num_fmt_fields = *(uint32_t*)fmt_ptr;
+    fmt_ptr += sizeof(uint32_t);
+  }
   for (unsigned i = 0; i < num_fmt_fields; ++i) {
     const char* key = fmt_ptr;
     size_t key_nbytes = strlen(key) + 1;
@@ -154,6 +252,11 @@ void Exporter::recover_record(
     int nvalues = *(int*)(fmt_ptr);
     fmt_ptr += sizeof(int);
 
+    if (!field_selected(false, key)) {
+      fmt_ptr += nvalues * utils::bcf_type_size(type);
+      continue;
+    }
+
     // For string types, bcf_update_format requires null-termination.
     if (type == BCF_HT_STR) {
       str_buffer.clear();
@@ -183,6 +286,10 @@ void Exporter::recover_record(
     const bool is_info = parts.first == "info";
     const auto& field_name = parts.second;
 
+    // Extracted attributes may also be read for the record filter.
+    if (!field_selected(is_info, field_name))
+      continue;
+
     auto sizes_iter = results.extra_attrs_size().find(attr.first);
     if (sizes_iter == results.extra_attrs_size().end())
       throw std::runtime_error(
@@ -197,14 +304,25 @@ void Exporter::recover_record(
                                        attr.second.offsets()[cell_idx + 1]) -
         attr.second.offsets()[cell_idx];
 
-    // Check if field exists for this record (check for dummy value).
-    if (field_nbytes == 1 && *field_ptr == 0)
-      continue;
-
-    int type = *(int*)(field_ptr);
-    field_ptr += sizeof(int);
-    int nvalues = *(int*)(field_ptr);
-    field_ptr += sizeof(int);
+    int type;
+    int nvalues;
+    tiledb_datatype_t datatype;
+    if (dataset_->is_attribute_typed(attr.first, &datatype)) {
+      // Typed attributes hold the values only, and are null if missing.
+      if (attr.second.validity()[cell_idx] == 0)
+        continue;
+      type = datatype == TILEDB_FLOAT32 ? BCF_HT_REAL : BCF_HT_INT;
+      nvalues = field_nbytes / attr.second.value_size();
+    } else {
+      // Check if field exists for this record (check for dummy value).
+      if (field_nbytes == 1 && *field_ptr == 0)
+        continue;
+
+      type = *(int*)(field_ptr);
+      field_ptr += sizeof(int);
+      nvalues = *(int*)(field_ptr);
+      field_ptr += sizeof(int);
+    }
 
     const char* values_ptr = field_ptr;
 
@@ -238,6 +356,25 @@ void Exporter::recover_record(
   }
 }
 
+uint64_t Exporter::export_records(
+    const ReadQueryResults& query_results,
+    const std::vector<ExportRow>& rows) {
+  SampleAndId sample{};
+  for (uint64_t i = 0; i < rows.size(); i++) {
+    const ExportRow& row = rows[i];
+    sample.sample_name.assign(row.sample_name);
+    if (!export_record(
+            sample,
+            row.sample_hdr,
+            *row.query_region,
+            row.query_contig_offset,
+            query_results,
+            row.cell_idx))
+      return i;
+  }
+  return rows.size();
+}
+
 bool Exporter::need_headers() const {
   return need_headers_;
 }
@@ -27,6 +27,8 @@
 #ifndef TILEDB_VCF_EXPORTER_H
 #define TILEDB_VCF_EXPORTER_H
 
+#include <string_view>
+
 #include "dataset/tiledbvcfdataset.h"
 #include "read/export_format.h"
 #include "read_query_results.h"
@@ -38,6 +40,24 @@ namespace vcf {
 /** Abstract interface for exporting extracted records to disk or in-memory. */
 class Exporter {
  public:
+  /** A record to export with export_records(). */
+  struct ExportRow {
+    /** Name of the sample that the record belongs to. */
+    std::string_view sample_name;
+
+    /** Header of the sample, or nullptr if headers are not loaded. */
+    const bcf_hdr_t* sample_hdr;
+
+    /** The query region that intersected the record. */
+    const Region* query_region;
+
+    /** Global offset of contig of query_region. */
+    uint32_t query_contig_offset;
+
+    /** The index of the cell of the record to export. */
+    uint64_t cell_idx;
+  };
+
   /** Constructor */
   Exporter();
 
@@ -56,6 +76,18 @@ class Exporter {
   /** Sets the dataset being exported. */
   void set_dataset(const TileDBVCFDataset* dataset);
 
+  /**
+   * Restricts the INFO/FMT fields of the exported records. Fields are named
+   * "info_<name>" or "fmt_<name>"; "info" and "fmt" select all fields of that
+   * kind. At most one of the two lists can be non-empty.
+   *
+   * @param include If non-empty, only these fields are exported.
+   * @param exclude If non-empty, all fields except these are exported.
+   */
+  void set_field_selection(
+      const std::vector<std::string>& include,
+      const std::vector<std::string>& exclude);
+
   /** Upload any/all exported files to the given local or remote (S3) URI. */
   void upload_exported_files(
       const VFS& vfs, const std::string& upload_dir) const;
@@ -80,6 +112,19 @@ class Exporter {
       const ReadQueryResults& query_results,
       uint64_t cell_idx) = 0;
 
+  /**
+   * Exports a batch of BCF records, in order. The default implementation
+   * calls export_record() for each row.
+   *
+   * @param query_results From TileDB, the query results for all cells.
+   * @param rows The records to export.
+   * @return The number of rows exported, less than the number of rows if
+   *    in-memory buffers are full.
+   */
+  virtual uint64_t export_records(
+      const ReadQueryResults& query_results,
+      const std::vector<ExportRow>& rows);
+
   /**
    * Finalize export of the given sample (after which no more records for the
    * sample are allowed to be exported).
@@ -115,6 +160,35 @@ class Exporter {
   /** Does the exporter need headers */
   bool need_headers_ = false;
 
+  /** True if set_field_selection() restricted the exported fields. */
+  bool select_fields_ = false;
+
+  /** True if the selected fields are the ones to exclude. */
+  bool exclude_fields_ = false;
+
+  /** True if all INFO (resp. FMT) fields are listed in the selection. */
+  bool all_info_fields_ = false;
+  bool all_fmt_fields_ = false;
+
+  /** Names (without prefix) of the INFO and FMT fields in the selection. */
+  std::set<std::string, std::less<>> info_fields_;
+  std::set<std::string, std::less<>> fmt_fields_;
+
+  /** Returns true if the given INFO or FMT field is exported. */
+  bool field_selected(bool is_info, std::string_view name) const;
+
+  /**
+   * Returns true if the info (or fmt) blob attribute is needed to recover the
+   * selected fields.
+   */
+  bool blob_required(bool is_info) const;
+
+  /**
+   * Returns the dataset attributes needed by recover_record() for the
+   * selected fields.
+   */
+  std::set<std::string> record_attributes_required() const;
+
   /**
    * Given the TileDB query results, populates the htslib record struct with
    * the corresponding attribute values for a particular cell.
@@ -0,0 +1,279 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <htslib/vcf.h>
+
+#include "read/genotype_matrix.h"
+
+namespace tiledb {
+namespace vcf {
+
+namespace {
+
+/** Number of rows the file is first mapped with. */
+const uint64_t initial_file_rows = 1024;
+
+}  // namespace
+
+GenotypeMatrix::GenotypeMatrix(const std::vector<std::string>& samples)
+    : samples_(samples)
+    , genotype_bytes_((2 * samples.size() + 7) / 8)
+    , row_bytes_(row_bytes(samples.size()))
+    , last_contig_(0)
+    , data_(nullptr)
+    , capacity_(0)
+    , fd_(-1) {
+  for (uint32_t i = 0; i < samples_.size(); i++)
+    columns_[samples_[i]] = i;
+}
+
+GenotypeMatrix::~GenotypeMatrix() {
+  close_file();
+}
+
+uint64_t GenotypeMatrix::row_bytes(uint64_t num_samples) {
+  return (2 * num_samples + 7) / 8 + (num_samples + 7) / 8;
+}
+
+void GenotypeMatrix::set_buffer(uint8_t* buffer, uint64_t size) {
+  close_file();
+  data_ = buffer;
+  capacity_ = row_bytes_ == 0 ? UINT64_MAX : size / row_bytes_;
+}
+
+void GenotypeMatrix::set_file(const std::string& path) {
+  close_file();
+  data_ = nullptr;
+  capacity_ = 0;
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0)
+    throw std::runtime_error(
+        "Error opening genotype matrix file '" + path +
+        "': " + std::strerror(errno));
+  path_ = path;
+  map_file(initial_file_rows);
+}
+
+void GenotypeMatrix::add(
+    const std::string& contig,
+    uint32_t pos,
+    std::string_view alleles,
+    std::string_view sample,
+    const int32_t* gt,
+    int num_gt) {
+  auto col_it = columns_.find(sample);
+  if (col_it == columns_.end())
+    throw std::runtime_error(
+        "Error adding to genotype matrix; sample '" + std::string(sample) +
+        "' is not a column of the matrix.");
+  const uint32_t col = col_it->second;
+  uint8_t* row = data_ + this->row(contig, pos, alleles) * row_bytes_;
+
+  bool called = num_gt > 0;
+  int num_alt = 0;
+  for (int i = 0; i < num_gt; i++) {
+    if (gt[i] == bcf_int32_vector_end)
+      break;
+    if (bcf_gt_is_missing(gt[i])) {
+      called = false;
+      break;
+    }
+    if (bcf_gt_allele(gt[i]) > 0)
+      num_alt++;
+  }
+  if (num_alt > 3)
+    throw std::runtime_error(
+        "Error adding to genotype matrix; genotype of sample '" +
+        std::string(sample) + "' has " + std::to_string(num_alt) +
+        " ALT alleles, more than fit in 2 bits.");
+
+  const int shift = 2 * (col % 4);
+  row[col / 4] = (row[col / 4] & ~(3 << shift)) | (num_alt << shift);
+  uint8_t& missing = row[genotype_bytes_ + col / 8];
+  if (called)
+    missing &= ~(1 << (col % 8));
+  else
+    missing |= 1 << (col % 8);
+}
+
+void GenotypeMatrix::finish() {
+  if (fd_ < 0)
+    return;
+
+  const uint64_t size = variants_.size() * row_bytes_;
+  if (data_ != nullptr)
+    munmap(data_, capacity_ * row_bytes_);
+  data_ = nullptr;
+  capacity_ = 0;
+  if (ftruncate(fd_, size) != 0)
+    throw std::runtime_error(
+        "Error truncating genotype matrix file '" + path_ +
+        "': " + std::strerror(errno));
+  if (size > 0)
+    map_file(variants_.size());
+}
+
+void GenotypeMatrix::reset() {
+  variants_.clear();
+  contigs_.clear();
+  last_contig_ = 0;
+  position_rows_.clear();
+}
+
+uint64_t GenotypeMatrix::num_rows() const {
+  return variants_.size();
+}
+
+uint64_t GenotypeMatrix::row_bytes() const {
+  return row_bytes_;
+}
+
+const uint8_t* GenotypeMatrix::data() const {
+  return data_;
+}
+
+const std::vector<std::string>& GenotypeMatrix::samples() const {
+  return samples_;
+}
+
+const std::vector<GenotypeMatrix::Variant>& GenotypeMatrix::variants() const {
+  return variants_;
+}
+
+uint64_t GenotypeMatrix::row(
+    const std::string& contig, uint32_t pos, std::string_view alleles) {
+  const bool same_contig = last_contig_ < contigs_.size() &&
+                           contigs_[last_contig_].first == contig;
+  if (same_contig && pos == key_.first) {
+    for (uint64_t row : position_rows_) {
+      if (variants_[row].alleles == alleles)
+        return row;
+    }
+  } else {
+    position_rows_.clear();
+  }
+
+  // The lookup key is reused to avoid an allocation per record.
+  auto& contig_rows = this->contig_rows(contig);
+  key_.first = pos;
+  key_.second.assign(alleles.data(), alleles.size());
+  auto it = contig_rows.find(key_);
+  if (it == contig_rows.end()) {
+    reserve_row();
+    const uint64_t row = variants_.size();
+    Variant variant;
+    variant.contig = contig;
+    variant.pos = pos + 1;
+    variant.alleles = key_.second;
+    variants_.push_back(std::move(variant));
+    it = contig_rows.emplace(key_, row).first;
+
+    // Genotypes are 0 and all samples missing until their record is added.
+    uint8_t* data = data_ + row * row_bytes_;
+    std::memset(data, 0, genotype_bytes_);
+    std::memset(data + genotype_bytes_, 0xff, row_bytes_ - genotype_bytes_);
+    if (samples_.size() % 8 != 0)
+      data[row_bytes_ - 1] = (1 << (samples_.size() % 8)) - 1;
+  }
+  position_rows_.push_back(it->second);
+  return it->second;
+}
+
+GenotypeMatrix::ContigRows& GenotypeMatrix::contig_rows(
+    const std::string& contig) {
+  if (last_contig_ < contigs_.size() && contigs_[last_contig_].first == contig)
+    return contigs_[last_contig_].second;
+
+  for (last_contig_ = 0; last_contig_ < contigs_.size(); last_contig_++) {
+    if (contigs_[last_contig_].first == contig)
+      return contigs_[last_contig_].second;
+  }
+  contigs_.emplace_back(contig, ContigRows());
+  return contigs_.back().second;
+}
+
+void GenotypeMatrix::reserve_row() {
+  if (variants_.size() < capacity_)
+    return;
+
+  if (fd_ < 0) {
+    if (data_ == nullptr && row_bytes_ > 0)
+      throw std::runtime_error(
+          "Error adding to genotype matrix; no buffer or file set.");
+    throw std::runtime_error(
+        "Error adding to genotype matrix; buffer full after " +
+        std::to_string(variants_.size()) + " rows.");
+  }
+  map_file(std::max(2 * capacity_, initial_file_rows));
+}
+
+void GenotypeMatrix::map_file(uint64_t capacity) {
+  if (data_ != nullptr)
+    munmap(data_, capacity_ * row_bytes_);
+  data_ = nullptr;
+  capacity_ = 0;
+  if (row_bytes_ == 0) {
+    capacity_ = UINT64_MAX;
+    return;
+  }
+
+  const uint64_t size = capacity * row_bytes_;
+  if (ftruncate(fd_, size) != 0)
+    throw std::runtime_error(
+        "Error growing genotype matrix file '" + path_ +
+        "': " + std::strerror(errno));
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED)
+    throw std::runtime_error(
+        "Error mapping genotype matrix file '" + path_ +
+        "': " + std::strerror(errno));
+  data_ = static_cast<uint8_t*>(data);
+  capacity_ = capacity;
+}
+
+void GenotypeMatrix::close_file() {
+  if (fd_ < 0)
+    return;
+  if (data_ != nullptr)
+    munmap(data_, capacity_ * row_bytes_);
+  ::close(fd_);
+  fd_ = -1;
+  data_ = nullptr;
+  capacity_ = 0;
+  path_.clear();
+}
+
+}  // namespace vcf
+}  // namespace tiledb
@@ -0,0 +1,206 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TILEDB_VCF_GENOTYPE_MATRIX_H
+#define TILEDB_VCF_GENOTYPE_MATRIX_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tiledb {
+namespace vcf {
+
+/**
+ * Dense, bit-packed matrix of the genotypes of a genotype matrix query, with
+ * one row per variant (contig, position, alleles) and one column per sample.
+ *
+ * Each row is stored as 2 bits per sample holding the number of ALT alleles
+ * of its call (0, 1 or 2 for a diploid call), followed by 1 bit per sample
+ * set if the call is missing: the sample has no record of the variant, or an
+ * allele of its genotype is missing. Samples are packed from the least
+ * significant bits of each byte, and the missing bits start on a byte
+ * boundary.
+ *
+ * Rows are appended in the order their variants are first added, and are
+ * written to caller-provided memory or to a memory-mapped file that grows as
+ * rows are added.
+ */
+class GenotypeMatrix {
+ public:
+  /** The variant of a row. */
+  struct Variant {
+    /** Contig of the variant. */
+    std::string contig;
+
+    /** 1-based position of the variant. */
+    uint32_t pos = 0;
+
+    /** CSV list of the alleles, REF first. */
+    std::string alleles;
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param samples Names of the samples of the columns, in order
+   */
+  explicit GenotypeMatrix(const std::vector<std::string>& samples);
+
+  /** Destructor; unmaps the file, if any. */
+  ~GenotypeMatrix();
+
+  GenotypeMatrix(const GenotypeMatrix&) = delete;
+  GenotypeMatrix& operator=(const GenotypeMatrix&) = delete;
+
+  /** Returns the number of bytes of a row of a matrix of the given width. */
+  static uint64_t row_bytes(uint64_t num_samples);
+
+  /**
+   * Writes the rows to the given memory. Adding a row that does not fit
+   * throws.
+   */
+  void set_buffer(uint8_t* buffer, uint64_t size);
+
+  /**
+   * Writes the rows to a memory-mapped file at the given local path, which is
+   * created or truncated. The file is truncated to the size of the rows by
+   * finish().
+   */
+  void set_file(const std::string& path);
+
+  /**
+   * Adds the genotype of a sample's record, adding the row of its variant if
+   * needed.
+   *
+   * @param contig Contig of the record
+   * @param pos 0-based start position of the record
+   * @param alleles CSV list of the alleles of the record, REF first
+   * @param sample Name of the sample of the record
+   * @param gt BCF-encoded genotype values, or nullptr if the record has none
+   * @param num_gt Number of genotype values
+   */
+  void add(
+      const std::string& contig,
+      uint32_t pos,
+      std::string_view alleles,
+      std::string_view sample,
+      const int32_t* gt,
+      int num_gt);
+
+  /** Flushes the rows, truncating the file (if any) to their size. */
+  void finish();
+
+  /** Removes all rows. */
+  void reset();
+
+  /** Returns the number of rows. */
+  uint64_t num_rows() const;
+
+  /** Returns the number of bytes of a row. */
+  uint64_t row_bytes() const;
+
+  /** Returns the matrix data, valid until the next row is added. */
+  const uint8_t* data() const;
+
+  /** Returns the samples of the columns. */
+  const std::vector<std::string>& samples() const;
+
+  /** Returns the variants of the rows. */
+  const std::vector<Variant>& variants() const;
+
+ private:
+  /** Rows of a contig, keyed by (0-based position, alleles). */
+  typedef std::pair<uint32_t, std::string> VariantKey;
+  typedef std::map<VariantKey, uint64_t> ContigRows;
+
+  /** Samples of the columns. */
+  std::vector<std::string> samples_;
+
+  /** Column of each sample, keyed by views of samples_. */
+  std::unordered_map<std::string_view, uint32_t> columns_;
+
+  /** Number of bytes of the genotype bits of a row. */
+  uint64_t genotype_bytes_;
+
+  /** Number of bytes of a row. */
+  uint64_t row_bytes_;
+
+  /** Variants of the rows. */
+  std::vector<Variant> variants_;
+
+  /** Rows of each contig, in the order the contigs were added. */
+  std::vector<std::pair<std::string, ContigRows>> contigs_;
+
+  /** Index in contigs_ of the contig of the last added record. */
+  size_t last_contig_;
+
+  /**
+   * Rows at the position of the last added record. Sorted results add all
+   * records of a position in a row, so most lookups stop here.
+   */
+  std::vector<uint64_t> position_rows_;
+
+  /** Reusable lookup key. */
+  VariantKey key_;
+
+  /** Storage of the rows. */
+  uint8_t* data_;
+
+  /** Number of rows the storage can hold. */
+  uint64_t capacity_;
+
+  /** Descriptor of the memory-mapped file, or -1. */
+  int fd_;
+
+  /** Path of the memory-mapped file. */
+  std::string path_;
+
+  /** Returns the row of the given variant, adding it if needed. */
+  uint64_t row(
+      const std::string& contig, uint32_t pos, std::string_view alleles);
+
+  /** Returns the rows of the given contig. */
+  ContigRows& contig_rows(const std::string& contig);
+
+  /** Makes room for one more row. */
+  void reserve_row();
+
+  /** Maps the file with room for the given number of rows. */
+  void map_file(uint64_t capacity);
+
+  /** Unmaps and closes the file, if any. */
+  void close_file();
+};
+
+}  // namespace vcf
+}  // namespace tiledb
+
+#endif  // TILEDB_VCF_GENOTYPE_MATRIX_H
@@ -24,12 +24,40 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 #include "read/in_memory_exporter.h"
 #include "enums/attr_datatype.h"
 
 namespace tiledb {
 namespace vcf {
 
+namespace {
+
+/**
+ * Gathers a fixed-width value per row into the given buffer.
+ *
+ * @param dest Start of the values to write
+ * @param rows Rows to gather
+ * @param num_rows Number of rows to gather
+ * @param value Returns the value of a row
+ */
+template <typename T, typename F>
+void gather_column(
+    char* dest,
+    const std::vector<Exporter::ExportRow>& rows,
+    uint64_t num_rows,
+    const F& value) {
+  for (uint64_t r = 0; r < num_rows; r++) {
+    const T v = value(rows[r]);
+    std::memcpy(dest + r * sizeof(T), &v, sizeof(T));
+  }
+}
+
+}  // namespace
+
 void InMemoryExporter::set_buffer_values(
     const std::string& attribute, void* buff, int64_t buff_size) {
   if (buff == nullptr) {
@@ -45,11 +73,17 @@ void InMemoryExporter::set_buffer_values(
 
 void InMemoryExporter::set_buffer_offsets(
     const std::string& attribute, int32_t* buff, int64_t buff_size) {
-  if (fixed_len_attr(attribute) && buff != nullptr) {
+  // Dictionary-encoded alleles keep offsets delimiting the indices of each
+  // record; the other dictionary-encoded attributes are fixed-length.
+  const bool fixed_len =
+      fixed_len_attr(attribute) || (dictionary_attrs_.count(attribute) > 0 &&
+                                    attr_name_to_enum(attribute) !=
+                                        ExportableAttribute::Alleles);
+  if (fixed_len && buff != nullptr) {
     throw std::runtime_error(
         "Error setting buffer; attribute '" + attribute +
         "' is fixed-length but offset buffer was provided.");
-  } else if (!fixed_len_attr(attribute) && buff == nullptr) {
+  } else if (!fixed_len && buff == nullptr) {
     throw std::runtime_error(
         "Error setting buffer; attribute '" + attribute +
         "' is variable-length but null offset buffer was provided.");
@@ -62,7 +96,9 @@ void InMemoryExporter::set_buffer_offsets(
 
 void InMemoryExporter::set_buffer_list_offsets(
     const std::string& attribute, int32_t* buff, int64_t buff_size) {
-  if (!var_len_list_attr(attribute) && buff != nullptr) {
+  const bool list = var_len_list_attr(attribute) &&
+                    dictionary_attrs_.count(attribute) == 0;
+  if (!list && buff != nullptr) {
     throw std::runtime_error(
         "Error setting buffer; attribute '" + attribute +
         "' is not a var-len list attribute but list offset buffer was "
@@ -91,6 +127,56 @@ void InMemoryExporter::set_buffer_validity_bitmap(
   user_buff->bitmap.reset(new Bitmap(buff, buff_size));
 }
 
+void InMemoryExporter::set_dictionary_encoding(
+    const std::string& attribute, bool dictionary) {
+  if (!dictionary_attr(attribute))
+    throw std::runtime_error(
+        "Error setting dictionary encoding; attribute '" + attribute +
+        "' cannot be dictionary-encoded.");
+  if (dictionary)
+    dictionary_attrs_.insert(attribute);
+  else
+    dictionary_attrs_.erase(attribute);
+
+  auto it = user_buffers_.find(attribute);
+  if (it != user_buffers_.end())
+    it->second.dictionary = dictionary;
+}
+
+void InMemoryExporter::set_buffer_dictionary_values(
+    const std::string& attribute, char* buff, int64_t buff_size) {
+  if (dictionary_attrs_.count(attribute) == 0)
+    throw std::runtime_error(
+        "Error setting buffer; attribute '" + attribute +
+        "' is not dictionary-encoded but dictionary buffer was provided.");
+  if (buff == nullptr)
+    throw std::runtime_error(
+        "Error setting buffer; null dictionary values buffer provided for "
+        "attribute '" +
+        attribute + "'.");
+
+  auto user_buff = get_buffer(attribute);
+  user_buff->dict_data = buff;
+  user_buff->max_dict_data_bytes = buff_size;
+}
+
+void InMemoryExporter::set_buffer_dictionary_offsets(
+    const std::string& attribute, int32_t* buff, int64_t buff_size) {
+  if (dictionary_attrs_.count(attribute) == 0)
+    throw std::runtime_error(
+        "Error setting buffer; attribute '" + attribute +
+        "' is not dictionary-encoded but dictionary buffer was provided.");
+  if (buff == nullptr)
+    throw std::runtime_error(
+        "Error setting buffer; null dictionary offsets buffer provided for "
+        "attribute '" +
+        attribute + "'.");
+
+  auto user_buff = get_buffer(attribute);
+  user_buff->dict_offsets = buff;
+  user_buff->max_num_dict_offsets = buff_size / sizeof(int32_t);
+}
+
 InMemoryExporter::UserBuffer* InMemoryExporter::get_buffer(
     const std::string& attribute) {
   auto it = user_buffers_.find(attribute);
@@ -99,6 +185,7 @@ InMemoryExporter::UserBuffer* InMemoryExporter::get_buffer(
     buff = &user_buffers_[attribute];
     buff->attr = attr_name_to_enum(attribute);
     buff->attr_name = attribute;
+    buff->dictionary = dictionary_attrs_.count(attribute) > 0;
     if (buff->attr == ExportableAttribute::InfoOrFmt) {
       auto p = TileDBVCFDataset::split_info_fmt_attr_name(buff->attr_name);
       buff->is_info = p.first == "info";
@@ -294,6 +381,22 @@ void InMemoryExporter::result_size(
     *num_data_bytes = buff.curr_sizes.data_bytes;
 }
 
+void InMemoryExporter::dictionary_result_size(
+    const std::string& attribute,
+    int64_t* num_offsets,
+    int64_t* num_data_bytes) const {
+  auto it = user_buffers_.find(attribute);
+  if (it == user_buffers_.end() || !it->second.dictionary)
+    throw std::runtime_error(
+        "Error getting dictionary result size; attribute '" + attribute +
+        "' had no dictionary-encoded buffer set.");
+  const UserBuffer& buff = it->second;
+  if (num_offsets)
+    *num_offsets = buff.num_dict_entries == 0 ? 0 : buff.num_dict_entries + 1;
+  if (num_data_bytes)
+    *num_data_bytes = buff.dict_data_bytes;
+}
+
 void InMemoryExporter::num_buffers(int32_t* num_buffers) const {
   *num_buffers = user_buffers_.size();
 }
@@ -338,9 +441,102 @@ void InMemoryExporter::get_buffer_validity_bitmap(
   *buff = user_buff->bitmap_buff;
 }
 
+void InMemoryExporter::get_buffer_dictionary(
+    int32_t buffer_idx,
+    char** values,
+    int64_t* values_bytes,
+    int32_t** offsets,
+    int64_t* offsets_bytes) const {
+  if (buffer_idx < 0 || (size_t)buffer_idx >= user_buffers_by_idx_.size())
+    throw std::runtime_error(
+        "Error getting buffer information; index out of bounds.");
+  UserBuffer* user_buff = user_buffers_by_idx_[buffer_idx];
+  *values = user_buff->dict_data;
+  *values_bytes = user_buff->max_dict_data_bytes;
+  *offsets = user_buff->dict_offsets;
+  *offsets_bytes = user_buff->max_num_dict_offsets * sizeof(int32_t);
+}
+
+void InMemoryExporter::get_buffer_sizes(
+    int32_t buffer_idx,
+    int64_t* data_bytes,
+    int64_t* offsets_bytes,
+    int64_t* list_offsets_bytes,
+    int64_t* bitmap_bytes) const {
+  if (buffer_idx < 0 || (size_t)buffer_idx >= user_buffers_by_idx_.size())
+    throw std::runtime_error(
+        "Error getting buffer information; index out of bounds.");
+  UserBuffer* user_buff = user_buffers_by_idx_[buffer_idx];
+  *data_bytes = user_buff->max_data_bytes;
+  *offsets_bytes = user_buff->max_num_offsets * sizeof(int32_t);
+  *list_offsets_bytes = user_buff->max_num_list_offsets * sizeof(int32_t);
+  *bitmap_bytes = user_buff->max_bitmap_bytes;
+}
+
 void InMemoryExporter::reset_current_sizes() {
-  for (auto& it : user_buffers_)
-    it.second.curr_sizes = UserBufferSizes();
+  for (auto& it : user_buffers_) {
+    UserBuffer& buff = it.second;
+    buff.curr_sizes = UserBufferSizes();
+    buff.num_dict_entries = 0;
+    buff.dict_data_bytes = 0;
+    buff.dict_index.clear();
+    buff.last_dict_entry = -1;
+  }
+  num_batch_records_ = 0;
+}
+
+void InMemoryExporter::set_max_batch_records(uint64_t max_batch_records) {
+  max_batch_records_ = max_batch_records;
+}
+
+void InMemoryExporter::buffer_size_estimate(
+    const std::string& attribute,
+    uint64_t num_records,
+    uint64_t last_num_records,
+    bool last_read_incomplete,
+    int64_t* data_bytes,
+    int64_t* offsets_bytes,
+    int64_t* list_offsets_bytes,
+    int64_t* bitmap_bytes) const {
+  auto it = user_buffers_.find(attribute);
+  if (it == user_buffers_.end())
+    throw std::runtime_error(
+        "Error estimating buffer size; no buffer set for attribute '" +
+        attribute + "'.");
+  const UserBuffer& buff = it->second;
+  const UserBufferSizes& used = buff.curr_sizes;
+
+  // If the last read stopped before the record cap, a buffer overflowed.
+  const bool overflow =
+      last_read_incomplete && last_num_records < max_batch_records_;
+
+  // Estimates the size of a buffer, in elements, from its use by the last
+  // read. Offsets buffers hold one more element than their number of cells.
+  auto estimate = [&](int64_t used, int64_t capacity, int64_t extra) {
+    if (capacity == 0)
+      return int64_t(0);
+    int64_t size = capacity;
+    double per_record = 0;
+    if (last_num_records > 0) {
+      per_record = double(std::max<int64_t>(used - extra, 0)) /
+                   double(last_num_records);
+      // Leave some headroom for records larger than the average.
+      size = int64_t(std::ceil(per_record * num_records * 1.25)) + extra;
+    }
+    const bool full = overflow && (last_num_records == 0 ||
+                                   capacity - used < 2 * per_record + 1);
+    if (full)
+      size = std::max(size, 2 * capacity);
+    return std::max<int64_t>(size, extra + 1);
+  };
+
+  *data_bytes = estimate(used.data_bytes, buff.max_data_bytes, 0);
+  *offsets_bytes =
+      estimate(used.num_offsets, buff.max_num_offsets, 1) * sizeof(int32_t);
+  *list_offsets_bytes =
+      estimate(used.num_list_offsets, buff.max_num_list_offsets, 1) *
+      sizeof(int32_t);
+  *bitmap_bytes = buff.max_bitmap_bytes == 0 ? 0 : (num_records + 7) / 8;
 }
 
 bool InMemoryExporter::export_record(
@@ -350,187 +546,438 @@ bool InMemoryExporter::export_record(
     uint32_t contig_offset,
     const ReadQueryResults& query_results,
     uint64_t cell_idx) {
-  const unsigned version = dataset_->metadata().version;
-
   // Keep a convenience reference to the current query results.
   curr_query_results_ = &query_results;
 
+  if (num_batch_records_ >= max_batch_records_)
+    return false;
+
   if (user_buffers_.empty()) {
     // With no user buffers to receive data, just degenerate to a count.
+    num_batch_records_++;
     return true;
   }
 
   // Record current buffer sizes in case of overflow on some attribute.
-  std::vector<UserBufferSizes> saved_sizes(user_buffers_.size());
-  for (size_t i = 0; i < user_buffers_.size(); i++)
-    saved_sizes[i] = user_buffers_by_idx_[i]->curr_sizes;
+  saved_sizes_.resize(user_buffers_by_idx_.size());
+  for (size_t i = 0; i < user_buffers_by_idx_.size(); i++)
+    saved_sizes_[i] = user_buffers_by_idx_[i]->curr_sizes;
 
   // For all user buffers, copy the appropriate data.
-  const auto* buffers = curr_query_results_->buffers();
-  bool overflow = false;
-  for (auto& it : user_buffers_) {
-    if (overflow)
-      break;
+  for (UserBuffer* user_buff : user_buffers_by_idx_) {
+    if (!copy_attribute(
+            user_buff,
+            sample.sample_name,
+            hdr,
+            query_region,
+            contig_offset,
+            cell_idx)) {
+      // Overflow can occur if a user buffer was too small to receive the
+      // copied data. Restore old buffer sizes so the user can process the
+      // incomplete results.
+      for (size_t i = 0; i < user_buffers_by_idx_.size(); i++)
+        user_buffers_by_idx_[i]->curr_sizes = saved_sizes_[i];
+      return false;
+    }
+  }
 
-    UserBuffer& user_buff = it.second;
-    switch (user_buff.attr) {
-      case ExportableAttribute::SampleName: {
-        const std::string& sample_name = sample.sample_name;
-        overflow = !copy_cell(
-            &user_buff,
-            sample_name.c_str(),
-            sample_name.size(),
-            sample_name.size(),
-            hdr);
-        break;
-      }
-      case ExportableAttribute::Contig: {
-        if (version == TileDBVCFDataset::Version::V4) {
-          uint64_t size = 0;
-          const char* contig = buffers->contig().value<char>(cell_idx, &size);
-          overflow = !copy_cell(&user_buff, contig, size, size, hdr);
-        } else {
-          overflow = !copy_cell(
-              &user_buff,
-              query_region.seq_name.c_str(),
-              query_region.seq_name.size(),
-              query_region.seq_name.size(),
-              hdr);
-        }
+  num_batch_records_++;
+  return true;
+}
+
+uint64_t InMemoryExporter::export_records(
+    const ReadQueryResults& query_results,
+    const std::vector<ExportRow>& rows) {
+  curr_query_results_ = &query_results;
+
+  const uint64_t max_rows = std::min<uint64_t>(
+      rows.size(), max_batch_records_ - num_batch_records_);
+  if (user_buffers_.empty()) {
+    num_batch_records_ += max_rows;
+    return max_rows;
+  }
+
+  // Split the buffers between those copied column by column and the others,
+  // copied row by row.
+  column_buffers_.clear();
+  row_buffers_.clear();
+  for (UserBuffer* user_buff : user_buffers_by_idx_) {
+    if (column_copyable(*user_buff))
+      column_buffers_.push_back(user_buff);
+    else
+      row_buffers_.push_back(user_buff);
+  }
+
+  // Only export the rows that fit in all the column buffers, so that
+  // copying them cannot overflow.
+  uint64_t num_rows = max_rows;
+  for (const UserBuffer* user_buff : column_buffers_)
+    num_rows = std::min(num_rows, column_rows_fitting(*user_buff, rows));
+
+  // Copy the other buffers. If one overflows, the batch ends at that row.
+  saved_sizes_.resize(row_buffers_.size());
+  for (uint64_t r = 0; r < num_rows && !row_buffers_.empty(); r++) {
+    const ExportRow& row = rows[r];
+    for (size_t i = 0; i < row_buffers_.size(); i++)
+      saved_sizes_[i] = row_buffers_[i]->curr_sizes;
+
+    for (UserBuffer* user_buff : row_buffers_) {
+      if (!copy_attribute(
+              user_buff,
+              row.sample_name,
+              row.sample_hdr,
+              *row.query_region,
+              row.query_contig_offset,
+              row.cell_idx)) {
+        for (size_t i = 0; i < row_buffers_.size(); i++)
+          row_buffers_[i]->curr_sizes = saved_sizes_[i];
+        num_rows = r;
         break;
       }
-      case ExportableAttribute::PosStart: {
-        if (version == TileDBVCFDataset::Version::V4) {
-          const uint32_t real_start_pos =
-              buffers->real_start_pos().value<uint32_t>(cell_idx) + 1;
-          overflow = !copy_cell(
-              &user_buff, &real_start_pos, sizeof(real_start_pos), 1, hdr);
+    }
+  }
 
-        } else if (version == TileDBVCFDataset::Version::V3) {
-          const uint32_t real_start_pos =
-              (buffers->real_start_pos().value<uint32_t>(cell_idx) -
-               contig_offset) +
-              1;
-          overflow = !copy_cell(
-              &user_buff, &real_start_pos, sizeof(real_start_pos), 1, hdr);
-        } else {
-          assert(version == TileDBVCFDataset::Version::V2);
-          const uint32_t pos =
-              (buffers->pos().value<uint32_t>(cell_idx) - contig_offset) + 1;
-          overflow = !copy_cell(&user_buff, &pos, sizeof(pos), 1, hdr);
-        }
-        break;
+  for (UserBuffer* user_buff : column_buffers_)
+    copy_column(user_buff, rows, num_rows);
+
+  num_batch_records_ += num_rows;
+  return num_rows;
+}
+
+bool InMemoryExporter::copy_attribute(
+    UserBuffer* dest,
+    std::string_view sample_name,
+    const bcf_hdr_t* hdr,
+    const Region& query_region,
+    uint32_t contig_offset,
+    uint64_t cell_idx) {
+  const unsigned version = dataset_->metadata().version;
+  const auto* buffers = curr_query_results_->buffers();
+
+  switch (dest->attr) {
+    case ExportableAttribute::SampleName: {
+      if (dest->dictionary)
+        return copy_dictionary_cell(dest, sample_name, hdr);
+      return copy_cell(
+          dest,
+          sample_name.data(),
+          sample_name.size(),
+          sample_name.size(),
+          hdr);
+    }
+    case ExportableAttribute::Contig: {
+      if (version == TileDBVCFDataset::Version::V4) {
+        uint64_t size = 0;
+        const char* contig = buffers->contig().value<char>(cell_idx, &size);
+        if (dest->dictionary)
+          return copy_dictionary_cell(
+              dest, std::string_view(contig, size), hdr);
+        return copy_cell(dest, contig, size, size, hdr);
       }
-      case ExportableAttribute::PosEnd: {
-        if (version == TileDBVCFDataset::Version::V4) {
-          const uint32_t end_pos =
-              buffers->end_pos().value<uint32_t>(cell_idx) + 1;
-          overflow = !copy_cell(&user_buff, &end_pos, sizeof(end_pos), 1, hdr);
-        } else if (version == TileDBVCFDataset::Version::V3) {
-          const uint32_t end_pos =
-              (buffers->end_pos().value<uint32_t>(cell_idx) - contig_offset) +
-              1;
-          overflow = !copy_cell(&user_buff, &end_pos, sizeof(end_pos), 1, hdr);
-        } else {
-          assert(version == TileDBVCFDataset::Version::V2);
-          const uint32_t real_end =
-              (buffers->real_end().value<uint32_t>(cell_idx) - contig_offset) +
-              1;
-          overflow =
-              !copy_cell(&user_buff, &real_end, sizeof(real_end), 1, hdr);
-        }
-        break;
+      if (dest->dictionary)
+        return copy_dictionary_cell(dest, query_region.seq_name, hdr);
+      return copy_cell(
+          dest,
+          query_region.seq_name.c_str(),
+          query_region.seq_name.size(),
+          query_region.seq_name.size(),
+          hdr);
+    }
+    case ExportableAttribute::PosStart: {
+      if (version == TileDBVCFDataset::Version::V4) {
+        const uint32_t real_start_pos =
+            buffers->real_start_pos().value<uint32_t>(cell_idx) + 1;
+        return copy_cell(
+            dest, &real_start_pos, sizeof(real_start_pos), 1, hdr);
+      } else if (version == TileDBVCFDataset::Version::V3) {
+        const uint32_t real_start_pos =
+            (buffers->real_start_pos().value<uint32_t>(cell_idx) -
+             contig_offset) +
+            1;
+        return copy_cell(
+            dest, &real_start_pos, sizeof(real_start_pos), 1, hdr);
       }
-      case ExportableAttribute::QueryBedStart: {
-        overflow = !copy_cell(
-            &user_buff, &query_region.min, sizeof(query_region.min), 1, hdr);
-        break;
+      assert(version == TileDBVCFDataset::Version::V2);
+      const uint32_t pos =
+          (buffers->pos().value<uint32_t>(cell_idx) - contig_offset) + 1;
+      return copy_cell(dest, &pos, sizeof(pos), 1, hdr);
+    }
+    case ExportableAttribute::PosEnd: {
+      if (version == TileDBVCFDataset::Version::V4) {
+        const uint32_t end_pos =
+            buffers->end_pos().value<uint32_t>(cell_idx) + 1;
+        return copy_cell(dest, &end_pos, sizeof(end_pos), 1, hdr);
+      } else if (version == TileDBVCFDataset::Version::V3) {
+        const uint32_t end_pos =
+            (buffers->end_pos().value<uint32_t>(cell_idx) - contig_offset) +
+            1;
+        return copy_cell(dest, &end_pos, sizeof(end_pos), 1, hdr);
       }
-      case ExportableAttribute::QueryBedEnd: {
-        // converting 0-indexed, inclusive end position to 0-indexed, half-open
-        // end position to match the BED file
-        uint32_t end = query_region.max + 1;
-        overflow = !copy_cell(&user_buff, &end, sizeof(end), 1, hdr);
+      assert(version == TileDBVCFDataset::Version::V2);
+      const uint32_t real_end =
+          (buffers->real_end().value<uint32_t>(cell_idx) - contig_offset) + 1;
+      return copy_cell(dest, &real_end, sizeof(real_end), 1, hdr);
+    }
+    case ExportableAttribute::QueryBedStart: {
+      return copy_cell(
+          dest, &query_region.min, sizeof(query_region.min), 1, hdr);
+    }
+    case ExportableAttribute::QueryBedEnd: {
+      // converting 0-indexed, inclusive end position to 0-indexed, half-open
+      // end position to match the BED file
+      uint32_t end = query_region.max + 1;
+      return copy_cell(dest, &end, sizeof(end), 1, hdr);
+    }
+    case ExportableAttribute::QueryBedLine: {
+      return copy_cell(
+          dest, &query_region.line, sizeof(query_region.line), 1, hdr);
+    }
+    case ExportableAttribute::Alleles: {
+      if (dest->dictionary)
+        return copy_alleles_indices(cell_idx, dest);
+      return copy_alleles_list(cell_idx, dest);
+    }
+    case ExportableAttribute::Id: {
+      void* data;
+      uint64_t nbytes;
+      get_var_attr_value(
+          buffers->id(),
+          cell_idx,
+          curr_query_results_->id_size().second,
+          &data,
+          &nbytes);
+      // Don't copy terminating null byte
+      if (nbytes > 0)
+        nbytes -= 1;
+      return copy_cell(dest, data, nbytes, nbytes, hdr);
+    }
+    case ExportableAttribute::Filters: {
+      return copy_filters_list(hdr, cell_idx, dest);
+    }
+    case ExportableAttribute::Qual: {
+      const auto qual = buffers->qual().value<float>(cell_idx);
+      return copy_cell(dest, &qual, sizeof(qual), 1, hdr);
+    }
+    case ExportableAttribute::Fmt: {
+      void* data;
+      uint64_t nbytes;
+      get_var_attr_value(
+          buffers->fmt(),
+          cell_idx,
+          curr_query_results_->fmt_size().second,
+          &data,
+          &nbytes);
+      return copy_cell(dest, data, nbytes, nbytes, hdr);
+    }
+    case ExportableAttribute::Info: {
+      void* data;
+      uint64_t nbytes;
+      get_var_attr_value(
+          buffers->info(),
+          cell_idx,
+          curr_query_results_->info_size().second,
+          &data,
+          &nbytes);
+      return copy_cell(dest, data, nbytes, nbytes, hdr);
+    }
+    case ExportableAttribute::InfoOrFmt: {
+      return copy_info_fmt_value(cell_idx, dest, hdr);
+    }
+    default:
+      throw std::runtime_error(
+          "Error copying cell; unimplemented attribute '" + dest->attr_name +
+          "'");
+  }
+}
+
+bool InMemoryExporter::column_copyable(const UserBuffer& buff) const {
+  // Validity bitmaps, list offsets and dictionaries are only maintained row by
+  // row.
+  if (dataset_->metadata().version != TileDBVCFDataset::Version::V4 ||
+      buff.bitmap_buff != nullptr || buff.list_offsets != nullptr ||
+      buff.dictionary)
+    return false;
+
+  switch (buff.attr) {
+    case ExportableAttribute::PosStart:
+    case ExportableAttribute::PosEnd:
+    case ExportableAttribute::QueryBedStart:
+    case ExportableAttribute::QueryBedEnd:
+    case ExportableAttribute::QueryBedLine:
+    case ExportableAttribute::Qual:
+      return buff.offsets == nullptr;
+    case ExportableAttribute::SampleName:
+    case ExportableAttribute::Contig:
+    case ExportableAttribute::Id:
+    case ExportableAttribute::Fmt:
+    case ExportableAttribute::Info:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool InMemoryExporter::fixed_width_column(const UserBuffer& buff) {
+  return buff.attr != ExportableAttribute::SampleName &&
+         buff.attr != ExportableAttribute::Contig &&
+         buff.attr != ExportableAttribute::Id &&
+         buff.attr != ExportableAttribute::Fmt &&
+         buff.attr != ExportableAttribute::Info;
+}
+
+std::string_view InMemoryExporter::var_column_value(
+    const UserBuffer& buff, const ExportRow& row) const {
+  const auto* buffers = curr_query_results_->buffers();
+  void* data = nullptr;
+  uint64_t nbytes = 0;
+  switch (buff.attr) {
+    case ExportableAttribute::SampleName:
+      return row.sample_name;
+    case ExportableAttribute::Contig: {
+      const char* contig = buffers->contig().value<char>(row.cell_idx, &nbytes);
+      return std::string_view(contig, nbytes);
+    }
+    case ExportableAttribute::Id:
+      get_var_attr_value(
+          buffers->id(),
+          row.cell_idx,
+          curr_query_results_->id_size().second,
+          &data,
+          &nbytes);
+      // Don't copy terminating null byte
+      if (nbytes > 0)
+        nbytes -= 1;
+      break;
+    case ExportableAttribute::Fmt:
+      get_var_attr_value(
+          buffers->fmt(),
+          row.cell_idx,
+          curr_query_results_->fmt_size().second,
+          &data,
+          &nbytes);
+      break;
+    case ExportableAttribute::Info:
+      get_var_attr_value(
+          buffers->info(),
+          row.cell_idx,
+          curr_query_results_->info_size().second,
+          &data,
+          &nbytes);
+      break;
+    default:
+      throw std::runtime_error(
+          "Error copying column; attribute '" + buff.attr_name +
+          "' is not variable-length");
+  }
+  return std::string_view(static_cast<const char*>(data), nbytes);
+}
+
+uint64_t InMemoryExporter::column_rows_fitting(
+    const UserBuffer& buff, const std::vector<ExportRow>& rows) const {
+  const UserBufferSizes& sizes = buff.curr_sizes;
+  if (fixed_width_column(buff)) {
+    // All fixed-width exportable attributes hold 4-byte values.
+    return std::min<uint64_t>(
+        rows.size(), (buff.max_data_bytes - sizes.data_bytes) / 4);
+  }
+
+  // Each row takes an offset, and the final offset is always kept set.
+  uint64_t max_rows = rows.size();
+  const bool var_len = buff.offsets != nullptr;
+  if (var_len)
+    max_rows = std::min<uint64_t>(
+        max_rows,
+        std::max<int64_t>(buff.max_num_offsets - sizes.num_offsets - 1, 0));
+
+  uint64_t data_bytes = sizes.data_bytes;
+  for (uint64_t r = 0; r < max_rows; r++) {
+    data_bytes += var_column_value(buff, rows[r]).size();
+    if (data_bytes > (uint64_t)buff.max_data_bytes ||
+        (var_len && data_bytes - sizes.data_bytes + sizes.data_nelts >
+                        (uint64_t)std::numeric_limits<int32_t>::max()))
+      return r;
+  }
+  return max_rows;
+}
+
+void InMemoryExporter::copy_column(
+    UserBuffer* dest,
+    const std::vector<ExportRow>& rows,
+    uint64_t num_rows) const {
+  UserBufferSizes& sizes = dest->curr_sizes;
+  char* data = static_cast<char*>(dest->data) + sizes.data_bytes;
+
+  if (fixed_width_column(*dest)) {
+    const auto* buffers = curr_query_results_->buffers();
+    switch (dest->attr) {
+      case ExportableAttribute::PosStart: {
+        const uint32_t* real_start_pos =
+            buffers->real_start_pos().data<uint32_t>();
+        gather_column<uint32_t>(data, rows, num_rows, [&](const auto& row) {
+          return real_start_pos[row.cell_idx] + 1;
+        });
         break;
       }
-      case ExportableAttribute::QueryBedLine: {
-        overflow = !copy_cell(
-            &user_buff, &query_region.line, sizeof(query_region.line), 1, hdr);
+      case ExportableAttribute::PosEnd: {
+        const uint32_t* end_pos = buffers->end_pos().data<uint32_t>();
+        gather_column<uint32_t>(data, rows, num_rows, [&](const auto& row) {
+          return end_pos[row.cell_idx] + 1;
+        });
         break;
       }
-      case ExportableAttribute::Alleles: {
-        overflow = !copy_alleles_list(cell_idx, &user_buff);
+      case ExportableAttribute::QueryBedStart:
+        gather_column<uint32_t>(data, rows, num_rows, [](const auto& row) {
+          return row.query_region->min;
+        });
         break;
-      }
-      case ExportableAttribute::Id: {
-        void* data;
-        uint64_t nbytes;
-        get_var_attr_value(
-            buffers->id(),
-            cell_idx,
-            curr_query_results_->id_size().second,
-            &data,
-            &nbytes);
-        // Don't copy terminating null byte
-        if (nbytes > 0)
-          nbytes -= 1;
-        overflow = !copy_cell(&user_buff, data, nbytes, nbytes, hdr);
+      case ExportableAttribute::QueryBedEnd:
+        // converting 0-indexed, inclusive end position to 0-indexed,
+        // half-open end position to match the BED file
+        gather_column<uint32_t>(data, rows, num_rows, [](const auto& row) {
+          return row.query_region->max + 1;
+        });
         break;
-      }
-      case ExportableAttribute::Filters: {
-        overflow = !copy_filters_list(hdr, cell_idx, &user_buff);
+      case ExportableAttribute::QueryBedLine:
+        gather_column<int32_t>(data, rows, num_rows, [](const auto& row) {
+          return row.query_region->line;
+        });
         break;
-      }
       case ExportableAttribute::Qual: {
-        const auto qual = buffers->qual().value<float>(cell_idx);
-        overflow = !copy_cell(&user_buff, &qual, sizeof(qual), 1, hdr);
-        break;
-      }
-      case ExportableAttribute::Fmt: {
-        void* data;
-        uint64_t nbytes;
-        get_var_attr_value(
-            buffers->fmt(),
-            cell_idx,
-            curr_query_results_->fmt_size().second,
-            &data,
-            &nbytes);
-        overflow = !copy_cell(&user_buff, data, nbytes, nbytes, hdr);
-        break;
-      }
-      case ExportableAttribute::Info: {
-        void* data;
-        uint64_t nbytes;
-        get_var_attr_value(
-            buffers->info(),
-            cell_idx,
-            curr_query_results_->info_size().second,
-            &data,
-            &nbytes);
-        overflow = !copy_cell(&user_buff, data, nbytes, nbytes, hdr);
-        break;
-      }
-      case ExportableAttribute::InfoOrFmt: {
-        overflow = !copy_info_fmt_value(cell_idx, &user_buff, hdr);
+        const float* qual = buffers->qual().data<float>();
+        gather_column<float>(data, rows, num_rows, [&](const auto& row) {
+          return qual[row.cell_idx];
+        });
         break;
       }
       default:
         throw std::runtime_error(
-            "Error copying cell; unimplemented attribute '" + it.first + "'");
-        break;
+            "Error copying column; unimplemented attribute '" +
+            dest->attr_name + "'");
     }
+    sizes.data_bytes += num_rows * 4;
+    sizes.data_nelts += num_rows;
+    return;
   }
 
-  // Overflow can occur if a user buffer was too small to receive the copied
-  // data. Restore old buffer sizes so the user can process the incomplete
-  // results.
-  if (overflow) {
-    for (size_t i = 0; i < user_buffers_.size(); i++)
-      user_buffers_by_idx_[i]->curr_sizes = saved_sizes[i];
-    return false;
+  // Copy the values, computing the offsets as their prefix sum.
+  const bool var_len = dest->offsets != nullptr;
+  uint64_t nbytes = 0;
+  for (uint64_t r = 0; r < num_rows; r++) {
+    if (var_len)
+      dest->offsets[sizes.num_offsets + r] =
+          static_cast<int32_t>(sizes.data_nelts + nbytes);
+    std::string_view value = var_column_value(*dest, rows[r]);
+    if (!value.empty())
+      std::memcpy(data + nbytes, value.data(), value.size());
+    nbytes += value.size();
   }
-
-  return true;
+  if (var_len && num_rows > 0) {
+    sizes.num_offsets += num_rows;
+    dest->offsets[sizes.num_offsets] =
+        static_cast<int32_t>(sizes.data_nelts + nbytes);
+  }
+  sizes.data_bytes += nbytes;
+  sizes.data_nelts += nbytes;
 }
 
 InMemoryExporter::ExportableAttribute InMemoryExporter::attr_name_to_enum(
@@ -591,14 +1038,34 @@ bool InMemoryExporter::nullable_attr(const std::string& attr) {
          attribute == ExportableAttribute::InfoOrFmt;
 }
 
+bool InMemoryExporter::dictionary_attr(const std::string& attr) {
+  ExportableAttribute attribute = attr_name_to_enum(attr);
+  return attribute == ExportableAttribute::SampleName ||
+         attribute == ExportableAttribute::Contig ||
+         attribute == ExportableAttribute::Alleles;
+}
+
 void InMemoryExporter::attribute_datatype(
     const TileDBVCFDataset* dataset,
     const std::string& attribute,
+    bool dictionary,
     AttrDatatype* datatype,
     bool* var_len,
     bool* nullable,
     bool* list) {
   ExportableAttribute attr = attr_name_to_enum(attribute);
+  if (dictionary) {
+    if (!dictionary_attr(attribute))
+      throw std::runtime_error(
+          "Error getting attribute '" + attribute +
+          "' datatype; attribute cannot be dictionary-encoded.");
+    *datatype = AttrDatatype::INT32;
+    *var_len = attr == ExportableAttribute::Alleles;
+    *nullable = false;
+    *list = false;
+    return;
+  }
+
   switch (attr) {
     case ExportableAttribute::SampleName:
       *datatype = AttrDatatype::CHAR;
@@ -826,6 +1293,93 @@ bool InMemoryExporter::add_zero_length_offset(UserBuffer* dest) const {
   return true;
 }
 
+bool InMemoryExporter::dictionary_index(
+    UserBuffer* dest, std::string_view value, int32_t* index) const {
+  if (dest->dict_data == nullptr || dest->dict_offsets == nullptr)
+    throw std::runtime_error(
+        "Error copying dictionary-encoded attribute '" + dest->attr_name +
+        "'; no buffer set for dictionary values or offsets.");
+
+  // Consecutive records mostly share their sample and contig.
+  const int32_t last = dest->last_dict_entry;
+  if (last >= 0) {
+    const int32_t start = dest->dict_offsets[last];
+    const std::string_view last_value(
+        dest->dict_data + start, dest->dict_offsets[last + 1] - start);
+    if (last_value == value) {
+      *index = last;
+      return true;
+    }
+  }
+
+  auto it = dest->dict_index.find(value);
+  if (it != dest->dict_index.end()) {
+    *index = dest->last_dict_entry = it->second;
+    return true;
+  }
+
+  // Add a new entry, keeping the final offset set as for the values offsets.
+  if (dest->num_dict_entries + 2 > dest->max_num_dict_offsets ||
+      dest->dict_data_bytes + (int64_t)value.size() >
+          std::min<int64_t>(
+              dest->max_dict_data_bytes, std::numeric_limits<int32_t>::max()))
+    return false;
+  const int32_t entry = dest->num_dict_entries++;
+  char* entry_data = dest->dict_data + dest->dict_data_bytes;
+  if (!value.empty())
+    std::memcpy(entry_data, value.data(), value.size());
+  dest->dict_offsets[entry] = dest->dict_data_bytes;
+  dest->dict_data_bytes += value.size();
+  dest->dict_offsets[entry + 1] = dest->dict_data_bytes;
+  dest->dict_index.emplace(std::string_view(entry_data, value.size()), entry);
+  *index = dest->last_dict_entry = entry;
+  return true;
+}
+
+bool InMemoryExporter::copy_dictionary_cell(
+    UserBuffer* dest, std::string_view value, const bcf_hdr_t* hdr) const {
+  int32_t index = 0;
+  if (!dictionary_index(dest, value, &index))
+    return false;
+  return copy_cell(dest, &index, sizeof(index), 1, hdr);
+}
+
+bool InMemoryExporter::copy_alleles_indices(
+    uint64_t cell_idx, UserBuffer* dest) const {
+  if (dest->offsets == nullptr)
+    throw std::runtime_error(
+        "Error copying alleles indices; no buffer set for offsets.");
+
+  const Buffer& src = curr_query_results_->buffers()->alleles();
+  const uint64_t src_size = curr_query_results_->alleles_size().second;
+  void* data = nullptr;
+  uint64_t nbytes = 0;
+  get_var_attr_value(src, cell_idx, src_size, &data, &nbytes);
+
+  // Note that the alleles data is ingested as a null-terminated CSV list.
+  std::string_view alleles(static_cast<const char*>(data), nbytes);
+  if (!alleles.empty() && alleles.back() == '\0')
+    alleles.remove_suffix(1);
+
+  // Gather the indices of the alleles, then copy them as a single cell.
+  allele_indices_.clear();
+  while (!alleles.empty()) {
+    const size_t end = std::min(alleles.find(','), alleles.size());
+    int32_t index = 0;
+    if (!dictionary_index(dest, alleles.substr(0, end), &index))
+      return false;
+    allele_indices_.push_back(index);
+    alleles.remove_prefix(std::min(end + 1, alleles.size()));
+  }
+
+  return copy_cell(
+      dest,
+      allele_indices_.data(),
+      allele_indices_.size() * sizeof(int32_t),
+      allele_indices_.size(),
+      nullptr);
+}
+
 bool InMemoryExporter::copy_alleles_list(
     uint64_t cell_idx, UserBuffer* dest) const {
   // Sanity check buffers
@@ -937,7 +1491,7 @@ bool InMemoryExporter::copy_info_fmt_value(
   uint64_t nbytes = 0, nelts = 0;
   get_info_fmt_value(dest, cell_idx, &src, &nbytes, &nelts);
 
-  if (is_gt) {
+  if (is_gt && src != nullptr) {
     // Genotype needs special handling to be decoded.
     const int* genotype = reinterpret_cast<const int*>(src);
     int decoded[nelts];
@@ -957,33 +1511,41 @@ void InMemoryExporter::get_info_fmt_value(
     uint64_t* nelts) const {
   // Get either the extracted attribute buffer, or the info/fmt blob attribute.
   const std::string& attr_name = attr_buff->attr_name;
-  const std::string& field_name = attr_buff->info_fmt_field_name;
-  const bool is_info = attr_buff->is_info;
   const Buffer* src = nullptr;
-  std::pair<uint64_t, uint64_t> src_size;
-  bool is_extracted_attr = false;
-  if (curr_query_results_->buffers()->extra_attr(attr_name, &src)) {
-    is_extracted_attr = true;
-
-    auto sizes_iter = curr_query_results_->extra_attrs_size().find(attr_name);
-    if (sizes_iter == curr_query_results_->extra_attrs_size().end())
-      throw std::runtime_error(
-          "Could not find size for extra attribute" + attr_name +
-          " in get_info_fmt_value");
-
-    src_size = curr_query_results_->extra_attrs_size().at(attr_name);
-  } else if (is_info) {
-    src = &curr_query_results_->buffers()->info();
-    src_size = curr_query_results_->info_size();
-  } else {
-    src = &curr_query_results_->buffers()->fmt();
-    src_size = curr_query_results_->fmt_size();
+  if (!curr_query_results_->buffers()->extra_attr(attr_name, &src)) {
+    // Look up the field in the index of the info/fmt blob.
+    int type = 0;
+    int num_values = 0;
+    const char* values = nullptr;
+    if (!curr_query_results_->blob_field_value(
+            attr_buff->is_info,
+            attr_buff->info_fmt_field_name,
+            cell_idx,
+            &type,
+            &num_values,
+            &values)) {
+      *data = nullptr;
+      *nbytes = 0;
+      *nelts = 0;
+      return;
+    }
+    *data = values;
+    *nbytes = utils::bcf_type_size(type) * num_values;
+    *nelts = num_values;
+    return;
   }
 
   if (src == nullptr)
     throw std::runtime_error(
         "Error copying attribute '" + attr_name + "'; no source buffer.");
 
+  auto sizes_iter = curr_query_results_->extra_attrs_size().find(attr_name);
+  if (sizes_iter == curr_query_results_->extra_attrs_size().end())
+    throw std::runtime_error(
+        "Could not find size for extra attribute" + attr_name +
+        " in get_info_fmt_value");
+  const std::pair<uint64_t, uint64_t>& src_size = sizes_iter->second;
+
   const uint64_t num_cells = curr_query_results_->num_cells();
   const auto& offsets = src->offsets();
   uint64_t offset = offsets[cell_idx];
@@ -992,6 +1554,15 @@ void InMemoryExporter::get_info_fmt_value(
   uint64_t tot_nbytes = next_offset - offset;
   const char* ptr = src->data<char>() + offset;
 
+  // Typed attributes hold the values only, and are null if missing.
+  if (src->nullable()) {
+    const bool is_null = src->validity()[cell_idx] == 0;
+    *data = is_null ? nullptr : ptr;
+    *nbytes = is_null ? 0 : tot_nbytes;
+    *nelts = is_null ? 0 : tot_nbytes / src->value_size();
+    return;
+  }
+
   // Check for null (dummy byte).
   if (tot_nbytes == 1 && *ptr == '\0') {
     *data = nullptr;
@@ -1000,46 +1571,13 @@ void InMemoryExporter::get_info_fmt_value(
     return;
   }
 
-  if (is_extracted_attr) {
-    int type = *reinterpret_cast<const int*>(ptr);
-    ptr += sizeof(int);
-    int num_values = *reinterpret_cast<const int*>(ptr);
-    ptr += sizeof(int);
-    *data = ptr;
-    *nbytes = utils::bcf_type_size(type) * num_values;
-    *nelts = num_values;
-    return;
-  } else {
-    // Skip initial 'nfmt'/'ninfo' field.
-    tot_nbytes -= sizeof(uint32_t);
-    ptr += sizeof(uint32_t);
-
-    const char* end = ptr + tot_nbytes;
-    while (ptr < end) {
-      size_t keylen = strlen(ptr);
-      bool match = strcmp(field_name.c_str(), ptr) == 0;
-      ptr += keylen + 1;
-      int type = *reinterpret_cast<const int*>(ptr);
-      int type_size = utils::bcf_type_size(type);
-      ptr += sizeof(int);
-      int num_values = *reinterpret_cast<const int*>(ptr);
-      ptr += sizeof(int);
-
-      if (match) {
-        *data = ptr;
-        *nbytes = type_size * num_values;
-        *nelts = num_values;
-        return;
-      }
-
-      ptr += num_values * type_size;
-    }
-  }
-
-  // If we get here, no value for this field; return null value.
-  *data = nullptr;
-  *nbytes = 0;
-  *nelts = 0;
+  int type = *reinterpret_cast<const int*>(ptr);
+  ptr += sizeof(int);
+  int num_values = *reinterpret_cast<const int*>(ptr);
+  ptr += sizeof(int);
+  *data = ptr;
+  *nbytes = utils::bcf_type_size(type) * num_values;
+  *nelts = num_values;
 }
 
 }  // namespace vcf
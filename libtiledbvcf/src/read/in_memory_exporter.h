@@ -27,6 +27,9 @@
 #ifndef TILEDB_VCF_USER_BUFFER_EXPORTER_H
 #define TILEDB_VCF_USER_BUFFER_EXPORTER_H
 
+#include <limits>
+#include <unordered_map>
+
 #include "enums/attr_datatype.h"
 #include "read/exporter.h"
 #include "read_query_results.h"
@@ -67,6 +70,32 @@ class InMemoryExporter : public Exporter {
   void set_buffer_validity_bitmap(
       const std::string& attribute, uint8_t* buff, int64_t buff_size);
 
+  /**
+   * Sets whether an attribute is exported dictionary-encoded. Only
+   * "sample_name", "contig" and "alleles" can be dictionary-encoded.
+   *
+   * The values buffer of a dictionary-encoded attribute receives int32 indices
+   * into a dictionary of the distinct values of the read, in the order they
+   * are first exported. The sample name and contig get one index per record;
+   * the alleles get one per allele, with the offsets buffer delimiting the
+   * alleles of each record (there is no list offsets buffer).
+   */
+  void set_dictionary_encoding(const std::string& attribute, bool dictionary);
+
+  /**
+   * Sets the dictionary values buffer pointer and size (in bytes) for a
+   * dictionary-encoded attribute.
+   */
+  void set_buffer_dictionary_values(
+      const std::string& attribute, char* buff, int64_t buff_size);
+
+  /**
+   * Sets the dictionary offsets buffer pointer and size (in bytes) for a
+   * dictionary-encoded attribute.
+   */
+  void set_buffer_dictionary_offsets(
+      const std::string& attribute, int32_t* buff, int64_t buff_size);
+
   /**
    * Based on the buffers that have been set, returns the list of array
    * attributes that must be read from the TileDB array.
@@ -100,6 +129,21 @@ class InMemoryExporter : public Exporter {
       const ReadQueryResults& query_results,
       uint64_t cell_idx) override;
 
+  /**
+   * Exports a batch of cells. Columns of fixed-width and non-nullable
+   * variable-length attributes (v4 only) are copied in a single pass each,
+   * after computing how many rows fit in their buffers; the other columns are
+   * copied row by row.
+   *
+   * @param query_results Handle on the query results / buffers
+   * @param rows Cells to export
+   * @return Number of rows exported; less than the number of rows if the user
+   *    buffers ran out of space.
+   */
+  uint64_t export_records(
+      const ReadQueryResults& query_results,
+      const std::vector<ExportRow>& rows) override;
+
   /**
    * Returns the size of the result copied for the given attribute.
    */
@@ -109,6 +153,16 @@ class InMemoryExporter : public Exporter {
       int64_t* num_data_elements,
       int64_t* num_data_bytes) const;
 
+  /**
+   * Returns the size of the dictionary built for the given dictionary-encoded
+   * attribute. The number of offsets includes the final one, as for
+   * result_size().
+   */
+  void dictionary_result_size(
+      const std::string& attribute,
+      int64_t* num_offsets,
+      int64_t* num_data_bytes) const;
+
   /** Returns the number of in-memory user buffers that have been set. */
   void num_buffers(int32_t* num_buffers) const;
 
@@ -124,6 +178,61 @@ class InMemoryExporter : public Exporter {
   void get_buffer_validity_bitmap(
       int32_t buffer_idx, const char** name, uint8_t** buff) const;
 
+  /**
+   * Gets the dictionary buffers of the given user buffer index and their
+   * allocation sizes (in bytes), or nulls and 0 if not set.
+   */
+  void get_buffer_dictionary(
+      int32_t buffer_idx,
+      char** values,
+      int64_t* values_bytes,
+      int32_t** offsets,
+      int64_t* offsets_bytes) const;
+
+  /**
+   * Gets the allocation sizes (in bytes) of the buffers of the given user
+   * buffer index. Sizes of buffers that were not set are 0.
+   */
+  void get_buffer_sizes(
+      int32_t buffer_idx,
+      int64_t* data_bytes,
+      int64_t* offsets_bytes,
+      int64_t* list_offsets_bytes,
+      int64_t* bitmap_bytes) const;
+
+  /**
+   * Sets the maximum number of records exported between two calls to
+   * reset_current_sizes(), i.e. per read. Exporting more records fails as if
+   * the user buffers were full.
+   */
+  void set_max_batch_records(uint64_t max_batch_records);
+
+  /**
+   * Estimates the sizes (in bytes) of the buffers of an attribute needed to
+   * export the given number of records, from the sizes used by the records of
+   * the last read. Buffers that were full when the last read stopped early are
+   * at least doubled. Without any record to learn from, the current sizes are
+   * returned.
+   *
+   * @param attribute Attribute name
+   * @param num_records Number of records to size the buffers for
+   * @param last_num_records Number of records exported by the last read
+   * @param last_read_incomplete True if the last read was incomplete
+   * @param data_bytes Set to the size of the values buffer
+   * @param offsets_bytes Set to the size of the offsets buffer
+   * @param list_offsets_bytes Set to the size of the list offsets buffer
+   * @param bitmap_bytes Set to the size of the validity bitmap buffer
+   */
+  void buffer_size_estimate(
+      const std::string& attribute,
+      uint64_t num_records,
+      uint64_t last_num_records,
+      bool last_read_incomplete,
+      int64_t* data_bytes,
+      int64_t* offsets_bytes,
+      int64_t* list_offsets_bytes,
+      int64_t* bitmap_bytes) const;
+
   /** Resets the "current" (i.e. copied so far) sizes for all user buffers. */
   void reset_current_sizes();
 
@@ -132,6 +241,8 @@ class InMemoryExporter : public Exporter {
    *
    * @param dataset Dataset (for metadata)
    * @param attribute Attribute name
+   * @param dictionary True if the attribute is dictionary-encoded, in which
+   *    case its values are int32 indices
    * @param datatype Set to the datatype of the attribute
    * @param var_len Set to true if the attribute is variable-length
    * @param nullable Set to true if the attribute is nullable
@@ -140,6 +251,7 @@ class InMemoryExporter : public Exporter {
   static void attribute_datatype(
       const TileDBVCFDataset* dataset,
       const std::string& attribute,
+      bool dictionary,
       AttrDatatype* datatype,
       bool* var_len,
       bool* nullable,
@@ -234,6 +346,32 @@ class InMemoryExporter : public Exporter {
     int64_t max_bitmap_bytes;
     /** Convenience wrapper around the bitmap buffer. */
     std::unique_ptr<Bitmap> bitmap;
+
+    /** True if the values are indices into the dictionary. */
+    bool dictionary = false;
+
+    /** Pointer to user's dictionary values buffer. */
+    char* dict_data = nullptr;
+    /** Size of user's dictionary values buffer allocation (in bytes) */
+    int64_t max_dict_data_bytes = 0;
+
+    /** Pointer to user's dictionary offsets buffer. */
+    int32_t* dict_offsets = nullptr;
+    /** Size, in num offsets, of user's dictionary offsets buffer. */
+    int64_t max_num_dict_offsets = 0;
+
+    /**
+     * Current number of dictionary entries and values bytes. Entries are not
+     * removed when a record overflows, they are merely left unreferenced.
+     */
+    int64_t num_dict_entries = 0;
+    int64_t dict_data_bytes = 0;
+
+    /** Index of each dictionary entry, keyed by its value in dict_data. */
+    std::unordered_map<std::string_view, int32_t> dict_index;
+
+    /** Index of the last entry looked up, or -1. */
+    int32_t last_dict_entry = -1;
   };
 
   /* ********************************* */
@@ -254,6 +392,25 @@ class InMemoryExporter : public Exporter {
   /** Reusable string buffer for temp results. */
   std::string str_buff_;
 
+  /** Reusable buffer sizes saved before exporting a record. */
+  std::vector<UserBufferSizes> saved_sizes_;
+
+  /** Maximum number of records exported per read. */
+  uint64_t max_batch_records_ = std::numeric_limits<uint64_t>::max();
+
+  /** Number of records exported since the last reset_current_sizes(). */
+  uint64_t num_batch_records_ = 0;
+
+  /** Reusable buffer for the dictionary indices of the alleles of a record. */
+  mutable std::vector<int32_t> allele_indices_;
+
+  /** Names of the dictionary-encoded attributes. */
+  std::set<std::string> dictionary_attrs_;
+
+  /** Reusable lists of the buffers copied by column and by row in a batch. */
+  std::vector<UserBuffer*> column_buffers_;
+  std::vector<UserBuffer*> row_buffers_;
+
   /* ********************************* */
   /*           PRIVATE METHODS         */
   /* ********************************* */
@@ -275,6 +432,9 @@ class InMemoryExporter : public Exporter {
   /** Returns true if the given exportable attribute is nullable. */
   static bool nullable_attr(const std::string& attr);
 
+  /** Returns true if the given attribute can be dictionary-encoded. */
+  static bool dictionary_attr(const std::string& attr);
+
   /** Gets the datatype for a specific info_/fmt_ attribute. */
   static AttrDatatype get_info_fmt_datatype(
       const TileDBVCFDataset* dataset,
@@ -283,6 +443,41 @@ class InMemoryExporter : public Exporter {
 
   UserBuffer* get_buffer(const std::string& attribute);
 
+  /** Copies the value of a cell to a user buffer. */
+  bool copy_attribute(
+      UserBuffer* dest,
+      std::string_view sample_name,
+      const bcf_hdr_t* hdr,
+      const Region& query_region,
+      uint32_t contig_offset,
+      uint64_t cell_idx);
+
+  /**
+   * Returns true if the given buffer can be copied column by column by
+   * export_records().
+   */
+  bool column_copyable(const UserBuffer& buff) const;
+
+  /** Returns true if a column-copyable buffer holds 4-byte values. */
+  static bool fixed_width_column(const UserBuffer& buff);
+
+  /** Returns the value of a variable-length column-copyable attribute. */
+  std::string_view var_column_value(
+      const UserBuffer& buff, const ExportRow& row) const;
+
+  /**
+   * Returns the number of leading rows whose values fit in a column-copyable
+   * buffer.
+   */
+  uint64_t column_rows_fitting(
+      const UserBuffer& buff, const std::vector<ExportRow>& rows) const;
+
+  /** Copies the first num_rows rows of a column-copyable attribute. */
+  void copy_column(
+      UserBuffer* dest,
+      const std::vector<ExportRow>& rows,
+      uint64_t num_rows) const;
+
   /** Copies the given cell data to a user buffer. */
   bool copy_cell(
       UserBuffer* dest,
@@ -321,6 +516,22 @@ class InMemoryExporter : public Exporter {
   /** Helper method to export the alleles attribute. */
   bool copy_alleles_list(uint64_t cell_idx, UserBuffer* dest) const;
 
+  /**
+   * Gets the index of a value in the dictionary of a dictionary-encoded
+   * buffer, adding the value if needed.
+   *
+   * @return False if the dictionary buffers ran out of space.
+   */
+  bool dictionary_index(
+      UserBuffer* dest, std::string_view value, int32_t* index) const;
+
+  /** Helper method to export a dictionary-encoded string attribute. */
+  bool copy_dictionary_cell(
+      UserBuffer* dest, std::string_view value, const bcf_hdr_t* hdr) const;
+
+  /** Helper method to export the dictionary-encoded alleles attribute. */
+  bool copy_alleles_indices(uint64_t cell_idx, UserBuffer* dest) const;
+
   /** Helper method to export the filters attribute. */
   bool copy_filters_list(
       const bcf_hdr_t* hdr, uint64_t cell_idx, UserBuffer* dest) const;
@@ -0,0 +1,120 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include "read/info_fmt_index.h"
+#include "utils/utils.h"
+
+namespace tiledb {
+namespace vcf {
+
+InfoFmtIndex::InfoFmtIndex(const InfoFmtIndex& other)
+    : keys_(other.keys_)
+    , cell_begin_(other.cell_begin_)
+    , cell_count_(other.cell_count_)
+    , entries_(other.entries_)
+    , num_decoded_cells_(other.num_decoded_cells_) {
+  for (uint32_t id = 0; id < keys_.size(); id++)
+    key_ids_.emplace(keys_[id], id);
+}
+
+InfoFmtIndex& InfoFmtIndex::operator=(const InfoFmtIndex& other) {
+  InfoFmtIndex copy(other);
+  *this = std::move(copy);
+  return *this;
+}
+
+void InfoFmtIndex::reset(uint64_t num_cells) {
+  cell_begin_.resize(num_cells);
+  cell_count_.assign(num_cells, NOT_DECODED);
+  entries_.clear();
+  num_decoded_cells_ = 0;
+}
+
+uint32_t InfoFmtIndex::key_id(std::string_view key) {
+  auto it = key_ids_.find(key);
+  if (it != key_ids_.end())
+    return it->second;
+
+  const uint32_t id = keys_.size();
+  keys_.emplace_back(key);
+  key_ids_.emplace(keys_.back(), id);
+  return id;
+}
+
+const InfoFmtIndex::Field* InfoFmtIndex::find(
+    uint64_t cell_idx, const char* blob, uint64_t nbytes, uint32_t key_id) {
+  if (cell_count_[cell_idx] == NOT_DECODED)
+    decode(cell_idx, blob, nbytes);
+
+  const Entry* begin = entries_.data() + cell_begin_[cell_idx];
+  const Entry* end = begin + cell_count_[cell_idx];
+  for (const Entry* e = begin; e < end; e++) {
+    if (e->key_id == key_id)
+      return &e->field;
+  }
+
+  // Missing field
+  return nullptr;
+}
+
+uint64_t InfoFmtIndex::num_decoded_cells() const {
+  return num_decoded_cells_;
+}
+
+void InfoFmtIndex::decode(
+    uint64_t cell_idx, const char* blob, uint64_t nbytes) {
+  cell_begin_[cell_idx] = entries_.size();
+  cell_count_[cell_idx] = 0;
+  num_decoded_cells_++;
+
+  // Null blobs hold a single dummy byte.
+  if (nbytes <= sizeof(uint32_t))
+    return;
+
+  // Skip initial 'nfmt'/'ninfo' field.
+  const char* ptr = blob + sizeof(uint32_t);
+  const char* end = blob + nbytes;
+  while (ptr < end) {
+    const size_t len = std::strlen(ptr);
+    Entry entry;
+    entry.key_id = key_id(std::string_view(ptr, len));
+    ptr += len + 1;
+    // Values in the blob are not aligned.
+    std::memcpy(&entry.field.type, ptr, sizeof(int));
+    ptr += sizeof(int);
+    std::memcpy(&entry.field.num_values, ptr, sizeof(int));
+    ptr += sizeof(int);
+    entry.field.values = ptr;
+    ptr += entry.field.num_values * utils::bcf_type_size(entry.field.type);
+    entries_.push_back(entry);
+  }
+  cell_count_[cell_idx] = entries_.size() - cell_begin_[cell_idx];
+}
+
+}  // namespace vcf
+}  // namespace tiledb
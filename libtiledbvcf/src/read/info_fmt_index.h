@@ -0,0 +1,134 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TILEDB_VCF_INFO_FMT_INDEX_H
+#define TILEDB_VCF_INFO_FMT_INDEX_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tiledb {
+namespace vcf {
+
+/**
+ * Index of the fields packed in the info (or fmt) blob attribute of a batch of
+ * query results.
+ *
+ * A blob holds the number of fields followed by "key\0,type,nvalues,values"
+ * for each field. Rather than scanning the blob with string comparisons for
+ * every field that is looked up, the blob of a cell is decoded once, the first
+ * time one of its fields is requested, into a list of (key id, value) entries.
+ * Keys are interned to integer ids that stay valid across batches, so later
+ * lookups in the cell only compare integers.
+ */
+class InfoFmtIndex {
+ public:
+  /** Location of the values of a field in the blob. */
+  struct Field {
+    /** BCF_HT_ type of the values. */
+    int type;
+
+    /** Number of values. */
+    int num_values;
+
+    /** Pointer to the values. */
+    const char* values;
+  };
+
+  /** Constructor. */
+  InfoFmtIndex() = default;
+
+  /** Copies the interned keys; the map of keys views the copied strings. */
+  InfoFmtIndex(const InfoFmtIndex& other);
+  InfoFmtIndex& operator=(const InfoFmtIndex& other);
+
+  /** Moving keeps the deque elements, and so the views of the map, in place. */
+  InfoFmtIndex(InfoFmtIndex&& other) = default;
+  InfoFmtIndex& operator=(InfoFmtIndex&& other) = default;
+
+  /** Clears the decoded cells, for a new batch of num_cells cells. */
+  void reset(uint64_t num_cells);
+
+  /** Returns the id of the given key, interning it if needed. */
+  uint32_t key_id(std::string_view key);
+
+  /**
+   * Looks up a field in the blob of a cell, decoding the blob if this is the
+   * first lookup in the cell since reset().
+   *
+   * @param cell_idx Index of the cell
+   * @param blob Pointer to the blob value of the cell
+   * @param nbytes Size of the blob value of the cell
+   * @param key_id Id of the key of the field
+   * @return The field, or nullptr if the cell has no value for the field
+   */
+  const Field* find(
+      uint64_t cell_idx, const char* blob, uint64_t nbytes, uint32_t key_id);
+
+  /** Returns the number of cells decoded since reset(). */
+  uint64_t num_decoded_cells() const;
+
+ private:
+  /** A decoded field. */
+  struct Entry {
+    uint32_t key_id;
+    Field field;
+  };
+
+  /** Marks a cell that has not been decoded. */
+  static constexpr uint32_t NOT_DECODED = UINT32_MAX;
+
+  /** Interned keys, in id order. A deque keeps the keys in place. */
+  std::deque<std::string> keys_;
+
+  /** Map of key -> id, viewing the strings in keys_. */
+  std::unordered_map<std::string_view, uint32_t> key_ids_;
+
+  /** Per cell, the index of its first entry in entries_. */
+  std::vector<uint64_t> cell_begin_;
+
+  /** Per cell, the number of entries, or NOT_DECODED. */
+  std::vector<uint32_t> cell_count_;
+
+  /** Decoded entries of all decoded cells. */
+  std::vector<Entry> entries_;
+
+  /** Number of cells decoded since reset(). */
+  uint64_t num_decoded_cells_ = 0;
+
+  /** Decodes the blob of a cell, appending its entries to entries_. */
+  void decode(uint64_t cell_idx, const char* blob, uint64_t nbytes);
+};
+
+}  // namespace vcf
+}  // namespace tiledb
+
+#endif  // TILEDB_VCF_INFO_FMT_INDEX_H
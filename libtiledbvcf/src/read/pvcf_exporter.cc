@@ -61,7 +61,7 @@ PVCFExporter::~PVCFExporter() {
 
 void PVCFExporter::init(
     const std::unordered_map<std::string, size_t>& hdrs_lookup,
-    const std::unordered_map<uint32_t, SafeBCFHdr>& hdrs) {
+    const std::unordered_map<uint32_t, SharedBCFHdr>& hdrs) {
   // sort sample names to match the order returned by tiledb
   std::vector<std::pair<std::string, size_t>> sorted_hdrs(
       hdrs_lookup.begin(), hdrs_lookup.end());
@@ -130,8 +130,7 @@ bool PVCFExporter::export_record(
 }
 
 std::set<std::string> PVCFExporter::array_attributes_required() const {
-  // TODO: currently we require all attributes for record recovery.
-  return dataset_->all_attributes();
+  return record_attributes_required();
 }
 
 }  // namespace vcf
@@ -42,7 +42,7 @@ class PVCFExporter : public Exporter {
 
   void init(
       const std::unordered_map<std::string, size_t>& hdrs_lookup,
-      const std::unordered_map<uint32_t, SafeBCFHdr>& hdrs);
+      const std::unordered_map<uint32_t, SharedBCFHdr>& hdrs);
 
   void reset() override;
 
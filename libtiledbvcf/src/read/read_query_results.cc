@@ -24,7 +24,11 @@
  * THE SOFTWARE.
  */
 
+#include <cstring>
+#include <stdexcept>
+
 #include "read/read_query_results.h"
+#include "utils/utils.h"
 
 namespace tiledb {
 namespace vcf {
@@ -60,10 +64,22 @@ void ReadQueryResults::set_results(
   filter_ids_size_ = result_el["filter_ids"];
   info_size_ = result_el["info"];
   fmt_size_ = result_el["fmt"];
+  info_index_.reset(num_cells_);
+  fmt_index_.reset(num_cells_);
 
   extra_attrs_size_.clear();
-  for (const auto& attr : dataset.metadata().extra_attributes)
-    extra_attrs_size_[attr] = result_el[attr];
+  typed_attr_types_.clear();
+  for (const auto& attr : dataset.metadata().extra_attributes) {
+    auto size = result_el[attr];
+    // Typed attributes report values, not bytes
+    tiledb_datatype_t datatype;
+    if (dataset.is_attribute_typed(attr, &datatype)) {
+      size.second *= tiledb_datatype_size(datatype);
+      typed_attr_types_[attr] =
+          datatype == TILEDB_FLOAT32 ? BCF_HT_REAL : BCF_HT_INT;
+    }
+    extra_attrs_size_[attr] = size;
+  }
 }
 
 tiledb::Query::Status ReadQueryResults::query_status() const {
@@ -111,5 +127,89 @@ ReadQueryResults::extra_attrs_size() const {
   return extra_attrs_size_;
 }
 
+const char* ReadQueryResults::var_attr_value(
+    const Buffer& src,
+    const std::pair<uint64_t, uint64_t>& src_size,
+    uint64_t cell_idx,
+    uint64_t* nbytes) const {
+  const auto& offsets = src.offsets();
+  const uint64_t offset = offsets[cell_idx];
+  const uint64_t next_offset =
+      cell_idx == num_cells_ - 1 ? src_size.second : offsets[cell_idx + 1];
+  *nbytes = next_offset - offset;
+  return src.data<char>() + offset;
+}
+
+bool ReadQueryResults::info_fmt_value(
+    const std::string& field,
+    uint64_t cell_idx,
+    int* type,
+    int* num_values,
+    const char** values) const {
+  const Buffer* src = nullptr;
+  if (buffers_->extra_attr(field, &src)) {
+    auto sizes_iter = extra_attrs_size_.find(field);
+    if (sizes_iter == extra_attrs_size_.end())
+      throw std::runtime_error(
+          "Error getting info/fmt value; could not find size for extra "
+          "attribute " +
+          field);
+    uint64_t nbytes = 0;
+    const char* ptr =
+        var_attr_value(*src, sizes_iter->second, cell_idx, &nbytes);
+
+    // Typed attributes hold the values only, and are null if missing.
+    auto typed = typed_attr_types_.find(field);
+    if (typed != typed_attr_types_.end()) {
+      if (src->validity()[cell_idx] == 0)
+        return false;
+      *type = typed->second;
+      *num_values = nbytes / src->value_size();
+      *values = ptr;
+      return true;
+    }
+
+    // Check for null (dummy byte).
+    if (nbytes <= 1)
+      return false;
+    *type = *reinterpret_cast<const int*>(ptr);
+    *num_values = *reinterpret_cast<const int*>(ptr + sizeof(int));
+    *values = ptr + 2 * sizeof(int);
+    return true;
+  }
+
+  const bool is_info = utils::starts_with(field, "info_");
+  const std::string_view key =
+      std::string_view(field).substr(is_info ? 5 : 4);
+  return blob_field_value(is_info, key, cell_idx, type, num_values, values);
+}
+
+bool ReadQueryResults::blob_field_value(
+    bool is_info,
+    std::string_view key,
+    uint64_t cell_idx,
+    int* type,
+    int* num_values,
+    const char** values) const {
+  uint64_t nbytes = 0;
+  const char* ptr =
+      is_info ?
+          var_attr_value(buffers_->info(), info_size_, cell_idx, &nbytes) :
+          var_attr_value(buffers_->fmt(), fmt_size_, cell_idx, &nbytes);
+  if (nbytes <= 1)
+    return false;
+
+  InfoFmtIndex& index = is_info ? info_index_ : fmt_index_;
+  const InfoFmtIndex::Field* field =
+      index.find(cell_idx, ptr, nbytes, index.key_id(key));
+  if (field == nullptr)
+    return false;
+
+  *type = field->type;
+  *num_values = field->num_values;
+  *values = field->values;
+  return true;
+}
+
 }  // namespace vcf
 }  // namespace tiledb
@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "dataset/attribute_buffer_set.h"
+#include "read/info_fmt_index.h"
 #include "utils/buffer.h"
 
 namespace tiledb {
@@ -86,6 +87,58 @@ struct ReadQueryResults {
   const std::unordered_map<std::string, std::pair<uint64_t, uint64_t>>&
   extra_attrs_size() const;
 
+  /**
+   * Gets a pointer to the value of a var-length attribute for a cell.
+   *
+   * @param src Buffer of the attribute
+   * @param src_size Result size of the attribute
+   * @param cell_idx Index of the cell
+   * @param nbytes Set to the size of the value in bytes
+   */
+  const char* var_attr_value(
+      const Buffer& src,
+      const std::pair<uint64_t, uint64_t>& src_size,
+      uint64_t cell_idx,
+      uint64_t* nbytes) const;
+
+  /**
+   * Gets the values of an info/fmt field for a cell, from its extracted
+   * attribute if it was read, else from the info/fmt blob attribute.
+   *
+   * @param field Field name, "info_<key>" or "fmt_<key>"
+   * @param cell_idx Index of the cell
+   * @param type Set to the BCF_HT_ type of the values
+   * @param num_values Set to the number of values
+   * @param values Set to a pointer to the values
+   * @return False if the cell has no value for the field
+   */
+  bool info_fmt_value(
+      const std::string& field,
+      uint64_t cell_idx,
+      int* type,
+      int* num_values,
+      const char** values) const;
+
+  /**
+   * Gets the values of a field of the info (or fmt) blob attribute for a cell.
+   * The blob of each cell is decoded once per batch of results.
+   *
+   * @param is_info True for the info blob, false for the fmt blob
+   * @param key Field key, without the "info_"/"fmt_" prefix
+   * @param cell_idx Index of the cell
+   * @param type Set to the BCF_HT_ type of the values
+   * @param num_values Set to the number of values
+   * @param values Set to a pointer to the values
+   * @return False if the cell has no value for the field
+   */
+  bool blob_field_value(
+      bool is_info,
+      std::string_view key,
+      uint64_t cell_idx,
+      int* type,
+      int* num_values,
+      const char** values) const;
+
  private:
   /** Pointer to buffer set holding the actual data. */
   const AttributeBufferSet* buffers_;
@@ -105,6 +158,13 @@ struct ReadQueryResults {
   std::pair<uint64_t, uint64_t> fmt_size_;
   std::unordered_map<std::string, std::pair<uint64_t, uint64_t>>
       extra_attrs_size_;
+
+  /** Map of typed extra attribute name -> BCF_HT_ type of its values. */
+  std::unordered_map<std::string, int> typed_attr_types_;
+
+  /** Indexes of the fields of the info and fmt blobs, per cell. */
+  mutable InfoFmtIndex info_index_;
+  mutable InfoFmtIndex fmt_index_;
 };
 
 }  // namespace vcf
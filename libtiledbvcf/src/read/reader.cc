@@ -24,6 +24,7 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <future>
 #include <iomanip>
 #include <random>
@@ -53,6 +54,10 @@ Reader::~Reader() {
     ctx_->cancel_tasks();
   }
 
+  // The async submission may still be writing into the buffers; wait for it
+  // before the buffers are freed.
+  wait_for_query();
+
   utils::free_htslib_tiledb_context();
 }
 
@@ -61,16 +66,25 @@ void Reader::open_dataset(const std::string& dataset_uri) {
 
   dataset_.reset(new TileDBVCFDataset(ctx_));
   dataset_->open(dataset_uri, params_.tiledb_config);
+  dataset_->set_vcf_header_cache_size(
+      params_.vcf_header_cache_mb * 1024 * 1024);
   read_state_.array = dataset_->data_array();
 }
 
 void Reader::reset() {
+  wait_for_query();
   read_state_ = ReadState();
   read_state_.array = dataset_->data_array();
   if (exporter_ != nullptr) {
     exporter_->reset();
     read_state_.need_headers = exporter_->need_headers();
   }
+  if (record_counter_ != nullptr)
+    record_counter_->reset();
+  if (variant_stats_ != nullptr)
+    variant_stats_->reset();
+  if (genotype_matrix_ != nullptr)
+    genotype_matrix_->reset();
 }
 
 void Reader::reset_buffers() {
@@ -90,6 +104,54 @@ void Reader::set_regions(const std::string& regions) {
   params_.regions = utils::split(regions, ',');
 }
 
+void Reader::set_contig_batch_concurrency(unsigned concurrency) {
+  if (concurrency == 0)
+    throw std::runtime_error(
+        "Error setting contig batch concurrency; must be at least 1.");
+  params_.contig_batch_concurrency = concurrency;
+}
+
+void Reader::set_late_materialization(bool late_materialization) {
+  params_.late_materialization = late_materialization;
+}
+
+void Reader::set_filter_expression(const std::string& expression) {
+  // Parse eagerly so that invalid expressions are reported here.
+  if (!expression.empty())
+    RecordFilter filter(expression);
+  params_.filter_expression = expression;
+}
+
+void Reader::set_count_group_by(CountGroupBy group_by) {
+  params_.count_group_by = group_by;
+}
+
+void Reader::set_variant_stats(bool variant_stats) {
+  params_.variant_stats = variant_stats;
+}
+
+void Reader::set_genotype_matrix(bool genotype_matrix) {
+  params_.genotype_matrix = genotype_matrix;
+}
+
+void Reader::set_genotype_matrix_buffer(void* buffer, uint64_t size) {
+  genotype_matrix_buffer_ = static_cast<uint8_t*>(buffer);
+  genotype_matrix_buffer_size_ = size;
+  params_.genotype_matrix_path.clear();
+}
+
+void Reader::set_genotype_matrix_file(const std::string& path) {
+  params_.genotype_matrix_path = path;
+  genotype_matrix_buffer_ = nullptr;
+  genotype_matrix_buffer_size_ = 0;
+}
+
+void Reader::set_vcf_header_cache_size(uint64_t mb) {
+  params_.vcf_header_cache_mb = mb;
+  if (dataset_ != nullptr)
+    dataset_->set_vcf_header_cache_size(mb * 1024 * 1024);
+}
+
 void Reader::set_sort_regions(bool sort_regions) {
   params_.sort_regions = sort_regions;
 }
@@ -180,12 +242,42 @@ void Reader::set_buffer_validity_bitmap(
   }
 }
 
+void Reader::set_dictionary_encoding(
+    const std::string& attribute, bool dictionary) {
+  auto exp = set_in_memory_exporter();
+  exp->set_dictionary_encoding(attribute, dictionary);
+  if (dictionary)
+    params_.dictionary_attributes.insert(attribute);
+  else
+    params_.dictionary_attributes.erase(attribute);
+}
+
+bool Reader::dictionary_encoding(const std::string& attribute) const {
+  return params_.dictionary_attributes.count(attribute) > 0;
+}
+
+void Reader::set_buffer_dictionary_values(
+    const std::string& attribute, char* buff, int64_t buff_size) {
+  auto exp = set_in_memory_exporter();
+  exp->set_buffer_dictionary_values(attribute, buff, buff_size);
+}
+
+void Reader::set_buffer_dictionary_offsets(
+    const std::string& attribute, int32_t* buff, int64_t buff_size) {
+  auto exp = set_in_memory_exporter();
+  exp->set_buffer_dictionary_offsets(attribute, buff, buff_size);
+}
+
 InMemoryExporter* Reader::set_in_memory_exporter() {
   // On the first call to set_buffer(), swap out any existing exporter with an
   // InMemoryExporter.
   auto exp = dynamic_cast<InMemoryExporter*>(exporter_.get());
   if (exp == nullptr) {
     exp = new InMemoryExporter;
+    if (params_.batch_num_records > 0)
+      exp->set_max_batch_records(params_.batch_num_records);
+    for (const auto& attribute : params_.dictionary_attributes)
+      exp->set_dictionary_encoding(attribute, true);
     exporter_.reset(exp);
   }
   return exp;
@@ -200,6 +292,41 @@ void Reader::set_record_limit(uint64_t max_num_records) {
   params_.max_num_records = max_num_records;
 }
 
+void Reader::set_batch_num_records(uint64_t num_records) {
+  params_.batch_num_records = num_records;
+  auto exp = dynamic_cast<InMemoryExporter*>(exporter_.get());
+  if (exp != nullptr)
+    exp->set_max_batch_records(
+        num_records > 0 ? num_records :
+                          std::numeric_limits<uint64_t>::max());
+}
+
+uint64_t Reader::batch_num_records() const {
+  return params_.batch_num_records;
+}
+
+void Reader::buffer_size_estimate(
+    const std::string& attribute,
+    uint64_t num_records,
+    int64_t* data_bytes,
+    int64_t* offsets_bytes,
+    int64_t* list_offsets_bytes,
+    int64_t* bitmap_bytes) const {
+  auto exp = dynamic_cast<InMemoryExporter*>(exporter_.get());
+  if (exp == nullptr)
+    throw std::runtime_error(
+        "Error estimating buffer size; improper or null exporter instance");
+  exp->buffer_size_estimate(
+      attribute,
+      num_records,
+      read_state_.last_num_records_exported,
+      read_state_.status == ReadStatus::INCOMPLETE,
+      data_bytes,
+      offsets_bytes,
+      list_offsets_bytes,
+      bitmap_bytes);
+}
+
 void Reader::set_tiledb_config(const std::string& config_str) {
   params_.tiledb_config = utils::split(config_str, ',');
   // Attempt to set config to check validity
@@ -217,6 +344,37 @@ uint64_t Reader::num_records_exported() const {
   return read_state_.last_num_records_exported;
 }
 
+const std::vector<RecordCounter::Group>& Reader::count_groups() {
+  if (record_counter_ == nullptr)
+    throw std::runtime_error(
+        "Error getting count groups; no count grouping was set for the last "
+        "read.");
+  return record_counter_->groups();
+}
+
+const std::vector<VariantStats::Variant>& Reader::variant_stats() {
+  if (variant_stats_ == nullptr)
+    throw std::runtime_error(
+        "Error getting variant stats; variant stats were not enabled for the "
+        "last read.");
+  return variant_stats_->variants();
+}
+
+const GenotypeMatrix& Reader::genotype_matrix() const {
+  if (genotype_matrix_ == nullptr)
+    throw std::runtime_error(
+        "Error getting genotype matrix; genotype matrix was not enabled for "
+        "the last read.");
+  return *genotype_matrix_;
+}
+
+VCFHeaderCache::Stats Reader::vcf_header_cache_stats() const {
+  if (dataset_ == nullptr)
+    throw std::runtime_error(
+        "Error getting VCF header cache stats; dataset is not open.");
+  return dataset_->vcf_header_cache_stats();
+}
+
 void Reader::set_tiledb_stats_enabled(bool stats_enabled) {
   params_.tiledb_stats_enabled = stats_enabled;
 }
@@ -258,6 +416,18 @@ void Reader::result_size(
       attribute, num_offsets, num_data_elements, num_data_bytes);
 }
 
+void Reader::dictionary_result_size(
+    const std::string& attribute,
+    int64_t* num_offsets,
+    int64_t* num_data_bytes) const {
+  auto exp = dynamic_cast<InMemoryExporter*>(exporter_.get());
+  if (exp == nullptr)
+    throw std::runtime_error(
+        "Error getting dictionary result size; improper or null exporter "
+        "instance");
+  exp->dictionary_result_size(attribute, num_offsets, num_data_bytes);
+}
+
 void Reader::attribute_datatype(
     const std::string& attribute,
     AttrDatatype* datatype,
@@ -266,7 +436,13 @@ void Reader::attribute_datatype(
     bool* list) const {
   // Datatypes for attributes are defined by the in-memory export.
   return InMemoryExporter::attribute_datatype(
-      dataset_.get(), attribute, datatype, var_len, nullable, list);
+      dataset_.get(),
+      attribute,
+      dictionary_encoding(attribute),
+      datatype,
+      var_len,
+      nullable,
+      list);
 }
 
 void Reader::num_buffers(int32_t* num_buffers) const {
@@ -313,6 +489,34 @@ void Reader::get_buffer_validity_bitmap(
   exp->get_buffer_validity_bitmap(buffer_idx, name, buff);
 }
 
+void Reader::get_buffer_dictionary(
+    int32_t buffer_idx,
+    char** values,
+    int64_t* values_bytes,
+    int32_t** offsets,
+    int64_t* offsets_bytes) const {
+  auto exp = dynamic_cast<InMemoryExporter*>(exporter_.get());
+  if (exp == nullptr)
+    throw std::runtime_error(
+        "Error getting buffer information; improper or null exporter instance");
+  exp->get_buffer_dictionary(
+      buffer_idx, values, values_bytes, offsets, offsets_bytes);
+}
+
+void Reader::get_buffer_sizes(
+    int32_t buffer_idx,
+    int64_t* data_bytes,
+    int64_t* offsets_bytes,
+    int64_t* list_offsets_bytes,
+    int64_t* bitmap_bytes) const {
+  auto exp = dynamic_cast<InMemoryExporter*>(exporter_.get());
+  if (exp == nullptr)
+    throw std::runtime_error(
+        "Error getting buffer information; improper or null exporter instance");
+  exp->get_buffer_sizes(
+      buffer_idx, data_bytes, offsets_bytes, list_offsets_bytes, bitmap_bytes);
+}
+
 void Reader::read() {
   dataset_->set_tiledb_stats_enabled(params_.tiledb_stats_enabled);
   dataset_->set_tiledb_stats_enabled_vcf_header(
@@ -337,8 +541,14 @@ void Reader::read() {
   switch (read_state_.status) {
     case ReadStatus::COMPLETED:
     case ReadStatus::FAILED:
+      // A failed read may have left prefetched queries in flight; wait for
+      // them before freeing the buffers they write into.
+      wait_for_query();
+
       // Reset buffers as the are no longer needed
       buffers_a.reset(nullptr);
+      buffers_b.reset(nullptr);
+      contig_batch_buffers_.clear();
       return;
     case ReadStatus::INCOMPLETE:
       // Do nothing; read will resume.
@@ -354,7 +564,8 @@ void Reader::read() {
   // sizes at the start of each query
   if (!params_.export_to_disk && exporter_ != nullptr) {
     auto exp = dynamic_cast<InMemoryExporter*>(exporter_.get());
-    exp->reset_current_sizes();
+    if (exp != nullptr)
+      exp->reset_current_sizes();
   }
 
   while (pending_work) {
@@ -366,8 +577,12 @@ void Reader::read() {
     pending_work = next_read_batch();
   }
 
-  // If we get here, query is complete.
+  // If we get here, query is complete. Queries started ahead of time are not
+  // needed if the record limit was hit.
+  wait_for_query();
   read_state_.status = ReadStatus::COMPLETED;
+  if (genotype_matrix_ != nullptr)
+    genotype_matrix_->finish();
 
   // Close the exporter (flushes any buffers), and upload files if specified.
   if (exporter_ != nullptr) {
@@ -375,7 +590,10 @@ void Reader::read() {
     exporter_->upload_exported_files(*vfs_, params_.upload_dir);
   }
 
-  if (params_.cli_count_only) {
+  if (params_.cli_count_only && record_counter_ != nullptr) {
+    for (const auto& group : record_counter_->groups())
+      std::cout << group.first << "\t" << group.second << std::endl;
+  } else if (params_.cli_count_only) {
     std::cout << read_state_.last_num_records_exported << std::endl;
   } else {
     LOG_INFO(fmt::format(
@@ -399,6 +617,19 @@ void Reader::init_for_reads() {
 
 void Reader::init_for_reads_v2() {
   assert(dataset_->metadata().version == TileDBVCFDataset::Version::V2);
+  if (!params_.filter_expression.empty())
+    throw std::runtime_error(
+        "Error initializing reads; filter expressions are only supported for "
+        "v4 datasets.");
+  if (params_.variant_stats)
+    throw std::runtime_error(
+        "Error initializing reads; variant stats are only supported for v4 "
+        "datasets.");
+  if (params_.genotype_matrix)
+    throw std::runtime_error(
+        "Error initializing reads; genotype matrices are only supported for "
+        "v4 datasets.");
+  record_filter_.reset();
   read_state_.batch_idx = 0;
   read_state_.sample_batches = prepare_sample_batches();
   read_state_.last_intersecting_region_idx_ = 0;
@@ -449,6 +680,19 @@ void Reader::init_for_reads_v2() {
 
 void Reader::init_for_reads_v3() {
   assert(dataset_->metadata().version == TileDBVCFDataset::Version::V3);
+  if (!params_.filter_expression.empty())
+    throw std::runtime_error(
+        "Error initializing reads; filter expressions are only supported for "
+        "v4 datasets.");
+  if (params_.variant_stats)
+    throw std::runtime_error(
+        "Error initializing reads; variant stats are only supported for v4 "
+        "datasets.");
+  if (params_.genotype_matrix)
+    throw std::runtime_error(
+        "Error initializing reads; genotype matrices are only supported for "
+        "v4 datasets.");
+  record_filter_.reset();
   read_state_.batch_idx = 0;
   read_state_.sample_batches = prepare_sample_batches();
   read_state_.last_intersecting_region_idx_ = 0;
@@ -506,6 +750,14 @@ void Reader::init_for_reads_v4() {
 
   init_exporter();
 
+  record_filter_.reset();
+  if (!params_.filter_expression.empty()) {
+    record_filter_.reset(new RecordFilter(params_.filter_expression));
+    // FILTER ids are resolved to names with the sample headers
+    if (record_filter_->uses_filters())
+      read_state_.need_headers = true;
+  }
+
   prepare_regions_v4(
       &read_state_.regions,
       &read_state_.regions_index_per_contig,
@@ -615,7 +867,7 @@ bool Reader::next_read_batch_v2_v3() {
 
   // Set up the TileDB query
   read_state_.query.reset(new Query(*ctx_, *read_state_.array));
-  set_tiledb_query_config();
+  set_tiledb_query_config(read_state_.query.get());
 
   // Set ranges
   std::stringstream debug_ranges;
@@ -760,9 +1012,52 @@ bool Reader::next_read_batch_v4() {
     }
   }
 
+  // Take over the query for this contig batch if it was started ahead of
+  // time, otherwise set it up now.
+  if (!read_state_.pending_contig_batches.empty() &&
+      read_state_.pending_contig_batches.front().contig_batch_idx ==
+          read_state_.query_contig_batch_idx) {
+    auto& pending = read_state_.pending_contig_batches.front();
+    read_state_.query = std::move(pending.query);
+    read_state_.query_future = std::move(pending.query_future);
+    read_state_.query_estimated_num_records = pending.estimated_num_records;
+    // The pending buffers receive the first chunk of results; the previous
+    // buffers are recycled for the next prefetched batch.
+    std::swap(buffers_a, pending.buffers);
+    contig_batch_buffers_.push_back(std::move(pending.buffers));
+    read_state_.pending_contig_batches.pop_front();
+  } else {
+    read_state_.query = build_query_v4(
+        read_state_.query_contig_batch_idx,
+        &read_state_.query_estimated_num_records);
+  }
+  read_state_.total_query_records_processed = 0;
+
+  prefetch_contig_batches_v4();
+
+  return true;
+}
+
+std::unique_ptr<Query> Reader::build_query_v4(
+    size_t contig_batch_idx, uint64_t* estimated_num_records) {
+  auto query = init_query_v4(contig_batch_idx);
+  std::unique_ptr<Query> position_query;
+  if (params_.late_materialization)
+    position_query = build_position_query_v4(contig_batch_idx);
+  add_start_pos_ranges_v4(
+      contig_batch_idx,
+      query.get(),
+      position_query.get(),
+      position_buffers_.get(),
+      estimated_num_records);
+  return query;
+}
+
+std::unique_ptr<Query> Reader::init_query_v4(size_t contig_batch_idx) {
   // Set up the TileDB query
-  read_state_.query.reset(new Query(*ctx_, *read_state_.array));
-  set_tiledb_query_config();
+  std::unique_ptr<Query> query(new Query(*ctx_, *read_state_.array));
+  set_tiledb_query_config(query.get());
+  const auto& query_regions = read_state_.query_regions_v4[contig_batch_idx];
 
   // Set ranges
   std::stringstream debug_ranges;
@@ -770,24 +1065,116 @@ bool Reader::next_read_batch_v4() {
     debug_ranges << std::endl << "samples:" << std::endl;
   }
 
+  add_sample_ranges_v4(query.get(), &debug_ranges);
+
+  query->add_range(0, query_regions.first, query_regions.first);
+  if (params_.debug_params.print_tiledb_query_ranges && LOG_DEBUG_ENABLED()) {
+    debug_ranges << std::endl << "contigs:" << std::endl;
+    debug_ranges << "[" << query_regions.first << ", " << query_regions.first
+                 << "]" << std::endl;
+  }
+
+  // Default export results are not sorted
+  query->set_layout(TILEDB_UNORDERED);
+  // If sorting export results, ask TileDB for results sorted on the anchors
+  if (params_.sort_real_start_pos) {
+    query->set_layout(TILEDB_ROW_MAJOR);
+  }
+
+  // Push the natively typed predicates down to TileDB
+  if (record_filter_ != nullptr)
+    record_filter_->set_query_condition(*ctx_, query.get());
+
+  if (params_.debug_params.print_tiledb_query_ranges) {
+    LOG_DEBUG("query_ranges:\n{}", debug_ranges.str());
+  }
+
+  LOG_INFO(
+      "Initialized TileDB query with {} for contig {} (contig batch {}/{}, "
+      "sample batch {}/{}).",
+      (read_state_.all_samples ?
+           "all samples" :
+           std::to_string(read_state_.current_sample_batches.size())),
+      query_regions.first,
+      contig_batch_idx + 1,
+      read_state_.query_regions_v4.size(),
+      read_state_.batch_idx + 1,
+      read_state_.sample_batches.size());
+
+  return query;
+}
+
+void Reader::add_start_pos_ranges_v4(
+    size_t contig_batch_idx,
+    Query* query,
+    Query* position_query,
+    AttributeBufferSet* position_buffers,
+    uint64_t* estimated_num_records) {
+  const auto& query_regions = read_state_.query_regions_v4[contig_batch_idx];
+
+  // With late materialization, only query the start positions of the cells
+  // that intersect a region
+  std::vector<QueryRegion> materialized_regions;
+  if (position_query != nullptr)
+    materialized_regions = materialized_query_regions_v4(
+        contig_batch_idx, position_query, position_buffers);
+  const auto& start_pos_ranges = position_query != nullptr ?
+                                     materialized_regions :
+                                     query_regions.second;
+
+  std::stringstream debug_ranges;
+  for (const auto& query_region : start_pos_ranges) {
+    query->add_range(1, query_region.col_min, query_region.col_max);
+    if (params_.debug_params.print_tiledb_query_ranges && LOG_DEBUG_ENABLED()) {
+      debug_ranges << "[" << query_region.col_min << ", "
+                   << query_region.col_max << "]" << std::endl;
+    }
+  }
+
+  if (params_.debug_params.print_tiledb_query_ranges) {
+    LOG_DEBUG("start_pos ranges:\n{}", debug_ranges.str());
+  }
+  LOG_INFO(
+      "Set {} start_pos ranges for contig {}.",
+      start_pos_ranges.size(),
+      query_regions.first);
+
+  // Get estimated records for verbose output
+  if (estimated_num_records == nullptr)
+    return;
+  *estimated_num_records = 1;
+  if (params_.enable_progress_estimation) {
+    *estimated_num_records =
+        query->est_result_size(
+            TileDBVCFDataset::DimensionNames::V4::start_pos) /
+        tiledb_datatype_size(
+            dataset_->data_array()
+                ->schema()
+                .domain()
+                .dimension(TileDBVCFDataset::DimensionNames::V4::start_pos)
+                .type());
+  }
+}
+
+void Reader::add_sample_ranges_v4(
+    Query* query, std::stringstream* debug_ranges) {
   // For samples we special case when we are looking at all samples. If so we
   // just need to set one range with the start/end sample id
   if (read_state_.all_samples) {
     if (params_.sample_partitioning.num_partitions == 1) {
       auto non_empty_domain = dataset_->data_array()->non_empty_domain_var(
           TileDBVCFDataset::DimensionNames::V4::sample);
-      read_state_.query->add_range(
-          2, non_empty_domain.first, non_empty_domain.second);
+      query->add_range(2, non_empty_domain.first, non_empty_domain.second);
       if (params_.debug_params.print_tiledb_query_ranges &&
           LOG_DEBUG_ENABLED()) {
-        debug_ranges << "[" << non_empty_domain.first << ", "
-                     << non_empty_domain.second << "]" << std::endl;
+        *debug_ranges << "[" << non_empty_domain.first << ", "
+                      << non_empty_domain.second << "]" << std::endl;
       }
     } else {
       // if we have all samples but are partitioning we need to only use the
       // first/last sample of the partition partitions are sorted both globally
       // and in the vector so this is a shortcut to have less ranges
-      read_state_.query->add_range(
+      query->add_range(
           2,
           read_state_.current_sample_batches[0].sample_name,
           read_state_
@@ -796,100 +1183,188 @@ bool Reader::next_read_batch_v4() {
               .sample_name);
       if (params_.debug_params.print_tiledb_query_ranges &&
           LOG_DEBUG_ENABLED()) {
-        debug_ranges << "[" << read_state_.current_sample_batches[0].sample_name
-                     << ", "
-                     << read_state_
-                            .current_sample_batches
-                                [read_state_.current_sample_batches.size() - 1]
-                            .sample_name
-                     << "]" << std::endl;
+        *debug_ranges
+            << "[" << read_state_.current_sample_batches[0].sample_name << ", "
+            << read_state_
+                   .current_sample_batches
+                       [read_state_.current_sample_batches.size() - 1]
+                   .sample_name
+            << "]" << std::endl;
       }
     }
   } else {
     // If we are not exporting all samples add the current partition/batch's
     // list
     for (const auto& sample : read_state_.current_sample_batches) {
-      read_state_.query->add_range(2, sample.sample_name, sample.sample_name);
+      query->add_range(2, sample.sample_name, sample.sample_name);
       if (params_.debug_params.print_tiledb_query_ranges &&
           LOG_DEBUG_ENABLED()) {
-        debug_ranges << "[" << sample.sample_name << ", " << sample.sample_name
-                     << "]" << std::endl;
+        *debug_ranges << "[" << sample.sample_name << ", "
+                      << sample.sample_name << "]" << std::endl;
       }
     }
   }
+}
 
-  if (params_.debug_params.print_tiledb_query_ranges && LOG_DEBUG_ENABLED()) {
-    debug_ranges << std::endl << "regions:" << std::endl;
-  }
-  for (const auto& query_region :
-       read_state_.query_regions_v4[read_state_.query_contig_batch_idx]
-           .second) {
-    read_state_.query->add_range(1, query_region.col_min, query_region.col_max);
-    if (params_.debug_params.print_tiledb_query_ranges && LOG_DEBUG_ENABLED()) {
-      debug_ranges << "[" << query_region.col_min << ", "
-                   << query_region.col_max << "]" << std::endl;
-    }
-  }
+std::unique_ptr<Query> Reader::build_position_query_v4(
+    size_t contig_batch_idx) {
+  const auto& query_regions = read_state_.query_regions_v4[contig_batch_idx];
+  const std::string& contig = query_regions.first;
 
-  read_state_.query->add_range(
-      0,
-      read_state_.query_regions_v4[read_state_.query_contig_batch_idx].first,
-      read_state_.query_regions_v4[read_state_.query_contig_batch_idx].first);
-  if (params_.debug_params.print_tiledb_query_ranges && LOG_DEBUG_ENABLED()) {
-    debug_ranges << std::endl << "contigs:" << std::endl;
-    debug_ranges << "["
-                 << read_state_
-                        .query_regions_v4[read_state_.query_contig_batch_idx]
-                        .first
-                 << ", "
-                 << read_state_
-                        .query_regions_v4[read_state_.query_contig_batch_idx]
-                        .first
-                 << "]" << std::endl;
+  // Phase one: query the position columns over the full start_pos ranges
+  std::unique_ptr<Query> query(new Query(*ctx_, *read_state_.array));
+  set_tiledb_query_config(query.get());
+  std::stringstream debug_ranges;
+  add_sample_ranges_v4(query.get(), &debug_ranges);
+  for (const auto& query_region : query_regions.second)
+    query->add_range(1, query_region.col_min, query_region.col_max);
+  query->add_range(0, contig, contig);
+  query->set_layout(TILEDB_UNORDERED);
+  return query;
+}
+
+std::vector<Reader::QueryRegion> Reader::materialized_query_regions_v4(
+    size_t contig_batch_idx,
+    Query* position_query,
+    AttributeBufferSet* position_buffers) {
+  const auto& query_regions = read_state_.query_regions_v4[contig_batch_idx];
+  const std::string& contig = query_regions.first;
+  Query& query = *position_query;
+  position_buffers->set_buffers(&query, dataset_->metadata().version);
+
+  // Each contig has its own intersector and cell filter, so phase one of a
+  // prefetched contig batch can run alongside the current one.
+  auto& intersector = read_state_.region_intersectors.at(contig);
+  auto& cell_filter = read_state_.cell_filters.at(contig);
+  const uint32_t* start_pos = position_buffers->start_pos().data<uint32_t>();
+  const uint32_t* real_start_pos =
+      position_buffers->real_start_pos().data<uint32_t>();
+  const uint32_t* end_pos = position_buffers->end_pos().data<uint32_t>();
+
+  std::vector<uint32_t> starts;
+  uint64_t num_cells = 0;
+  tiledb::Query::Status status;
+  do {
+    TRY_CATCH_THROW(status = query.submit());
+    const uint64_t n =
+        query
+            .result_buffer_elements()
+                [TileDBVCFDataset::DimensionNames::V4::start_pos]
+            .second;
+    if (status == tiledb::Query::Status::INCOMPLETE && n == 0)
+      throw std::runtime_error(
+          "Error in late materialization query; position buffers are too "
+          "small to hold a single result.");
+
+    cell_filter.select(
+        start_pos, real_start_pos, end_pos, nullptr, 0, n, &intersector);
+    for (const auto& selected : cell_filter.selected())
+      starts.push_back(start_pos[selected.pos]);
+    num_cells += n;
+  } while (status == tiledb::Query::Status::INCOMPLETE);
+
+  std::sort(starts.begin(), starts.end());
+  starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+  // Coalesce consecutive start positions into ranges
+  std::vector<QueryRegion> result;
+  for (auto start : starts) {
+    if (!result.empty() && result.back().col_max + 1 == start)
+      result.back().col_max = start;
+    else
+      result.push_back({start, start, contig});
+  }
+
+  // There must be at least one range, otherwise TileDB reads the full domain.
+  // Results at this position are discarded when processed.
+  if (result.empty()) {
+    const uint32_t col_min = query_regions.second.front().col_min;
+    result.push_back({col_min, col_min, contig});
   }
 
-  // Default export results are not sorted
-  read_state_.query->set_layout(TILEDB_UNORDERED);
-  // If sorting export results, ask TileDB for results sorted on the anchors
-  if (params_.sort_real_start_pos) {
-    read_state_.query->set_layout(TILEDB_ROW_MAJOR);
-  }
+  LOG_DEBUG(
+      "Late materialization selected {} of {} cells in {} start_pos ranges "
+      "for contig {}.",
+      starts.size(),
+      num_cells,
+      result.size(),
+      contig);
 
-  if (params_.debug_params.print_tiledb_query_ranges) {
-    LOG_DEBUG("query_ranges:\n{}", debug_ranges.str());
-  }
+  return result;
+}
 
-  LOG_INFO(
-      "Initialized TileDB query with {} start_pos ranges, {} for contig {} "
-      "(contig batch {}/{}, sample batch {}/{}).",
-      read_state_.query_regions_v4[read_state_.query_contig_batch_idx]
-          .second.size(),
-      (read_state_.all_samples ?
-           "all samples" :
-           std::to_string(read_state_.current_sample_batches.size())),
-      read_state_.query_regions_v4[read_state_.query_contig_batch_idx].first,
-      read_state_.query_contig_batch_idx + 1,
-      read_state_.query_regions_v4.size(),
-      read_state_.batch_idx + 1,
-      read_state_.sample_batches.size());
+void Reader::prefetch_contig_batches_v4() {
+  // Keep up to (concurrency - 1) contig batches following the current one
+  // running. Results are only ever processed for the current contig batch, so
+  // the export order is unchanged.
+  const size_t num_contig_batches = read_state_.query_regions_v4.size();
+  size_t next_idx = read_state_.query_contig_batch_idx + 1 +
+                    read_state_.pending_contig_batches.size();
+  while (read_state_.pending_contig_batches.size() + 1 <
+             params_.contig_batch_concurrency &&
+         next_idx < num_contig_batches && !contig_batch_buffers_.empty()) {
+    PendingContigBatch pending;
+    pending.contig_batch_idx = next_idx++;
+    if (params_.late_materialization) {
+      // The start_pos ranges are set once phase one has run with the query.
+      // The number of records is not estimated.
+      pending.query = init_query_v4(pending.contig_batch_idx);
+      pending.estimated_num_records = 0;
+    } else {
+      pending.query = build_query_v4(
+          pending.contig_batch_idx, &pending.estimated_num_records);
+    }
+    pending.buffers = std::move(contig_batch_buffers_.back());
+    contig_batch_buffers_.pop_back();
 
-  // Get estimated records for verbose output
-  read_state_.total_query_records_processed = 0;
-  read_state_.query_estimated_num_records = 1;
+    tiledb::Query* query = pending.query.get();
+    pending.buffers->set_buffers(query, dataset_->metadata().version);
+    LOG_DEBUG(
+        "reader.cc:{}: query started for contig batch {}.",
+        __LINE__,
+        pending.contig_batch_idx + 1);
+    if (params_.late_materialization) {
+      // Run phase one in the task submitting the query, with its own
+      // position buffers, so that it overlaps the export of the current batch.
+      std::unique_ptr<Query> position_query =
+          build_position_query_v4(pending.contig_batch_idx);
+      std::unique_ptr<AttributeBufferSet> position_buffers(
+          new AttributeBufferSet(LOG_DEBUG_ENABLED()));
+      allocate_position_buffers(position_buffers.get());
+      const size_t contig_batch_idx = pending.contig_batch_idx;
+      TRY_CATCH_THROW(
+          pending.query_future = std::async(
+              std::launch::async,
+              [this,
+               query,
+               contig_batch_idx,
+               position_query = std::move(position_query),
+               position_buffers = std::move(position_buffers)]() {
+                add_start_pos_ranges_v4(
+                    contig_batch_idx,
+                    query,
+                    position_query.get(),
+                    position_buffers.get(),
+                    nullptr);
+                return query->submit();
+              }));
+    } else {
+      TRY_CATCH_THROW(
+          pending.query_future = std::async(
+              std::launch::async, [query]() { return query->submit(); }));
+    }
 
-  if (params_.enable_progress_estimation) {
-    read_state_.query_estimated_num_records =
-        read_state_.query->est_result_size(
-            TileDBVCFDataset::DimensionNames::V4::start_pos) /
-        tiledb_datatype_size(
-            dataset_->data_array()
-                ->schema()
-                .domain()
-                .dimension(TileDBVCFDataset::DimensionNames::V4::start_pos)
-                .type());
+    read_state_.pending_contig_batches.push_back(std::move(pending));
   }
+}
 
-  return true;
+void Reader::allocate_position_buffers(AttributeBufferSet* buffers) const {
+  buffers->allocate_fixed(
+      {TileDBVCFDataset::DimensionNames::V4::start_pos,
+       TileDBVCFDataset::AttrNames::V4::real_start_pos,
+       TileDBVCFDataset::AttrNames::V4::end_pos},
+      position_buffers_budget_,
+      dataset_.get());
 }
 
 void Reader::init_exporter() {
@@ -897,6 +1372,8 @@ void Reader::init_exporter() {
     if (params_.export_combined_vcf) {
       params_.sort_real_start_pos = true;
       exporter_.reset(new PVCFExporter(params_.output_path, params_.format));
+      exporter_->set_field_selection(
+          params_.include_fields, params_.exclude_fields);
     } else {
       switch (params_.format) {
         case ExportFormat::CompressedBCF:
@@ -904,6 +1381,8 @@ void Reader::init_exporter() {
         case ExportFormat::VCFGZ:
         case ExportFormat::VCF:
           exporter_.reset(new BCFExporter(params_.format));
+          exporter_->set_field_selection(
+              params_.include_fields, params_.exclude_fields);
           break;
         case ExportFormat::TSV:
           exporter_.reset(
@@ -924,12 +1403,63 @@ void Reader::init_exporter() {
   if (exporter_ != nullptr)
     exporter_->set_dataset(dataset_.get());
 
+  // Count, variant stats and genotype matrix queries bypass the exporter.
+  record_counter_.reset();
+  variant_stats_.reset();
+  genotype_matrix_.reset();
+  if ((params_.count_group_by != CountGroupBy::COUNT_NONE) +
+          params_.variant_stats + params_.genotype_matrix >
+      1)
+    throw std::runtime_error(
+        "Error initializing reads; at most one of count grouping, variant "
+        "stats and genotype matrix can be set for a read.");
+  if (params_.count_group_by != CountGroupBy::COUNT_NONE) {
+    record_counter_.reset(new RecordCounter(params_.count_group_by));
+    read_state_.need_headers = false;
+    return;
+  }
+  if (params_.variant_stats) {
+    variant_stats_.reset(new VariantStats());
+    read_state_.need_headers = false;
+    return;
+  }
+  if (params_.genotype_matrix) {
+    init_genotype_matrix();
+    read_state_.need_headers = false;
+    return;
+  }
+
   // Set need_headers based on if the exporter needs a header and its not been
   // requested by an info/fmt field
   if (!read_state_.need_headers && exporter_ != nullptr)
     read_state_.need_headers = exporter_->need_headers();
 }
 
+void Reader::init_genotype_matrix() {
+  // The columns are the samples of the single v4 sample batch, or all
+  // samples in name order.
+  std::vector<std::string> samples;
+  if (read_state_.sample_batches.empty()) {
+    samples = dataset_->get_all_samples_from_vcf_headers();
+    std::sort(samples.begin(), samples.end());
+  } else {
+    for (const auto& batch : read_state_.sample_batches) {
+      for (const auto& sample : batch)
+        samples.push_back(sample.sample_name);
+    }
+  }
+  genotype_matrix_.reset(new GenotypeMatrix(samples));
+  if (!params_.genotype_matrix_path.empty())
+    genotype_matrix_->set_file(params_.genotype_matrix_path);
+  else
+    genotype_matrix_->set_buffer(
+        genotype_matrix_buffer_, genotype_matrix_buffer_size_);
+
+  // Sorting the records on their position adds the records of a variant in
+  // a row, so that most rows are found without a map lookup.
+  params_.sort_real_start_pos = true;
+}
+
 bool Reader::read_current_batch() {
   tiledb::Query* query = read_state_.query.get();
 
@@ -959,23 +1489,30 @@ bool Reader::read_current_batch() {
     // itself to capture the case of a new underlying tiledb query for the
     // next range/sample partitioning since we partition samples on
     // tile_extent
+    // A query that was started ahead of time (e.g. a prefetched contig batch)
+    // still has results to be picked up.
     if (read_state_.query_results.query_status() !=
             tiledb::Query::Status::INCOMPLETE &&
+        !read_state_.query_future.valid() &&
         read_state_.query->query_status() !=
             tiledb::Query::Status::UNINITIALIZED) {
       return true;
     }
   }
 
-  buffers_a->set_buffers(query, dataset_->metadata().version);
+  // Submit the query unless the next chunk of results is already being
+  // fetched from a previous (double-buffered) submission.
+  if (!read_state_.query_future.valid())
+    submit_query_async();
 
   do {
-    // Run query and get status
+    // Wait for the in-flight submission and get its status
     auto query_start_timer = std::chrono::steady_clock::now();
-    LOG_DEBUG("reader.cc:{}: query started.", __LINE__);
-    auto query_status = query->submit();
+    LOG_DEBUG("reader.cc:{}: waiting for query results.", __LINE__);
+    tiledb::Query::Status query_status;
+    TRY_CATCH_THROW(query_status = read_state_.query_future.get());
     LOG_INFO(
-        "reader.cc:{}: query completed in {} sec.",
+        "reader.cc:{}: query completed after waiting {} sec.",
         __LINE__,
         utils::chrono_duration(query_start_timer));
 
@@ -994,6 +1531,15 @@ bool Reader::read_current_batch() {
 
     read_state_.cell_idx = 0;
 
+    // If there are more results, swap buffer sets and start fetching the next
+    // chunk while the current results are processed. The query results keep
+    // pointing at the buffer set they were read into.
+    if (query_status == tiledb::Query::Status::INCOMPLETE &&
+        read_state_.total_num_records_exported < params_.max_num_records) {
+      std::swap(buffers_a, buffers_b);
+      submit_query_async();
+    }
+
     // TODO: This condition is normal in TileDB 2.5-2.6, revisit in 2.7+
     /*
     if (read_state_.query_results.num_cells() == 0 &&
@@ -1039,19 +1585,17 @@ bool Reader::read_current_batch() {
           read_state_.last_num_records_exported - old_num_exported);
     }
 
-    // Return early if we couldn't process all the results.
+    // Return early if we couldn't process all the results. Any prefetch stays
+    // in flight and is picked up when the read is resumed.
     if (!complete)
       return false;
-
-    if (query_status ==
-        tiledb::Query::Status::INCOMPLETE) {  // resubmit existing buffers_a if
-                                              // not double buffering
-      buffers_a->set_buffers(query, dataset_->metadata().version);
-    }
-  } while (read_state_.query_results.query_status() ==
-               tiledb::Query::Status::INCOMPLETE &&
+  } while (read_state_.query_future.valid() &&
            read_state_.total_num_records_exported < params_.max_num_records);
 
+  // If the record limit was hit, the prefetched results are not needed.
+  if (read_state_.query_future.valid())
+    TRY_CATCH_THROW(read_state_.query_future.get());
+
   // Batch complete; finalize the export (if applicable).
   if (exporter_ != nullptr && read_state_.need_headers) {
     if (dataset_->metadata().version == TileDBVCFDataset::Version::V3 ||
@@ -1080,6 +1624,32 @@ bool Reader::read_current_batch() {
   return true;
 }
 
+void Reader::submit_query_async() {
+  tiledb::Query* query = read_state_.query.get();
+  buffers_a->set_buffers(query, dataset_->metadata().version);
+  LOG_DEBUG("reader.cc:{}: query started.", __LINE__);
+  TRY_CATCH_THROW(
+      read_state_.query_future = std::async(
+          std::launch::async, [query]() { return query->submit(); }));
+}
+
+void Reader::wait_for_query() {
+  auto wait = [](std::future<tiledb::Query::Status>& query_future) {
+    if (query_future.valid()) {
+      try {
+        query_future.get();
+      } catch (const std::exception& e) {
+        // The results are being discarded, so a failure is only worth noting.
+        LOG_DEBUG("Discarded in-flight query failed: {}", e.what());
+      }
+    }
+  };
+
+  wait(read_state_.query_future);
+  for (auto& pending : read_state_.pending_contig_batches)
+    wait(pending.query_future);
+}
+
 /**
  * Comparator used to binary search across regions to find the first index to
  * start checking for intersections
@@ -1099,58 +1669,6 @@ struct RegionComparator {
   }
 } RegionComparator;
 
-bool Reader::first_intersecting_region(
-    const std::string& contig, uint32_t real_start, size_t& first_region) {
-  const auto& regions =
-      read_state_.regions_index_per_contig.find(contig)->second;
-
-  if (read_state_.super_regions.count(contig) == 0) {
-    // No overlapping regions exist for this contig.
-    // Perform binary search to find the first intersecting region, where
-    // real_start <= region.max
-    auto it = std::lower_bound(
-        regions.begin(),
-        regions.end(),
-        real_start,
-        [&](const unsigned index, const unsigned value) {
-          return read_state_.regions[index].max < value;
-        });
-
-    // no intersecting regions found
-    if (it == regions.end()) {
-      return false;
-    }
-
-    first_region = *it;
-  } else {
-    // Super regions exist for this contig.
-    // Perform binary search to find the first intersecting super region, where
-    // real_start <= super_region.end_max
-    std::vector<SuperRegion> super_regions = read_state_.super_regions[contig];
-    auto it = std::lower_bound(
-        super_regions.begin(),
-        super_regions.end(),
-        real_start,
-        [&](const SuperRegion& sr, const unsigned value) {
-          return sr.end_max < value;
-        });
-
-    // no intersecting super regions found
-    if (it == super_regions.end()) {
-      return false;
-    }
-
-    first_region = it->region_min;
-  }
-
-  // Translate first_region to an index into the contig's
-  // regions_index_per_contig vector
-  first_region -= regions[0];
-  assert(first_region < regions.size());
-
-  return true;
-}
-
 bool Reader::process_query_results_v4() {
   if (read_state_.regions.empty())
     throw std::runtime_error(
@@ -1195,87 +1713,189 @@ bool Reader::process_query_results_v4() {
         "list for contig " +
         query_contig);
 
-  // Report all intersections. If the previous read returned before
-  // reporting all intersecting regions, 'last_intersecting_region_idx_'
-  // will be non-zero. All regions with an index less-than
-  // 'last_intersecting_region_idx_' have already been reported, so we
-  // must avoid reporting them multiple times.
   const auto& regions = regions_indexes->second;
+  auto& intersector = read_state_.region_intersectors.at(query_contig);
+  auto& cell_filter = read_state_.cell_filters.at(query_contig);
+
+  // Select the cells intersecting any region in a single pass over the
+  // position columns, so the loop below only visits cells to be reported.
+  cell_filter.select(
+      results.buffers()->start_pos().data<uint32_t>(),
+      results.buffers()->real_start_pos().data<uint32_t>(),
+      results.buffers()->end_pos().data<uint32_t>(),
+      params_.sort_real_start_pos ? sorted_indexes.data() : nullptr,
+      read_state_.cell_idx,
+      num_cells,
+      &intersector);
+
+  // Drop the cells rejected by the record filter before reporting any of
+  // them, so that they never reach the exporter.
+  if (record_filter_ != nullptr && !record_filter_->all_pushed_down()) {
+    cell_filter.retain([&](const CellFilter::SelectedCell& cell) {
+      const uint64_t i =
+          params_.sort_real_start_pos ? sorted_indexes[cell.pos] : cell.pos;
+      return record_filter_->evaluate(results, i, cell_header_v4(i));
+    });
+  }
+
+  // Variant stats and genotype matrices add each record once, whatever the
+  // number of regions it intersects, up to the record limit.
+  if (variant_stats_ != nullptr || genotype_matrix_ != nullptr) {
+    for (const auto& selected : cell_filter.selected()) {
+      if (read_state_.total_num_records_exported >= params_.max_num_records) {
+        read_state_.cell_idx = selected.pos;
+        return true;
+      }
+      const uint64_t i = params_.sort_real_start_pos ?
+                             sorted_indexes[selected.pos] :
+                             selected.pos;
+      add_genotype_cell(query_contig, regions, selected, i, &intersector);
+    }
+    read_state_.cell_idx = num_cells;
+    return true;
+  }
 
-  for (; read_state_.cell_idx < num_cells; read_state_.cell_idx++) {
+  // Collect the (cell, region) pairs to report and report them in batches,
+  // so that exporters can copy whole columns at once.
+  report_rows_.clear();
+  bool overflow = false;
+  for (const auto& selected : cell_filter.selected()) {
     // For easy reference
     const uint64_t i = params_.sort_real_start_pos ?
-                           sorted_indexes[read_state_.cell_idx] :
-                           read_state_.cell_idx;
+                           sorted_indexes[selected.pos] :
+                           selected.pos;
 
-    // Get the start, real_start and end. We don't need the contig because we
-    // know the query is limited to a single contig
-    const uint32_t start = results.buffers()->start_pos().value<uint32_t>(i);
-    const uint32_t real_start =
-        results.buffers()->real_start_pos().value<uint32_t>(i);
-
-    const uint32_t end = results.buffers()->end_pos().value<uint32_t>(i);
-
-    // Search for the first intersecting region
-    bool found = first_intersecting_region(
-        query_contig, real_start, read_state_.last_intersecting_region_idx_);
+    if (!selected.scan_regions) {
+      // The cell intersects only its first region
+      report_rows_.push_back({selected.pos, i, selected.first_region});
+    } else {
+      // Get the start, real_start and end. We don't need the contig because
+      // we know the query is limited to a single contig
+      const uint32_t start = results.buffers()->start_pos().value<uint32_t>(i);
+      const uint32_t real_start =
+          results.buffers()->real_start_pos().value<uint32_t>(i);
+
+      const uint32_t end = results.buffers()->end_pos().value<uint32_t>(i);
+
+      // Report all intersections. If the previous read returned before
+      // reporting all intersecting regions, 'last_intersecting_region_idx_'
+      // will be non-zero. All regions with an index less-than
+      // 'last_intersecting_region_idx_' have already been reported, so we
+      // must avoid reporting them multiple times.
+      size_t j = read_state_.last_intersecting_region_idx_ > 0 ?
+                     read_state_.last_intersecting_region_idx_ :
+                     selected.first_region;
+      for (; j < regions.size(); j++) {
+        const auto& reg = read_state_.regions[regions[j]];
+
+        const uint32_t reg_min = reg.min;
+        const uint32_t reg_max = reg.max;
+
+        // If the vcf record is not contained in the region skip it
+        if (real_start > reg_max)
+          continue;
+
+        // Exit early, in this case all regions are now passed this record
+        if (end < reg_min)
+          break;
 
-    // Continue to the next record if no intersecting regions are found
-    if (!found) {
-      continue;
+        // Unless start is the real start (aka first record) then if we skip
+        // for any record greater than the region min the goal is to only
+        // capture starts which are within 1 anchor gap of the region start on
+        // the lower side of the region start
+        if (start != real_start && start >= reg_min)
+          continue;
+
+        // First lets make sure the anchor gap is smaller than the region
+        // minimum, this avoid overflow in the next check.. second if the
+        // start is further away from the region_start than the anchor gap
+        // discard
+        if (anchor_gap < reg_min && start < reg_min - anchor_gap)
+          continue;
+
+        report_rows_.push_back({selected.pos, i, j});
+      }
     }
 
-    for (size_t j = read_state_.last_intersecting_region_idx_;
-         j < regions.size();
-         j++) {
-      const auto& reg = read_state_.regions[regions[j]];
+    // Only the first cell resumes from 'last_intersecting_region_idx_'.
+    read_state_.last_intersecting_region_idx_ = 0;
 
-      const uint32_t reg_min = reg.min;
-      const uint32_t reg_max = reg.max;
+    if (report_rows_.size() >= REPORT_BATCH_SIZE &&
+        !report_rows_v4(regions, &overflow))
+      return !overflow;
+  }
 
-      // If the vcf record is not contained in the region skip it
-      if (real_start > reg_max)
-        continue;
+  if (!report_rows_v4(regions, &overflow))
+    return !overflow;
 
-      // Exit early, in this case all regions are now passed this record
-      if (end < reg_min)
-        break;
+  read_state_.region_idx = 0;
+  read_state_.cell_idx = num_cells;
 
-      // Unless start is the real start (aka first record) then if we skip for
-      // any record greater than the region min the goal is to only capture
-      // starts which are within 1 anchor gap of the region start on the lower
-      // side of the region start
-      if (start != real_start && start >= reg_min)
-        continue;
+  return true;
+}
 
-      // First lets make sure the anchor gap is smaller than the region
-      // minimum, this avoid overflow in the next check.. second if the start
-      // is further away from the region_start than the anchor gap discard
-      if (anchor_gap < reg_min && start < reg_min - anchor_gap)
-        continue;
+bool Reader::report_rows_v4(
+    const std::vector<size_t>& regions, bool* overflow) {
+  *overflow = false;
+  const auto& results = read_state_.query_results;
 
-      // If we overflow when reporting this cell, save the index of the
-      // current region so that we restart from the same position on the
-      // next read. Otherwise, we will re-report the cells in regions with
-      // an index below 'j'.
-      if (!report_cell(reg, reg.seq_offset, i)) {
-        read_state_.last_intersecting_region_idx_ = j;
-        return false;
-      }
+  // Stop at the record limit, unless records are only counted.
+  uint64_t num_rows = report_rows_.size();
+  bool limit_reached = false;
+  if (record_counter_ == nullptr) {
+    const uint64_t remaining =
+        params_.max_num_records - read_state_.total_num_records_exported;
+    if (num_rows >= remaining) {
+      num_rows = remaining;
+      limit_reached = true;
+    }
+  }
 
-      // Return early if we've hit the record limit.
-      if (read_state_.total_num_records_exported >= params_.max_num_records) {
-        return true;
-      }
+  uint64_t num_reported = num_rows;
+  if (exporter_ != nullptr && record_counter_ == nullptr) {
+    export_rows_.resize(num_rows);
+    for (uint64_t r = 0; r < num_rows; r++) {
+      const ReportRow& row = report_rows_[r];
+      const auto& reg = read_state_.regions[regions[row.region_idx]];
+      uint64_t size = 0;
+      const char* sample_name =
+          results.buffers()->sample_name().value<char>(row.cell_idx, &size);
+      export_rows_[r] = {
+          std::string_view(sample_name, size),
+          cell_header_v4(row.cell_idx),
+          &reg,
+          reg.seq_offset,
+          row.cell_idx};
     }
 
-    // Clear 'last_intersecting_region_idx_' after successfully reporting
-    // all cells in intersecting regions.
-    read_state_.last_intersecting_region_idx_ = 0;
+    num_reported = exporter_->export_records(results, export_rows_);
+    read_state_.last_num_records_exported += num_reported;
+    read_state_.total_num_records_exported += num_reported;
+  } else {
+    for (uint64_t r = 0; r < num_rows; r++) {
+      const ReportRow& row = report_rows_[r];
+      const auto& reg = read_state_.regions[regions[row.region_idx]];
+      report_cell(reg, reg.seq_offset, row.cell_idx);
+    }
+  }
 
-    read_state_.region_idx = 0;
+  // If we overflow when reporting a row, save its cell and region so that we
+  // restart from the same position on the next read.
+  if (num_reported < num_rows) {
+    const ReportRow& row = report_rows_[num_reported];
+    read_state_.cell_idx = row.pos;
+    read_state_.last_intersecting_region_idx_ = row.region_idx;
+    *overflow = true;
+    return false;
   }
 
+  if (limit_reached) {
+    if (num_rows > 0)
+      read_state_.cell_idx = report_rows_[num_rows - 1].pos;
+    return false;
+  }
+
+  report_rows_.clear();
   return true;
 }
 
@@ -1499,8 +2119,34 @@ bool Reader::process_query_results_v2() {
   return true;
 }
 
+const bcf_hdr_t* Reader::cell_header_v4(uint64_t cell_idx) {
+  if (!read_state_.need_headers)
+    return nullptr;
+
+  uint64_t size = 0;
+  const char* sample_name =
+      read_state_.query_results.buffers()->sample_name().value<char>(
+          cell_idx, &size);
+  const std::string name(sample_name, size);
+  auto lookup_iter = read_state_.current_hdrs_lookup.find(name);
+  if (lookup_iter == read_state_.current_hdrs_lookup.end())
+    throw std::runtime_error(
+        "Could not find VCF header for " + name + " in cell_header_v4");
+
+  auto hdr_iter = read_state_.current_hdrs.find(lookup_iter->second);
+  if (hdr_iter == read_state_.current_hdrs.end())
+    throw std::runtime_error(
+        "Could not find VCF header for " + name + " in cell_header_v4");
+  return hdr_iter->second.get();
+}
+
 bool Reader::report_cell(
     const Region& region, uint32_t contig_offset, uint64_t cell_idx) {
+  if (record_counter_ != nullptr) {
+    count_cell(region, cell_idx);
+    return true;
+  }
+
   if (exporter_ == nullptr) {
     read_state_.last_num_records_exported++;
     read_state_.total_num_records_exported++;
@@ -1550,6 +2196,109 @@ bool Reader::report_cell(
   return true;
 }
 
+void Reader::count_cell(const Region& region, uint64_t cell_idx) {
+  std::string_view sample_name;
+  if (record_counter_->group_by() == CountGroupBy::COUNT_BY_SAMPLE) {
+    const auto& results = read_state_.query_results;
+    if (dataset_->metadata().version == TileDBVCFDataset::Version::V4) {
+      uint64_t size = 0;
+      const char* name =
+          results.buffers()->sample_name().value<char>(cell_idx, &size);
+      sample_name = std::string_view(name, size);
+    } else {
+      uint32_t samp_idx =
+          results.buffers()->sample().value<uint32_t>(cell_idx);
+      auto it = read_state_.current_samples.find(samp_idx);
+      if (it == read_state_.current_samples.end())
+        return;
+      sample_name = it->second.sample_name;
+    }
+  }
+
+  record_counter_->add(region, sample_name);
+  read_state_.last_num_records_exported++;
+  read_state_.total_num_records_exported++;
+}
+
+void Reader::add_genotype_cell(
+    const std::string& contig,
+    const std::vector<size_t>& regions,
+    const CellFilter::SelectedCell& selected,
+    uint64_t cell_idx,
+    RegionIntersector* intersector) {
+  const auto& results = read_state_.query_results;
+  const uint32_t anchor_gap = dataset_->metadata().anchor_gap;
+  const uint32_t start =
+      results.buffers()->start_pos().value<uint32_t>(cell_idx);
+  const uint32_t real_start =
+      results.buffers()->real_start_pos().value<uint32_t>(cell_idx);
+  const uint32_t end = results.buffers()->end_pos().value<uint32_t>(cell_idx);
+
+  // Find the first region the cell is reported for, with the same checks as
+  // the region loop of process_query_results_v4().
+  size_t j = selected.first_region;
+  for (; selected.scan_regions && j < regions.size(); j++) {
+    const auto& reg = read_state_.regions[regions[j]];
+    if (end < reg.min)
+      return;
+    if (real_start <= reg.max && (start == real_start || start < reg.min) &&
+        (anchor_gap >= reg.min || start >= reg.min - anchor_gap))
+      break;
+  }
+  if (j == regions.size())
+    return;
+
+  // Each region intersecting a record is reported through exactly one of its
+  // cells, so an anchor cell is only added if no earlier region intersects
+  // the record.
+  if (start != real_start) {
+    for (size_t k = intersector->first_intersecting(real_start); k < j; k++) {
+      const auto& reg = read_state_.regions[regions[k]];
+      if (reg.min <= end && reg.max >= real_start)
+        return;
+    }
+  }
+
+  // The alleles are stored as a null-terminated CSV list.
+  uint64_t nbytes = 0;
+  const char* alleles = results.var_attr_value(
+      results.buffers()->alleles(), results.alleles_size(), cell_idx, &nbytes);
+  std::string_view alleles_str(alleles, nbytes);
+  if (!alleles_str.empty() && alleles_str.back() == '\0')
+    alleles_str.remove_suffix(1);
+
+  int type = 0;
+  int num_gt = 0;
+  const char* gt = nullptr;
+  if (!results.info_fmt_value("fmt_GT", cell_idx, &type, &num_gt, &gt))
+    num_gt = 0;
+  else if (type != BCF_HT_INT)
+    throw std::runtime_error(
+        "Error reading genotypes; GT values are not integers.");
+
+  if (genotype_matrix_ != nullptr) {
+    uint64_t size = 0;
+    const char* sample_name =
+        results.buffers()->sample_name().value<char>(cell_idx, &size);
+    genotype_matrix_->add(
+        contig,
+        real_start,
+        alleles_str,
+        std::string_view(sample_name, size),
+        reinterpret_cast<const int32_t*>(gt),
+        num_gt);
+  } else {
+    variant_stats_->add(
+        contig,
+        real_start,
+        alleles_str,
+        reinterpret_cast<const int32_t*>(gt),
+        num_gt);
+  }
+  read_state_.last_num_records_exported++;
+  read_state_.total_num_records_exported++;
+}
+
 std::vector<std::vector<SampleAndId>> Reader::prepare_sample_batches() const {
   // Get the list of all sample names and ID
   auto samples = prepare_sample_names();
@@ -1918,71 +2667,27 @@ void Reader::prepare_regions_v4(
     }
   }
 
-  // Create super regions if overlapping regions exist
+  // Build the per-contig region intersectors and cell filters
   for (auto& regions_index_per_contig : read_state_.regions_index_per_contig) {
     auto& contig = regions_index_per_contig.first;
     auto& region_indexes = regions_index_per_contig.second;
 
-    // Check for overlapping regions.
-    // If region.max is not monotonically increasing, overlaps exist.
-    bool overlap = false;
-    uint32_t prev_max = 0;
+    std::vector<uint32_t> region_starts, region_ends;
+    region_starts.reserve(region_indexes.size());
+    region_ends.reserve(region_indexes.size());
     for (auto i : region_indexes) {
-      if (prev_max > read_state_.regions[i].max) {
-        overlap = true;
-        break;
-      }
-      prev_max = read_state_.regions[i].max;
+      region_starts.push_back(read_state_.regions[i].min);
+      region_ends.push_back(read_state_.regions[i].max);
     }
 
-    // Create super regions for this contig
-    if (overlap) {
-      int max_super_region_size = 0;
-      int super_region_size = 0;
-      SuperRegion super_region = {SIZE_MAX, 0};
-
-      for (auto i : region_indexes) {
-        auto end = read_state_.regions[i].max;
-
-        // Finish super region when it meets the size requirement and the next
-        // region does not overlap the super region. This ensures there are no
-        // overlapping super regions.
-        if (super_region_size >= params_.min_super_region_size &&
-            end >= super_region.end_max) {
-          read_state_.super_regions[contig].emplace_back(super_region);
-          max_super_region_size =
-              std::max(max_super_region_size, super_region_size);
-          super_region = {SIZE_MAX, 0};
-          super_region_size = 0;
-        }
-        super_region.region_min = std::min(super_region.region_min, i);
-        super_region.end_max = std::max(super_region.end_max, end);
-        super_region_size++;
-      }
-      // Add final super region
-      if (super_region_size) {
-        read_state_.super_regions[contig].emplace_back(super_region);
-        max_super_region_size =
-            std::max(max_super_region_size, super_region_size);
-      }
-
-      LOG_TRACE(
-          "Created {} super regions for {} (max size = {})",
-          read_state_.super_regions[contig].size(),
-          contig,
-          max_super_region_size);
-
-      // Assert that there are no overlapping super regions
-      uint32_t prev_max = 0;
-      for (auto sr : read_state_.super_regions[contig]) {
-        if (prev_max > sr.end_max) {
-          assert(false);
-        }
-        prev_max = sr.end_max;
-      }
-    } else {
+    RegionIntersector intersector(region_ends);
+    if (intersector.has_overlaps())
+      LOG_TRACE("Region overlaps in contig: {}", contig);
+    else
       LOG_TRACE("No region overlaps in contig: {}", contig);
-    }
+    read_state_.region_intersectors[contig] = std::move(intersector);
+    read_state_.cell_filters[contig] =
+        CellFilter(region_starts, region_ends, g);
   }
 }
 
@@ -2272,9 +2977,23 @@ void Reader::prepare_attribute_buffers() {
   }
 
   buffers_a.reset(new AttributeBufferSet(LOG_DEBUG_ENABLED()));
+  buffers_b.reset(new AttributeBufferSet(LOG_DEBUG_ENABLED()));
+  contig_batch_buffers_.clear();
+  position_buffers_.reset();
 
   const auto* user_exp = dynamic_cast<const InMemoryExporter*>(exporter_.get());
-  if (params_.cli_count_only || exporter_ == nullptr ||
+  if (variant_stats_ != nullptr || genotype_matrix_ != nullptr) {
+    // Variant stats and genotype matrices need the alleles and genotypes
+    // only.
+    attrs.insert(TileDBVCFDataset::AttrNames::V4::alleles);
+    const auto& extra = dataset_->metadata().extra_attributes;
+    if (std::find(extra.begin(), extra.end(), "fmt_GT") != extra.end())
+      attrs.insert("fmt_GT");
+    else
+      attrs.insert(TileDBVCFDataset::AttrNames::V4::fmt);
+  } else if (
+      params_.cli_count_only || exporter_ == nullptr ||
+      record_counter_ != nullptr ||
       (user_exp != nullptr && user_exp->array_attributes_required().empty())) {
     // Count only: need only required attributes. Do nothing here.
   } else if (exporter_ != nullptr) {
@@ -2287,12 +3006,43 @@ void Reader::prepare_attribute_buffers() {
         "requirements.");
   }
 
+  // The record filter needs the attributes it evaluates on the results
+  if (record_filter_ != nullptr) {
+    auto required = record_filter_->array_attributes_required(dataset_.get());
+    attrs.insert(required.begin(), required.end());
+  }
+
   // We get one-forth of the memory budget for the query buffers.
   // another one-forth goes to TileDB for `sm.memory_budget` and
-  // `sm.memory_budget_var`
-  uint64_t alloc_budget = params_.memory_budget_breakdown.buffers;
+  // `sm.memory_budget_var`. The query buffers are double-buffered, and v4
+  // reads get one more set per concurrently queried contig batch, so the
+  // budget is split evenly across all sets.
+  uint64_t num_contig_batch_buffers = 0;
+  bool late_materialization = false;
+  if (dataset_->metadata().version == TileDBVCFDataset::Version::V4) {
+    num_contig_batch_buffers = params_.contig_batch_concurrency - 1;
+    late_materialization = params_.late_materialization;
+  }
+  uint64_t alloc_budget =
+      params_.memory_budget_breakdown.buffers /
+      (2 + num_contig_batch_buffers + (late_materialization ? 1 : 0));
+
+  if (late_materialization) {
+    // Phase one runs for the current and each prefetched contig batch, which
+    // share one set's budget for their position buffers.
+    position_buffers_budget_ = alloc_budget / params_.contig_batch_concurrency;
+    position_buffers_.reset(new AttributeBufferSet(LOG_DEBUG_ENABLED()));
+    allocate_position_buffers(position_buffers_.get());
+  }
 
   buffers_a->allocate_fixed(attrs, alloc_budget, dataset_.get());
+  buffers_b->allocate_fixed(attrs, alloc_budget, dataset_.get());
+  for (uint64_t i = 0; i < num_contig_batch_buffers; i++) {
+    contig_batch_buffers_.emplace_back(
+        new AttributeBufferSet(LOG_DEBUG_ENABLED()));
+    contig_batch_buffers_.back()->allocate_fixed(
+        attrs, alloc_budget, dataset_.get());
+  }
 }
 
 void Reader::init_tiledb() {
@@ -2434,25 +3184,31 @@ void Reader::set_verbose(const bool& verbose) {
   }
 }
 
-void Reader::set_tiledb_query_config() {
-  assert(read_state_.query != nullptr);
+void Reader::set_tiledb_query_config(tiledb::Query* query) {
+  assert(query != nullptr);
   assert(buffers_a != nullptr);
 
+  // v4 reads run one query per concurrently queried contig batch, plus the
+  // position query of late materialization. They share the TileDB budget.
+  uint64_t num_queries = 1;
+  if (dataset_->metadata().version == TileDBVCFDataset::Version::V4)
+    num_queries = params_.contig_batch_concurrency +
+                  (params_.late_materialization ? 1 : 0);
+  const uint64_t query_memory_budget =
+      params_.memory_budget_breakdown.tiledb_memory_budget /
+      (buffers_a->nbuffers() * num_queries);
+
   tiledb::Config cfg;
   utils::set_tiledb_config(params_.tiledb_config, &cfg);
   if (params_.tiledb_config_map.find("sm.memory_budget") ==
           params_.tiledb_config_map.end() &&
       params_.memory_budget_breakdown.tiledb_memory_budget > 0)
-    cfg["sm.memory_budget"] =
-        params_.memory_budget_breakdown.tiledb_memory_budget /
-        buffers_a->nbuffers();
+    cfg["sm.memory_budget"] = query_memory_budget;
 
   if (params_.tiledb_config_map.find("sm.memory_budget_var") ==
           params_.tiledb_config_map.end() &&
       params_.memory_budget_breakdown.tiledb_memory_budget > 0)
-    cfg["sm.memory_budget_var"] =
-        params_.memory_budget_breakdown.tiledb_memory_budget /
-        buffers_a->nbuffers();
+    cfg["sm.memory_budget_var"] = query_memory_budget;
 
   if (params_.tiledb_config_map.find("sm.skip_est_size_partitioning") ==
       params_.tiledb_config_map.end())
@@ -2464,7 +3220,7 @@ void Reader::set_tiledb_query_config() {
     cfg["sm.mem.total_budget"] = tiledb_total;
   }
 
-  read_state_.query->set_config(cfg);
+  query->set_config(cfg);
 }
 
 void Reader::compute_memory_budget_details() {
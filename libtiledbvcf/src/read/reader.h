@@ -27,9 +27,12 @@
 #ifndef TILEDB_VCF_READER_H
 #define TILEDB_VCF_READER_H
 
+#include <deque>
 #include <future>
 #include <map>
 #include <memory>
+#include <set>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -41,10 +44,17 @@
 #include "dataset/attribute_buffer_set.h"
 #include "dataset/tiledbvcfdataset.h"
 #include "enums/attr_datatype.h"
+#include "enums/count_group_by.h"
 #include "enums/read_status.h"
 #include "read/exporter.h"
+#include "read/cell_filter.h"
+#include "read/genotype_matrix.h"
 #include "read/in_memory_exporter.h"
 #include "read/read_query_results.h"
+#include "read/record_counter.h"
+#include "read/record_filter.h"
+#include "read/region_intersector.h"
+#include "read/variant_stats.h"
 
 namespace tiledb {
 namespace vcf {
@@ -92,6 +102,10 @@ struct ExportParams {
   std::string upload_dir;
   std::string output_path;
   std::vector<std::string> tsv_fields;
+  // INFO/FMT fields to include in (or exclude from) VCF/BCF exports, e.g.
+  // "info_DP" or "fmt" for all FMT fields. At most one can be non-empty.
+  std::vector<std::string> include_fields;
+  std::vector<std::string> exclude_fields;
   PartitionInfo sample_partitioning;
   PartitionInfo region_partitioning;
   ExportFormat format = ExportFormat::CompressedBCF;
@@ -101,6 +115,9 @@ struct ExportParams {
   bool cli_count_only = false;
   bool sort_regions = true;
   uint64_t max_num_records = std::numeric_limits<uint64_t>::max();
+  uint64_t batch_num_records = 0;
+  // Attributes exported dictionary-encoded (in-memory export only).
+  std::set<std::string> dictionary_attributes;
   std::vector<std::string> tiledb_config;
   std::unordered_map<std::string, std::string> tiledb_config_map;
 
@@ -124,14 +141,42 @@ struct ExportParams {
   // Debug parameters for optional debug information
   struct DebugParams debug_params;
 
-  // Minimum super region size, used to handle overlapping regions.
-  // Recommed setting to 1 to create smaller super regions and reduce the
-  // time to find the first intersecting region. Increase the setting if
-  // the memory overhead of super regions needs to be reduced.
-  int min_super_region_size = 1;
-
   // Should results be sorted on real_start_pos
   bool sort_real_start_pos = false;
+
+  // Number of contig batches whose TileDB queries run concurrently in v4
+  // reads. Results are always exported in contig order. The default of 1
+  // runs one contig batch at a time.
+  unsigned contig_batch_concurrency = 1;
+
+  // Use two-phase reads in v4. The first phase reads only the position
+  // columns to find the cells intersecting the regions, the second reads all
+  // requested attributes for the start positions of those cells only.
+  bool late_materialization = false;
+
+  // Expression filtering the exported records on their values, e.g.
+  // "QUAL>30 && FILTER==PASS" (v4 only). Empty to export all records.
+  std::string filter_expression;
+
+  // Count the records per query region, sample or contig instead of
+  // exporting them. Only the position attributes are read.
+  CountGroupBy count_group_by = CountGroupBy::COUNT_NONE;
+
+  // Aggregate the allele counts and genotype classes of each variant across
+  // the samples instead of exporting the records (v4 only). Only the
+  // position, alleles and GT attributes are read.
+  bool variant_stats = false;
+
+  // Build a bit-packed matrix of the genotypes of each variant across the
+  // samples instead of exporting the records (v4 only). Only the position,
+  // alleles and GT attributes are read. If non-empty, the matrix is written
+  // to a memory-mapped file at genotype_matrix_path.
+  bool genotype_matrix = false;
+  std::string genotype_matrix_path;
+
+  // Memory cap, in MB, of the dataset's cache of parsed VCF headers, which
+  // successive reads of the same samples reuse (v4 only). 0 disables it.
+  uint64_t vcf_header_cache_mb = 128;
 };
 
 /* ********************************* */
@@ -189,6 +234,57 @@ class Reader {
   /** Sets the regions list parameter. */
   void set_regions(const std::string& regions);
 
+  /**
+   * Sets the number of contig batches whose TileDB queries run concurrently
+   * (v4 only).
+   */
+  void set_contig_batch_concurrency(unsigned concurrency);
+
+  /** Sets whether v4 reads run in two phases (late materialization). */
+  void set_late_materialization(bool late_materialization);
+
+  /**
+   * Sets the expression filtering the exported records on their values (v4
+   * only). Throws if the expression cannot be parsed.
+   */
+  void set_filter_expression(const std::string& expression);
+
+  /**
+   * Sets the grouping of a count query. Unless COUNT_NONE, reads count the
+   * intersecting records per group instead of exporting them.
+   */
+  void set_count_group_by(CountGroupBy group_by);
+
+  /**
+   * Sets whether reads aggregate the variant statistics of the intersecting
+   * records instead of exporting them (v4 only).
+   */
+  void set_variant_stats(bool variant_stats);
+
+  /**
+   * Sets whether reads build a genotype matrix of the intersecting records
+   * instead of exporting them (v4 only).
+   */
+  void set_genotype_matrix(bool genotype_matrix);
+
+  /**
+   * Sets the memory the genotype matrix is written to. A read adding more
+   * rows than fit fails.
+   */
+  void set_genotype_matrix_buffer(void* buffer, uint64_t size);
+
+  /**
+   * Sets the local path of a file the genotype matrix is memory-mapped to
+   * instead of a buffer. The file grows as rows are added.
+   */
+  void set_genotype_matrix_file(const std::string& path);
+
+  /**
+   * Sets the memory cap, in MB, of the cache of parsed VCF headers. 0
+   * disables the cache.
+   */
+  void set_vcf_header_cache_size(uint64_t mb);
+
   /** Sets the sort regionsparameter. */
   void set_sort_regions(bool sort_regions);
 
@@ -222,6 +318,29 @@ class Reader {
   void set_buffer_validity_bitmap(
       const std::string& attribute, uint8_t* buff, int64_t buff_size);
 
+  /**
+   * Sets whether an attribute ("sample_name", "contig" or "alleles") is
+   * exported dictionary-encoded. See InMemoryExporter::set_dictionary_encoding.
+   */
+  void set_dictionary_encoding(const std::string& attribute, bool dictionary);
+
+  /** Returns true if the given attribute is exported dictionary-encoded. */
+  bool dictionary_encoding(const std::string& attribute) const;
+
+  /**
+   * Sets the dictionary values buffer pointer and size (in bytes) for a
+   * dictionary-encoded attribute.
+   */
+  void set_buffer_dictionary_values(
+      const std::string& attribute, char* buff, int64_t buff_size);
+
+  /**
+   * Sets the dictionary offsets buffer pointer and size (in bytes) for a
+   * dictionary-encoded attribute.
+   */
+  void set_buffer_dictionary_offsets(
+      const std::string& attribute, int32_t* buff, int64_t buff_size);
+
   /**
    * Sets the memory budget parameter.
    *
@@ -243,6 +362,29 @@ class Reader {
   /** Sets the attribute buffer size parameter. */
   void set_record_limit(uint64_t max_num_records);
 
+  /**
+   * Sets the maximum number of records exported by each read (0 for no
+   * limit). Reads stop with an incomplete status after that many records, as
+   * if the buffers were full.
+   */
+  void set_batch_num_records(uint64_t num_records);
+
+  /**
+   * Estimates the buffer sizes (in bytes) needed for an attribute to export
+   * the given number of records, from the sizes of the records of the last
+   * read. This is for in-memory export only.
+   */
+  void buffer_size_estimate(
+      const std::string& attribute,
+      uint64_t num_records,
+      int64_t* data_bytes,
+      int64_t* offsets_bytes,
+      int64_t* list_offsets_bytes,
+      int64_t* bitmap_bytes) const;
+
+  /** Returns the maximum number of records exported by each read. */
+  uint64_t batch_num_records() const;
+
   /** Sets TileDB config parameters. */
   void set_tiledb_config(const std::string& config_str);
 
@@ -267,6 +409,27 @@ class Reader {
   /** Returns the number of records last exported. */
   uint64_t num_records_exported() const;
 
+  /**
+   * Returns the record counts per group of the last count query (see
+   * set_count_group_by()).
+   */
+  const std::vector<RecordCounter::Group>& count_groups();
+
+  /**
+   * Returns the statistics of each variant of the last variant stats query
+   * (see set_variant_stats()).
+   */
+  const std::vector<VariantStats::Variant>& variant_stats();
+
+  /**
+   * Returns the genotype matrix of the last genotype matrix query (see
+   * set_genotype_matrix()).
+   */
+  const GenotypeMatrix& genotype_matrix() const;
+
+  /** Returns the counters of the VCF header cache of the open dataset. */
+  VCFHeaderCache::Stats vcf_header_cache_stats() const;
+
   /** Gets the version number of the open dataset. */
   void dataset_version(int32_t* version) const;
 
@@ -280,9 +443,19 @@ class Reader {
       int64_t* num_data_elements,
       int64_t* num_data_bytes) const;
 
+  /**
+   * Returns the size of the dictionary last exported for the given
+   * dictionary-encoded attribute.
+   */
+  void dictionary_result_size(
+      const std::string& attribute,
+      int64_t* num_offsets,
+      int64_t* num_data_bytes) const;
+
   /**
    * Returns the datatype, var-length, and nullable setting of the given
-   * attribute.
+   * attribute. Dictionary-encoded attributes are reported as their int32
+   * indices.
    */
   void attribute_datatype(
       const std::string& attribute,
@@ -322,6 +495,28 @@ class Reader {
   void get_buffer_validity_bitmap(
       int32_t buffer_idx, const char** name, uint8_t** buff) const;
 
+  /**
+   * Gets the dictionary buffers previously set for an attribute, and their
+   * allocation sizes (in bytes). This is for in-memory export only.
+   */
+  void get_buffer_dictionary(
+      int32_t buffer_idx,
+      char** values,
+      int64_t* values_bytes,
+      int32_t** offsets,
+      int64_t* offsets_bytes) const;
+
+  /**
+   * Gets the allocation sizes (in bytes) of the buffers previously set for an
+   * attribute. This is for in-memory export only.
+   */
+  void get_buffer_sizes(
+      int32_t buffer_idx,
+      int64_t* data_bytes,
+      int64_t* offsets_bytes,
+      int64_t* list_offsets_bytes,
+      int64_t* bitmap_bytes) const;
+
   /**
    * Get the count of queryable attributes
    * @param count of attributes
@@ -448,10 +643,37 @@ class Reader {
     std::string contig;
   };
 
-  /** Helper struct containing stats for a group of regions */
-  struct SuperRegion {
-    size_t region_min;  // minimum region index
-    uint32_t end_max;   // maximum end position
+  /**
+   * A v4 contig batch whose TileDB query was started ahead of being
+   * processed.
+   */
+  struct PendingContigBatch {
+    /** Index into `ReadState::query_regions_v4`. */
+    size_t contig_batch_idx = 0;
+
+    /** Estimated number of records for the query, or 0 if unknown. */
+    uint64_t estimated_num_records = 1;
+
+    /** TileDB query object. */
+    std::unique_ptr<Query> query;
+
+    /** Buffers receiving the first chunk of query results. */
+    std::unique_ptr<AttributeBufferSet> buffers;
+
+    /** Status of the in-flight query submission. */
+    std::future<tiledb::Query::Status> query_future;
+  };
+
+  /** A cell of the v4 query results to report in a region. */
+  struct ReportRow {
+    /** Position of the cell in the visit order. */
+    uint64_t pos;
+
+    /** Index of the cell in the query results. */
+    uint64_t cell_idx;
+
+    /** Index of the region in the contig's regions. */
+    size_t region_idx;
   };
 
   /**
@@ -474,7 +696,7 @@ class Reader {
     std::unordered_map<uint32_t, SampleAndId> current_samples;
 
     /** Map of current relative sample ID -> VCF header instance. */
-    std::unordered_map<uint32_t, SafeBCFHdr> current_hdrs;
+    std::unordered_map<uint32_t, SharedBCFHdr> current_hdrs;
 
     std::unordered_map<std::string, size_t> current_hdrs_lookup;
 
@@ -494,11 +716,16 @@ class Reader {
     std::vector<Region> regions;
 
     /**
-     * Contains merged regions per contig to support overlapping regions.
-     * If the super_region vector does not exist for a contig, there are no
-     * overlapping regions in that contig.
+     * Per-contig lookup of the first region that can intersect a record. Built
+     * once in prepare_regions_v4 and indexed like regions_index_per_contig.
      */
-    std::unordered_map<std::string, std::vector<SuperRegion>> super_regions;
+    std::unordered_map<std::string, RegionIntersector> region_intersectors;
+
+    /**
+     * Per-contig filter selecting the result cells that intersect a region.
+     * Built once in prepare_regions_v4.
+     */
+    std::unordered_map<std::string, CellFilter> cell_filters;
 
     /** Store index positions to only compare again regions for a contig */
     std::unordered_map<std::string, std::vector<size_t>>
@@ -518,6 +745,12 @@ class Reader {
     /** The index of the current batch of samples being exported. */
     size_t query_contig_batch_idx = 0;
 
+    /**
+     * Bounded queue of upcoming contig batches whose queries are already
+     * running, ordered by contig batch index.
+     */
+    std::deque<PendingContigBatch> pending_contig_batches;
+
     /** The samples being exported, batched by space tile. */
     std::vector<std::vector<SampleAndId>> sample_batches;
 
@@ -540,6 +773,12 @@ class Reader {
     /** TileDB query object. */
     std::unique_ptr<Query> query;
 
+    /**
+     * Status of the in-flight (asynchronous) TileDB query submission. While
+     * valid, TileDB is writing results into `buffers_a`.
+     */
+    std::future<tiledb::Query::Status> query_future;
+
     /** Struct containing query results from last TileDB query. */
     ReadQueryResults query_results;
 
@@ -579,9 +818,59 @@ class Reader {
   /** The read state. */
   ReadState read_state_;
 
-  /** Set of attribute buffers holding TileDB query results. */
+  /**
+   * Set of attribute buffers that the next (or in-flight) TileDB query
+   * submission writes into.
+   */
   std::unique_ptr<AttributeBufferSet> buffers_a;
 
+  /**
+   * Second set of attribute buffers used for double-buffering. While the
+   * results in one set are being processed, the next incomplete chunk of the
+   * TileDB query is fetched into the other.
+   */
+  std::unique_ptr<AttributeBufferSet> buffers_b;
+
+  /**
+   * Spare attribute buffer sets for contig batches that are queried ahead of
+   * being processed.
+   */
+  std::vector<std::unique_ptr<AttributeBufferSet>> contig_batch_buffers_;
+
+  /**
+   * Position column buffers for the first phase of late materialization
+   * reads.
+   */
+  std::unique_ptr<AttributeBufferSet> position_buffers_;
+
+  /** Memory budget of each set of position buffers. */
+  uint64_t position_buffers_budget_ = 0;
+
+  /** Filter on record values, if a filter expression is set. */
+  std::unique_ptr<RecordFilter> record_filter_;
+
+  /** Record counts of a count query, if a count grouping is set. */
+  std::unique_ptr<RecordCounter> record_counter_;
+
+  /** Statistics of a variant stats query, if enabled. */
+  std::unique_ptr<VariantStats> variant_stats_;
+
+  /** Genotypes of a genotype matrix query, if enabled. */
+  std::unique_ptr<GenotypeMatrix> genotype_matrix_;
+
+  /** Memory the genotype matrix is written to, unless a file is set. */
+  uint8_t* genotype_matrix_buffer_ = nullptr;
+  uint64_t genotype_matrix_buffer_size_ = 0;
+
+  /** Maximum number of rows collected before reporting them (v4). */
+  static const size_t REPORT_BATCH_SIZE = 4096;
+
+  /** Reusable list of the rows to report (v4). */
+  std::vector<ReportRow> report_rows_;
+
+  /** Reusable list of the rows to export (v4). */
+  std::vector<Exporter::ExportRow> export_rows_;
+
   /* ********************************* */
   /*           PRIVATE METHODS         */
   /* ********************************* */
@@ -598,6 +887,83 @@ class Reader {
   bool next_read_batch_v2_v3();
   bool next_read_batch_v4();
 
+  /**
+   * Builds the TileDB query for the given v4 contig batch of the current
+   * sample batch.
+   *
+   * @param contig_batch_idx Index into `read_state_.query_regions_v4`
+   * @param estimated_num_records Set to the estimated number of records
+   * @return The query, ready to be submitted
+   */
+  std::unique_ptr<Query> build_query_v4(
+      size_t contig_batch_idx, uint64_t* estimated_num_records);
+
+  /**
+   * Builds the TileDB query for the given v4 contig batch of the current
+   * sample batch, without its start_pos ranges.
+   *
+   * @param contig_batch_idx Index into `read_state_.query_regions_v4`
+   * @return The query, missing its start_pos ranges
+   */
+  std::unique_ptr<Query> init_query_v4(size_t contig_batch_idx);
+
+  /**
+   * Adds the start_pos ranges of a v4 contig batch to its query. With late
+   * materialization, they are found by running the position query first.
+   * Only touches the state of the contig batch's contig, so it can run on
+   * another thread for a prefetched contig batch.
+   *
+   * @param contig_batch_idx Index into `read_state_.query_regions_v4`
+   * @param query Query built by init_query_v4()
+   * @param position_query Phase one query, or null without late
+   *     materialization
+   * @param position_buffers Buffers of the phase one query
+   * @param estimated_num_records Set to the estimated number of records, if
+   *     not null
+   */
+  void add_start_pos_ranges_v4(
+      size_t contig_batch_idx,
+      Query* query,
+      Query* position_query,
+      AttributeBufferSet* position_buffers,
+      uint64_t* estimated_num_records);
+
+  /** Adds the sample ranges of the current sample batch to a v4 query. */
+  void add_sample_ranges_v4(Query* query, std::stringstream* debug_ranges);
+
+  /**
+   * Builds the first phase query of a late materialization read for a v4
+   * contig batch, which reads the position columns only.
+   *
+   * @param contig_batch_idx Index into `read_state_.query_regions_v4`
+   * @return The position query, ready to be submitted
+   */
+  std::unique_ptr<Query> build_position_query_v4(size_t contig_batch_idx);
+
+  /**
+   * Runs the first phase of a late materialization read for a v4 contig
+   * batch, and returns the start_pos ranges covering the cells that
+   * intersect a region.
+   *
+   * @param contig_batch_idx Index into `read_state_.query_regions_v4`
+   * @param position_query Query built by build_position_query_v4()
+   * @param position_buffers Buffers receiving the position columns
+   * @return Coalesced start_pos ranges, sorted on start
+   */
+  std::vector<QueryRegion> materialized_query_regions_v4(
+      size_t contig_batch_idx,
+      Query* position_query,
+      AttributeBufferSet* position_buffers);
+
+  /** Allocates a set of position buffers for late materialization. */
+  void allocate_position_buffers(AttributeBufferSet* buffers) const;
+
+  /**
+   * Starts the queries of the contig batches following the current one, up to
+   * the contig batch concurrency.
+   */
+  void prefetch_contig_batches_v4();
+
   /**
    * Runs the TileDB-VCF read algorithm for the current batch. Returns false if,
    * during in-memory export, a user buffer filled up (which means it was an
@@ -605,6 +971,18 @@ class Reader {
    */
   bool read_current_batch();
 
+  /**
+   * Sets `buffers_a` on the current TileDB query and submits it
+   * asynchronously, storing the pending status in `read_state_.query_future`.
+   */
+  void submit_query_async();
+
+  /**
+   * Blocks until the in-flight TileDB query submissions (if any) have
+   * finished, discarding their results.
+   */
+  void wait_for_query();
+
   /** Initializes the batches and exporter before the first read. */
   void init_for_reads();
   void init_for_reads_v2();
@@ -675,14 +1053,6 @@ class Reader {
   /** Allocates required attribute buffers to receive TileDB query data. */
   void prepare_attribute_buffers();
 
-  /**
-   * Search the regions vector for the first region that can intersect with
-   * the real_start position. If a region is found, modify first_region and
-   * return true. Otherwise, return false.
-   */
-  bool first_intersecting_region(
-      const std::string& contig, uint32_t real_start, size_t& first_region);
-
   /**
    * Processes the result cells from the last TileDB query. Returns false if,
    * during in-memory export, a user buffer filled up (which means it was an
@@ -690,6 +1060,20 @@ class Reader {
    */
   bool process_query_results_v4();
 
+  /**
+   * Reports the collected v4 rows, in batch if exporting. Returns false if
+   * reporting must stop: either the record limit was reached, or a user
+   * buffer filled up, in which case `overflow` is set and the read state is
+   * saved to resume from the first unreported row.
+   */
+  bool report_rows_v4(const std::vector<size_t>& regions, bool* overflow);
+
+  /**
+   * Returns the header of the sample of a v4 result cell, or nullptr if
+   * headers are not loaded.
+   */
+  const bcf_hdr_t* cell_header_v4(uint64_t cell_idx);
+
   /**
    * Processes the result cells from the last TileDB query. Returns false if,
    * during in-memory export, a user buffer filled up (which means it was an
@@ -713,6 +1097,36 @@ class Reader {
   bool report_cell(
       const Region& region, uint32_t contig_offset, uint64_t cell_idx);
 
+  /**
+   * Adds the cell in the current query results at the given index to the
+   * record counts of a count query.
+   */
+  void count_cell(const Region& region, uint64_t cell_idx);
+
+  /**
+   * Adds a selected cell of the current v4 query results to the variant
+   * stats or genotype matrix, unless the record was already added through
+   * another cell or region.
+   *
+   * @param contig The query contig
+   * @param regions Indexes of the regions of the query contig
+   * @param selected The selected cell
+   * @param cell_idx Index of the cell in the query results
+   * @param intersector Intersector for the regions of the query contig
+   */
+  void add_genotype_cell(
+      const std::string& contig,
+      const std::vector<size_t>& regions,
+      const CellFilter::SelectedCell& selected,
+      uint64_t cell_idx,
+      RegionIntersector* intersector);
+
+  /**
+   * Creates the genotype matrix of a genotype matrix query, with the samples
+   * of the query as columns.
+   */
+  void init_genotype_matrix();
+
   /** Initializes the TileDB context and VFS instances. */
   void init_tiledb();
 
@@ -726,7 +1140,7 @@ class Reader {
    * Currently used for setting things like the `sm.memory_budget` and
    * `sm.memory_buget_var`
    */
-  void set_tiledb_query_config();
+  void set_tiledb_query_config(tiledb::Query* query);
 
   void compute_memory_budget_details();
 };
@@ -0,0 +1,110 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "read/record_counter.h"
+
+namespace tiledb {
+namespace vcf {
+
+RecordCounter::RecordCounter(CountGroupBy group_by)
+    : group_by_(group_by)
+    , last_region_(nullptr)
+    , last_count_(nullptr)
+    , groups_valid_(false) {
+  if (group_by_ == CountGroupBy::COUNT_NONE)
+    throw std::runtime_error(
+        "Error creating record counter; a grouping is required.");
+}
+
+CountGroupBy RecordCounter::group_by() const {
+  return group_by_;
+}
+
+void RecordCounter::add(const Region& region, std::string_view sample_name) {
+  groups_valid_ = false;
+  switch (group_by_) {
+    case CountGroupBy::COUNT_BY_REGION:
+      if (&region != last_region_) {
+        RegionKey key(region.line, region.seq_name, region.min, region.max);
+        last_count_ = &region_counts_[key];
+        last_region_ = &region;
+      }
+      break;
+    case CountGroupBy::COUNT_BY_SAMPLE:
+      last_count_ = name_count(sample_name);
+      break;
+    case CountGroupBy::COUNT_BY_CONTIG:
+      last_count_ = name_count(region.seq_name);
+      break;
+    default:
+      throw std::runtime_error("Error counting record; unknown grouping.");
+  }
+  (*last_count_)++;
+}
+
+void RecordCounter::reset() {
+  region_counts_.clear();
+  name_counts_.clear();
+  last_region_ = nullptr;
+  last_name_.clear();
+  last_count_ = nullptr;
+  groups_.clear();
+  groups_valid_ = false;
+}
+
+const std::vector<RecordCounter::Group>& RecordCounter::groups() {
+  if (groups_valid_)
+    return groups_;
+
+  groups_.clear();
+  if (group_by_ == CountGroupBy::COUNT_BY_REGION) {
+    for (const auto& it : region_counts_) {
+      const auto& key = it.first;
+      groups_.emplace_back(
+          std::get<1>(key) + ":" + std::to_string(std::get<2>(key) + 1) + "-" +
+              std::to_string(std::get<3>(key) + 1),
+          it.second);
+    }
+  } else {
+    groups_.assign(name_counts_.begin(), name_counts_.end());
+  }
+  groups_valid_ = true;
+  return groups_;
+}
+
+uint64_t* RecordCounter::name_count(std::string_view name) {
+  if (last_count_ != nullptr && name == last_name_)
+    return last_count_;
+
+  auto it = name_counts_.find(name);
+  if (it == name_counts_.end())
+    it = name_counts_.emplace(std::string(name), 0).first;
+  last_name_.assign(name.data(), name.size());
+  return &it->second;
+}
+
+}  // namespace vcf
+}  // namespace tiledb
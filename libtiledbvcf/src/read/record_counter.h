@@ -0,0 +1,116 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TILEDB_VCF_RECORD_COUNTER_H
+#define TILEDB_VCF_RECORD_COUNTER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "enums/count_group_by.h"
+#include "vcf/region.h"
+
+namespace tiledb {
+namespace vcf {
+
+/**
+ * Accumulates the record counts of a count query, grouped by query region,
+ * sample or contig. Only groups with at least one record are reported.
+ *
+ * Records of the same group usually arrive consecutively, so the count of
+ * the last group is cached to avoid a map lookup per record.
+ */
+class RecordCounter {
+ public:
+  /** A group name and the number of records in it. */
+  typedef std::pair<std::string, uint64_t> Group;
+
+  explicit RecordCounter(CountGroupBy group_by);
+
+  /** Returns the grouping of the counts. */
+  CountGroupBy group_by() const;
+
+  /**
+   * Counts a record.
+   *
+   * @param region The query region intersecting the record. Must stay valid
+   *    until reset() as it is used as a cache key.
+   * @param sample_name Name of the sample of the record (only used when
+   *    grouping by sample)
+   */
+  void add(const Region& region, std::string_view sample_name);
+
+  /** Clears all counts. */
+  void reset();
+
+  /**
+   * Returns the counted groups. Regions are ordered by BED line and position
+   * and named "contig:start-end" (1-indexed, inclusive). Samples and contigs
+   * are ordered by name.
+   */
+  const std::vector<Group>& groups();
+
+ private:
+  /** Key ordering the region groups: (line, contig, min, max). */
+  typedef std::tuple<int32_t, std::string, uint32_t, uint32_t> RegionKey;
+
+  /** The grouping of the counts. */
+  CountGroupBy group_by_;
+
+  /** Counts per region. */
+  std::map<RegionKey, uint64_t> region_counts_;
+
+  /** Counts per sample or contig name. */
+  std::map<std::string, uint64_t, std::less<>> name_counts_;
+
+  /** The region of the last counted record. */
+  const Region* last_region_;
+
+  /** The sample or contig name of the last counted record. */
+  std::string last_name_;
+
+  /** The count of the group of the last counted record. */
+  uint64_t* last_count_;
+
+  /** The groups built from the counts by groups(). */
+  std::vector<Group> groups_;
+
+  /** True if groups_ is up to date. */
+  bool groups_valid_;
+
+  /** Returns the count to increment for the given sample or contig name. */
+  uint64_t* name_count(std::string_view name);
+};
+
+}  // namespace vcf
+}  // namespace tiledb
+
+#endif  // TILEDB_VCF_RECORD_COUNTER_H
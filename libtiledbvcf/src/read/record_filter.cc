@@ -0,0 +1,359 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "read/record_filter.h"
+#include "utils/utils.h"
+
+namespace tiledb {
+namespace vcf {
+
+RecordFilter::RecordFilter(const std::string& expression) {
+  // Split on "&&", except inside quoted values.
+  size_t pos = 0;
+  char quote = '\0';
+  for (size_t i = 0; i < expression.size(); i++) {
+    const char c = expression[i];
+    if (quote != '\0') {
+      if (c == quote)
+        quote = '\0';
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+    } else if (c == '&' && i + 1 < expression.size() &&
+               expression[i + 1] == '&') {
+      predicates_.push_back(parse_predicate(expression.substr(pos, i - pos)));
+      pos = i + 2;
+      i++;
+    }
+  }
+  predicates_.push_back(parse_predicate(expression.substr(pos)));
+}
+
+RecordFilter::Predicate RecordFilter::parse_predicate(const std::string& str) {
+  const size_t op_pos = str.find_first_of("=!<>");
+  if (op_pos == std::string::npos)
+    throw std::runtime_error(
+        "Error parsing filter expression; no comparison operator in '" + str +
+        "'.");
+
+  Predicate pred;
+  size_t op_len = 1;
+  const bool followed_by_eq =
+      op_pos + 1 < str.size() && str[op_pos + 1] == '=';
+  switch (str[op_pos]) {
+    case '=':
+      if (!followed_by_eq)
+        throw std::runtime_error(
+            "Error parsing filter expression; use '==' for equality in '" +
+            str + "'.");
+      pred.op = Op::EQ;
+      op_len = 2;
+      break;
+    case '!':
+      if (!followed_by_eq)
+        throw std::runtime_error(
+            "Error parsing filter expression; unknown operator in '" + str +
+            "'.");
+      pred.op = Op::NE;
+      op_len = 2;
+      break;
+    case '<':
+      pred.op = followed_by_eq ? Op::LE : Op::LT;
+      op_len = followed_by_eq ? 2 : 1;
+      break;
+    default:
+      pred.op = followed_by_eq ? Op::GE : Op::GT;
+      op_len = followed_by_eq ? 2 : 1;
+      break;
+  }
+
+  pred.field = str.substr(0, op_pos);
+  pred.value = str.substr(op_pos + op_len);
+  utils::trim(&pred.field);
+  utils::trim(&pred.value);
+  if (pred.value.size() >= 2 &&
+      (pred.value.front() == '"' || pred.value.front() == '\'') &&
+      pred.value.back() == pred.value.front())
+    pred.value = pred.value.substr(1, pred.value.size() - 2);
+
+  if (pred.field.empty() || pred.value.empty())
+    throw std::runtime_error(
+        "Error parsing filter expression; missing field or value in '" + str +
+        "'.");
+
+  try {
+    size_t num_parsed = 0;
+    pred.numeric_value = std::stod(pred.value, &num_parsed);
+    pred.is_numeric = num_parsed == pred.value.size();
+  } catch (const std::exception&) {
+    pred.is_numeric = false;
+  }
+
+  const bool equality = pred.op == Op::EQ || pred.op == Op::NE;
+  if (pred.field == "QUAL" || pred.field == "qual") {
+    pred.field = "qual";
+    if (!pred.is_numeric)
+      throw std::runtime_error(
+          "Error parsing filter expression; QUAL value must be numeric in '" +
+          str + "'.");
+    // Missing QUAL values never match, which TileDB cannot express for '!='.
+    pred.pushed_down = pred.op != Op::NE;
+  } else if (
+      pred.field == "FILTER" || pred.field == "filter" ||
+      pred.field == "filters") {
+    pred.field = "filters";
+    if (!equality)
+      throw std::runtime_error(
+          "Error parsing filter expression; FILTER only supports '==' and "
+          "'!=' in '" +
+          str + "'.");
+  } else if (
+      utils::starts_with(pred.field, "info_") ||
+      utils::starts_with(pred.field, "fmt_")) {
+    if (!pred.is_numeric && !equality)
+      throw std::runtime_error(
+          "Error parsing filter expression; string values only support '==' "
+          "and '!=' in '" +
+          str + "'.");
+  } else {
+    throw std::runtime_error(
+        "Error parsing filter expression; unsupported field '" + pred.field +
+        "'. Supported fields are QUAL, FILTER, info_<key> and fmt_<key>.");
+  }
+
+  return pred;
+}
+
+const std::vector<RecordFilter::Predicate>& RecordFilter::predicates() const {
+  return predicates_;
+}
+
+bool RecordFilter::uses_filters() const {
+  for (const auto& pred : predicates_) {
+    if (pred.field == "filters")
+      return true;
+  }
+  return false;
+}
+
+bool RecordFilter::all_pushed_down() const {
+  for (const auto& pred : predicates_) {
+    if (!pred.pushed_down)
+      return false;
+  }
+  return true;
+}
+
+std::set<std::string> RecordFilter::array_attributes_required(
+    const TileDBVCFDataset* dataset) const {
+  std::set<std::string> result;
+  for (const auto& pred : predicates_) {
+    if (pred.pushed_down)
+      continue;
+
+    if (pred.field == "qual") {
+      result.insert(TileDBVCFDataset::AttrNames::V4::qual);
+    } else if (pred.field == "filters") {
+      result.insert(TileDBVCFDataset::AttrNames::V4::filter_ids);
+    } else if (dataset->is_attribute_materialized(pred.field)) {
+      result.insert(pred.field);
+    } else if (utils::starts_with(pred.field, "info_")) {
+      result.insert(TileDBVCFDataset::AttrNames::V4::info);
+    } else {
+      result.insert(TileDBVCFDataset::AttrNames::V4::fmt);
+    }
+  }
+  return result;
+}
+
+void RecordFilter::set_query_condition(
+    const tiledb::Context& ctx, tiledb::Query* query) {
+  std::unique_ptr<tiledb::QueryCondition> condition;
+  for (const auto& pred : predicates_) {
+    if (!pred.pushed_down)
+      continue;
+
+    tiledb_query_condition_op_t op = TILEDB_EQ;
+    switch (pred.op) {
+      case Op::EQ:
+        op = TILEDB_EQ;
+        break;
+      case Op::NE:
+        op = TILEDB_NE;
+        break;
+      case Op::LT:
+        op = TILEDB_LT;
+        break;
+      case Op::LE:
+        op = TILEDB_LE;
+        break;
+      case Op::GT:
+        op = TILEDB_GT;
+        break;
+      case Op::GE:
+        op = TILEDB_GE;
+        break;
+    }
+
+    float value = static_cast<float>(pred.numeric_value);
+    tiledb::QueryCondition qc(ctx);
+    qc.init(TileDBVCFDataset::AttrNames::V4::qual, &value, sizeof(value), op);
+    if (condition == nullptr)
+      condition.reset(new tiledb::QueryCondition(qc));
+    else
+      condition.reset(
+          new tiledb::QueryCondition(condition->combine(qc, TILEDB_AND)));
+  }
+
+  if (condition != nullptr)
+    query->set_condition(*condition);
+}
+
+bool RecordFilter::evaluate(
+    const ReadQueryResults& results,
+    uint64_t cell_idx,
+    const bcf_hdr_t* hdr) const {
+  for (const auto& pred : predicates_) {
+    if (pred.pushed_down)
+      continue;
+
+    bool match;
+    if (pred.field == "qual")
+      match = evaluate_qual(pred, results, cell_idx);
+    else if (pred.field == "filters")
+      match = evaluate_filters(pred, results, cell_idx, hdr);
+    else
+      match = evaluate_info_fmt(pred, results, cell_idx);
+
+    if (!match)
+      return false;
+  }
+  return true;
+}
+
+template <typename T>
+bool RecordFilter::compare(Op op, T lhs, T rhs) {
+  switch (op) {
+    case Op::EQ:
+      return lhs == rhs;
+    case Op::NE:
+      return lhs != rhs;
+    case Op::LT:
+      return lhs < rhs;
+    case Op::LE:
+      return lhs <= rhs;
+    case Op::GT:
+      return lhs > rhs;
+    case Op::GE:
+      return lhs >= rhs;
+  }
+  return false;
+}
+
+bool RecordFilter::evaluate_qual(
+    const Predicate& pred, const ReadQueryResults& results, uint64_t i) {
+  const float qual = results.buffers()->qual().value<float>(i);
+  if (bcf_float_is_missing(qual))
+    return false;
+  return compare<float>(
+      pred.op, qual, static_cast<float>(pred.numeric_value));
+}
+
+bool RecordFilter::evaluate_filters(
+    const Predicate& pred,
+    const ReadQueryResults& results,
+    uint64_t i,
+    const bcf_hdr_t* hdr) {
+  if (hdr == nullptr)
+    throw std::runtime_error(
+        "Error evaluating filter expression; no header to look up FILTER "
+        "values.");
+
+  // The filters are stored as a count followed by the int32 filter IDs.
+  uint64_t nbytes = 0;
+  const char* data = results.var_attr_value(
+      results.buffers()->filter_ids(), results.filter_ids_size(), i, &nbytes);
+  const int* int_data = reinterpret_cast<const int*>(data);
+  const int num_filters = nbytes >= sizeof(int) ? *int_data : 0;
+
+  bool found = false;
+  for (int f = 0; f < num_filters && !found; f++) {
+    const char* name = bcf_hdr_int2id(hdr, BCF_DT_ID, int_data[f + 1]);
+    found = name != nullptr && pred.value == name;
+  }
+
+  return pred.op == Op::EQ ? found : !found;
+}
+
+bool RecordFilter::evaluate_info_fmt(
+    const Predicate& pred, const ReadQueryResults& results, uint64_t i) {
+  int type = 0;
+  int num_values = 0;
+  const char* values = nullptr;
+  if (!results.info_fmt_value(pred.field, i, &type, &num_values, &values))
+    return false;
+  return evaluate_values(pred, type, num_values, values);
+}
+
+bool RecordFilter::evaluate_values(
+    const Predicate& pred, int type, int num_values, const char* values) {
+  if (type == BCF_HT_STR) {
+    // Strings may hold several comma-separated values.
+    std::string str(values, num_values);
+    str.erase(str.find_last_not_of('\0') + 1);
+    bool found = false;
+    for (const auto& s : utils::split(str, ','))
+      found |= s == pred.value;
+    return pred.op == Op::EQ ? found : !found;
+  }
+
+  if (!pred.is_numeric)
+    return false;
+
+  for (int v = 0; v < num_values; v++) {
+    if (type == BCF_HT_REAL) {
+      const float value = reinterpret_cast<const float*>(values)[v];
+      if (bcf_float_is_missing(value) || bcf_float_is_vector_end(value))
+        continue;
+      if (compare<float>(
+              pred.op, value, static_cast<float>(pred.numeric_value)))
+        return true;
+    } else {
+      const int32_t value = reinterpret_cast<const int32_t*>(values)[v];
+      if (value == bcf_int32_missing || value == bcf_int32_vector_end)
+        continue;
+      if (compare<double>(pred.op, value, pred.numeric_value))
+        return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace vcf
+}  // namespace tiledb
@@ -0,0 +1,162 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TILEDB_VCF_RECORD_FILTER_H
+#define TILEDB_VCF_RECORD_FILTER_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <htslib/vcf.h>
+#include <tiledb/tiledb>
+
+#include "dataset/tiledbvcfdataset.h"
+#include "read/read_query_results.h"
+
+namespace tiledb {
+namespace vcf {
+
+/**
+ * Filter on record values, parsed from an expression such as
+ * `QUAL>30 && FILTER==PASS && info_AF<0.01`.
+ *
+ * An expression is a conjunction (`&&`) of predicates of the form
+ * `<field> <op> <value>`, where the field is `QUAL`, `FILTER`, `info_<key>` or
+ * `fmt_<key>` and the op is one of `==`, `!=`, `<`, `<=`, `>`, `>=`.
+ *
+ * - `FILTER` only supports `==` and `!=`. `FILTER==X` matches records with X
+ *   in their filter list.
+ * - A multi-valued info/fmt field matches if any of its values matches.
+ *   String values only support `==` and `!=`, and may be quoted with `"` or
+ *   `'` (a quoted value may contain `&&`).
+ * - A missing value never matches.
+ *
+ * Predicates on QUAL are pushed down to TileDB as a QueryCondition. The
+ * remaining predicates are evaluated on the query results.
+ */
+class RecordFilter {
+ public:
+  /** Comparison operator of a predicate. */
+  enum class Op { EQ, NE, LT, LE, GT, GE };
+
+  /** A single `<field> <op> <value>` predicate. */
+  struct Predicate {
+    /** Field name, as written in the expression. */
+    std::string field;
+
+    /** Comparison operator. */
+    Op op;
+
+    /** Value to compare with. */
+    std::string value;
+
+    /** Value as a number, if it is numeric. */
+    double numeric_value = 0;
+
+    /** True if the value is numeric. */
+    bool is_numeric = false;
+
+    /** True if the predicate is evaluated by TileDB. */
+    bool pushed_down = false;
+  };
+
+  /** Constructor. Throws if the expression cannot be parsed. */
+  explicit RecordFilter(const std::string& expression);
+
+  /** Returns the parsed predicates. */
+  const std::vector<Predicate>& predicates() const;
+
+  /** Returns true if a predicate is on the FILTER field. */
+  bool uses_filters() const;
+
+  /** Returns true if all predicates are pushed down to TileDB. */
+  bool all_pushed_down() const;
+
+  /**
+   * Returns the array attributes needed to evaluate the predicates that are
+   * not pushed down.
+   */
+  std::set<std::string> array_attributes_required(
+      const TileDBVCFDataset* dataset) const;
+
+  /**
+   * Pushes down the predicates that TileDB can evaluate, by setting a
+   * QueryCondition on the query. Those predicates are skipped by evaluate().
+   *
+   * @param ctx TileDB context
+   * @param query Query to set the condition on
+   */
+  void set_query_condition(const tiledb::Context& ctx, tiledb::Query* query);
+
+  /**
+   * Evaluates the predicates that are not pushed down on a result cell.
+   *
+   * @param results Query results
+   * @param cell_idx Index of the cell
+   * @param hdr Header of the cell's sample (only needed for FILTER)
+   * @return True if the cell satisfies all predicates
+   */
+  bool evaluate(
+      const ReadQueryResults& results,
+      uint64_t cell_idx,
+      const bcf_hdr_t* hdr) const;
+
+ private:
+  /** The parsed predicates. */
+  std::vector<Predicate> predicates_;
+
+  /** Parses a single predicate. */
+  static Predicate parse_predicate(const std::string& str);
+
+  /** Returns true if the comparison `lhs op rhs` holds. */
+  template <typename T>
+  static bool compare(Op op, T lhs, T rhs);
+
+  /** Evaluates a QUAL predicate. */
+  static bool evaluate_qual(
+      const Predicate& pred, const ReadQueryResults& results, uint64_t i);
+
+  /** Evaluates a FILTER predicate. */
+  static bool evaluate_filters(
+      const Predicate& pred,
+      const ReadQueryResults& results,
+      uint64_t i,
+      const bcf_hdr_t* hdr);
+
+  /** Evaluates an info_/fmt_ predicate. */
+  static bool evaluate_info_fmt(
+      const Predicate& pred, const ReadQueryResults& results, uint64_t i);
+
+  /** Evaluates a predicate on a typed BCF value list. */
+  static bool evaluate_values(
+      const Predicate& pred, int type, int num_values, const char* values);
+};
+
+}  // namespace vcf
+}  // namespace tiledb
+
+#endif  // TILEDB_VCF_RECORD_FILTER_H
@@ -0,0 +1,85 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "read/region_intersector.h"
+
+namespace tiledb {
+namespace vcf {
+
+RegionIntersector::RegionIntersector(const std::vector<uint32_t>& region_ends)
+    : max_end_(region_ends) {
+  for (size_t i = 1; i < max_end_.size(); i++) {
+    if (max_end_[i] < max_end_[i - 1]) {
+      max_end_[i] = max_end_[i - 1];
+      has_overlaps_ = true;
+    }
+  }
+}
+
+size_t RegionIntersector::first_intersecting(uint32_t real_start) {
+  const size_t n = max_end_.size();
+
+  if (real_start < last_real_start_) {
+    // Out-of-order lookup. The answer can be no further than the cursor.
+    cursor_ = std::lower_bound(
+                  max_end_.begin(), max_end_.begin() + cursor_, real_start) -
+              max_end_.begin();
+  } else {
+    // Gallop forward from the cursor: every index before the cursor has a
+    // running maximum below the previous (and therefore the current) start.
+    size_t lo = cursor_;
+    size_t step = 1;
+    while (lo + step < n && max_end_[lo + step] < real_start) {
+      lo += step;
+      step *= 2;
+    }
+    const size_t hi = std::min(lo + step, n);
+    cursor_ = std::lower_bound(
+                  max_end_.begin() + lo, max_end_.begin() + hi, real_start) -
+              max_end_.begin();
+  }
+
+  last_real_start_ = real_start;
+  return cursor_;
+}
+
+void RegionIntersector::reset_cursor() {
+  cursor_ = 0;
+  last_real_start_ = 0;
+}
+
+size_t RegionIntersector::size() const {
+  return max_end_.size();
+}
+
+bool RegionIntersector::has_overlaps() const {
+  return has_overlaps_;
+}
+
+}  // namespace vcf
+}  // namespace tiledb
@@ -0,0 +1,96 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TILEDB_VCF_REGION_INTERSECTOR_H
+#define TILEDB_VCF_REGION_INTERSECTOR_H
+
+#include <cstdint>
+#include <vector>
+
+namespace tiledb {
+namespace vcf {
+
+/**
+ * Finds the first region of a contig that can intersect a record, given the
+ * record's real start position.
+ *
+ * The intersector is built once per contig from the end positions of the
+ * contig's regions, in region (sorted by start) order. It stores a running
+ * maximum of the region ends, which is monotonic even when regions overlap,
+ * so the first candidate region is always the first index whose running
+ * maximum is >= real_start.
+ *
+ * A cursor remembers the result of the previous lookup. When lookups arrive in
+ * non-decreasing real_start order (e.g. sorted v4 results), the search gallops
+ * forward from the cursor, which is amortized O(1) per lookup. Out-of-order
+ * lookups fall back to a binary search.
+ */
+class RegionIntersector {
+ public:
+  /** Constructor. */
+  RegionIntersector() = default;
+
+  /**
+   * Constructor.
+   *
+   * @param region_ends End positions of the contig's regions, in region order.
+   */
+  explicit RegionIntersector(const std::vector<uint32_t>& region_ends);
+
+  /**
+   * Returns the index (relative to the contig's regions) of the first region
+   * that can intersect a record starting at real_start, or size() if no
+   * region can.
+   */
+  size_t first_intersecting(uint32_t real_start);
+
+  /** Resets the sweep cursor to the first region. */
+  void reset_cursor();
+
+  /** Returns the number of regions. */
+  size_t size() const;
+
+  /** Returns true if any two regions of the contig overlap. */
+  bool has_overlaps() const;
+
+ private:
+  /** Running maximum of the region end positions. */
+  std::vector<uint32_t> max_end_;
+
+  /** Result of the previous lookup. */
+  size_t cursor_ = 0;
+
+  /** real_start of the previous lookup. */
+  uint32_t last_real_start_ = 0;
+
+  /** True if region end positions are not monotonically increasing. */
+  bool has_overlaps_ = false;
+};
+
+}  // namespace vcf
+}  // namespace tiledb
+
+#endif  // TILEDB_VCF_REGION_INTERSECTOR_H
@@ -0,0 +1,137 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <htslib/vcf.h>
+
+#include "read/variant_stats.h"
+
+namespace tiledb {
+namespace vcf {
+
+VariantStats::VariantStats()
+    : last_contig_(0)
+    , variants_valid_(false) {
+}
+
+void VariantStats::add(
+    const std::string& contig,
+    uint32_t pos,
+    std::string_view alleles,
+    const int32_t* gt,
+    int num_gt) {
+  variants_valid_ = false;
+  auto& contig_variants = this->contig_variants(contig);
+
+  // The lookup key is reused to avoid an allocation per record.
+  key_.first = pos;
+  key_.second.assign(alleles.data(), alleles.size());
+  auto it = contig_variants.find(key_);
+  if (it == contig_variants.end()) {
+    Variant variant;
+    variant.contig = contig;
+    variant.pos = pos + 1;
+    variant.alleles = key_.second;
+    variant.allele_counts.resize(
+        1 + std::count(alleles.begin(), alleles.end(), ','));
+    it = contig_variants.emplace(key_, std::move(variant)).first;
+  }
+  Variant& variant = it->second;
+
+  bool called = num_gt > 0;
+  bool het = false;
+  int first_allele = -1;
+  for (int i = 0; i < num_gt; i++) {
+    if (gt[i] == bcf_int32_vector_end)
+      break;
+    if (bcf_gt_is_missing(gt[i])) {
+      called = false;
+      continue;
+    }
+
+    const int allele = bcf_gt_allele(gt[i]);
+    if (allele >= static_cast<int>(variant.allele_counts.size()))
+      throw std::runtime_error(
+          "Error computing variant stats; genotype allele " +
+          std::to_string(allele) + " out of range for alleles '" +
+          variant.alleles + "'.");
+    variant.allele_counts[allele]++;
+    variant.num_alleles_called++;
+
+    if (first_allele < 0)
+      first_allele = allele;
+    else if (allele != first_allele)
+      het = true;
+  }
+
+  if (!called || first_allele < 0) {
+    variant.num_missing++;
+    return;
+  }
+  variant.num_called++;
+  if (het)
+    variant.num_het++;
+  else if (first_allele > 0)
+    variant.num_hom_alt++;
+}
+
+void VariantStats::reset() {
+  contigs_.clear();
+  last_contig_ = 0;
+  variants_.clear();
+  variants_valid_ = false;
+}
+
+const std::vector<VariantStats::Variant>& VariantStats::variants() {
+  if (variants_valid_)
+    return variants_;
+
+  variants_.clear();
+  for (const auto& contig : contigs_) {
+    for (const auto& it : contig.second)
+      variants_.push_back(it.second);
+  }
+  variants_valid_ = true;
+  return variants_;
+}
+
+VariantStats::ContigVariants& VariantStats::contig_variants(
+    const std::string& contig) {
+  if (last_contig_ < contigs_.size() && contigs_[last_contig_].first == contig)
+    return contigs_[last_contig_].second;
+
+  for (last_contig_ = 0; last_contig_ < contigs_.size(); last_contig_++) {
+    if (contigs_[last_contig_].first == contig)
+      return contigs_[last_contig_].second;
+  }
+  contigs_.emplace_back(contig, ContigVariants());
+  return contigs_.back().second;
+}
+
+}  // namespace vcf
+}  // namespace tiledb
@@ -0,0 +1,136 @@
+/**
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2019-2021 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TILEDB_VCF_VARIANT_STATS_H
+#define TILEDB_VCF_VARIANT_STATS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tiledb {
+namespace vcf {
+
+/**
+ * Streaming group-by of the genotypes of a variant stats query over
+ * (contig, position, alleles), computing the allele counts and genotype
+ * classes of each variant across the samples.
+ *
+ * Allele counts follow the bcftools AC/AN semantics: every non-missing allele
+ * of a genotype is counted, including those of partially called genotypes.
+ * Genotype classes only consider fully called genotypes, the others count as
+ * missing.
+ */
+class VariantStats {
+ public:
+  /** The statistics of a variant. */
+  struct Variant {
+    /** Contig of the variant. */
+    std::string contig;
+
+    /** 1-based position of the variant. */
+    uint32_t pos = 0;
+
+    /** CSV list of the alleles, REF first. */
+    std::string alleles;
+
+    /** Number of called alleles, per allele index (REF first). */
+    std::vector<int32_t> allele_counts;
+
+    /** Total number of called alleles (AN). */
+    int32_t num_alleles_called = 0;
+
+    /** Number of samples with a fully called genotype. */
+    int32_t num_called = 0;
+
+    /** Number of called heterozygous genotypes. */
+    int32_t num_het = 0;
+
+    /** Number of called homozygous genotypes of an ALT allele. */
+    int32_t num_hom_alt = 0;
+
+    /** Number of samples with a missing or partially called genotype. */
+    int32_t num_missing = 0;
+  };
+
+  VariantStats();
+
+  /**
+   * Adds the genotype of a sample's record.
+   *
+   * @param contig Contig of the record
+   * @param pos 0-based start position of the record
+   * @param alleles CSV list of the alleles of the record, REF first
+   * @param gt BCF-encoded genotype values, or nullptr if the record has none
+   * @param num_gt Number of genotype values
+   */
+  void add(
+      const std::string& contig,
+      uint32_t pos,
+      std::string_view alleles,
+      const int32_t* gt,
+      int num_gt);
+
+  /** Clears all statistics. */
+  void reset();
+
+  /**
+   * Returns the statistics of all variants, ordered by contig (in the order
+   * they were first added), position and alleles.
+   */
+  const std::vector<Variant>& variants();
+
+ private:
+  /** Variants of a contig, keyed by (0-based position, alleles). */
+  typedef std::pair<uint32_t, std::string> VariantKey;
+  typedef std::map<VariantKey, Variant> ContigVariants;
+
+  /** The variants of each contig, in the order the contigs were added. */
+  std::vector<std::pair<std::string, ContigVariants>> contigs_;
+
+  /** Reusable lookup key. */
+  VariantKey key_;
+
+  /** Index in contigs_ of the contig of the last added record. */
+  size_t last_contig_;
+
+  /** The variants built by variants(). */
+  std::vector<Variant> variants_;
+
+  /** True if variants_ is up to date. */
+  bool variants_valid_;
+
+  /** Returns the variants of the given contig. */
+  ContigVariants& contig_variants(const std::string& contig);
+};
+
+}  // namespace vcf
+}  // namespace tiledb
+
+#endif  // TILEDB_VCF_VARIANT_STATS_H
@@ -25,6 +25,7 @@
  */
 
 #include <cstdlib>
+#include <cstring>
 
 #include "utils/buffer.h"
 
@@ -37,7 +38,9 @@ Buffer::Buffer()
     , data_alloced_size_(0)
     , data_size_(0)
     , data_effective_size_(0)
-    , offset_nelts_(0) {
+    , offset_nelts_(0)
+    , nullable_(false)
+    , value_size_(1) {
 }
 
 Buffer::~Buffer() {
@@ -59,6 +62,9 @@ Buffer::Buffer(const Buffer& other) {
     std::memcpy(data_, other.data_, other.data_size_);
   }
   offsets_.insert(offsets_.end(), other.offsets_.begin(), other.offsets_.end());
+  nullable_ = other.nullable_;
+  value_size_ = other.value_size_;
+  validity_ = other.validity_;
 }
 
 Buffer& Buffer::operator=(const Buffer& other) {
@@ -79,8 +85,11 @@ void Buffer::start_expecting() {
 void Buffer::stop_expecting() {
   if (expecting_) {
     offsets_.push_back(data_size_);
-    realloc(data_size_ + 1, false);
-    data_[data_size_++] = 0;
+    realloc(data_size_ + value_size_, false);
+    std::memset(data_ + data_size_, 0, value_size_);
+    data_size_ += value_size_;
+    if (nullable_)
+      validity_.push_back(0);
   }
 }
 
@@ -97,6 +106,7 @@ void Buffer::append(const void* data, size_t bytes) {
 
 void Buffer::clear() {
   offsets_.clear();
+  validity_.clear();
   data_size_ = 0;
   offset_nelts_ = 0;
   data_effective_size_ = 0;
@@ -130,6 +140,27 @@ const std::vector<uint64_t>& Buffer::offsets() const {
   return offsets_;
 }
 
+void Buffer::set_nullable(size_t value_size) {
+  nullable_ = true;
+  value_size_ = value_size;
+}
+
+bool Buffer::nullable() const {
+  return nullable_;
+}
+
+size_t Buffer::value_size() const {
+  return value_size_;
+}
+
+std::vector<uint8_t>& Buffer::validity() {
+  return validity_;
+}
+
+const std::vector<uint8_t>& Buffer::validity() const {
+  return validity_;
+}
+
 size_t Buffer::size() const {
   return data_size_;
 }
@@ -181,6 +212,9 @@ void Buffer::swap(Buffer& other) {
   std::swap(data_alloced_size_, other.data_alloced_size_);
   std::swap(data_size_, other.data_size_);
   offsets_.swap(other.offsets_);
+  std::swap(nullable_, other.nullable_);
+  std::swap(value_size_, other.value_size_);
+  validity_.swap(other.validity_);
 }
 
 std::string_view Buffer::value(uint64_t element_index) const {
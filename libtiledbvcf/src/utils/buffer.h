@@ -75,6 +75,21 @@ class Buffer {
 
   const std::vector<uint64_t>& offsets() const;
 
+  /**
+   * Makes the buffer nullable: a validity byte is kept per cell, and a cell
+   * finished without data holds a single zeroed value of `value_size` bytes.
+   */
+  void set_nullable(size_t value_size);
+
+  bool nullable() const;
+
+  /** Size in bytes of a single value of a nullable buffer. */
+  size_t value_size() const;
+
+  std::vector<uint8_t>& validity();
+
+  const std::vector<uint8_t>& validity() const;
+
   size_t size() const;
 
   size_t alloced_size() const;
@@ -151,6 +166,12 @@ class Buffer {
 
   std::vector<uint64_t> offsets_;
 
+  bool nullable_;
+
+  size_t value_size_;
+
+  std::vector<uint8_t> validity_;
+
   void realloc(uint64_t new_alloced_size, bool clear_new);
 };
 
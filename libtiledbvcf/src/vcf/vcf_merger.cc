@@ -26,16 +26,19 @@ VCFMerger::~VCFMerger() {
 
 void VCFMerger::init(
     const std::vector<std::pair<std::string, size_t>>& sorted_hdrs,
-    const std::unordered_map<uint32_t, SafeBCFHdr>& hdr_map) {
+    const std::unordered_map<uint32_t, SharedBCFHdr>& hdr_map) {
   hdr_.reset(bcf_hdr_init("w"));
   hdrs_.clear();
 
+  // Samples with identical headers share a header, which is merged once.
+  std::unordered_set<const bcf_hdr_t*> merged_hdrs;
   for (const auto& [name, hdr_key] : sorted_hdrs) {
     LOG_DEBUG("Adding sample_num {}: {}", hdrs_.size(), name);
     sample_map_[name] = hdrs_.size();
     auto hdr = hdr_map.at(hdr_key).get();
     hdrs_.push_back(hdr);
-    if (bcf_hdr_merge(hdr_.get(), hdr) == NULL) {
+    if (merged_hdrs.insert(hdr).second &&
+        bcf_hdr_merge(hdr_.get(), hdr) == NULL) {
       LOG_FATAL("Error merging header from sample: {}", name);
     }
     if (bcf_hdr_add_sample(hdr_.get(), name.c_str()) < 0) {
@@ -102,7 +102,7 @@ class VCFMerger {
 
   void init(
       const std::vector<std::pair<std::string, size_t>>& sorted_hdrs,
-      const std::unordered_map<uint32_t, SafeBCFHdr>& hdr_map);
+      const std::unordered_map<uint32_t, SharedBCFHdr>& hdr_map);
 
   void reset();
 
@@ -226,8 +226,8 @@ class VCFMerger {
   // combined VCF header
   SafeBCFHdr hdr_;
 
-  // vector of sample VCF headers, indexed by sample number
-  // TODO: update ReadState to use shared_ptrs
+  // vector of sample VCF headers, indexed by sample number. Samples with
+  // identical headers share the same instance, owned by the caller of init().
   std::vector<bcf_hdr_t*> hdrs_;
 
   // combined VCF record
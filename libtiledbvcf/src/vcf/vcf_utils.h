@@ -46,6 +46,12 @@ namespace vcf {
 /** Alias for unique_ptr to bcf_hdr_t. */
 typedef std::unique_ptr<bcf_hdr_t, decltype(&bcf_hdr_destroy)> SafeBCFHdr;
 
+/**
+ * Alias for shared_ptr to bcf_hdr_t. Used for headers parsed once and shared
+ * by all samples with an identical header.
+ */
+typedef std::shared_ptr<bcf_hdr_t> SharedBCFHdr;
+
 /** Alias for unique_ptr to bcf1_t. */
 typedef std::unique_ptr<bcf1_t, decltype(&bcf_destroy)> SafeBCFRec;
 
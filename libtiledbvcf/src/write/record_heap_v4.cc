@@ -3,7 +3,7 @@
  *
  * The MIT License
  *
- * @copyright Copyright (c) 2019 TileDB, Inc.
+ * @copyright Copyright (c) 2020 TileDB, Inc.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -24,19 +24,48 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <numeric>
+
 #include "write/record_heap_v4.h"
-#include "vcf/vcf_utils.h"
 
 namespace tiledb {
 namespace vcf {
 
+void RecordHeapV4::init(const std::vector<std::string>& sample_names) {
+  clear();
+
+  const uint32_t num_samples = sample_names.size();
+  sample_names_ = sample_names;
+
+  // Ties on (contig, start_pos) are broken by sample name.
+  std::vector<uint32_t> order(num_samples);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return sample_names_[a] < sample_names_[b];
+  });
+  heads_.assign(num_samples, Head{nullptr, 0, 0});
+  for (uint32_t i = 0; i < num_samples; i++)
+    heads_[order[i]].rank = i;
+
+  sample_nodes_.resize(num_samples);
+  tree_.assign(2 * num_samples, NO_SAMPLE);
+}
+
 void RecordHeapV4::clear() {
-  while (!heap_.empty())
-    heap_.pop();
+  for (auto& nodes : sample_nodes_) {
+    for (uint32_t idx : nodes) {
+      pool_[idx].record.reset();
+      free_nodes_.push_back(idx);
+    }
+    nodes.clear();
+  }
+  std::fill(tree_.begin(), tree_.end(), NO_SAMPLE);
+  size_ = 0;
 }
 
 bool RecordHeapV4::empty() const {
-  return heap_.empty();
+  return size_ == 0;
 }
 
 void RecordHeapV4::insert(
@@ -46,38 +75,124 @@ void RecordHeapV4::insert(
     const std::string& contig,
     uint32_t start_pos,
     uint32_t end_pos,
-    const std::string& sample_name) {
+    uint32_t sample) {
+  if (sample >= sample_names_.size())
+    throw std::runtime_error(
+        "Error inserting into ingestion heap; sample index " +
+        std::to_string(sample) + " is out of bounds.");
+
   // Sanity check start_pos is greater than the record start position.
   if (start_pos < (uint32_t)record->pos) {
-    HtslibValueMem val;
     std::string str_type = type == NodeType::Record ? "record" : "anchor";
     throw std::runtime_error(
         "Error inserting " + str_type + " '" + contig + ":" +
-        std::to_string(record->pos + 1) + "-" +
-        std::to_string(
-            VCFUtils::get_end_pos(vcf->hdr(), record.get(), &val) + 1) +
-        "' into ingestion heap from sample " + sample_name +
+        std::to_string(record->pos + 1) + "-" + std::to_string(end_pos + 1) +
+        "' into ingestion heap from sample " + sample_names_[sample] +
         "; sort start position " + std::to_string(start_pos + 1) +
         " cannot be less than start.");
   }
 
-  auto node = std::unique_ptr<Node>(new Node);
-  node->vcf = vcf;
-  node->type = type;
-  node->record = std::move(record);
-  node->contig = contig;
-  node->start_pos = start_pos;
-  node->end_pos = end_pos;
-  node->sample_name = sample_name;
-  heap_.push(std::move(node));
+  uint32_t idx;
+  if (free_nodes_.empty()) {
+    idx = pool_.size();
+    pool_.emplace_back();
+  } else {
+    idx = free_nodes_.back();
+    free_nodes_.pop_back();
+  }
+
+  Node& node = pool_[idx];
+  node.vcf = vcf;
+  node.type = type;
+  node.record = std::move(record);
+  node.contig = intern(contig);
+  node.start_pos = start_pos;
+  node.end_pos = end_pos;
+  node.sample = sample;
+  node.sample_name = &sample_names_[sample];
+
+  auto& nodes = sample_nodes_[sample];
+  nodes.push_back(idx);
+  std::push_heap(nodes.begin(), nodes.end(), [this](uint32_t a, uint32_t b) {
+    return less(pool_[b], pool_[a]);
+  });
+  size_++;
+
+  // The tournament only changes if the node is the sample's new smallest.
+  if (nodes.front() == idx)
+    update(sample);
 }
 
 const RecordHeapV4::Node& RecordHeapV4::top() const {
-  return *heap_.top();
+  return pool_[sample_nodes_[tree_[1]].front()];
 }
 
 void RecordHeapV4::pop() {
-  heap_.pop();
+  const uint32_t sample = tree_[1];
+  auto& nodes = sample_nodes_[sample];
+  std::pop_heap(nodes.begin(), nodes.end(), [this](uint32_t a, uint32_t b) {
+    return less(pool_[b], pool_[a]);
+  });
+  const uint32_t idx = nodes.back();
+  nodes.pop_back();
+
+  // Release the record now, so it can be returned to the VCF record pool.
+  pool_[idx].record.reset();
+  free_nodes_.push_back(idx);
+  size_--;
+
+  update(sample);
+}
+
+const std::string* RecordHeapV4::intern(const std::string& contig) {
+  // Records of a region are nearly always on the same contig.
+  if (last_contig_ != &contig &&
+      (last_contig_ == nullptr || *last_contig_ != contig))
+    last_contig_ = &*contigs_.insert(contig).first;
+  return last_contig_;
+}
+
+bool RecordHeapV4::less(const Node& a, const Node& b) const {
+  if (a.contig != b.contig) {
+    const int cmp = a.contig->compare(*b.contig);
+    if (cmp != 0)
+      return cmp < 0;
+  }
+  return a.start_pos < b.start_pos;
+}
+
+uint32_t RecordHeapV4::winner(uint32_t a, uint32_t b) const {
+  if (a == NO_SAMPLE)
+    return b;
+  if (b == NO_SAMPLE)
+    return a;
+
+  const Head& head_a = heads_[a];
+  const Head& head_b = heads_[b];
+  if (head_a.contig != head_b.contig) {
+    const int cmp = head_a.contig->compare(*head_b.contig);
+    if (cmp != 0)
+      return cmp < 0 ? a : b;
+  }
+  if (head_a.start_pos != head_b.start_pos)
+    return head_a.start_pos < head_b.start_pos ? a : b;
+  return head_a.rank < head_b.rank ? a : b;
+}
+
+void RecordHeapV4::update(uint32_t sample) {
+  const size_t num_samples = sample_names_.size();
+  size_t i = num_samples + sample;
+  const auto& nodes = sample_nodes_[sample];
+  if (nodes.empty()) {
+    tree_[i] = NO_SAMPLE;
+  } else {
+    const Node& node = pool_[nodes.front()];
+    heads_[sample].contig = node.contig;
+    heads_[sample].start_pos = node.start_pos;
+    tree_[i] = sample;
+  }
+  for (i >>= 1; i > 0; i >>= 1)
+    tree_[i] = winner(tree_[2 * i], tree_[2 * i + 1]);
 }
 
 }  // namespace vcf
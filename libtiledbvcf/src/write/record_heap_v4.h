@@ -28,13 +28,29 @@
 #define TILEDB_VCF_RECORD_HEAP_V4_H
 
 #include <htslib/vcf.h>
-#include <queue>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "vcf/vcf_v4.h"
 
 namespace tiledb {
 namespace vcf {
 
+/**
+ * Merges the records and anchors of a set of samples into the global order of
+ * the array: by contig, then start position, then sample name.
+ *
+ * Each sample keeps a small min-heap of its pending nodes (its next record
+ * plus the anchors of its records spanning anchor gaps), and a tournament
+ * tree over the samples selects the sample holding the smallest node, so a
+ * pop or insert only replays the path of one sample to the root. Nodes are
+ * pooled and contig names interned, so once warmed up the heap does not
+ * allocate or copy strings.
+ */
 class RecordHeapV4 {
  public:
   enum class NodeType { Record, Anchor };
@@ -43,20 +59,38 @@ class RecordHeapV4 {
         : vcf(nullptr)
         , type(NodeType::Record)
         , record(nullptr)
+        , contig(nullptr)
         , start_pos(std::numeric_limits<uint32_t>::max())
         , end_pos(std::numeric_limits<uint32_t>::max())
-        , sample_name() {
+        , sample(0)
+        , sample_name(nullptr) {
     }
 
     VCFV4* vcf;
     NodeType type;
     SafeSharedBCFRec record;
-    std::string contig;
+
+    /** Name of the record's contig, valid until the heap is destroyed. */
+    const std::string* contig;
+
     uint32_t start_pos;
+
+    /** End position of the record. */
     uint32_t end_pos;
-    std::string sample_name;
+
+    /** Index of the record's sample in the list passed to init(). */
+    uint32_t sample;
+
+    /** Name of the record's sample. */
+    const std::string* sample_name;
   };
 
+  /**
+   * Sets the samples whose nodes are merged and clears the heap. Samples are
+   * referred to by their index in the given list.
+   */
+  void init(const std::vector<std::string>& sample_names);
+
   void clear();
 
   bool empty() const;
@@ -68,39 +102,67 @@ class RecordHeapV4 {
       const std::string& contig,
       uint32_t start_pos,
       uint32_t end_pos,
-      const std::string& sample_name);
+      uint32_t sample);
 
   const Node& top() const;
 
   void pop();
 
  private:
+  /** Tournament tree entry of a sample without nodes. */
+  static constexpr uint32_t NO_SAMPLE = UINT32_MAX;
+
+  /** Names of the samples. */
+  std::vector<std::string> sample_names_;
+
+  /** Sort key of the smallest node of a sample. */
+  struct Head {
+    const std::string* contig;
+    uint32_t start_pos;
+    /** Position of the sample in the sample names' sorted order. */
+    uint32_t rank;
+  };
+
+  /** Sort key of the smallest node of each sample, kept by update(). */
+  std::vector<Head> heads_;
+
+  /** Min-heap of the indices in pool_ of the nodes of each sample. */
+  std::vector<std::vector<uint32_t>> sample_nodes_;
+
+  /** Node storage; a deque so references to nodes survive inserts. */
+  std::deque<Node> pool_;
+
+  /** Indices of the unused nodes of pool_. */
+  std::vector<uint32_t> free_nodes_;
+
   /**
-   * Performs a greater-than comparison on two RecordHeapV4 Node structs. This
-   * results in a min-heap sorted on start position first, breaking ties by
-   * sample ID.
+   * Tournament tree of the samples: the leaf of sample `s` is at index
+   * `n + s` (n being the number of samples) and holds `s`, or NO_SAMPLE if
+   * the sample has no nodes. Each inner node `i` holds the winner of its
+   * children `2i` and `2i + 1`, so index 1 holds the sample of the top node.
    */
-  struct NodeCompareGT {
-    bool operator()(
-        const std::unique_ptr<Node>& a, const std::unique_ptr<Node>& b) const {
-      auto a_start = a->start_pos, b_start = b->start_pos;
-      auto a_contig = a->contig, b_contig = b->contig;
-      return a_contig > b_contig ||
-             (a_contig == b_contig && a_start > b_start) ||
-             (a_contig == b_contig && a_start == b_start &&
-              a->sample_name > b->sample_name);
-    }
-  };
+  std::vector<uint32_t> tree_;
+
+  /** Number of nodes in the heap. */
+  size_t size_ = 0;
+
+  /** Interned contig names. */
+  std::unordered_set<std::string> contigs_;
+
+  /** Last interned contig name. */
+  const std::string* last_contig_ = nullptr;
+
+  /** Returns the interned copy of the given contig name. */
+  const std::string* intern(const std::string& contig);
+
+  /** Returns true if node a sorts before node b on (contig, start_pos). */
+  bool less(const Node& a, const Node& b) const;
 
-  /** A min-heap of BCF record structs, sorted on start pos. */
-  typedef std::priority_queue<
-      std::unique_ptr<Node>,
-      std::vector<std::unique_ptr<Node>>,
-      NodeCompareGT>
-      record_heap_t;
+  /** Returns the sample (or NO_SAMPLE) whose smallest node sorts first. */
+  uint32_t winner(uint32_t a, uint32_t b) const;
 
-  /** The heap. */
-  record_heap_t heap_;
+  /** Replays the tournament from the leaf of the given sample to the root. */
+  void update(uint32_t sample);
 };
 
 }  // namespace vcf
@@ -25,7 +25,10 @@
  */
 
 #include <sys/resource.h>
+#include <atomic>
+#include <condition_variable>
 #include <future>
+#include <mutex>
 
 #include "dataset/attribute_buffer_set.h"
 #include "dataset/tiledbvcfdataset.h"
@@ -40,6 +43,30 @@
 namespace tiledb {
 namespace vcf {
 
+namespace {
+
+/** A fragment written by ingest_samples_v4() from consecutive regions. */
+struct FragmentWriteV4 {
+  /** First and last contig of the regions of the fragment. */
+  std::string first_contig;
+  std::string last_contig;
+
+  /** Index of the next region to write. */
+  size_t next_task = 0;
+
+  /** Index past the last region of the fragment. */
+  size_t end_task = 0;
+
+  /** Global order write query, created with the first submitted records. */
+  std::unique_ptr<Query> query;
+
+  /** Guards next_task, signaled when a region has been written. */
+  std::mutex mtx;
+  std::condition_variable cv;
+};
+
+}  // namespace
+
 Writer::Writer() {
 }
 
@@ -154,6 +181,10 @@ void Writer::set_vcf_attributes(const std::string& vcf_uri) {
   creation_params_.vcf_uri = vcf_uri;
 }
 
+void Writer::set_typed_attributes(const std::string& attributes) {
+  creation_params_.typed_attributes = utils::split(attributes, ",");
+}
+
 void Writer::set_checksum_type(const int& checksum) {
   set_checksum_type((tiledb_filter_type_t)checksum);
 }
@@ -245,14 +276,12 @@ void Writer::update_params(IngestionParams& params) {
     LOG_INFO(
         "Using legacy option: --mem-budget-mb={}",
         params.max_tiledb_buffer_size_mb);
-    LOG_INFO("Output buffer flush = {} MiB", params.max_tiledb_buffer_size_mb);
-
   } else {
     params.max_tiledb_buffer_size_mb = params.ratio_output_flush *
                                        params.output_memory_budget_mb /
                                        params.num_threads;
     LOG_INFO(
-        "Output buffers = {} threads * {} MiB (flush = {} MiB)",
+        "Output buffers = {} threads * {} MiB (flush budget = {} MiB)",
         params.num_threads,
         output_mb / params.num_threads,
         params.max_tiledb_buffer_size_mb);
@@ -520,6 +549,7 @@ std::pair<uint64_t, uint64_t> Writer::ingest_samples(
     workers[i]->init(*dataset_, params, samples);
     workers[i]->set_max_total_buffer_size_mb(params.max_tiledb_buffer_size_mb);
   }
+  LOG_INFO("Output buffer flush = {} MiB", params.max_tiledb_buffer_size_mb);
 
   // First compose the set of contigs that are nonempty.
   // This can significantly speed things up in the common case that the sample
@@ -640,6 +670,13 @@ std::pair<uint64_t, uint64_t> Writer::ingest_samples_v4(
     LOG_FATAL("Cannot set contigs_to_allow_merging with contig_mode != all");
   }
 
+  // V4 workers fill one buffer set while the other is written, so each set
+  // gets half of the per thread output budget.
+  const uint32_t flush_mb = std::max(params.max_tiledb_buffer_size_mb / 2, 1u);
+  LOG_INFO(
+      "Output buffer flush = {} MiB per buffer set (2 buffer sets per thread)",
+      flush_mb);
+
   // TODO: workers can be reused across space tiles
   // TODO: use multiple threads for vcf open, currenly serial with num_threads *
   // samples.size() vcf open calls
@@ -648,7 +685,7 @@ std::pair<uint64_t, uint64_t> Writer::ingest_samples_v4(
     workers[i] = std::unique_ptr<WriterWorker>(new WriterWorkerV4(i));
 
     workers[i]->init(*dataset_, params, samples);
-    workers[i]->set_max_total_buffer_size_mb(params.max_tiledb_buffer_size_mb);
+    workers[i]->set_max_total_buffer_size_mb(flush_mb);
   }
 
   // First compose the set of contigs that are nonempty.
@@ -794,9 +831,8 @@ std::pair<uint64_t, uint64_t> Writer::ingest_samples_v4(
     return {0, 0};
 
   // Estimate the number of records that will fill the output buffer
-  float output_buffer_records = 1024.0 * 1024.0 *
-                                params.max_tiledb_buffer_size_mb /
-                                params.avg_vcf_record_size;
+  float output_buffer_records =
+      1024.0 * 1024.0 * flush_mb / params.avg_vcf_record_size;
 
   LOG_DEBUG("Output buffer records = {}", output_buffer_records);
   assert(output_buffer_records > 0 && output_buffer_records < UINT32_MAX);
@@ -912,175 +948,163 @@ std::pair<uint64_t, uint64_t> Writer::ingest_samples_v4(
   // list specific to this batch
   dataset_->write_vcf_headers_v4(*ctx_, sample_headers);
 
-  const size_t nregions = regions.size();
-  size_t region_idx = 0;
-  std::vector<std::future<bool>> tasks;
-  for (unsigned i = 0; i < workers.size(); i++) {
-    WriterWorker* worker = workers[i].get();
-    while (region_idx < nregions) {
-      Region reg = regions[region_idx++];
-      if (nonempty_contigs.count(reg.seq_name) > 0) {
-        TRY_CATCH_THROW(
-            tasks.push_back(std::async(std::launch::async, [worker, reg]() {
-              return worker->parse(reg);
-            })));
-        break;
+  // Split the regions to ingest into fragments. Consecutive regions are
+  // written to the same fragment unless the contigs they end and start on
+  // cannot be merged.
+  std::vector<Region> tasks;
+  std::vector<std::unique_ptr<FragmentWriteV4>> fragments;
+  std::vector<size_t> task_fragments;
+  int last_merged_fragment_index = 0;
+  for (const auto& reg : regions) {
+    if (nonempty_contigs.count(reg.seq_name) == 0)
+      continue;
+
+    bool new_fragment = fragments.empty();
+    if (!new_fragment) {
+      const std::string& last_contig = fragments.back()->last_contig;
+      // If ingesting merged contigs only, finalize on fragment boundaries
+      bool finalize_merged_fragment = false;
+      if (ingestion_params_.contig_mode ==
+          IngestionParams::ContigMode::MERGED) {
+        int merged_fragment_index = get_merged_fragment_index(reg.seq_name);
+        finalize_merged_fragment =
+            merged_fragment_index != last_merged_fragment_index;
+        last_merged_fragment_index = merged_fragment_index;
       }
+      new_fragment = last_contig != reg.seq_name &&
+                     (!check_contig_mergeable(last_contig) ||
+                      !check_contig_mergeable(reg.seq_name) ||
+                      finalize_merged_fragment);
+    } else if (
+        ingestion_params_.contig_mode == IngestionParams::ContigMode::MERGED) {
+      last_merged_fragment_index = get_merged_fragment_index(reg.seq_name);
     }
-  }
-
-  int last_merged_fragment_index = 0;
-  std::string last_region_contig = workers[0]->region().seq_name;
-  std::string starting_region_contig_for_merge = workers[0]->region().seq_name;
-  bool finished = tasks.empty();
-  while (!finished) {
-    finished = true;
-
-    auto start = std::chrono::steady_clock::now();
-    size_t prev_records = records_ingested;
-    for (unsigned i = 0; i < tasks.size(); i++) {
-      if (!tasks[i].valid())
-        continue;
 
-      WriterWorker* worker = workers[i].get();
-      bool task_complete = false;
-      while (!task_complete) {
-        TRY_CATCH_THROW(task_complete = tasks[i].get());
+    if (new_fragment) {
+      fragments.emplace_back(new FragmentWriteV4());
+      fragments.back()->first_contig = reg.seq_name;
+      fragments.back()->next_task = tasks.size();
+    }
+    fragments.back()->last_contig = reg.seq_name;
+    fragments.back()->end_task = tasks.size() + 1;
+    task_fragments.push_back(fragments.size() - 1);
+    tasks.push_back(reg);
+  }
 
-        // Write worker buffers, if any data.
-        if (worker->records_buffered() > 0) {
-          const std::string& contig = worker->region().seq_name;
-          // Check if finished contig is allowed to be merged
-          const bool contig_mergeable = check_contig_mergeable(contig);
-          const bool last_contig_mergeable =
-              check_contig_mergeable(last_region_contig);
-          bool finalize_merged_fragment = false;
-
-          // If ingesting merged contigs only, finalize on fragment boundaries
-          if (ingestion_params_.contig_mode ==
-              IngestionParams::ContigMode::MERGED) {
-            int merged_fragment_index = get_merged_fragment_index(contig);
-            finalize_merged_fragment =
-                merged_fragment_index != last_merged_fragment_index;
-            last_merged_fragment_index = merged_fragment_index;
-          }
-          //  If the contig is different the last one we wrote, and we aren't
-          //  suppose to merge this new one, then finalize the previous one
-          if (last_region_contig != contig) {
-            if (!last_contig_mergeable || !contig_mergeable ||
-                finalize_merged_fragment) {
-              if (!last_contig_mergeable) {
-                LOG_DEBUG(
-                    "Previous contig {} found to NOT be mergeable, "
-                    "finalizing previous fragment and starting new write for "
-                    "{}",
-                    last_region_contig,
-                    contig);
-              } else if (!contig_mergeable) {
-                LOG_DEBUG(
-                    "Contig {0} found to NOT be mergeable, "
-                    "finalizing previous fragment and starting new write for "
-                    "{0}",
-                    contig);
-              } else if (finalize_merged_fragment) {
-                LOG_DEBUG(
-                    "Previous contig {} found to be end of mergeable fragment, "
-                    "finalizing previous fragment and starting new write for "
-                    "{}",
-                    last_region_contig,
-                    contig);
-              }
-              // If the contig is different the last one we wrote, and we aren't
-              // suppose to merge this new one, then finalize the previous one
-              LOG_INFO(
-                  "Finalizing contig batch [{}, {}]",
-                  starting_region_contig_for_merge,
-                  last_region_contig);
-
-              // Finalize fragment for this contig async
-              // it is okay to move the query because we reset it next.
-              TRY_CATCH_THROW(finalize_tasks_.emplace_back(std::async(
-                  std::launch::async, finalize_query, std::move(query_))));
-
-              // Start new query for new fragment for next contig
-              query_.reset(new Query(*ctx_, *array_));
-              query_->set_layout(TILEDB_GLOBAL_ORDER);
-
-              // Set new contig
-              last_region_contig = contig;
-              starting_region_contig_for_merge = contig;
-            } else {
-              LOG_DEBUG(
-                  "last contig {} and contig {} found to be mergeable, "
-                  "combining into super fragment",
-                  last_region_contig,
-                  contig);
-              // Set the last contig to the current one if we are merging
-              last_region_contig = contig;
+  // Each worker repeatedly takes the next region and parses it. Fragments are
+  // written concurrently, each by its own global order query, while the
+  // regions of a fragment are submitted in order: a worker done parsing a
+  // region waits for the previous regions of its fragment to be written.
+  std::atomic<size_t> next_task(0);
+  std::atomic<bool> failed(false);
+  std::atomic<uint64_t> records_written(0), anchors_written(0);
+  std::mutex finalize_mtx;
+  auto ingest_tasks = [&](WriterWorker* worker) {
+    try {
+      for (size_t t = next_task++; t < tasks.size() && !failed;
+           t = next_task++) {
+        FragmentWriteV4& fragment = *fragments[task_fragments[t]];
+        bool task_complete = worker->parse(tasks[t]);
+
+        std::unique_lock<std::mutex> lock(fragment.mtx);
+        fragment.cv.wait(
+            lock, [&]() { return fragment.next_task == t || failed; });
+        if (failed)
+          return;
+        lock.unlock();
+
+        // Repeatedly resume the worker where it left off until it is able to
+        // complete the region. The worker double buffers its output, so it
+        // resumes parsing into its other buffers while the full ones are
+        // written, and only waits for the write once both are full.
+        std::future<void> write;
+        while (true) {
+          if (worker->records_buffered() > 0) {
+            if (fragment.query == nullptr) {
+              fragment.query.reset(new Query(*ctx_, *array_));
+              fragment.query->set_layout(TILEDB_GLOBAL_ORDER);
             }
+            Query* query = fragment.query.get();
+            const AttributeBufferSet* buffers = &worker->buffers();
+            const auto version = dataset_->metadata().version;
+            write = std::async(std::launch::async, [query, buffers, version]() {
+              buffers->set_buffers(query, version);
+              auto st = query->submit();
+              if (st != Query::Status::COMPLETE)
+                throw std::runtime_error(
+                    "Error submitting TileDB write query; unexpected query "
+                    "status.");
+            });
+            LOG_DEBUG(
+                "Recording {:L} cells for contig {} (task {} / {})",
+                worker->records_buffered(),
+                worker->region().seq_name,
+                t + 1,
+                tasks.size());
+          } else {
+            LOG_DEBUG("No records found for {}", worker->region().seq_name);
           }
-
-          worker->buffers().set_buffers(
-              query_.get(), dataset_->metadata().version);
-          auto st = query_->submit();
-          if (st != Query::Status::COMPLETE)
-            throw std::runtime_error(
-                "Error submitting TileDB write query; unexpected query "
-                "status.");
-          LOG_DEBUG(
-              "Recorded {:L} cells for contig {} (task {} / {})",
-              worker->records_buffered(),
-              contig,
-              i + 1,
-              tasks.size());
-        } else {
-          LOG_DEBUG("No records found for {}", worker->region().seq_name);
+          records_written += worker->records_buffered();
+          anchors_written += worker->anchors_buffered();
+
+          if (task_complete)
+            break;
+          LOG_DEBUG("Work for {} not complete, resuming", t);
+          task_complete = worker->resume();
+          if (write.valid())
+            write.get();
         }
-        records_ingested += worker->records_buffered();
-        anchors_ingested += worker->anchors_buffered();
+        if (write.valid())
+          write.get();
 
-        // Repeatedly resume the same worker where it left off until it
-        // is able to complete.
-        if (!task_complete) {
-          TRY_CATCH_THROW(tasks[i] = std::async(std::launch::async, [worker]() {
-                            return worker->resume();
-                          }));
-          LOG_DEBUG("Work for {} not complete, resuming", i);
+        lock.lock();
+        fragment.next_task = t + 1;
+        if (fragment.next_task == fragment.end_task &&
+            fragment.query != nullptr) {
+          LOG_INFO(
+              "Finalizing contig batch [{}, {}]",
+              fragment.first_contig,
+              fragment.last_contig);
+          // Finalize fragment for this contig async
+          std::lock_guard<std::mutex> finalize_lock(finalize_mtx);
+          finalize_tasks_.emplace_back(std::async(
+              std::launch::async,
+              finalize_query,
+              std::move(fragment.query)));
         }
+        lock.unlock();
+        fragment.cv.notify_all();
       }
-
-      // Start next region parsing using the same worker.
-      while (region_idx < nregions) {
-        Region reg = regions[region_idx++];
-        if (nonempty_contigs.count(reg.seq_name) > 0) {
-          TRY_CATCH_THROW(
-              tasks[i] = std::async(std::launch::async, [worker, reg]() {
-                return worker->parse(reg);
-              }));
-          finished = false;
-          break;
-        }
+    } catch (...) {
+      // Wake up the workers waiting on a region that will not be written.
+      failed = true;
+      for (auto& fragment : fragments) {
+        std::lock_guard<std::mutex> lock(fragment->mtx);
+        fragment->cv.notify_all();
       }
+      throw;
     }
-    if (records_ingested > prev_records) {
-      LOG_INFO(
-          "Ingestion rate = {:.3f} records/sec",
-          (records_ingested - prev_records) / utils::chrono_duration(start));
-    }
-  }
-
-  LOG_DEBUG(
-      "Finalizing last contig batch of [{}, {}]",
-      starting_region_contig_for_merge,
-      last_region_contig);
+  };
 
-  // Finalize fragment for this contig
-  TRY_CATCH_THROW(finalize_tasks_.emplace_back(
-      std::async(std::launch::async, finalize_query, std::move(query_))));
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::future<void>> worker_tasks;
+  for (size_t i = 0; i < workers.size() && i < tasks.size(); i++) {
+    WriterWorker* worker = workers[i].get();
+    TRY_CATCH_THROW(worker_tasks.push_back(std::async(
+        std::launch::async, [&ingest_tasks, worker]() {
+          ingest_tasks(worker);
+        })));
+  }
+  for (auto& worker_task : worker_tasks)
+    TRY_CATCH_THROW(worker_task.get());
 
-  // Start new query for new fragment for next contig
-  query_.reset(new Query(*ctx_, *array_));
-  query_->set_layout(TILEDB_GLOBAL_ORDER);
+  records_ingested = records_written;
+  anchors_ingested = anchors_written;
+  if (records_ingested > 0) {
+    LOG_INFO(
+        "Ingestion rate = {:.3f} records/sec",
+        records_ingested / utils::chrono_duration(start));
+  }
 
   return {records_ingested, anchors_ingested};
 }
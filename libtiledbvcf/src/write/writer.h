@@ -235,6 +235,15 @@ class Writer {
    */
   void set_vcf_attributes(const std::string& vcf_uri);
 
+  /**
+   * Sets the extracted info/fmt fields that should be stored as natively
+   * typed attributes, using the field types of the VCF file set with
+   * set_vcf_attributes().
+   *
+   * @param attributes CSV string of typed attributes
+   */
+  void set_typed_attributes(const std::string& attributes);
+
   /**
    * Sets the checksum type for filter on new dataset arrays
    *
@@ -301,7 +310,10 @@ class Writer {
   /** Set the max length of an ingestion task. */
   void set_thread_task_size(const unsigned size);
 
-  /** Set the max size of TileDB buffers before flushing. Defaults to 1GB. */
+  /**
+   * Set the max size of TileDB buffers per thread before flushing. Defaults
+   * to 1GB. V4 workers split it across two buffer sets.
+   */
   void set_memory_budget(const unsigned mb);
 
   /** Set ingestion scatch space for ingestion or registration */
@@ -430,7 +442,9 @@ class Writer {
       std::vector<Region>& regions);
 
   /**
-   * Ingests a batch of samples.
+   * Ingests a batch of samples. The workers parse the regions in parallel
+   * and write them as soon as they are parsed; the fragments of contigs that
+   * cannot be merged are written concurrently, each by its own query.
    *
    * @param params Ingestion parameters
    * @param samples List of samples to ingest with this call
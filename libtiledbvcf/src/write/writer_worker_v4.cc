@@ -24,17 +24,242 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include "write/writer_worker_v4.h"
 #include "utils/logger_public.h"
 
 namespace tiledb {
 namespace vcf {
 
+namespace {
+
+/** Returns the bytes of a buffer, as counted by AttributeBufferSet. */
+uint64_t buffer_bytes(const Buffer& buff) {
+  return buff.size() + buff.offsets().size() * sizeof(uint64_t) +
+         buff.validity().size();
+}
+
+/**
+ * True if BCF values, which are little-endian, can be read in place. The
+ * decoders below defer to htslib otherwise.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr bool raw_bcf_values = false;
+#else
+constexpr bool raw_bcf_values = true;
+#endif
+
+/** Returns the values of `val`, with room for at least `n` int32 values. */
+int32_t* int32_values(HtslibValueMem* val, int n) {
+  val->ndst = HtslibValueMem::convert_ndst_for_type(
+      val->ndst, BCF_HT_INT, &val->type_for_ndst);
+  if (val->ndst < n) {
+    void* dst = std::realloc(val->dst, n * sizeof(int32_t));
+    if (dst == nullptr)
+      throw std::bad_alloc();
+    val->dst = dst;
+    val->ndst = n;
+  }
+  return static_cast<int32_t*>(val->dst);
+}
+
+/**
+ * Returns the number of `n` encoded values of type T before the first
+ * vector end value.
+ */
+template <typename T>
+int count_to_vector_end(const uint8_t* p, int n, T vector_end) {
+  for (int i = 0; i < n; i++) {
+    T v;
+    std::memcpy(&v, p + i * sizeof(T), sizeof(T));
+    if (v == vector_end)
+      return i;
+  }
+  return n;
+}
+
+/** Returns the number of encoded floats before the first vector end value. */
+int count_floats_to_vector_end(const uint8_t* p, int n) {
+  return count_to_vector_end<uint32_t>(p, n, bcf_float_vector_end);
+}
+
+/**
+ * Widens `n` encoded integers of type T to int32 in `out` as htslib does.
+ * Values after a vector end value are set to vector end if `pad` is true and
+ * dropped otherwise. Returns the number of values written.
+ */
+template <typename T>
+int widen_ints(
+    const uint8_t* p,
+    int n,
+    T missing,
+    T vector_end,
+    bool pad,
+    int32_t* out) {
+  for (int i = 0; i < n; i++) {
+    T v;
+    std::memcpy(&v, p + i * sizeof(T), sizeof(T));
+    if (v == vector_end) {
+      if (!pad)
+        return i;
+      for (; i < n; i++)
+        out[i] = bcf_int32_vector_end;
+      return n;
+    }
+    out[i] = v == missing ? bcf_int32_missing : v;
+  }
+  return n;
+}
+
+/**
+ * Decodes the values of an unpacked INFO field of BCF_HT_ type `type` from
+ * the record's BCF encoding, with the results of bcf_get_info_values().
+ * Values needing no conversion are left in place in the record; `*values`
+ * points to them, to a copy in `val`, or is null for a flag.
+ *
+ * @return The number of values, or -1 if the encoding is not handled here.
+ */
+int decode_info_values(
+    const bcf_info_t* info,
+    int type,
+    HtslibValueMem* val,
+    const void** values) {
+  if (!raw_bcf_values || info->vptr == nullptr)
+    return -1;
+
+  const uint8_t* p = info->vptr;
+  switch (type) {
+    case BCF_HT_FLAG:
+      *values = nullptr;
+      return 1;
+    case BCF_HT_STR:
+      if (info->type != BCF_BT_CHAR)
+        return -1;
+      *values = p;
+      return info->len;
+    case BCF_HT_REAL:
+      if (info->type != BCF_BT_FLOAT)
+        return -1;
+      *values = p;
+      return count_floats_to_vector_end(p, info->len);
+    case BCF_HT_INT:
+      switch (info->type) {
+        case BCF_BT_INT8: {
+          int32_t* out = int32_values(val, info->len);
+          *values = out;
+          return widen_ints<int8_t>(
+              p,
+              info->len,
+              bcf_int8_missing,
+              bcf_int8_vector_end,
+              false,
+              out);
+        }
+        case BCF_BT_INT16: {
+          int32_t* out = int32_values(val, info->len);
+          *values = out;
+          return widen_ints<int16_t>(
+              p,
+              info->len,
+              bcf_int16_missing,
+              bcf_int16_vector_end,
+              false,
+              out);
+        }
+        case BCF_BT_INT32:
+          *values = p;
+          return count_to_vector_end<int32_t>(
+              p, info->len, bcf_int32_vector_end);
+        default:
+          return -1;
+      }
+    default:
+      return -1;
+  }
+}
+
+/**
+ * Decodes the values of an unpacked FMT field of BCF_HT_ type `type` (int for
+ * GT) from the record's BCF encoding, with the results of
+ * bcf_get_format_values(). Values needing no conversion are left in place in
+ * the record; `*values` points to them or to a copy in `val`.
+ *
+ * @return The number of values, or -1 if the encoding is not handled here.
+ */
+int decode_fmt_values(
+    const bcf_fmt_t* fmt,
+    int num_samples,
+    int type,
+    HtslibValueMem* val,
+    const void** values) {
+  if (!raw_bcf_values || fmt->p == nullptr)
+    return -1;
+
+  // The values of the samples are contiguous, each padded to `fmt->n` values
+  // with vector end values, which is how htslib returns them.
+  const int num_vals = fmt->n * num_samples;
+  const uint8_t* p = fmt->p;
+  switch (type) {
+    case BCF_HT_STR:
+      if (fmt->type != BCF_BT_CHAR)
+        return -1;
+      *values = p;
+      return num_vals;
+    case BCF_HT_REAL:
+      if (fmt->type != BCF_BT_FLOAT)
+        return -1;
+      *values = p;
+      return num_vals;
+    case BCF_HT_INT:
+      switch (fmt->type) {
+        case BCF_BT_INT8: {
+          int32_t* out = int32_values(val, num_vals);
+          for (int i = 0; i < num_samples; i++)
+            widen_ints<int8_t>(
+                p + i * fmt->size,
+                fmt->n,
+                bcf_int8_missing,
+                bcf_int8_vector_end,
+                true,
+                out + i * fmt->n);
+          *values = out;
+          return num_vals;
+        }
+        case BCF_BT_INT16: {
+          int32_t* out = int32_values(val, num_vals);
+          for (int i = 0; i < num_samples; i++)
+            widen_ints<int16_t>(
+                p + i * fmt->size,
+                fmt->n,
+                bcf_int16_missing,
+                bcf_int16_vector_end,
+                true,
+                out + i * fmt->n);
+          *values = out;
+          return num_vals;
+        }
+        case BCF_BT_INT32:
+          *values = p;
+          return num_vals;
+        default:
+          return -1;
+      }
+    default:
+      return -1;
+  }
+}
+
+}  // namespace
+
 WriterWorkerV4::WriterWorkerV4(int id)
     : id_(id)
+    , active_(0)
     , dataset_(nullptr)
     , records_buffered_(0)
-    , anchors_buffered_(0) {
+    , anchors_buffered_(0)
+    , bytes_buffered_(0) {
 }
 
 void WriterWorkerV4::init(
@@ -50,12 +275,93 @@ void WriterWorkerV4::init(
     vcfs_.push_back(std::move(vcf));
   }
 
-  for (const auto& attr : dataset.metadata().extra_attributes)
-    buffers_.extra_attrs()[attr] = Buffer();
+  std::vector<std::string> sample_names;
+  for (const auto& vcf : vcfs_)
+    sample_names.push_back(vcf->sample_name());
+  record_heap_.init(sample_names);
+
+  extra_attrs_ = dataset.metadata().extra_attributes;
+  extra_attr_types_.clear();
+  for (unsigned i = 0; i < 2; i++)
+    extra_attr_buffers_[i].clear();
+  for (const auto& attr : extra_attrs_) {
+    tiledb_datatype_t datatype;
+    const bool typed = dataset.is_attribute_typed(attr, &datatype);
+    for (unsigned i = 0; i < 2; i++) {
+      Buffer& buff = buffer_sets_[i].extra_attrs()[attr];
+      buff = Buffer();
+      if (typed)
+        buff.set_nullable(tiledb_datatype_size(datatype));
+      extra_attr_buffers_[i].push_back(&buff);
+    }
+    if (!typed)
+      extra_attr_types_.push_back(-1);
+    else
+      extra_attr_types_.push_back(
+          datatype == TILEDB_FLOAT32 ? BCF_HT_REAL : BCF_HT_INT);
+  }
+
+  // Plan the fields of each header.
+  field_plans_.assign(vcfs_.size(), {});
+  for (uint32_t sample = 0; sample < vcfs_.size(); sample++) {
+    const bcf_hdr_t* hdr = vcfs_[sample]->hdr();
+    for (int id = 0; id < hdr->n[BCF_DT_ID]; id++)
+      plan_field(sample, id);
+  }
+}
+
+const WriterWorkerV4::FieldPlan& WriterWorkerV4::field_plan(
+    uint32_t sample, int id, int hl_type) {
+  auto& plans = field_plans_[sample];
+  if (static_cast<size_t>(id) >= plans.size() ||
+      (hl_type == BCF_HL_INFO ? plans[id].info_type : plans[id].fmt_type) < 0)
+    plan_field(sample, id);
+  return plans[id];
+}
+
+void WriterWorkerV4::plan_field(uint32_t sample, int id) {
+  const bcf_hdr_t* hdr = vcfs_[sample]->hdr();
+  if (id < 0 || id >= hdr->n[BCF_DT_ID])
+    throw std::runtime_error(
+        "Error planning record fields; ID " + std::to_string(id) +
+        " is not in the header of sample " + vcfs_[sample]->sample_name());
+
+  auto& plans = field_plans_[sample];
+  if (static_cast<size_t>(id) >= plans.size())
+    plans.resize(id + 1);
+
+  FieldPlan& plan = plans[id];
+  plan = FieldPlan();
+  plan.key = hdr->id[BCF_DT_ID][id].key;
+  if (plan.key == nullptr || hdr->id[BCF_DT_ID][id].val == nullptr)
+    return;
+
+  auto find_attr = [this](const std::string& attr) {
+    auto it = std::find(extra_attrs_.begin(), extra_attrs_.end(), attr);
+    if (it == extra_attrs_.end())
+      return FIELD_BLOB;
+    return static_cast<int>(it - extra_attrs_.begin());
+  };
+
+  if (bcf_hdr_idinfo_exists(hdr, BCF_HL_INFO, id)) {
+    plan.info_type = bcf_hdr_id2type(hdr, BCF_HL_INFO, id);
+    // No need to store END.
+    plan.info_attr = std::strcmp("END", plan.key) == 0 ?
+                         FIELD_SKIP :
+                         find_attr(std::string("info_") + plan.key);
+  }
+
+  if (bcf_hdr_idinfo_exists(hdr, BCF_HL_FMT, id)) {
+    // Header says GT is str, but it's encoded as an int (index into alleles)
+    plan.fmt_type = std::strcmp("GT", plan.key) == 0 ?
+                        BCF_HT_INT :
+                        bcf_hdr_id2type(hdr, BCF_HL_FMT, id);
+    plan.fmt_attr = find_attr(std::string("fmt_") + plan.key);
+  }
 }
 
 const AttributeBufferSet& WriterWorkerV4::buffers() const {
-  return buffers_;
+  return buffer_sets_[active_];
 }
 
 uint64_t WriterWorkerV4::records_buffered() const {
@@ -70,7 +376,7 @@ void WriterWorkerV4::insert_record(
     const SafeSharedBCFRec& record,
     VCFV4* vcf,
     const std::string& contig,
-    const std::string& sample_name) {
+    uint32_t sample) {
   // If a record starts outside the region max, skip it.
   const uint32_t start_pos = record->pos;
   if (start_pos > region_.max)
@@ -85,7 +391,7 @@ void WriterWorkerV4::insert_record(
       contig,
       start_pos,
       end_pos,
-      sample_name);
+      sample);
 }
 
 bool WriterWorkerV4::parse(const Region& region) {
@@ -96,7 +402,9 @@ bool WriterWorkerV4::parse(const Region& region) {
   region_ = region;
 
   // Initialize the record heap with the first record from each sample.
-  for (auto& vcf : vcfs_) {
+  for (uint32_t sample = 0; sample < vcfs_.size(); sample++) {
+    VCFV4* vcf = vcfs_[sample].get();
+
     // If seek returns false there is no records for this contig
     if (!vcf->seek(region.seq_name, region.min))
       continue;
@@ -108,7 +416,7 @@ bool WriterWorkerV4::parse(const Region& region) {
     }
     vcf->pop_record();
 
-    insert_record(r, vcf.get(), region.seq_name, vcf->sample_name());
+    insert_record(r, vcf, region.seq_name, sample);
   }
 
   // Start buffering records (which can possibly be incomplete if the buffers
@@ -117,9 +425,14 @@ bool WriterWorkerV4::parse(const Region& region) {
 }
 
 bool WriterWorkerV4::resume() {
-  buffers_.clear();
+  // Fill the other buffer set, so that the buffers of the previous call can
+  // be written meanwhile.
+  active_ ^= 1;
+  AttributeBufferSet& buffers = buffer_sets_[active_];
+  buffers.clear();
   records_buffered_ = 0;
   anchors_buffered_ = 0;
+  bytes_buffered_ = 0;
 
   const auto& metadata = dataset_->metadata();
 
@@ -141,18 +454,15 @@ bool WriterWorkerV4::resume() {
   //        on the heap.
   // 3. Repeat step (1) until the heap is empty.
   while (!record_heap_.empty()) {
-    RecordHeapV4::Node& top =
-        const_cast<RecordHeapV4::Node&>(record_heap_.top());
-    const std::string sample_name = top.sample_name;
+    const RecordHeapV4::Node& top = record_heap_.top();
+    const uint32_t sample = top.sample;
     VCFV4* vcf = top.vcf;
 
     // If the top record is inside the region, copy the record into the buffers.
     // If the record caused the buffers to exceed the max memory allocation,
     // we'll stop processing at this record.
     bool overflowed = false;
-    const uint32_t local_end_pos =
-        VCFUtils::get_end_pos(vcf->hdr(), top.record.get(), &val_);
-    if (local_end_pos <= region_.max) {
+    if (top.end_pos <= region_.max) {
       overflowed = !buffer_record(top);
     }
 
@@ -176,7 +486,7 @@ bool WriterWorkerV4::resume() {
         if (next_r != nullptr) {
           vcf->pop_record();
           insert_record(
-              next_r, vcf, vcf->contig_name(next_r.get()), sample_name);
+              next_r, vcf, vcf->contig_name(next_r.get()), sample);
         }
       }
     } else {
@@ -186,10 +496,10 @@ bool WriterWorkerV4::resume() {
           vcf,
           RecordHeapV4::NodeType::Anchor,
           top.record,
-          top.contig,
+          *top.contig,
           anchor_start,
           top.end_pos,
-          sample_name);
+          sample);
 
       // We're done with the top node. Remove it from the heap.
       record_heap_.pop();
@@ -202,7 +512,7 @@ bool WriterWorkerV4::resume() {
             static_cast<uint32_t>(next_r->pos) < anchor_start) {
           vcf->pop_record();
           insert_record(
-              next_r, vcf, vcf->contig_name(next_r.get()), sample_name);
+              next_r, vcf, vcf->contig_name(next_r.get()), sample);
         }
       }
     }
@@ -211,7 +521,7 @@ bool WriterWorkerV4::resume() {
       LOG_DEBUG(
           "Worker {}: flush, output buffer size = {} MiB",
           id_,
-          buffers_.total_size() >> 20);
+          buffers.total_size() >> 20);
       return false;
     }
   }
@@ -219,7 +529,7 @@ bool WriterWorkerV4::resume() {
   LOG_DEBUG(
       "Worker {}: record heap empty, output buffer size = {} MiB",
       id_,
-      buffers_.total_size() >> 20);
+      buffers.total_size() >> 20);
   return true;
 }
 
@@ -227,116 +537,143 @@ bool WriterWorkerV4::buffer_record(const RecordHeapV4::Node& node) {
   VCFV4* vcf = node.vcf;
   bcf1_t* r = node.record.get();
   bcf_hdr_t* hdr = vcf->hdr();
-  const std::string contig = vcf->contig_name(r);
-  const std::string sample_name = node.sample_name;
+  const std::string& contig = *node.contig;
+  const std::string& sample_name = *node.sample_name;
   const uint32_t col = node.start_pos;
   const uint32_t pos = r->pos;
-  const uint32_t end_pos = VCFUtils::get_end_pos(hdr, r, &val_);
-
-  buffers_.sample_name().offsets().push_back(buffers_.sample_name().size());
-  buffers_.sample_name().append(sample_name.c_str(), sample_name.length());
-  buffers_.contig().offsets().push_back(buffers_.contig().size());
-  buffers_.contig().append(contig.c_str(), contig.length());
-  buffers_.start_pos().append(&col, sizeof(uint32_t));
-  buffers_.qual().append(&r->qual, sizeof(float));
-  buffers_.real_start_pos().append(&pos, sizeof(uint32_t));
-  buffers_.end_pos().append(&end_pos, sizeof(uint32_t));
+  const uint32_t end_pos = node.end_pos;
+  AttributeBufferSet& buffers = buffer_sets_[active_];
+  const std::vector<Buffer*>& extra_buffers = extra_attr_buffers_[active_];
+
+  // Bytes of the variable sized buffers before buffering the record, to
+  // track the total buffered size without walking all buffers.
+  uint64_t bytes_before = buffer_bytes(buffers.alleles()) +
+                          buffer_bytes(buffers.info()) +
+                          buffer_bytes(buffers.fmt());
+
+  buffers.sample_name().offsets().push_back(buffers.sample_name().size());
+  buffers.sample_name().append(sample_name.c_str(), sample_name.length());
+  buffers.contig().offsets().push_back(buffers.contig().size());
+  buffers.contig().append(contig.c_str(), contig.length());
+  buffers.start_pos().append(&col, sizeof(uint32_t));
+  buffers.qual().append(&r->qual, sizeof(float));
+  buffers.real_start_pos().append(&pos, sizeof(uint32_t));
+  buffers.end_pos().append(&end_pos, sizeof(uint32_t));
 
   // ID string (include null terminator)
   const size_t id_size = strlen(r->d.id) + 1;
-  buffers_.id().offsets().push_back(buffers_.id().size());
-  buffers_.id().append(r->d.id, id_size);
+  buffers.id().offsets().push_back(buffers.id().size());
+  buffers.id().append(r->d.id, id_size);
 
   // Alleles
-  buffer_alleles(r, &buffers_.alleles());
+  buffer_alleles(r, &buffers.alleles());
 
   // Filter IDs
-  buffers_.filter_ids().offsets().push_back(buffers_.filter_ids().size());
-  buffers_.filter_ids().append(&(r->d.n_flt), sizeof(int32_t));
-  buffers_.filter_ids().append(r->d.flt, sizeof(int32_t) * r->d.n_flt);
+  buffers.filter_ids().offsets().push_back(buffers.filter_ids().size());
+  buffers.filter_ids().append(&(r->d.n_flt), sizeof(int32_t));
+  buffers.filter_ids().append(r->d.flt, sizeof(int32_t) * r->d.n_flt);
 
   // Start expecting info on all the extra buffers
-  for (auto& it : buffers_.extra_attrs())
-    it.second.start_expecting();
+  for (Buffer* buff : extra_buffers) {
+    bytes_before += buffer_bytes(*buff);
+    buff->start_expecting();
+  }
 
   // Extract INFO fields into separate attributes
-  std::vector<bool> infos_extracted(r->n_info, false);
   unsigned n_info_as_attr = 0;
   for (unsigned i = 0; i < r->n_info; i++) {
     bcf_info_t* info = r->d.info + i;
-    int info_id = info->key;
-    const char* key = bcf_hdr_int2id(hdr, BCF_DT_ID, info_id);
+    const FieldPlan& field = field_plan(node.sample, info->key, BCF_HL_INFO);
+    if (field.info_attr == FIELD_BLOB)
+      continue;
 
-    // No need to store END.
-    if (strcmp("END", key) == 0) {
-      infos_extracted[i] = true;
-      n_info_as_attr++;
+    // Extracted or skipped fields are left out of the info blob attribute.
+    n_info_as_attr++;
+    if (field.info_attr == FIELD_SKIP)
       continue;
-    }
 
-    Buffer* buff;
-    if (buffers_.extra_attr(std::string("info_") + key, &buff)) {
-      // No need to store the string key, as it's an extracted attribute.
-      const bool include_key = false;
-      buffer_info_field(hdr, r, info, include_key, &val_, buff);
-      // Mark key so we don't add it again in the info blob attribute
-      infos_extracted[i] = true;
-      n_info_as_attr++;
-    }
+    // No need to store the string key, as it's an extracted attribute.
+    const bool include_key = false;
+    buffer_info_field(
+        hdr,
+        r,
+        info,
+        field,
+        include_key,
+        extra_attr_types_[field.info_attr],
+        &val_,
+        extra_buffers[field.info_attr]);
   }
 
   // Extract FMT fields into separate attributes
-  std::vector<bool> fmts_extracted(r->n_fmt, false);
   unsigned n_fmt_as_attr = 0;
   for (unsigned i = 0; i < r->n_fmt; i++) {
     bcf_fmt_t* fmt = r->d.fmt + i;
-    int fmt_id = fmt->id;
-    const char* key = bcf_hdr_int2id(hdr, BCF_DT_ID, fmt_id);
-    Buffer* buff;
-    if (buffers_.extra_attr(std::string("fmt_") + key, &buff)) {
-      // No need to store the string key, as it's an extracted attribute.
-      const bool include_key = false;
-      buffer_fmt_field(hdr, r, fmt, include_key, &val_, buff);
-      // Mark key so we don't add it again in the fmt blob attribute
-      fmts_extracted[i] = true;
-      n_fmt_as_attr++;
-    }
+    const FieldPlan& field = field_plan(node.sample, fmt->id, BCF_HL_FMT);
+    if (field.fmt_attr == FIELD_BLOB)
+      continue;
+
+    // No need to store the string key, as it's an extracted attribute.
+    const bool include_key = false;
+    buffer_fmt_field(
+        hdr,
+        r,
+        fmt,
+        field,
+        include_key,
+        extra_attr_types_[field.fmt_attr],
+        &val_,
+        extra_buffers[field.fmt_attr]);
+    n_fmt_as_attr++;
   }
 
   // Remaining INFO/FMT fields go into blob attributes
-  Buffer& info = buffers_.info();
+  Buffer& info = buffers.info();
   info.offsets().push_back(info.size());
   const uint32_t non_attr_info = r->n_info - n_info_as_attr;
   info.append(&non_attr_info, sizeof(uint32_t));
   for (unsigned i = 0; i < r->n_info; i++) {
-    if (!infos_extracted[i]) {
-      bcf_info_t* info_field = r->d.info + i;
-      buffer_info_field(hdr, r, info_field, true, &val_, &info);
-    }
+    bcf_info_t* info_field = r->d.info + i;
+    const FieldPlan& field = field_plans_[node.sample][info_field->key];
+    if (field.info_attr == FIELD_BLOB)
+      buffer_info_field(hdr, r, info_field, field, true, -1, &val_, &info);
   }
 
-  Buffer& fmt = buffers_.fmt();
+  Buffer& fmt = buffers.fmt();
   fmt.offsets().push_back(fmt.size());
   const uint32_t non_attr_fmt = r->n_fmt - n_fmt_as_attr;
   fmt.append(&non_attr_fmt, sizeof(uint32_t));
   for (unsigned i = 0; i < r->n_fmt; i++) {
-    if (!fmts_extracted[i]) {
-      bcf_fmt_t* fmt_field = r->d.fmt + i;
-      buffer_fmt_field(hdr, r, fmt_field, true, &val_, &fmt);
-    }
+    bcf_fmt_t* fmt_field = r->d.fmt + i;
+    const FieldPlan& field = field_plans_[node.sample][fmt_field->id];
+    if (field.fmt_attr == FIELD_BLOB)
+      buffer_fmt_field(hdr, r, fmt_field, field, true, -1, &val_, &fmt);
   }
 
   // Make sure any extra attributes get dummy values if no info was written.
-  for (auto& it : buffers_.extra_attrs())
-    it.second.stop_expecting();
+  uint64_t bytes_after = buffer_bytes(buffers.alleles()) +
+                         buffer_bytes(buffers.info()) +
+                         buffer_bytes(buffers.fmt());
+  for (Buffer* buff : extra_buffers) {
+    buff->stop_expecting();
+    bytes_after += buffer_bytes(*buff);
+  }
 
   if (node.type == RecordHeapV4::NodeType::Record)
     records_buffered_++;
   else
     anchors_buffered_++;
 
+  // Add the bytes of the other buffers as counted by
+  // AttributeBufferSet::total_size(): the fixed size attributes, the contig,
+  // ID and filter IDs with their offsets, and (twice) the sample name.
+  bytes_buffered_ += 4 * sizeof(uint32_t) + 3 * sizeof(uint64_t) +
+                     2 * sample_name.length() + contig.length() + id_size +
+                     sizeof(int32_t) * (1 + r->d.n_flt) + bytes_after -
+                     bytes_before;
+
   // Return false if buffers are full
-  const uint64_t buffer_size_mb = buffers_.total_size() >> 20;
+  const uint64_t buffer_size_mb = bytes_buffered_ >> 20;
   if (buffer_size_mb > max_total_buffer_size_mb_) {
     return false;
   }
@@ -367,19 +704,29 @@ void WriterWorkerV4::buffer_info_field(
     const bcf_hdr_t* hdr,
     bcf1_t* r,
     const bcf_info_t* info,
+    const FieldPlan& field,
     bool include_key,
+    int attr_type,
     HtslibValueMem* val,
     Buffer* buff) {
-  int info_id = info->key;
-  const char* key = bcf_hdr_int2id(hdr, BCF_DT_ID, info_id);
-  int type = bcf_hdr_id2type(hdr, BCF_HL_INFO, info->key);
-  val->ndst = HtslibValueMem::convert_ndst_for_type(
-      val->ndst, type, &val->type_for_ndst);
-  int num_vals = bcf_get_info_values(hdr, r, key, &val->dst, &val->ndst, type);
-  if (num_vals < 0)
-    throw std::runtime_error(
-        "Error reading INFO value for '" + std::string(key) + "'; " +
-        std::to_string(num_vals));
+  const char* key = field.key;
+  int type = field.info_type;
+  const void* values = nullptr;
+  int num_vals = decode_info_values(info, type, val, &values);
+  if (num_vals < 0) {
+    // Let htslib decode the encodings not handled in place.
+    val->ndst = HtslibValueMem::convert_ndst_for_type(
+        val->ndst, type, &val->type_for_ndst);
+    num_vals = bcf_get_info_values(hdr, r, key, &val->dst, &val->ndst, type);
+    if (num_vals < 0)
+      throw std::runtime_error(
+          "Error reading INFO value for '" + std::string(key) + "'; " +
+          std::to_string(num_vals));
+    values = val->dst;
+  }
+
+  if (attr_type >= 0)
+    return buffer_typed_values(key, type, num_vals, values, attr_type, buff);
 
   if (buff->expecting())
     buff->offsets().push_back(buff->size());
@@ -389,10 +736,10 @@ void WriterWorkerV4::buffer_info_field(
     buff->append(key, strlen(key) + 1);
   buff->append(&type, sizeof(int));
   buff->append(&num_vals, sizeof(int));
-  if (val->dst) {
-    buff->append(val->dst, num_vals * utils::bcf_type_size(type));
+  if (values) {
+    buff->append(values, num_vals * utils::bcf_type_size(type));
   } else {
-    // val->dst can be NULL if the only INFO value is a flag
+    // There are no values for a flag
     assert(num_vals == 1);
     int dummy = 0;
     buff->append(&dummy, num_vals * utils::bcf_type_size(type));
@@ -403,23 +750,30 @@ void WriterWorkerV4::buffer_fmt_field(
     const bcf_hdr_t* hdr,
     bcf1_t* r,
     const bcf_fmt_t* fmt,
+    const FieldPlan& field,
     bool include_key,
+    int attr_type,
     HtslibValueMem* val,
     Buffer* buff) {
-  const char* key = bcf_hdr_int2id(hdr, BCF_DT_ID, fmt->id);
-
-  // Header says GT is str, but it's encoded as an int (index into alleles)
-  int type = std::strcmp("GT", key) == 0 ?
-                 BCF_HT_INT :
-                 bcf_hdr_id2type(hdr, BCF_HL_FMT, fmt->id);
-  val->ndst = HtslibValueMem::convert_ndst_for_type(
-      val->ndst, type, &val->type_for_ndst);
+  const char* key = field.key;
+  int type = field.fmt_type;
+  const void* values = nullptr;
   int num_vals =
-      bcf_get_format_values(hdr, r, key, &val->dst, &val->ndst, type);
-  if (num_vals < 0)
-    throw std::runtime_error(
-        "Error reading FMT field '" + std::string(key) + "'; " +
-        std::to_string(num_vals));
+      decode_fmt_values(fmt, bcf_hdr_nsamples(hdr), type, val, &values);
+  if (num_vals < 0) {
+    // Let htslib decode the encodings not handled in place.
+    val->ndst = HtslibValueMem::convert_ndst_for_type(
+        val->ndst, type, &val->type_for_ndst);
+    num_vals = bcf_get_format_values(hdr, r, key, &val->dst, &val->ndst, type);
+    if (num_vals < 0)
+      throw std::runtime_error(
+          "Error reading FMT field '" + std::string(key) + "'; " +
+          std::to_string(num_vals));
+    values = val->dst;
+  }
+
+  if (attr_type >= 0)
+    return buffer_typed_values(key, type, num_vals, values, attr_type, buff);
 
   if (buff->expecting())
     buff->offsets().push_back(buff->size());
@@ -429,7 +783,48 @@ void WriterWorkerV4::buffer_fmt_field(
     buff->append(key, strlen(key) + 1);
   buff->append(&type, sizeof(int));
   buff->append(&num_vals, sizeof(int));
-  buff->append(val->dst, num_vals * utils::bcf_type_size(type));
+  buff->append(values, num_vals * utils::bcf_type_size(type));
+}
+
+void WriterWorkerV4::buffer_typed_values(
+    const char* key,
+    int type,
+    int num_vals,
+    const void* values,
+    int attr_type,
+    Buffer* buff) {
+  // No values (e.g. a flag); the cell is left null by stop_expecting().
+  if (num_vals <= 0 || values == nullptr)
+    return;
+
+  if (buff->expecting())
+    buff->offsets().push_back(buff->size());
+
+  if (type == attr_type) {
+    buff->append(values, num_vals * utils::bcf_type_size(type));
+  } else if (type == BCF_HT_INT && attr_type == BCF_HT_REAL) {
+    // Integer values stored in a Float attribute, e.g. when the VCF headers
+    // of the samples disagree on the field type. The values may be unaligned
+    // in the record.
+    const char* ints = static_cast<const char*>(values);
+    for (int i = 0; i < num_vals; i++) {
+      int32_t int_value;
+      std::memcpy(&int_value, ints + i * sizeof(int32_t), sizeof(int32_t));
+      float value;
+      if (int_value == bcf_int32_missing)
+        bcf_float_set_missing(value);
+      else if (int_value == bcf_int32_vector_end)
+        bcf_float_set_vector_end(value);
+      else
+        value = static_cast<float>(int_value);
+      buff->append(&value, sizeof(float));
+    }
+  } else {
+    throw std::runtime_error(
+        "Error buffering typed attribute for field '" + std::string(key) +
+        "'; the field type in the VCF header does not match the dataset.");
+  }
+  buff->validity().push_back(1);
 }
 
 }  // namespace vcf
@@ -31,6 +31,7 @@
 #include <memory>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <htslib/vcf.h>
@@ -84,12 +85,19 @@ class WriterWorkerV4 : public WriterWorker {
    * Resumes parsing from the current state. This is used if the buffers are too
    * small to fit all records in the genomic region in memory.
    *
+   * The records are buffered into the other of the worker's two buffer sets,
+   * so the buffers filled by the previous parse() or resume() call can be
+   * written to TileDB while this call runs.
+   *
    * @return True if the last record from all samples was buffered. False if the
    *    buffers ran out of space, and there are more records to be read.
    */
   bool resume();
 
-  /** Return a handle to the attribute buffers */
+  /**
+   * Return a handle to the attribute buffers filled by the last parse() or
+   * resume() call. They are not modified until after the next call.
+   */
   const AttributeBufferSet& buffers() const;
 
   /** Returns the number of records buffered by the last parse operation. */
@@ -102,8 +110,14 @@ class WriterWorkerV4 : public WriterWorker {
   /** Worker id */
   int id_;
 
-  /** Attribute buffers holding parsed data. */
-  AttributeBufferSet buffers_;
+  /**
+   * Attribute buffers holding parsed data. Parsing alternates between the two
+   * sets, so one can be written while the other is filled.
+   */
+  AttributeBufferSet buffer_sets_[2];
+
+  /** Index in buffer_sets_ of the buffers filled by the last parse. */
+  unsigned active_;
 
   /** The destination dataset. */
   const TileDBVCFDataset* dataset_;
@@ -120,23 +134,80 @@ class WriterWorkerV4 : public WriterWorker {
   /** Current number of anchors buffered. */
   uint64_t anchors_buffered_;
 
+  /** Bytes buffered into the active buffer set by the last parse. */
+  uint64_t bytes_buffered_;
+
   /** Record heap for sorting records across samples. */
   RecordHeapV4 record_heap_;
 
+  /** Destination of a field stored in the INFO or FMT blob attribute. */
+  static constexpr int FIELD_BLOB = -1;
+
+  /** Destination of a field that is not stored (INFO END). */
+  static constexpr int FIELD_SKIP = -2;
+
+  /** How the INFO and FMT values of a header ID are buffered. */
+  struct FieldPlan {
+    /** Field key, owned by the VCF header. */
+    const char* key = nullptr;
+
+    /** BCF_HT_ type of the INFO values, or -1 if not an INFO field. */
+    int info_type = -1;
+
+    /** BCF_HT_ type of the FMT values (int for GT), or -1 if not FMT. */
+    int fmt_type = -1;
+
+    /** Index in `extra_attrs_` of the INFO destination, or FIELD_*. */
+    int info_attr = FIELD_BLOB;
+
+    /** Index in `extra_attrs_` of the FMT destination, or FIELD_*. */
+    int fmt_attr = FIELD_BLOB;
+  };
+
+  /**
+   * Field plans of the header of each VCF of `vcfs_`, indexed by the header's
+   * BCF_DT_ID dictionary IDs. Built by init() so buffering a record does not
+   * look up field names.
+   */
+  std::vector<std::vector<FieldPlan>> field_plans_;
+
+  /** Names of the extracted attributes. */
+  std::vector<std::string> extra_attrs_;
+
+  /**
+   * BCF_HT_ type of the values of each extracted attribute, or -1 if the
+   * attribute is stored as a blob.
+   */
+  std::vector<int> extra_attr_types_;
+
+  /** Buffers of the extracted attributes in each buffer set. */
+  std::vector<Buffer*> extra_attr_buffers_[2];
+
+  /**
+   * Returns the plan of the given header ID of the given sample, for INFO or
+   * FMT values (BCF_HL_INFO or BCF_HL_FMT). The ID is planned first if it was
+   * added to the header after init(), as htslib does for fields missing from
+   * the header of a VCF text file.
+   */
+  const FieldPlan& field_plan(uint32_t sample, int id, int hl_type);
+
+  /** (Re)builds the plan of a header ID of the given sample. */
+  void plan_field(uint32_t sample, int id);
+
   /**
    * Inserts a record (non-anchor) into the heap if it fits
    * in `region_`.
    *
    * @param record The record to insert
    * @param vcf The VCF state that contains `record`.
-   * @param contig_offset The VCF contig offset
-   * @param sample_id The sample id for the record.
+   * @param contig The record's contig
+   * @param sample Index of the record's sample in `vcfs_`.
    */
   void insert_record(
       const SafeSharedBCFRec& record,
       VCFV4* vcf,
       const std::string& contig,
-      const std::string& sample_name);
+      uint32_t sample);
 
   /**
    * Copies all fields of a VCF record or anchor into the attribute buffers.
@@ -150,23 +221,45 @@ class WriterWorkerV4 : public WriterWorker {
   /** Helper function to buffer the alleles attribute. */
   static void buffer_alleles(bcf1_t* record, Buffer* buffer);
 
-  /** Helper function to buffer an INFO field. */
+  /**
+   * Helper function to buffer an INFO field. If `attr_type` is a BCF_HT_ type,
+   * the buffer is a typed attribute of that type.
+   */
   static void buffer_info_field(
       const bcf_hdr_t* hdr,
       bcf1_t* r,
       const bcf_info_t* info,
+      const FieldPlan& field,
       bool include_key,
+      int attr_type,
       HtslibValueMem* val,
       Buffer* buff);
 
-  /** Helper function to buffer a FMT field. */
+  /**
+   * Helper function to buffer a FMT field. If `attr_type` is a BCF_HT_ type,
+   * the buffer is a typed attribute of that type.
+   */
   static void buffer_fmt_field(
       const bcf_hdr_t* hdr,
       bcf1_t* r,
       const bcf_fmt_t* fmt,
+      const FieldPlan& field,
       bool include_key,
+      int attr_type,
       HtslibValueMem* val,
       Buffer* buff);
+
+  /**
+   * Helper function to buffer the values of a field of BCF_HT_ type `type`
+   * into a typed attribute of BCF_HT_ type `attr_type`.
+   */
+  static void buffer_typed_values(
+      const char* key,
+      int type,
+      int num_vals,
+      const void* values,
+      int attr_type,
+      Buffer* buff);
 };
 
 }  // namespace vcf
@@ -107,6 +107,18 @@ $tilevcf export -u ingested_1_2 -v -s HG01762,HG00280 -O v -b 512
 diff -u <(bcftools view --no-version ${input_dir}/small.bcf) HG01762.vcf || exit 1
 diff -u <(bcftools view --no-version ${input_dir}/small2.bcf) HG00280.vcf || exit 1
 
+## Check export of a subset of the INFO/FMT fields
+rm -f HG00280.vcf HG01762.vcf
+$tilevcf export -u ingested_1_2 -s HG01762,HG00280 -O v -b 512 --exclude info_DP,fmt_PL || exit 1
+diff -u <(bcftools annotate --no-version -x INFO/DP,FORMAT/PL ${input_dir}/small.bcf) HG01762.vcf || exit 1
+diff -u <(bcftools annotate --no-version -x INFO/DP,FORMAT/PL ${input_dir}/small2.bcf) HG00280.vcf || exit 1
+rm -f HG00280.vcf HG01762.vcf
+$tilevcf export -u ingested_1_2 -s HG01762,HG00280 -O v -b 512 --include info_END,fmt_GT,fmt_DP || exit 1
+diff -u <(bcftools annotate --no-version -x ^INFO/END,FORMAT/GT,FORMAT/DP ${input_dir}/small.bcf) HG01762.vcf || exit 1
+diff -u <(bcftools annotate --no-version -x ^INFO/END,FORMAT/GT,FORMAT/DP ${input_dir}/small2.bcf) HG00280.vcf || exit 1
+$tilevcf export -u ingested_1_2 -s HG01762 -O v --include info_DP --exclude fmt_DP && exit 1
+rm -f HG00280.vcf HG01762.vcf
+
 ## Check whole export for ingested_3 which has some indels, where we add END tags
 ## on export (which are not present in the input BCF). So we just compare without
 ## the END tags.
@@ -31,8 +31,13 @@
 #include "catch.hpp"
 #include "unit-helpers.h"
 
+#include <tiledb/tiledb>
+
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <map>
+#include <tuple>
 
 static std::string INPUT_ARRAYS_DIR_V4 =
     TILEDB_VCF_TEST_INPUT_DIR + std::string("/arrays/v4");
@@ -369,6 +374,29 @@ std::vector<record> build_records(
   return ret;
 }
 
+/**
+ * Ingests two samples into a new dataset: HG00280 has records on contig "1"
+ * only, v2-DjrIAzkP has records on many contigs.
+ */
+void ingest_multi_contig_dataset(const std::string& dataset_uri) {
+  tiledb::Context ctx;
+  tiledb::VFS vfs(ctx);
+  if (vfs.is_dir(dataset_uri))
+    vfs.remove_dir(dataset_uri);
+
+  tiledb_vcf_writer_t* writer = nullptr;
+  REQUIRE(tiledb_vcf_writer_alloc(&writer) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_writer_init(writer, dataset_uri.c_str()) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_writer_create_dataset(writer) == TILEDB_VCF_OK);
+  std::string samples = TILEDB_VCF_TEST_INPUT_DIR +
+                        std::string("/v2-DjrIAzkP-downsampled.vcf.gz,") +
+                        TILEDB_VCF_TEST_INPUT_DIR + std::string("/small3.bcf");
+  REQUIRE(
+      tiledb_vcf_writer_set_samples(writer, samples.c_str()) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_writer_store(writer) == TILEDB_VCF_OK);
+  tiledb_vcf_writer_free(&writer);
+}
+
 /* ********************************* */
 /*               TESTS               */
 /* ********************************* */
@@ -1991,6 +2019,1256 @@ TEST_CASE("C API: Reader submit (BED file)", "[capi][reader]") {
   tiledb_vcf_reader_free(&reader);
 }
 
+TEST_CASE(
+    "C API: Reader submit (contig batch concurrency)", "[capi][reader]") {
+  std::string dataset_uri = "test_dataset_contig_batches";
+  ingest_multi_contig_dataset(dataset_uri);
+
+  // Returns the (contig, start, sample) of the records read, in read order,
+  // reading at most `max_records` records per read() call
+  using Record = std::tuple<std::string, uint32_t, std::string>;
+  auto read_records = [&](int32_t concurrency,
+                          unsigned max_records,
+                          bool* crossed_contigs,
+                          bool late_materialization = false) {
+    tiledb_vcf_reader_t* reader = nullptr;
+    REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_samples(reader, "HG00280,v2-DjrIAzkP") ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_contig_batch_concurrency(reader, concurrency) ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_late_materialization(
+            reader, late_materialization) == TILEDB_VCF_OK);
+
+    std::vector<int32_t> contig_offsets(max_records + 1);
+    std::vector<char> contig(max_records * 32);
+    std::vector<uint32_t> pos_start(max_records);
+    std::vector<int32_t> sample_name_offsets(max_records + 1);
+    std::vector<char> sample_name(max_records * 16);
+    REQUIRE(
+        tiledb_vcf_reader_set_buffer_values(
+            reader, "contig", contig.size(), contig.data()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_buffer_offsets(
+            reader,
+            "contig",
+            sizeof(int32_t) * contig_offsets.size(),
+            contig_offsets.data()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_buffer_values(
+            reader,
+            "pos_start",
+            sizeof(uint32_t) * pos_start.size(),
+            pos_start.data()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_buffer_values(
+            reader, "sample_name", sample_name.size(), sample_name.data()) ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_buffer_offsets(
+            reader,
+            "sample_name",
+            sizeof(int32_t) * sample_name_offsets.size(),
+            sample_name_offsets.data()) == TILEDB_VCF_OK);
+
+    std::vector<Record> records;
+    tiledb_vcf_read_status_t status = TILEDB_VCF_INCOMPLETE;
+    while (status == TILEDB_VCF_INCOMPLETE) {
+      REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+      REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+
+      int64_t num_records = ~0;
+      REQUIRE(
+          tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+          TILEDB_VCF_OK);
+      REQUIRE(num_records <= max_records);
+      if (status == TILEDB_VCF_INCOMPLETE)
+        REQUIRE(num_records > 0);
+
+      for (int64_t i = 0; i < num_records; i++) {
+        std::string c(
+            contig.data() + contig_offsets[i],
+            contig_offsets[i + 1] - contig_offsets[i]);
+        std::string sample(
+            sample_name.data() + sample_name_offsets[i],
+            sample_name_offsets[i + 1] - sample_name_offsets[i]);
+        if (i > 0 && c != std::get<0>(records.back()))
+          *crossed_contigs = true;
+        records.emplace_back(c, pos_start[i], sample);
+      }
+    }
+    REQUIRE(status == TILEDB_VCF_COMPLETED);
+
+    tiledb_vcf_reader_free(&reader);
+    return records;
+  };
+
+  // v2-DjrIAzkP has 246 records and HG00280 has 70; all fit in a single read
+  const unsigned max_num_records = 1000;
+  bool crossed_contigs = false;
+  auto expected = read_records(1, max_num_records, &crossed_contigs);
+  REQUIRE(expected.size() >= 316);
+  REQUIRE(expected.size() < max_num_records);
+  REQUIRE(crossed_contigs);
+
+  SECTION("- Complete") {
+    crossed_contigs = false;
+    auto records = read_records(4, max_num_records, &crossed_contigs);
+    REQUIRE(records == expected);
+  }
+
+  SECTION("- Incomplete") {
+    // Reads stop and resume within and across contig batches
+    crossed_contigs = false;
+    auto records = read_records(4, 7, &crossed_contigs);
+    REQUIRE(crossed_contigs);
+    REQUIRE(records == expected);
+  }
+
+  SECTION("- Late materialization") {
+    // Fewer cells are queried, so only the set of records is unchanged
+    auto late_expected =
+        read_records(1, max_num_records, &crossed_contigs, true);
+    auto sorted_expected = expected;
+    std::sort(sorted_expected.begin(), sorted_expected.end());
+    auto sorted_late_expected = late_expected;
+    std::sort(sorted_late_expected.begin(), sorted_late_expected.end());
+    REQUIRE(sorted_late_expected == sorted_expected);
+
+    // Phase one of the prefetched contig batches runs with their queries
+    auto records = read_records(4, 7, &crossed_contigs, true);
+    REQUIRE(records == late_expected);
+  }
+
+  SECTION("- Invalid concurrency") {
+    tiledb_vcf_reader_t* reader = nullptr;
+    REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_contig_batch_concurrency(reader, 0) ==
+        TILEDB_VCF_ERR);
+    tiledb_vcf_reader_free(&reader);
+  }
+
+  tiledb::Context ctx;
+  tiledb::VFS vfs(ctx);
+  if (vfs.is_dir(dataset_uri))
+    vfs.remove_dir(dataset_uri);
+}
+
+TEST_CASE(
+    "C API: Reader read after failure (contig batch concurrency)",
+    "[capi][reader]") {
+  std::string dataset_uri = "test_dataset_contig_batches";
+  ingest_multi_contig_dataset(dataset_uri);
+
+  tiledb_vcf_reader_t* reader = nullptr;
+  REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_samples(reader, "HG00280,v2-DjrIAzkP") ==
+      TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_contig_batch_concurrency(reader, 4) ==
+      TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_set_genotype_matrix(reader, true) == TILEDB_VCF_OK);
+
+  // A single row does not fit the first contig, so the read fails while the
+  // queries of the following contigs are still in flight
+  const int64_t row_bytes = 2;
+  std::vector<uint8_t> matrix(1000 * row_bytes);
+  REQUIRE(
+      tiledb_vcf_reader_set_genotype_matrix_buffer(
+          reader, row_bytes, matrix.data()) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_ERR);
+
+  // Reading again releases the buffers once those queries are done
+  REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+  tiledb_vcf_read_status_t status;
+  REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+  REQUIRE(status == TILEDB_VCF_FAILED);
+
+  // The reader can be reused after a reset
+  REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_genotype_matrix_buffer(
+          reader, matrix.size(), matrix.data()) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+  REQUIRE(status == TILEDB_VCF_COMPLETED);
+
+  int64_t num_rows = 0, num_row_bytes = 0;
+  int32_t num_samples = 0;
+  REQUIRE(
+      tiledb_vcf_reader_get_genotype_matrix_shape(
+          reader, &num_rows, &num_samples, &num_row_bytes) == TILEDB_VCF_OK);
+  REQUIRE(num_samples == 2);
+  REQUIRE(num_row_bytes == row_bytes);
+  REQUIRE(num_rows > 1);
+
+  tiledb_vcf_reader_free(&reader);
+
+  tiledb::Context ctx;
+  tiledb::VFS vfs(ctx);
+  if (vfs.is_dir(dataset_uri))
+    vfs.remove_dir(dataset_uri);
+}
+
+TEST_CASE("C API: Reader submit (late materialization)", "[capi][reader]") {
+  std::string dataset_uri =
+      INPUT_ARRAYS_DIR_V4 + "/ingested_2samples_GT_DP_PL";
+  auto bed_uri = TILEDB_VCF_TEST_INPUT_DIR + std::string("/simple.bed");
+  const unsigned expected_num_records = 10;
+
+  // Returns the sorted (sample, start, end) of the records read
+  auto read_records = [&](bool late_materialization) {
+    tiledb_vcf_reader_t* reader = nullptr;
+    REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_late_materialization(
+            reader, late_materialization) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_bed_file(reader, bed_uri.c_str()) ==
+        TILEDB_VCF_OK);
+
+    SET_BUFF_POS_START(reader, expected_num_records);
+    SET_BUFF_POS_END(reader, expected_num_records);
+    SET_BUFF_SAMPLE_NAME(reader, expected_num_records);
+
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+    tiledb_vcf_read_status_t status;
+    REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+    REQUIRE(status == TILEDB_VCF_COMPLETED);
+
+    int64_t num_records = ~0;
+    REQUIRE(
+        tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+        TILEDB_VCF_OK);
+    REQUIRE(num_records == expected_num_records);
+
+    std::vector<std::tuple<std::string, uint32_t, uint32_t>> records;
+    for (int64_t i = 0; i < num_records; i++) {
+      std::string sample(
+          sample_name.data() + sample_name_offsets[i],
+          sample_name_offsets[i + 1] - sample_name_offsets[i]);
+      records.emplace_back(sample, pos_start[i], pos_end[i]);
+    }
+    std::sort(records.begin(), records.end());
+
+    tiledb_vcf_reader_free(&reader);
+    return records;
+  };
+
+  REQUIRE(read_records(true) == read_records(false));
+}
+
+TEST_CASE("C API: Reader submit (filter expression)", "[capi][reader]") {
+  std::string dataset_uri =
+      INPUT_ARRAYS_DIR_V4 + "/ingested_2samples_GT_DP_PL";
+  auto bed_uri = TILEDB_VCF_TEST_INPUT_DIR + std::string("/simple.bed");
+  const unsigned expected_num_records = 10;
+
+  // Returns the sorted (sample, start, fmt_DP) of the records read
+  auto read_records = [&](const std::string& expression) {
+    tiledb_vcf_reader_t* reader = nullptr;
+    REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_filter_expression(reader, expression.c_str()) ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_bed_file(reader, bed_uri.c_str()) ==
+        TILEDB_VCF_OK);
+
+    SET_BUFF_POS_START(reader, expected_num_records);
+    SET_BUFF_SAMPLE_NAME(reader, expected_num_records);
+    SET_BUFF_FMT_DP(reader, expected_num_records);
+
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+    tiledb_vcf_read_status_t status;
+    REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+    REQUIRE(status == TILEDB_VCF_COMPLETED);
+
+    int64_t num_records = ~0;
+    REQUIRE(
+        tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+        TILEDB_VCF_OK);
+
+    std::vector<std::tuple<std::string, uint32_t, int>> records;
+    for (int64_t i = 0; i < num_records; i++) {
+      std::string sample(
+          sample_name.data() + sample_name_offsets[i],
+          sample_name_offsets[i + 1] - sample_name_offsets[i]);
+      records.emplace_back(sample, pos_start[i], fmt_DP[i]);
+    }
+    std::sort(records.begin(), records.end());
+
+    tiledb_vcf_reader_free(&reader);
+    return records;
+  };
+
+  auto all_records = read_records("");
+  REQUIRE(all_records.size() == expected_num_records);
+
+  // Filter on the median depth, so that some records are dropped
+  std::vector<int> depths;
+  for (const auto& r : all_records)
+    depths.push_back(std::get<2>(r));
+  std::sort(depths.begin(), depths.end());
+  const int min_depth = depths[depths.size() / 2];
+
+  decltype(all_records) expected;
+  for (const auto& r : all_records) {
+    if (std::get<2>(r) >= min_depth)
+      expected.push_back(r);
+  }
+  REQUIRE(
+      read_records("fmt_DP >= " + std::to_string(min_depth)) == expected);
+
+  // FILTER values are resolved with the sample headers
+  auto low_qual = read_records("FILTER==LowQual");
+  REQUIRE(low_qual.size() == 1);
+  REQUIRE(std::get<2>(low_qual[0]) == 15);
+  REQUIRE(
+      read_records(
+          "fmt_DP>=" + std::to_string(min_depth) + " && FILTER != LowQual")
+          .size() == expected.size() - (15 >= min_depth ? 1 : 0));
+
+  // "&&" inside quoted values does not split the expression
+  REQUIRE(
+      read_records(
+          "fmt_DP >= " + std::to_string(min_depth) +
+          " && FILTER != \"Low&&Qual\"") == expected);
+
+  // QUAL is pushed down to TileDB; missing values never match
+  REQUIRE(read_records("QUAL>=0").empty());
+
+  // Invalid expressions are rejected
+  tiledb_vcf_reader_t* reader = nullptr;
+  REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_filter_expression(reader, "fmt_DP = 1") ==
+      TILEDB_VCF_ERR);
+  REQUIRE(
+      tiledb_vcf_reader_set_filter_expression(reader, "POS > 1") ==
+      TILEDB_VCF_ERR);
+  REQUIRE(
+      tiledb_vcf_reader_set_filter_expression(reader, "FILTER < PASS") ==
+      TILEDB_VCF_ERR);
+  REQUIRE(
+      tiledb_vcf_reader_set_filter_expression(reader, nullptr) ==
+      TILEDB_VCF_ERR);
+  tiledb_vcf_reader_free(&reader);
+}
+
+TEST_CASE("C API: Reader submit (count group by)", "[capi][reader]") {
+  std::string dataset_uri =
+      INPUT_ARRAYS_DIR_V4 + "/ingested_2samples_GT_DP_PL";
+  auto bed_uri = TILEDB_VCF_TEST_INPUT_DIR + std::string("/simple.bed");
+  const unsigned expected_num_records = 10;
+
+  tiledb_vcf_reader_t* reader = nullptr;
+  REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_bed_file(reader, bed_uri.c_str()) ==
+      TILEDB_VCF_OK);
+
+  SET_BUFF_QUERY_BED_START(reader, expected_num_records);
+  SET_BUFF_QUERY_BED_END(reader, expected_num_records);
+  SET_BUFF_SAMPLE_NAME(reader, expected_num_records);
+
+  // Export the records to compute the expected counts
+  REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+  int64_t num_records = ~0;
+  REQUIRE(
+      tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+      TILEDB_VCF_OK);
+  REQUIRE(num_records == expected_num_records);
+
+  std::map<std::string, int64_t> expected_by_region, expected_by_sample;
+  for (int64_t i = 0; i < num_records; i++) {
+    std::string region = "1:" + std::to_string(query_bed_start[i] + 1) + "-" +
+                         std::to_string(query_bed_end[i]);
+    std::string sample(
+        sample_name.data() + sample_name_offsets[i],
+        sample_name_offsets[i + 1] - sample_name_offsets[i]);
+    expected_by_region[region]++;
+    expected_by_sample[sample]++;
+  }
+
+  auto count_groups = [&](tiledb_vcf_count_group_by_t group_by) {
+    REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_count_group_by(reader, group_by) ==
+        TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+    tiledb_vcf_read_status_t status;
+    REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+    REQUIRE(status == TILEDB_VCF_COMPLETED);
+
+    int64_t num_records = ~0;
+    REQUIRE(
+        tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+        TILEDB_VCF_OK);
+    REQUIRE(num_records == expected_num_records);
+
+    int64_t num_groups = 0;
+    REQUIRE(
+        tiledb_vcf_reader_get_count_num_groups(reader, &num_groups) ==
+        TILEDB_VCF_OK);
+    std::map<std::string, int64_t> result;
+    for (int64_t i = 0; i < num_groups; i++) {
+      const char* name = nullptr;
+      int64_t count = 0;
+      REQUIRE(
+          tiledb_vcf_reader_get_count_group(reader, i, &name, &count) ==
+          TILEDB_VCF_OK);
+      result[name] = count;
+    }
+    const char* name = nullptr;
+    int64_t count = 0;
+    REQUIRE(
+        tiledb_vcf_reader_get_count_group(reader, num_groups, &name, &count) ==
+        TILEDB_VCF_ERR);
+    return result;
+  };
+
+  REQUIRE(count_groups(TILEDB_VCF_COUNT_BY_REGION) == expected_by_region);
+  REQUIRE(count_groups(TILEDB_VCF_COUNT_BY_SAMPLE) == expected_by_sample);
+  REQUIRE(
+      count_groups(TILEDB_VCF_COUNT_BY_CONTIG) ==
+      std::map<std::string, int64_t>{{"1", expected_num_records}});
+
+  // The buffers set on the reader are used again once counting is disabled
+  REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_count_group_by(reader, TILEDB_VCF_COUNT_NONE) ==
+      TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+      TILEDB_VCF_OK);
+  REQUIRE(num_records == expected_num_records);
+  int64_t num_groups = 0;
+  REQUIRE(
+      tiledb_vcf_reader_get_count_num_groups(reader, &num_groups) ==
+      TILEDB_VCF_ERR);
+
+  tiledb_vcf_reader_free(&reader);
+}
+
+TEST_CASE("C API: Reader submit (variant stats)", "[capi][reader]") {
+  tiledb_vcf_reader_t* reader = nullptr;
+  REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+
+  SECTION("- V4") {
+    std::string dataset_uri =
+        INPUT_ARRAYS_DIR_V4 + "/ingested_2samples_GT_DP_PL";
+    REQUIRE(
+        tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+
+    // The record at 13354 intersects both regions, but is counted once
+    const char* regions = "1:12700-13360,1:13350-13400";
+    REQUIRE(tiledb_vcf_reader_set_regions(reader, regions) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_set_variant_stats(reader, true) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+    tiledb_vcf_read_status_t status;
+    REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+    REQUIRE(status == TILEDB_VCF_COMPLETED);
+
+    int64_t num_records = ~0;
+    REQUIRE(
+        tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+        TILEDB_VCF_OK);
+    REQUIRE(num_records == 6);
+
+    int64_t num_rows = 0;
+    REQUIRE(
+        tiledb_vcf_reader_get_variant_stats_num_rows(reader, &num_rows) ==
+        TILEDB_VCF_OK);
+    REQUIRE(num_rows == 4);
+
+    const uint32_t expected_pos[] = {12546, 13354, 13375, 13396};
+    const char* expected_alleles[] = {
+        "G,<NON_REF>", "T,<NON_REF>", "G,<NON_REF>", "T,<NON_REF>"};
+    const int32_t expected_an[] = {4, 4, 2, 2};
+    for (int64_t i = 0; i < num_rows; i++) {
+      const char* contig = nullptr;
+      uint32_t pos = 0;
+      const char* alleles = nullptr;
+      const int32_t* allele_counts = nullptr;
+      int32_t num_alleles = 0, an = 0, num_called = 0, num_het = 0,
+              num_hom_alt = 0, num_missing = 0;
+      REQUIRE(
+          tiledb_vcf_reader_get_variant_stats_row(
+              reader,
+              i,
+              &contig,
+              &pos,
+              &alleles,
+              &allele_counts,
+              &num_alleles,
+              &an,
+              &num_called,
+              &num_het,
+              &num_hom_alt,
+              &num_missing) == TILEDB_VCF_OK);
+      REQUIRE_THAT(contig, Catch::Matchers::Equals("1"));
+      REQUIRE(pos == expected_pos[i]);
+      REQUIRE_THAT(alleles, Catch::Matchers::Equals(expected_alleles[i]));
+
+      // All genotypes are 0/0
+      REQUIRE(num_alleles == 2);
+      REQUIRE(allele_counts[0] == expected_an[i]);
+      REQUIRE(allele_counts[1] == 0);
+      REQUIRE(an == expected_an[i]);
+      REQUIRE(num_called == expected_an[i] / 2);
+      REQUIRE(num_het == 0);
+      REQUIRE(num_hom_alt == 0);
+      REQUIRE(num_missing == 0);
+    }
+
+    const char *contig = nullptr, *alleles = nullptr;
+    uint32_t pos = 0;
+    const int32_t* allele_counts = nullptr;
+    int32_t n = 0;
+    REQUIRE(
+        tiledb_vcf_reader_get_variant_stats_row(
+            reader,
+            num_rows,
+            &contig,
+            &pos,
+            &alleles,
+            &allele_counts,
+            &n,
+            &n,
+            &n,
+            &n,
+            &n,
+            &n) == TILEDB_VCF_ERR);
+
+    // The record limit bounds the number of records aggregated
+    REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_set_max_num_records(reader, 3) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+    REQUIRE(status == TILEDB_VCF_COMPLETED);
+    REQUIRE(
+        tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+        TILEDB_VCF_OK);
+    REQUIRE(num_records == 3);
+    REQUIRE(
+        tiledb_vcf_reader_get_variant_stats_num_rows(reader, &num_rows) ==
+        TILEDB_VCF_OK);
+    int32_t total_called = 0;
+    for (int64_t i = 0; i < num_rows; i++) {
+      int32_t num_called = 0;
+      REQUIRE(
+          tiledb_vcf_reader_get_variant_stats_row(
+              reader,
+              i,
+              &contig,
+              &pos,
+              &alleles,
+              &allele_counts,
+              &n,
+              &n,
+              &num_called,
+              &n,
+              &n,
+              &n) == TILEDB_VCF_OK);
+      total_called += num_called;
+    }
+    REQUIRE(total_called == 3);
+
+    // Variant stats cannot be combined with grouped counts
+    REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_count_group_by(
+            reader, TILEDB_VCF_COUNT_BY_SAMPLE) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_ERR);
+  }
+
+  SECTION("- V3") {
+    std::string dataset_uri = INPUT_ARRAYS_DIR_V3 + "/ingested_2samples";
+    REQUIRE(
+        tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_regions(reader, "1:12700-13400") ==
+        TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_set_variant_stats(reader, true) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_ERR);
+  }
+
+  tiledb_vcf_reader_free(&reader);
+}
+
+TEST_CASE("C API: Reader submit (genotype matrix)", "[capi][reader]") {
+  tiledb_vcf_reader_t* reader = nullptr;
+  REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+
+  SECTION("- V4") {
+    std::string dataset_uri =
+        INPUT_ARRAYS_DIR_V4 + "/ingested_2samples_GT_DP_PL";
+    REQUIRE(
+        tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+
+    // The record at 13354 intersects both regions, but is added once
+    const char* regions = "1:12700-13360,1:13350-13400";
+    REQUIRE(tiledb_vcf_reader_set_regions(reader, regions) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_genotype_matrix(reader, true) == TILEDB_VCF_OK);
+    std::vector<uint8_t> matrix(16, 0xaa);
+    REQUIRE(
+        tiledb_vcf_reader_set_genotype_matrix_buffer(
+            reader, matrix.size(), matrix.data()) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+    tiledb_vcf_read_status_t status;
+    REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+    REQUIRE(status == TILEDB_VCF_COMPLETED);
+
+    int64_t num_rows = 0, row_bytes = 0;
+    int32_t num_samples = 0;
+    REQUIRE(
+        tiledb_vcf_reader_get_genotype_matrix_shape(
+            reader, &num_rows, &num_samples, &row_bytes) == TILEDB_VCF_OK);
+    REQUIRE(num_rows == 4);
+    REQUIRE(num_samples == 2);
+    REQUIRE(row_bytes == 2);
+
+    const char* sample = nullptr;
+    REQUIRE(
+        tiledb_vcf_reader_get_genotype_matrix_sample(reader, 0, &sample) ==
+        TILEDB_VCF_OK);
+    REQUIRE_THAT(sample, Catch::Matchers::Equals("HG00280"));
+    REQUIRE(
+        tiledb_vcf_reader_get_genotype_matrix_sample(reader, 1, &sample) ==
+        TILEDB_VCF_OK);
+    REQUIRE_THAT(sample, Catch::Matchers::Equals("HG01762"));
+    REQUIRE(
+        tiledb_vcf_reader_get_genotype_matrix_sample(reader, 2, &sample) ==
+        TILEDB_VCF_ERR);
+
+    // All genotypes are 0/0; only HG00280 has records at 13375 and 13396
+    const uint32_t expected_pos[] = {12546, 13354, 13375, 13396};
+    const char* expected_alleles[] = {
+        "G,<NON_REF>", "T,<NON_REF>", "G,<NON_REF>", "T,<NON_REF>"};
+    const uint8_t expected_missing[] = {0, 0, 2, 2};
+    for (int64_t i = 0; i < num_rows; i++) {
+      const char* contig = nullptr;
+      uint32_t pos = 0;
+      const char* alleles = nullptr;
+      REQUIRE(
+          tiledb_vcf_reader_get_genotype_matrix_row(
+              reader, i, &contig, &pos, &alleles) == TILEDB_VCF_OK);
+      REQUIRE_THAT(contig, Catch::Matchers::Equals("1"));
+      REQUIRE(pos == expected_pos[i]);
+      REQUIRE_THAT(alleles, Catch::Matchers::Equals(expected_alleles[i]));
+      REQUIRE(matrix[2 * i] == 0);
+      REQUIRE(matrix[2 * i + 1] == expected_missing[i]);
+    }
+    // Memory past the rows is untouched
+    REQUIRE(matrix[8] == 0xaa);
+
+    const char *contig = nullptr, *alleles = nullptr;
+    uint32_t pos = 0;
+    REQUIRE(
+        tiledb_vcf_reader_get_genotype_matrix_row(
+            reader, num_rows, &contig, &pos, &alleles) == TILEDB_VCF_ERR);
+
+    // Reads fail once the buffer is full
+    REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_genotype_matrix_buffer(
+            reader, 3 * row_bytes, matrix.data()) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_ERR);
+
+    // Genotype matrices cannot be combined with variant stats
+    REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_genotype_matrix_buffer(
+            reader, matrix.size(), matrix.data()) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_set_variant_stats(reader, true) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_ERR);
+  }
+
+  SECTION("- V3") {
+    std::string dataset_uri = INPUT_ARRAYS_DIR_V3 + "/ingested_2samples";
+    REQUIRE(
+        tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_regions(reader, "1:12700-13400") ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_genotype_matrix(reader, true) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_ERR);
+  }
+
+  tiledb_vcf_reader_free(&reader);
+}
+
+TEST_CASE(
+    "C API: Reader submit (incomplete batch export)",
+    "[capi][reader][incomplete]") {
+  std::string dataset_uri =
+      INPUT_ARRAYS_DIR_V4 + "/ingested_2samples_GT_DP_PL";
+
+  // Reads all records with buffers of num_records records, mixing attributes
+  // copied by column (sample_name, pos_start, query_bed_start) and by row
+  // (alleles). Records intersecting both regions are reported twice.
+  auto read_records = [&](unsigned num_records) {
+    tiledb_vcf_reader_t* reader = nullptr;
+    REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_regions(
+            reader, "1:12100-13360,1:13350-13400") == TILEDB_VCF_OK);
+
+    SET_BUFF_SAMPLE_NAME(reader, num_records);
+    SET_BUFF_POS_START(reader, num_records);
+    SET_BUFF_QUERY_BED_START(reader, num_records);
+    SET_BUFF_ALLELES(reader, num_records);
+
+    std::vector<std::tuple<std::string, uint32_t, uint32_t, std::string>>
+        records;
+    tiledb_vcf_read_status_t status = TILEDB_VCF_INCOMPLETE;
+    while (status == TILEDB_VCF_INCOMPLETE) {
+      REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+      REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+      int64_t num = ~0;
+      REQUIRE(
+          tiledb_vcf_reader_get_result_num_records(reader, &num) ==
+          TILEDB_VCF_OK);
+      REQUIRE(num <= num_records);
+      for (int64_t i = 0; i < num; i++) {
+        std::string sample(
+            sample_name.data() + sample_name_offsets[i],
+            sample_name_offsets[i + 1] - sample_name_offsets[i]);
+        int32_t alleles_begin = alleles_offsets[alleles_list_offsets[i]];
+        int32_t alleles_end = alleles_offsets[alleles_list_offsets[i + 1]];
+        std::string record_alleles(
+            alleles.data() + alleles_begin, alleles_end - alleles_begin);
+        records.emplace_back(
+            sample, pos_start[i], query_bed_start[i], record_alleles);
+      }
+    }
+    REQUIRE(status == TILEDB_VCF_COMPLETED);
+
+    tiledb_vcf_reader_free(&reader);
+    return records;
+  };
+
+  auto expected = read_records(100);
+  REQUIRE(!expected.empty());
+  REQUIRE(read_records(1) == expected);
+  REQUIRE(read_records(2) == expected);
+  REQUIRE(read_records(5) == expected);
+}
+
+TEST_CASE("C API: Reader Arrow stream", "[capi][reader][arrow]") {
+  tiledb_vcf_reader_t* reader = nullptr;
+  REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+  std::string dataset_uri = INPUT_ARRAYS_DIR_V4 + "/ingested_2samples";
+  REQUIRE(tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+  const char* all_samples = "HG01762,HG00280";
+  REQUIRE(tiledb_vcf_reader_set_samples(reader, all_samples) == TILEDB_VCF_OK);
+  const char* ranges = "1:12100-13360,1:13500-17350";
+  REQUIRE(tiledb_vcf_reader_set_regions(reader, ranges) == TILEDB_VCF_OK);
+
+  // The buffers only define the attributes and size of the batches.
+  const unsigned expected_num_records = 10;
+  const unsigned num_records = 3;
+  SET_BUFF_POS_START(reader, num_records);
+  SET_BUFF_SAMPLE_NAME(reader, num_records);
+  SET_BUFF_ALLELES(reader, num_records);
+
+  struct ArrowArrayStream stream;
+  REQUIRE(
+      tiledb_vcf_reader_read_arrow_stream(reader, &stream) == TILEDB_VCF_OK);
+
+  struct ArrowSchema schema;
+  REQUIRE(stream.get_schema(&stream, &schema) == 0);
+  REQUIRE(std::string(schema.format) == "+s");
+  REQUIRE(schema.n_children == 3);
+  REQUIRE(std::string(schema.children[0]->name) == "pos_start");
+  REQUIRE(std::string(schema.children[0]->format) == "i");
+  REQUIRE(std::string(schema.children[1]->name) == "sample_name");
+  REQUIRE(std::string(schema.children[1]->format) == "u");
+  REQUIRE(std::string(schema.children[2]->name) == "alleles");
+  REQUIRE(std::string(schema.children[2]->format) == "+l");
+  REQUIRE(schema.children[2]->n_children == 1);
+  REQUIRE(std::string(schema.children[2]->children[0]->format) == "u");
+  schema.release(&schema);
+  REQUIRE(schema.release == nullptr);
+
+  // Keep all batches until the end, to check they are independent.
+  std::vector<struct ArrowArray> batches;
+  while (true) {
+    struct ArrowArray batch;
+    REQUIRE(stream.get_next(&stream, &batch) == 0);
+    if (batch.release == nullptr)
+      break;
+    REQUIRE(batch.length > 0);
+    REQUIRE(batch.length <= num_records);
+    REQUIRE(batch.n_children == 3);
+    batches.push_back(batch);
+  }
+  REQUIRE(batches.size() > 1);
+  stream.release(&stream);
+  REQUIRE(stream.release == nullptr);
+
+  std::vector<uint32_t> stream_pos;
+  std::vector<std::string> stream_samples;
+  std::vector<std::string> stream_alleles;
+  for (auto& batch : batches) {
+    const struct ArrowArray* pos = batch.children[0];
+    const struct ArrowArray* samples = batch.children[1];
+    const struct ArrowArray* alleles = batch.children[2];
+    REQUIRE(pos->length == batch.length);
+    REQUIRE(samples->length == batch.length);
+    REQUIRE(alleles->length == batch.length);
+
+    auto pos_values = static_cast<const uint32_t*>(pos->buffers[1]);
+    auto sample_offsets = static_cast<const int32_t*>(samples->buffers[1]);
+    auto sample_values = static_cast<const char*>(samples->buffers[2]);
+    auto allele_lists = static_cast<const int32_t*>(alleles->buffers[1]);
+    const struct ArrowArray* allele_strings = alleles->children[0];
+    auto allele_offsets =
+        static_cast<const int32_t*>(allele_strings->buffers[1]);
+    auto allele_values = static_cast<const char*>(allele_strings->buffers[2]);
+    for (int64_t i = 0; i < batch.length; i++) {
+      stream_pos.push_back(pos_values[i]);
+      stream_samples.emplace_back(
+          sample_values + sample_offsets[i],
+          sample_offsets[i + 1] - sample_offsets[i]);
+      std::string record_alleles;
+      for (int32_t j = allele_lists[i]; j < allele_lists[i + 1]; j++)
+        record_alleles.append(
+            allele_values + allele_offsets[j],
+            allele_offsets[j + 1] - allele_offsets[j]);
+      stream_alleles.push_back(record_alleles);
+    }
+    batch.release(&batch);
+    REQUIRE(batch.release == nullptr);
+  }
+  REQUIRE(stream_pos.size() == expected_num_records);
+
+  // The reader's buffers were set back and not written to; compare the
+  // results with a regular read.
+  REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+  std::vector<uint32_t> read_pos;
+  std::vector<std::string> read_samples;
+  std::vector<std::string> read_alleles;
+  tiledb_vcf_read_status_t status = TILEDB_VCF_INCOMPLETE;
+  while (status == TILEDB_VCF_INCOMPLETE) {
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+    int64_t num = 0;
+    REQUIRE(
+        tiledb_vcf_reader_get_result_num_records(reader, &num) ==
+        TILEDB_VCF_OK);
+    for (int64_t i = 0; i < num; i++) {
+      read_pos.push_back(pos_start[i]);
+      read_samples.emplace_back(
+          sample_name.data() + sample_name_offsets[i],
+          sample_name_offsets[i + 1] - sample_name_offsets[i]);
+      std::string record_alleles;
+      for (int32_t j = alleles_list_offsets[i]; j < alleles_list_offsets[i + 1];
+           j++)
+        record_alleles.append(
+            alleles.data() + alleles_offsets[j],
+            alleles_offsets[j + 1] - alleles_offsets[j]);
+      read_alleles.push_back(record_alleles);
+    }
+  }
+  REQUIRE(status == TILEDB_VCF_COMPLETED);
+  REQUIRE(read_pos == stream_pos);
+  REQUIRE(read_samples == stream_samples);
+  REQUIRE(read_alleles == stream_alleles);
+
+  tiledb_vcf_reader_free(&reader);
+}
+
+TEST_CASE("C API: Reader batch number of records", "[capi][reader]") {
+  tiledb_vcf_reader_t* reader = nullptr;
+  REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+  std::string dataset_uri = INPUT_ARRAYS_DIR_V4 + "/ingested_2samples";
+  REQUIRE(tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+  const char* all_samples = "HG01762,HG00280";
+  REQUIRE(tiledb_vcf_reader_set_samples(reader, all_samples) == TILEDB_VCF_OK);
+  const char* ranges = "1:12100-13360,1:13500-17350";
+  REQUIRE(tiledb_vcf_reader_set_regions(reader, ranges) == TILEDB_VCF_OK);
+
+  const int64_t batch_num_records = 3;
+  REQUIRE(
+      tiledb_vcf_reader_set_batch_num_records(reader, -1) == TILEDB_VCF_ERR);
+  REQUIRE(
+      tiledb_vcf_reader_set_batch_num_records(reader, batch_num_records) ==
+      TILEDB_VCF_OK);
+
+  // The sample name buffers only hold one record.
+  const unsigned expected_num_records = 10;
+  SET_BUFF_POS_START(reader, expected_num_records);
+  SET_BUFF_SAMPLE_NAME(reader, 1);
+
+  tiledb_vcf_read_status_t status;
+  int64_t num_records = ~0;
+  REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+  REQUIRE(status == TILEDB_VCF_INCOMPLETE);
+  REQUIRE(
+      tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+      TILEDB_VCF_OK);
+  REQUIRE(num_records == 1);
+  std::vector<uint32_t> read_pos(pos_start.begin(), pos_start.begin() + 1);
+
+  // The estimate grows the overflowed buffers to hold a batch.
+  int64_t data_bytes = 0, offsets_bytes = 0, list_offsets_bytes = 0,
+          bitmap_bytes = 0;
+  REQUIRE(
+      tiledb_vcf_reader_get_buffer_size_estimate(
+          reader,
+          "sample_name",
+          batch_num_records,
+          &data_bytes,
+          &offsets_bytes,
+          &list_offsets_bytes,
+          &bitmap_bytes) == TILEDB_VCF_OK);
+  REQUIRE(data_bytes >= batch_num_records * 7);
+  REQUIRE(offsets_bytes >= (batch_num_records + 1) * int64_t(sizeof(int32_t)));
+  REQUIRE(list_offsets_bytes == 0);
+  REQUIRE(
+      tiledb_vcf_reader_get_buffer_size_estimate(
+          reader,
+          "pos_start",
+          batch_num_records,
+          &data_bytes,
+          &offsets_bytes,
+          &list_offsets_bytes,
+          &bitmap_bytes) == TILEDB_VCF_OK);
+  REQUIRE(data_bytes >= batch_num_records * int64_t(sizeof(uint32_t)));
+  REQUIRE(offsets_bytes == 0);
+  REQUIRE(
+      tiledb_vcf_reader_get_buffer_size_estimate(
+          reader,
+          "alleles",
+          batch_num_records,
+          &data_bytes,
+          &offsets_bytes,
+          &list_offsets_bytes,
+          &bitmap_bytes) == TILEDB_VCF_ERR);
+
+  // Read the rest with sample name buffers sized from the estimate.
+  REQUIRE(
+      tiledb_vcf_reader_get_buffer_size_estimate(
+          reader,
+          "sample_name",
+          batch_num_records,
+          &data_bytes,
+          &offsets_bytes,
+          &list_offsets_bytes,
+          &bitmap_bytes) == TILEDB_VCF_OK);
+  std::vector<char> batch_sample_name(data_bytes);
+  std::vector<int32_t> batch_sample_name_offsets(
+      offsets_bytes / sizeof(int32_t));
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_values(
+          reader,
+          "sample_name",
+          batch_sample_name.size(),
+          batch_sample_name.data()) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_offsets(
+          reader,
+          "sample_name",
+          sizeof(int32_t) * batch_sample_name_offsets.size(),
+          batch_sample_name_offsets.data()) == TILEDB_VCF_OK);
+
+  while (status == TILEDB_VCF_INCOMPLETE) {
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+        TILEDB_VCF_OK);
+    // Only the last batch may hold fewer records.
+    if (status == TILEDB_VCF_INCOMPLETE)
+      REQUIRE(num_records == batch_num_records);
+    else
+      REQUIRE(num_records <= batch_num_records);
+    read_pos.insert(
+        read_pos.end(), pos_start.begin(), pos_start.begin() + num_records);
+  }
+  REQUIRE(status == TILEDB_VCF_COMPLETED);
+  REQUIRE(read_pos.size() == expected_num_records);
+
+  // Without a batch number of records, a single read returns all records.
+  REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_set_batch_num_records(reader, 0) == TILEDB_VCF_OK);
+  std::vector<char> all_sample_name(expected_num_records * 10);
+  std::vector<int32_t> all_sample_name_offsets(expected_num_records + 1);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_values(
+          reader,
+          "sample_name",
+          all_sample_name.size(),
+          all_sample_name.data()) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_offsets(
+          reader,
+          "sample_name",
+          sizeof(int32_t) * all_sample_name_offsets.size(),
+          all_sample_name_offsets.data()) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+  REQUIRE(status == TILEDB_VCF_COMPLETED);
+  REQUIRE(
+      tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+      TILEDB_VCF_OK);
+  REQUIRE(num_records == expected_num_records);
+  REQUIRE(
+      std::vector<uint32_t>(pos_start.begin(), pos_start.end()) == read_pos);
+
+  tiledb_vcf_reader_free(&reader);
+}
+
+TEST_CASE("C API: Reader dictionary encoding", "[capi][reader]") {
+  tiledb_vcf_reader_t* reader = nullptr;
+  REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+  std::string dataset_uri = INPUT_ARRAYS_DIR_V4 + "/ingested_2samples";
+  REQUIRE(tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+  const char* all_samples = "HG01762,HG00280";
+  REQUIRE(tiledb_vcf_reader_set_samples(reader, all_samples) == TILEDB_VCF_OK);
+  const char* ranges = "1:12100-13360,1:13500-17350";
+  REQUIRE(tiledb_vcf_reader_set_regions(reader, ranges) == TILEDB_VCF_OK);
+
+  // Read the string values.
+  const unsigned expected_num_records = 10;
+  SET_BUFF_SAMPLE_NAME(reader, expected_num_records);
+  SET_BUFF_ALLELES(reader, expected_num_records);
+  REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+  int64_t num_records = ~0;
+  REQUIRE(
+      tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+      TILEDB_VCF_OK);
+  REQUIRE(num_records == expected_num_records);
+  std::vector<std::string> expected_samples, expected_alleles;
+  for (int64_t i = 0; i < num_records; i++) {
+    expected_samples.emplace_back(
+        sample_name.data() + sample_name_offsets[i],
+        sample_name_offsets[i + 1] - sample_name_offsets[i]);
+    std::string record_alleles;
+    for (int32_t j = alleles_list_offsets[i]; j < alleles_list_offsets[i + 1];
+         j++)
+      record_alleles += std::string(
+                            alleles.data() + alleles_offsets[j],
+                            alleles_offsets[j + 1] - alleles_offsets[j]) +
+                        ",";
+    expected_alleles.push_back(record_alleles);
+  }
+
+  // Read the same records dictionary-encoded.
+  REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+  REQUIRE(tiledb_vcf_reader_reset_buffers(reader) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_dictionary_encoding(reader, "pos_start", 1) ==
+      TILEDB_VCF_ERR);
+  REQUIRE(
+      tiledb_vcf_reader_set_dictionary_encoding(reader, "sample_name", 1) ==
+      TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_dictionary_encoding(reader, "alleles", 1) ==
+      TILEDB_VCF_OK);
+  int32_t dictionary = 0;
+  REQUIRE(
+      tiledb_vcf_reader_get_dictionary_encoding(
+          reader, "sample_name", &dictionary) == TILEDB_VCF_OK);
+  REQUIRE(dictionary == 1);
+  tiledb_vcf_attr_datatype_t datatype;
+  int32_t var_len = 0, nullable = 0, list = 0;
+  REQUIRE(
+      tiledb_vcf_reader_get_attribute_type(
+          reader, "alleles", &datatype, &var_len, &nullable, &list) ==
+      TILEDB_VCF_OK);
+  REQUIRE(datatype == TILEDB_VCF_INT32);
+  REQUIRE(var_len == 1);
+  REQUIRE(list == 0);
+
+  std::vector<int32_t> sample_indices(expected_num_records);
+  std::vector<char> sample_dict(100);
+  std::vector<int32_t> sample_dict_offsets(expected_num_records + 1);
+  std::vector<int32_t> allele_indices(3 * expected_num_records);
+  std::vector<int32_t> allele_offsets(expected_num_records + 1);
+  std::vector<char> allele_dict(200);
+  std::vector<int32_t> allele_dict_offsets(3 * expected_num_records + 1);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_values(
+          reader,
+          "sample_name",
+          sizeof(int32_t) * sample_indices.size(),
+          sample_indices.data()) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_offsets(
+          reader,
+          "sample_name",
+          sizeof(int32_t) * sample_dict_offsets.size(),
+          sample_dict_offsets.data()) == TILEDB_VCF_ERR);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_dictionary_values(
+          reader, "sample_name", sample_dict.size(), sample_dict.data()) ==
+      TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_dictionary_offsets(
+          reader,
+          "sample_name",
+          sizeof(int32_t) * sample_dict_offsets.size(),
+          sample_dict_offsets.data()) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_values(
+          reader,
+          "alleles",
+          sizeof(int32_t) * allele_indices.size(),
+          allele_indices.data()) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_offsets(
+          reader,
+          "alleles",
+          sizeof(int32_t) * allele_offsets.size(),
+          allele_offsets.data()) == TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_dictionary_values(
+          reader, "alleles", allele_dict.size(), allele_dict.data()) ==
+      TILEDB_VCF_OK);
+  REQUIRE(
+      tiledb_vcf_reader_set_buffer_dictionary_offsets(
+          reader,
+          "alleles",
+          sizeof(int32_t) * allele_dict_offsets.size(),
+          allele_dict_offsets.data()) == TILEDB_VCF_OK);
+
+  REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+  tiledb_vcf_read_status_t status;
+  REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+  REQUIRE(status == TILEDB_VCF_COMPLETED);
+  REQUIRE(
+      tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+      TILEDB_VCF_OK);
+  REQUIRE(num_records == expected_num_records);
+
+  // One dictionary entry per sample.
+  int64_t num_offsets = 0, num_data_bytes = 0;
+  REQUIRE(
+      tiledb_vcf_reader_get_dictionary_result_size(
+          reader, "sample_name", &num_offsets, &num_data_bytes) ==
+      TILEDB_VCF_OK);
+  REQUIRE(num_offsets == 3);
+  REQUIRE(num_data_bytes == 14);
+  REQUIRE(
+      tiledb_vcf_reader_get_dictionary_result_size(
+          reader, "alleles", &num_offsets, &num_data_bytes) ==
+      TILEDB_VCF_OK);
+  REQUIRE(num_offsets > 1);
+
+  auto dict_value = [](const std::vector<char>& values,
+                       const std::vector<int32_t>& offsets,
+                       int32_t index) {
+    return std::string(
+        values.data() + offsets[index], offsets[index + 1] - offsets[index]);
+  };
+  for (int64_t i = 0; i < num_records; i++) {
+    REQUIRE(
+        dict_value(sample_dict, sample_dict_offsets, sample_indices[i]) ==
+        expected_samples[i]);
+    std::string record_alleles;
+    for (int32_t j = allele_offsets[i]; j < allele_offsets[i + 1]; j++)
+      record_alleles +=
+          dict_value(allele_dict, allele_dict_offsets, allele_indices[j]) +
+          ",";
+    REQUIRE(record_alleles == expected_alleles[i]);
+  }
+
+  tiledb_vcf_reader_free(&reader);
+}
+
+TEST_CASE("C API: Reader VCF header cache", "[capi][reader]") {
+  tiledb_vcf_reader_t* reader = nullptr;
+  REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+  std::string dataset_uri =
+      INPUT_ARRAYS_DIR_V4 + "/ingested_2samples_GT_DP_PL";
+  auto bed_uri = TILEDB_VCF_TEST_INPUT_DIR + std::string("/simple.bed");
+  REQUIRE(tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+
+  // FILTER values are resolved with the sample headers
+  auto read_low_qual = [&]() {
+    REQUIRE(tiledb_vcf_reader_reset(reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_bed_file(reader, bed_uri.c_str()) ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_filter_expression(reader, "FILTER==LowQual") ==
+        TILEDB_VCF_OK);
+    const unsigned expected_num_records = 10;
+    SET_BUFF_POS_START(reader, expected_num_records);
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+    int64_t num_records = ~0;
+    REQUIRE(
+        tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+        TILEDB_VCF_OK);
+    REQUIRE(num_records == 1);
+  };
+
+  uint64_t hits = ~0, misses = ~0, evictions = ~0, num_entries = ~0,
+           size_bytes = ~0;
+  auto get_stats = [&]() {
+    REQUIRE(
+        tiledb_vcf_reader_get_vcf_header_cache_stats(
+            reader, &hits, &misses, &evictions, &num_entries, &size_bytes) ==
+        TILEDB_VCF_OK);
+  };
+
+  // The first read parses the headers of both samples
+  read_low_qual();
+  get_stats();
+  REQUIRE(hits == 0);
+  REQUIRE(misses >= 2);
+  REQUIRE(num_entries == 2);
+  REQUIRE(size_bytes > 0);
+  const uint64_t first_misses = misses;
+
+  // The second read takes them from the cache
+  read_low_qual();
+  get_stats();
+  REQUIRE(hits >= 2);
+  REQUIRE(misses == first_misses);
+  REQUIRE(evictions == 0);
+
+  // Disabling the cache empties it
+  REQUIRE(
+      tiledb_vcf_reader_set_vcf_header_cache_size(reader, 0) == TILEDB_VCF_OK);
+  read_low_qual();
+  get_stats();
+  REQUIRE(num_entries == 0);
+  REQUIRE(size_bytes == 0);
+
+  REQUIRE(
+      tiledb_vcf_reader_set_vcf_header_cache_size(reader, -1) ==
+      TILEDB_VCF_ERR);
+  REQUIRE(
+      tiledb_vcf_reader_get_vcf_header_cache_stats(
+          reader, nullptr, &misses, &evictions, &num_entries, &size_bytes) ==
+      TILEDB_VCF_ERR);
+
+  tiledb_vcf_reader_free(&reader);
+}
+
 TEST_CASE("C API: Reader submit (samples file)", "[capi][reader]") {
   tiledb_vcf_reader_t* reader = nullptr;
   REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
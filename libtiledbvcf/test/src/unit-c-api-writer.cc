@@ -31,8 +31,10 @@
 #include "catch.hpp"
 #include "dataset/tiledbvcfdataset.h"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <tuple>
 
 static const std::string INPUT_DIR =
     TILEDB_VCF_TEST_INPUT_DIR + std::string("/");
@@ -238,6 +240,254 @@ TEST_CASE("C API: Writer with vcf attributes", "[capi][writer]") {
     vfs.remove_dir(dataset_uri);
 }
 
+TEST_CASE("C API: Writer with typed attributes", "[capi][writer]") {
+  tiledb::Context ctx;
+  tiledb::VFS vfs(ctx);
+
+  std::string dataset_uri = "test_dataset";
+  if (vfs.is_dir(dataset_uri))
+    vfs.remove_dir(dataset_uri);
+
+  std::string vcf_uri = INPUT_DIR + "small.vcf";
+
+  SECTION("- Integer and Float fields") {
+    tiledb_vcf_writer_t* writer = nullptr;
+    REQUIRE(tiledb_vcf_writer_alloc(&writer) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_init(writer, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_set_vcf_attributes(writer, vcf_uri.c_str()) ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_set_typed_attributes(
+            writer, "fmt_DP,fmt_PL,fmt_GT,info_MLEAF") == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_writer_create_dataset(writer) == TILEDB_VCF_OK);
+
+    std::string samples =
+        INPUT_DIR + "small.bcf" + "," + INPUT_DIR + "small2.bcf";
+    REQUIRE(
+        tiledb_vcf_writer_set_samples(writer, samples.c_str()) ==
+        TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_writer_store(writer) == TILEDB_VCF_OK);
+    tiledb_vcf_writer_free(&writer);
+
+    tiledb::vcf::TileDBVCFDataset ds(std::make_shared<tiledb::Context>(ctx));
+    REQUIRE_NOTHROW(ds.open(dataset_uri));
+    tiledb_datatype_t datatype;
+    REQUIRE(ds.is_attribute_typed("fmt_DP", &datatype));
+    REQUIRE(datatype == TILEDB_INT32);
+    REQUIRE(ds.is_attribute_typed("fmt_PL", &datatype));
+    REQUIRE(datatype == TILEDB_INT32);
+    REQUIRE(ds.is_attribute_typed("fmt_GT", &datatype));
+    REQUIRE(datatype == TILEDB_INT32);
+    REQUIRE(ds.is_attribute_typed("info_MLEAF", &datatype));
+    REQUIRE(datatype == TILEDB_FLOAT32);
+    REQUIRE(!ds.is_attribute_typed("fmt_GQ"));
+    REQUIRE(!ds.is_attribute_typed("info_DP"));
+  }
+
+  SECTION("- Requires vcf attributes") {
+    tiledb_vcf_writer_t* writer = nullptr;
+    REQUIRE(tiledb_vcf_writer_alloc(&writer) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_init(writer, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_set_extra_attributes(writer, "fmt_DP") ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_set_typed_attributes(writer, "fmt_DP") ==
+        TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_writer_create_dataset(writer) == TILEDB_VCF_ERR);
+    tiledb_vcf_writer_free(&writer);
+  }
+
+  SECTION("- Non-numeric field") {
+    tiledb_vcf_writer_t* writer = nullptr;
+    REQUIRE(tiledb_vcf_writer_alloc(&writer) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_init(writer, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_set_vcf_attributes(writer, vcf_uri.c_str()) ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_set_typed_attributes(writer, "info_DS") ==
+        TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_writer_create_dataset(writer) == TILEDB_VCF_ERR);
+    tiledb_vcf_writer_free(&writer);
+  }
+
+  if (vfs.is_dir(dataset_uri))
+    vfs.remove_dir(dataset_uri);
+}
+
+TEST_CASE(
+    "C API: Writer with typed attributes round trip", "[capi][writer]") {
+  tiledb::Context ctx;
+  tiledb::VFS vfs(ctx);
+
+  std::string vcf_uri = INPUT_DIR + "small.vcf";
+  // small3.bcf has records without DP and PL, and records with MLEAF
+  std::string samples =
+      INPUT_DIR + "small.bcf" + "," + INPUT_DIR + "small3.bcf";
+  const std::vector<std::string> attrs = {
+      "fmt_DP", "fmt_PL", "fmt_GT", "info_MLEAF"};
+
+  auto ingest = [&](const std::string& dataset_uri, bool typed) {
+    if (vfs.is_dir(dataset_uri))
+      vfs.remove_dir(dataset_uri);
+    tiledb_vcf_writer_t* writer = nullptr;
+    REQUIRE(tiledb_vcf_writer_alloc(&writer) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_init(writer, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_set_vcf_attributes(writer, vcf_uri.c_str()) ==
+        TILEDB_VCF_OK);
+    if (typed)
+      REQUIRE(
+          tiledb_vcf_writer_set_typed_attributes(
+              writer, "fmt_DP,fmt_PL,fmt_GT,info_MLEAF") == TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_writer_create_dataset(writer) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_writer_set_samples(writer, samples.c_str()) ==
+        TILEDB_VCF_OK);
+    REQUIRE(tiledb_vcf_writer_store(writer) == TILEDB_VCF_OK);
+    tiledb_vcf_writer_free(&writer);
+  };
+
+  // Returns the (sample, start, values) of the records read, sorted. The
+  // values of each attribute are its raw bytes, or nothing if it is null.
+  using Value = std::pair<bool, std::string>;
+  using Record = std::tuple<std::string, uint32_t, std::vector<Value>>;
+  auto read_records = [&](const std::string& dataset_uri,
+                          const std::string& expression) {
+    tiledb_vcf_reader_t* reader = nullptr;
+    REQUIRE(tiledb_vcf_reader_alloc(&reader) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_init(reader, dataset_uri.c_str()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_samples(reader, "HG00280,HG01762") ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_filter_expression(reader, expression.c_str()) ==
+        TILEDB_VCF_OK);
+
+    const unsigned max_records = 1000;
+    std::vector<uint32_t> pos_start(max_records);
+    std::vector<int32_t> sample_name_offsets(max_records + 1);
+    std::vector<char> sample_name(max_records * 10);
+    REQUIRE(
+        tiledb_vcf_reader_set_buffer_values(
+            reader,
+            "pos_start",
+            sizeof(uint32_t) * pos_start.size(),
+            pos_start.data()) == TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_buffer_values(
+            reader, "sample_name", sample_name.size(), sample_name.data()) ==
+        TILEDB_VCF_OK);
+    REQUIRE(
+        tiledb_vcf_reader_set_buffer_offsets(
+            reader,
+            "sample_name",
+            sizeof(int32_t) * sample_name_offsets.size(),
+            sample_name_offsets.data()) == TILEDB_VCF_OK);
+
+    // All attributes hold 4-byte values
+    std::vector<std::vector<int32_t>> values(
+        attrs.size(), std::vector<int32_t>(max_records * 10));
+    std::vector<std::vector<int32_t>> offsets(
+        attrs.size(), std::vector<int32_t>(max_records + 1));
+    std::vector<std::vector<uint8_t>> bitmaps(
+        attrs.size(), std::vector<uint8_t>(max_records / 8 + 1));
+    for (size_t a = 0; a < attrs.size(); a++) {
+      REQUIRE(
+          tiledb_vcf_reader_set_buffer_values(
+              reader,
+              attrs[a].c_str(),
+              sizeof(int32_t) * values[a].size(),
+              values[a].data()) == TILEDB_VCF_OK);
+      REQUIRE(
+          tiledb_vcf_reader_set_buffer_offsets(
+              reader,
+              attrs[a].c_str(),
+              sizeof(int32_t) * offsets[a].size(),
+              offsets[a].data()) == TILEDB_VCF_OK);
+      REQUIRE(
+          tiledb_vcf_reader_set_buffer_validity_bitmap(
+              reader,
+              attrs[a].c_str(),
+              bitmaps[a].size(),
+              bitmaps[a].data()) == TILEDB_VCF_OK);
+    }
+
+    REQUIRE(tiledb_vcf_reader_read(reader) == TILEDB_VCF_OK);
+    tiledb_vcf_read_status_t status;
+    REQUIRE(tiledb_vcf_reader_get_status(reader, &status) == TILEDB_VCF_OK);
+    REQUIRE(status == TILEDB_VCF_COMPLETED);
+
+    int64_t num_records = ~0;
+    REQUIRE(
+        tiledb_vcf_reader_get_result_num_records(reader, &num_records) ==
+        TILEDB_VCF_OK);
+
+    std::vector<Record> records;
+    for (int64_t i = 0; i < num_records; i++) {
+      std::string sample(
+          sample_name.data() + sample_name_offsets[i],
+          sample_name_offsets[i + 1] - sample_name_offsets[i]);
+      std::vector<Value> record_values;
+      for (size_t a = 0; a < attrs.size(); a++) {
+        const bool valid = (bitmaps[a][i / 8] >> (i % 8)) & 1;
+        std::string bytes;
+        if (valid)
+          bytes.assign(
+              reinterpret_cast<const char*>(
+                  values[a].data() + offsets[a][i]),
+              sizeof(int32_t) * (offsets[a][i + 1] - offsets[a][i]));
+        record_values.emplace_back(valid, bytes);
+      }
+      records.emplace_back(sample, pos_start[i], record_values);
+    }
+    std::sort(records.begin(), records.end());
+
+    tiledb_vcf_reader_free(&reader);
+    return records;
+  };
+
+  std::string dataset_uri = "test_dataset";
+  std::string typed_dataset_uri = "test_dataset_typed";
+  ingest(dataset_uri, false);
+  ingest(typed_dataset_uri, true);
+
+  auto expected = read_records(dataset_uri, "");
+  REQUIRE(expected.size() >= 73);
+  REQUIRE(read_records(typed_dataset_uri, "") == expected);
+
+  // Missing values are read as nulls from both layouts
+  auto count_nulls = [&](size_t a) {
+    return std::count_if(
+        expected.begin(), expected.end(), [a](const Record& r) {
+          return !std::get<2>(r)[a].first;
+        });
+  };
+  for (size_t a = 0; a < attrs.size(); a++) {
+    if (attrs[a] != "fmt_GT")
+      REQUIRE(count_nulls(a) > 0);
+    REQUIRE(count_nulls(a) < static_cast<long>(expected.size()));
+  }
+
+  // Filters are evaluated on the values of either layout
+  auto filtered = read_records(dataset_uri, "fmt_DP>5");
+  REQUIRE(!filtered.empty());
+  REQUIRE(filtered.size() < expected.size());
+  REQUIRE(read_records(typed_dataset_uri, "fmt_DP>5") == filtered);
+
+  if (vfs.is_dir(dataset_uri))
+    vfs.remove_dir(dataset_uri);
+  if (vfs.is_dir(typed_dataset_uri))
+    vfs.remove_dir(typed_dataset_uri);
+}
+
 TEST_CASE(
     "C API: Writer store with overlapping records",
     "[capi][writer][overlapping]") {
@@ -0,0 +1,257 @@
+/**
+ * @file   unit-cell-filter.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Tests for CellFilter.
+ */
+
+#include "catch.hpp"
+
+#include "read/cell_filter.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace tiledb::vcf;
+
+namespace {
+
+/** Test regions, sorted on start. */
+struct Regions {
+  std::vector<uint32_t> mins;
+  std::vector<uint32_t> maxes;
+};
+
+/** Test cells. */
+struct Cells {
+  std::vector<uint32_t> start;
+  std::vector<uint32_t> real_start;
+  std::vector<uint32_t> end;
+};
+
+/** Region check done by Reader::process_query_results_v4 for a single pair. */
+bool intersects(
+    const Regions& regions,
+    size_t j,
+    uint32_t start,
+    uint32_t real_start,
+    uint32_t end,
+    uint32_t anchor_gap) {
+  const uint32_t reg_min = regions.mins[j];
+  const uint32_t reg_max = regions.maxes[j];
+  if (real_start > reg_max || end < reg_min)
+    return false;
+  if (start != real_start && start >= reg_min)
+    return false;
+  if (anchor_gap < reg_min && start < reg_min - anchor_gap)
+    return false;
+  return true;
+}
+
+/** Checks every cell/region pair and compares with the filter's selection. */
+void check_selection(
+    const Regions& regions,
+    const Cells& cells,
+    uint32_t anchor_gap,
+    const std::vector<size_t>* order,
+    bool avx2) {
+  RegionIntersector intersector(regions.maxes);
+  CellFilter filter(regions.mins, regions.maxes, anchor_gap);
+  filter.set_avx2_enabled(avx2);
+
+  const size_t num_cells = cells.start.size();
+  filter.select(
+      cells.start.data(),
+      cells.real_start.data(),
+      cells.end.data(),
+      order == nullptr ? nullptr : order->data(),
+      0,
+      num_cells,
+      &intersector);
+
+  // Regions reported per visit position by the filtered loop
+  std::vector<std::set<size_t>> filtered(num_cells);
+  for (const auto& cell : filter.selected()) {
+    const size_t i = order == nullptr ? cell.pos : (*order)[cell.pos];
+    const uint32_t start = cells.start[i];
+    const uint32_t real_start = cells.real_start[i];
+    const uint32_t end = cells.end[i];
+    if (!cell.scan_regions) {
+      REQUIRE(intersects(
+          regions, cell.first_region, start, real_start, end, anchor_gap));
+      filtered[cell.pos].insert(cell.first_region);
+      continue;
+    }
+    for (size_t j = cell.first_region; j < regions.mins.size(); j++) {
+      if (end < regions.mins[j])
+        break;
+      if (intersects(regions, j, start, real_start, end, anchor_gap))
+        filtered[cell.pos].insert(j);
+    }
+  }
+
+  for (size_t pos = 0; pos < num_cells; pos++) {
+    const size_t i = order == nullptr ? pos : (*order)[pos];
+    std::set<size_t> expected;
+    for (size_t j = 0; j < regions.mins.size(); j++) {
+      if (intersects(
+              regions,
+              j,
+              cells.start[i],
+              cells.real_start[i],
+              cells.end[i],
+              anchor_gap))
+        expected.insert(j);
+    }
+    REQUIRE(filtered[pos] == expected);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("CellFilter: Anchor gap checks", "[tiledbvcf][region]") {
+  const uint32_t anchor_gap = 10;
+  // Regions [100,200], [300,400]
+  Regions regions = {{100, 300}, {200, 400}};
+  // Cells:
+  //   0: record inside the first region
+  //   1: record ending before the first region
+  //   2: anchor of a record spanning the first region, within the anchor gap
+  //   3: anchor inside the first region
+  //   4: anchor further than the anchor gap from the first region
+  //   5: record spanning both regions
+  //   6: record after all regions
+  Cells cells = {
+      {150, 50, 95, 150, 80, 190, 500},
+      {150, 50, 20, 20, 20, 190, 500},
+      {160, 60, 150, 250, 150, 350, 510}};
+
+  for (bool avx2 : {false, true}) {
+    RegionIntersector intersector(regions.maxes);
+    CellFilter filter(regions.mins, regions.maxes, anchor_gap);
+    filter.set_avx2_enabled(avx2);
+    filter.select(
+        cells.start.data(),
+        cells.real_start.data(),
+        cells.end.data(),
+        nullptr,
+        0,
+        cells.start.size(),
+        &intersector);
+
+    const auto& selected = filter.selected();
+    REQUIRE(selected.size() == 3);
+    REQUIRE(selected[0].pos == 0);
+    REQUIRE(selected[0].first_region == 0);
+    REQUIRE(!selected[0].scan_regions);
+    REQUIRE(selected[1].pos == 2);
+    REQUIRE(selected[1].first_region == 0);
+    REQUIRE(!selected[1].scan_regions);
+    REQUIRE(selected[2].pos == 5);
+    REQUIRE(selected[2].first_region == 0);
+    REQUIRE(selected[2].scan_regions);
+  }
+
+  check_selection(regions, cells, anchor_gap, nullptr, false);
+  check_selection(regions, cells, anchor_gap, nullptr, true);
+}
+
+TEST_CASE("CellFilter: Partial batch", "[tiledbvcf][region]") {
+  Regions regions = {{100}, {200}};
+  Cells cells = {{150, 150, 150}, {150, 150, 150}, {160, 160, 160}};
+
+  RegionIntersector intersector(regions.maxes);
+  CellFilter filter(regions.mins, regions.maxes, 0);
+  filter.select(
+      cells.start.data(),
+      cells.real_start.data(),
+      cells.end.data(),
+      nullptr,
+      1,
+      cells.start.size(),
+      &intersector);
+
+  const auto& selected = filter.selected();
+  REQUIRE(selected.size() == 2);
+  REQUIRE(selected[0].pos == 1);
+  REQUIRE(selected[1].pos == 2);
+}
+
+TEST_CASE("CellFilter: Random cells", "[tiledbvcf][region]") {
+  std::mt19937 gen(5678);
+  auto anchor_gap = GENERATE(0u, 1000u);
+  auto max_region_width = GENERATE(10u, 3000u);
+  bool avx2 = GENERATE(false, true);
+
+  // Regions sorted on start, possibly overlapping
+  Regions regions;
+  std::uniform_int_distribution<uint32_t> gap(1, 500);
+  std::uniform_int_distribution<uint32_t> width(0, max_region_width);
+  uint32_t region_start = 1;
+  for (int j = 0; j < 200; j++) {
+    region_start += gap(gen);
+    regions.mins.push_back(region_start);
+    regions.maxes.push_back(region_start + width(gen));
+  }
+
+  // Records with anchors every anchor_gap positions
+  Cells cells;
+  std::uniform_int_distribution<uint32_t> pos(0, region_start + 1000);
+  std::uniform_int_distribution<uint32_t> length(0, 5000);
+  for (int r = 0; r < 1000; r++) {
+    const uint32_t real_start = pos(gen);
+    const uint32_t end = real_start + length(gen);
+    cells.start.push_back(real_start);
+    cells.real_start.push_back(real_start);
+    cells.end.push_back(end);
+    if (anchor_gap == 0)
+      continue;
+    for (uint32_t anchor = real_start + anchor_gap; anchor <= end;
+         anchor += anchor_gap) {
+      cells.start.push_back(anchor);
+      cells.real_start.push_back(real_start);
+      cells.end.push_back(end);
+    }
+  }
+
+  SECTION("- Column order") {
+    check_selection(regions, cells, anchor_gap, nullptr, avx2);
+  }
+
+  SECTION("- Sorted on real_start") {
+    std::vector<size_t> order(cells.start.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return cells.real_start[a] < cells.real_start[b];
+    });
+    check_selection(regions, cells, anchor_gap, &order, avx2);
+  }
+}
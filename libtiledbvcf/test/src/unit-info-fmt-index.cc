@@ -0,0 +1,154 @@
+/**
+ * @file   unit-cell-filter.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Tests for InfoFmtIndex.
+ */
+
+#include "catch.hpp"
+
+#include "read/info_fmt_index.h"
+
+#include <htslib/vcf.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace tiledb::vcf;
+
+namespace {
+
+/** Appends a field to a blob, in the "key\0,type,nvalues,values" layout. */
+template <typename T>
+void append_field(
+    std::string* blob,
+    const std::string& key,
+    int type,
+    const std::vector<T>& values) {
+  const int num_values = values.size();
+  blob->append(key.c_str(), key.size() + 1);
+  blob->append(reinterpret_cast<const char*>(&type), sizeof(int));
+  blob->append(reinterpret_cast<const char*>(&num_values), sizeof(int));
+  blob->append(
+      reinterpret_cast<const char*>(values.data()), sizeof(T) * num_values);
+}
+
+/** Returns an empty blob holding the number of fields. */
+std::string make_blob(uint32_t num_fields) {
+  return std::string(reinterpret_cast<const char*>(&num_fields), 4);
+}
+
+/** Reads a value of a field (values in the blob are not aligned). */
+template <typename T>
+T value_at(const InfoFmtIndex::Field* field, int i) {
+  T value;
+  std::memcpy(&value, field->values + i * sizeof(T), sizeof(T));
+  return value;
+}
+
+}  // namespace
+
+TEST_CASE("InfoFmtIndex: Find fields", "[info_fmt_index]") {
+  std::string cell0 = make_blob(3);
+  append_field<int32_t>(&cell0, "GQ", BCF_HT_INT, {10});
+  append_field<int32_t>(&cell0, "DP", BCF_HT_INT, {7});
+  append_field<float>(&cell0, "AF", BCF_HT_REAL, {0.5f, 0.25f});
+
+  std::string cell1 = make_blob(2);
+  append_field<char>(&cell1, "MIN_DP", BCF_HT_STR, {'a', 'b', 'c'});
+  append_field<int32_t>(&cell1, "DP", BCF_HT_INT, {3});
+
+  InfoFmtIndex index;
+  index.reset(2);
+  const uint32_t dp = index.key_id("DP");
+  const uint32_t af = index.key_id("AF");
+  const uint32_t pl = index.key_id("PL");
+  REQUIRE(index.key_id("DP") == dp);
+  REQUIRE(dp != af);
+
+  auto field = index.find(0, cell0.data(), cell0.size(), dp);
+  REQUIRE(field != nullptr);
+  REQUIRE(field->type == BCF_HT_INT);
+  REQUIRE(field->num_values == 1);
+  REQUIRE(value_at<int32_t>(field, 0) == 7);
+
+  field = index.find(0, cell0.data(), cell0.size(), af);
+  REQUIRE(field != nullptr);
+  REQUIRE(field->type == BCF_HT_REAL);
+  REQUIRE(field->num_values == 2);
+  REQUIRE(value_at<float>(field, 1) == 0.25f);
+  REQUIRE(index.find(0, cell0.data(), cell0.size(), pl) == nullptr);
+  REQUIRE(index.num_decoded_cells() == 1);
+
+  field = index.find(1, cell1.data(), cell1.size(), index.key_id("MIN_DP"));
+  REQUIRE(field != nullptr);
+  REQUIRE(field->type == BCF_HT_STR);
+  REQUIRE(std::string(field->values, field->num_values) == "abc");
+  field = index.find(1, cell1.data(), cell1.size(), dp);
+  REQUIRE(field != nullptr);
+  REQUIRE(value_at<int32_t>(field, 0) == 3);
+  REQUIRE(index.find(1, cell1.data(), cell1.size(), af) == nullptr);
+  REQUIRE(index.num_decoded_cells() == 2);
+
+  // Key ids are kept across batches.
+  index.reset(1);
+  REQUIRE(index.num_decoded_cells() == 0);
+  REQUIRE(index.key_id("DP") == dp);
+  field = index.find(0, cell1.data(), cell1.size(), dp);
+  REQUIRE(field != nullptr);
+  REQUIRE(value_at<int32_t>(field, 0) == 3);
+}
+
+TEST_CASE("InfoFmtIndex: Empty blobs", "[info_fmt_index]") {
+  const std::string null_blob(1, '\0');
+  const std::string empty_blob = make_blob(0);
+
+  InfoFmtIndex index;
+  index.reset(2);
+  const uint32_t dp = index.key_id("DP");
+  REQUIRE(index.find(0, null_blob.data(), null_blob.size(), dp) == nullptr);
+  REQUIRE(index.find(1, empty_blob.data(), empty_blob.size(), dp) == nullptr);
+  REQUIRE(index.num_decoded_cells() == 2);
+}
+
+TEST_CASE("InfoFmtIndex: Copy", "[info_fmt_index]") {
+  std::string cell = make_blob(1);
+  append_field<int32_t>(&cell, "DP", BCF_HT_INT, {7});
+
+  InfoFmtIndex index;
+  index.reset(1);
+  const uint32_t dp = index.key_id("DP");
+  const uint32_t gq = index.key_id("GQ");
+
+  InfoFmtIndex copy(index);
+  index = InfoFmtIndex();
+  REQUIRE(copy.key_id("GQ") == gq);
+  REQUIRE(copy.key_id("DP") == dp);
+  REQUIRE(copy.find(0, cell.data(), cell.size(), dp) != nullptr);
+}
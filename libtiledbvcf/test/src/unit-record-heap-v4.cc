@@ -0,0 +1,374 @@
+/**
+ * @file   unit-region-intersector.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *
+ * @section DESCRIPTION
+ *
+ * Tests for RecordHeapV4.
+ */
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+
+#include "write/record_heap_v4.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace tiledb::vcf;
+
+namespace {
+
+/**
+ * Record heap previously used by WriterWorkerV4: a priority queue of
+ * individually allocated nodes holding copies of the contig and sample names.
+ */
+class LegacyRecordHeap {
+ public:
+  struct Node {
+    VCFV4* vcf;
+    RecordHeapV4::NodeType type;
+    SafeSharedBCFRec record;
+    std::string contig;
+    uint32_t start_pos;
+    uint32_t end_pos;
+    std::string sample_name;
+  };
+
+  bool empty() const {
+    return heap_.empty();
+  }
+
+  void insert(
+      VCFV4* vcf,
+      RecordHeapV4::NodeType type,
+      SafeSharedBCFRec record,
+      const std::string& contig,
+      uint32_t start_pos,
+      uint32_t end_pos,
+      const std::string& sample_name) {
+    auto node = std::unique_ptr<Node>(new Node);
+    node->vcf = vcf;
+    node->type = type;
+    node->record = std::move(record);
+    node->contig = contig;
+    node->start_pos = start_pos;
+    node->end_pos = end_pos;
+    node->sample_name = sample_name;
+    heap_.push(std::move(node));
+  }
+
+  const Node& top() const {
+    return *heap_.top();
+  }
+
+  void pop() {
+    heap_.pop();
+  }
+
+ private:
+  struct NodeCompareGT {
+    bool operator()(
+        const std::unique_ptr<Node>& a, const std::unique_ptr<Node>& b) const {
+      auto a_start = a->start_pos, b_start = b->start_pos;
+      auto a_contig = a->contig, b_contig = b->contig;
+      return a_contig > b_contig ||
+             (a_contig == b_contig && a_start > b_start) ||
+             (a_contig == b_contig && a_start == b_start &&
+              a->sample_name > b->sample_name);
+    }
+  };
+
+  std::priority_queue<
+      std::unique_ptr<Node>,
+      std::vector<std::unique_ptr<Node>>,
+      NodeCompareGT>
+      heap_;
+};
+
+/** A record of a simulated sample, with its end position. */
+struct SimRecord {
+  SafeSharedBCFRec record;
+  uint32_t end_pos;
+};
+
+/** Position-sorted records of a set of samples on one contig. */
+struct Simulation {
+  std::string contig;
+  std::vector<std::string> sample_names;
+  std::vector<std::vector<SimRecord>> records;
+};
+
+/** A node popped from a heap: (contig, start, sample name). */
+typedef std::tuple<std::string, uint32_t, std::string> Popped;
+
+/**
+ * The heaps never dereference the VCF of a node outside of error paths, so
+ * the simulation stores the sample index in it, as the worker identifies the
+ * sample of a node by its VCF.
+ */
+VCFV4* sample_key(uint32_t sample) {
+  return reinterpret_cast<VCFV4*>(static_cast<uintptr_t>(sample) + 1);
+}
+
+uint32_t sample_of(const VCFV4* vcf) {
+  return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(vcf) - 1);
+}
+
+void insert(
+    LegacyRecordHeap& heap,
+    const Simulation& sim,
+    uint32_t sample,
+    RecordHeapV4::NodeType type,
+    const SafeSharedBCFRec& record,
+    uint32_t start_pos,
+    uint32_t end_pos) {
+  heap.insert(
+      sample_key(sample),
+      type,
+      record,
+      sim.contig,
+      start_pos,
+      end_pos,
+      sim.sample_names[sample]);
+}
+
+void insert(
+    RecordHeapV4& heap,
+    const Simulation& sim,
+    uint32_t sample,
+    RecordHeapV4::NodeType type,
+    const SafeSharedBCFRec& record,
+    uint32_t start_pos,
+    uint32_t end_pos) {
+  heap.insert(
+      sample_key(sample), type, record, sim.contig, start_pos, end_pos, sample);
+}
+
+Popped popped(const LegacyRecordHeap::Node& node) {
+  return Popped(node.contig, node.start_pos, node.sample_name);
+}
+
+Popped popped(const RecordHeapV4::Node& node) {
+  return Popped(*node.contig, node.start_pos, *node.sample_name);
+}
+
+/**
+ * Merges the records of the simulated samples as WriterWorkerV4::resume()
+ * does, re-inserting records spanning anchor gaps as anchors. Returns the
+ * number of nodes popped, appending them to `result` if not null.
+ */
+template <typename Heap>
+uint64_t merge(
+    Heap& heap,
+    const Simulation& sim,
+    uint32_t anchor_gap,
+    std::vector<Popped>* result) {
+  const auto num_samples = static_cast<uint32_t>(sim.records.size());
+  std::vector<size_t> next(num_samples, 0);
+  auto insert_next = [&](uint32_t sample) {
+    const SimRecord& r = sim.records[sample][next[sample]++];
+    insert(
+        heap,
+        sim,
+        sample,
+        RecordHeapV4::NodeType::Record,
+        r.record,
+        r.record->pos,
+        r.end_pos);
+  };
+
+  for (uint32_t sample = 0; sample < num_samples; sample++) {
+    if (!sim.records[sample].empty())
+      insert_next(sample);
+  }
+
+  uint64_t num_popped = 0;
+  while (!heap.empty()) {
+    const auto& top = heap.top();
+    const uint32_t sample = sample_of(top.vcf);
+    const auto& records = sim.records[sample];
+    if (result != nullptr)
+      result->push_back(popped(top));
+    num_popped++;
+
+    const bool is_end_node = top.end_pos == top.start_pos ||
+                             (top.end_pos - top.start_pos - 1) < anchor_gap;
+    if (is_end_node) {
+      heap.pop();
+      if (next[sample] < records.size())
+        insert_next(sample);
+    } else {
+      const uint32_t anchor_start = top.start_pos + anchor_gap;
+      insert(
+          heap,
+          sim,
+          sample,
+          RecordHeapV4::NodeType::Anchor,
+          top.record,
+          anchor_start,
+          top.end_pos);
+      heap.pop();
+      if (next[sample] < records.size() &&
+          static_cast<uint32_t>(records[next[sample]].record->pos) <
+              anchor_start)
+        insert_next(sample);
+    }
+  }
+  return num_popped;
+}
+
+/**
+ * Simulates samples with records of random lengths; sample names are not in
+ * sample index order.
+ */
+Simulation simulate(
+    uint32_t num_samples,
+    uint32_t records_per_sample,
+    uint32_t max_length,
+    std::mt19937& gen) {
+  std::uniform_int_distribution<uint32_t> gap(0, 20);
+  std::uniform_int_distribution<uint32_t> length(0, max_length);
+  std::bernoulli_distribution is_long(0.05);
+
+  Simulation sim;
+  sim.contig = "chr1";
+  for (uint32_t s = 0; s < num_samples; s++)
+    sim.sample_names.push_back("sample" + std::to_string(num_samples - s));
+  sim.records.resize(num_samples);
+  for (auto& records : sim.records) {
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < records_per_sample; i++) {
+      pos += gap(gen);
+      SafeSharedBCFRec r(bcf_init(), bcf_destroy);
+      r->pos = pos;
+      const uint32_t end_pos = is_long(gen) ? pos + length(gen) : pos;
+      records.push_back({r, end_pos});
+    }
+  }
+  return sim;
+}
+
+}  // namespace
+
+TEST_CASE("RecordHeapV4: Global order", "[tiledbvcf][record-heap]") {
+  const std::vector<std::string> sample_names = {"s2", "s10", "s1"};
+  RecordHeapV4 heap;
+  heap.init(sample_names);
+  REQUIRE(heap.empty());
+
+  SafeSharedBCFRec r(bcf_init(), bcf_destroy);
+  r->pos = 0;
+  const auto type = RecordHeapV4::NodeType::Record;
+  heap.insert(nullptr, type, r, "2", 5, 5, 0);
+  heap.insert(nullptr, type, r, "10", 7, 7, 1);
+  heap.insert(nullptr, type, r, "2", 5, 5, 2);
+  heap.insert(nullptr, type, r, "2", 3, 9, 1);
+  heap.insert(nullptr, type, r, "10", 7, 7, 0);
+  heap.insert(nullptr, type, r, "2", 5, 5, 1);
+  REQUIRE(r.use_count() == 7);
+
+  // Contigs sort by name, ties on start position by sample name.
+  const std::vector<Popped> expected = {
+      Popped("10", 7, "s10"),
+      Popped("10", 7, "s2"),
+      Popped("2", 3, "s10"),
+      Popped("2", 5, "s1"),
+      Popped("2", 5, "s10"),
+      Popped("2", 5, "s2"),
+  };
+  std::vector<Popped> result;
+  while (!heap.empty()) {
+    const auto& top = heap.top();
+    REQUIRE(*top.sample_name == sample_names[top.sample]);
+    result.push_back(popped(top));
+    heap.pop();
+  }
+  REQUIRE(result == expected);
+
+  // Popped nodes release their records.
+  REQUIRE(r.use_count() == 1);
+
+  heap.insert(nullptr, type, r, "1", 1, 1, 2);
+  heap.clear();
+  REQUIRE(heap.empty());
+  REQUIRE(r.use_count() == 1);
+
+  // Inserting a node starting before its record fails.
+  r->pos = 10;
+  REQUIRE_THROWS(heap.insert(nullptr, type, r, "1", 9, 10, 0));
+  REQUIRE(heap.empty());
+}
+
+TEST_CASE("RecordHeapV4: Merge with anchors", "[tiledbvcf][record-heap]") {
+  std::mt19937 gen(1234);
+  auto num_samples = GENERATE(1u, 2u, 7u, 64u);
+  auto anchor_gap = GENERATE(10u, 1000u);
+  Simulation sim = simulate(num_samples, 200, 5000, gen);
+
+  LegacyRecordHeap legacy_heap;
+  std::vector<Popped> expected;
+  merge(legacy_heap, sim, anchor_gap, &expected);
+
+  RecordHeapV4 heap;
+  heap.init(sim.sample_names);
+  std::vector<Popped> result;
+  merge(heap, sim, anchor_gap, &result);
+  REQUIRE(std::is_sorted(result.begin(), result.end()));
+  REQUIRE(result == expected);
+
+  // The heap can be reused once drained.
+  result.clear();
+  merge(heap, sim, anchor_gap, &result);
+  REQUIRE(result == expected);
+}
+
+TEST_CASE(
+    "RecordHeapV4: Benchmark against priority queue",
+    "[.][record-heap][benchmark]") {
+  std::mt19937 gen(1234);
+  const uint32_t anchor_gap = 1000;
+  Simulation sim = simulate(200, 5000, 5000, gen);
+
+  LegacyRecordHeap legacy_heap;
+  const uint64_t num_nodes = merge(legacy_heap, sim, anchor_gap, nullptr);
+  WARN("Merging " << num_nodes << " records and anchors per run");
+
+  BENCHMARK("Priority queue") {
+    return merge(legacy_heap, sim, anchor_gap, nullptr);
+  };
+
+  RecordHeapV4 heap;
+  BENCHMARK("Tournament tree") {
+    heap.init(sim.sample_names);
+    return merge(heap, sim, anchor_gap, nullptr);
+  };
+}
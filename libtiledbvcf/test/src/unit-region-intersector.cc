@@ -0,0 +1,240 @@
+/**
+ * @file   unit-region-intersector.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Tests for RegionIntersector.
+ */
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+
+#include "read/region_intersector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace tiledb::vcf;
+
+namespace {
+
+/** Brute-force reference: first region whose end is >= real_start. */
+size_t first_intersecting_linear(
+    const std::vector<uint32_t>& region_ends, uint32_t real_start) {
+  for (size_t i = 0; i < region_ends.size(); i++) {
+    if (region_ends[i] >= real_start)
+      return i;
+  }
+  return region_ends.size();
+}
+
+/** Super region, as previously stored per contig by the Reader. */
+struct SuperRegion {
+  size_t region_min;
+  uint32_t end_max;
+};
+
+/** Super region construction previously done in Reader::prepare_regions_v4. */
+std::vector<SuperRegion> build_super_regions(
+    const std::vector<uint32_t>& region_ends) {
+  std::vector<SuperRegion> result;
+  SuperRegion super_region = {SIZE_MAX, 0};
+  int super_region_size = 0;
+  for (size_t i = 0; i < region_ends.size(); i++) {
+    auto end = region_ends[i];
+    if (super_region_size >= 1 && end >= super_region.end_max) {
+      result.emplace_back(super_region);
+      super_region = {SIZE_MAX, 0};
+      super_region_size = 0;
+    }
+    super_region.region_min = std::min(super_region.region_min, i);
+    super_region.end_max = std::max(super_region.end_max, end);
+    super_region_size++;
+  }
+  if (super_region_size)
+    result.emplace_back(super_region);
+  return result;
+}
+
+/**
+ * Per-cell lookup previously done in Reader::first_intersecting_region,
+ * including the by-value copy of the contig's super regions.
+ */
+size_t first_intersecting_legacy(
+    const std::unordered_map<std::string, std::vector<SuperRegion>>& map,
+    const std::string& contig,
+    uint32_t real_start) {
+  std::vector<SuperRegion> super_regions = map.find(contig)->second;
+  auto it = std::lower_bound(
+      super_regions.begin(),
+      super_regions.end(),
+      real_start,
+      [&](const SuperRegion& sr, const unsigned value) {
+        return sr.end_max < value;
+      });
+  return it == super_regions.end() ? SIZE_MAX : it->region_min;
+}
+
+/** Generates regions sorted by start, of random width. */
+std::vector<uint32_t> random_region_ends(
+    size_t num_regions, uint32_t max_width, std::mt19937& gen) {
+  std::uniform_int_distribution<uint32_t> gap(0, 100);
+  std::uniform_int_distribution<uint32_t> width(0, max_width);
+  std::vector<uint32_t> region_ends;
+  uint32_t start = 1;
+  for (size_t i = 0; i < num_regions; i++) {
+    start += gap(gen);
+    region_ends.push_back(start + width(gen));
+  }
+  return region_ends;
+}
+
+}  // namespace
+
+TEST_CASE("RegionIntersector: Empty", "[tiledbvcf][region]") {
+  RegionIntersector intersector;
+  REQUIRE(intersector.size() == 0);
+  REQUIRE(!intersector.has_overlaps());
+  REQUIRE(intersector.first_intersecting(0) == 0);
+  REQUIRE(intersector.first_intersecting(100) == 0);
+}
+
+TEST_CASE("RegionIntersector: Disjoint regions", "[tiledbvcf][region]") {
+  // Regions [10,20], [30,40], [50,60]
+  RegionIntersector intersector({20, 40, 60});
+  REQUIRE(intersector.size() == 3);
+  REQUIRE(!intersector.has_overlaps());
+
+  REQUIRE(intersector.first_intersecting(1) == 0);
+  REQUIRE(intersector.first_intersecting(20) == 0);
+  REQUIRE(intersector.first_intersecting(21) == 1);
+  REQUIRE(intersector.first_intersecting(40) == 1);
+  REQUIRE(intersector.first_intersecting(60) == 2);
+  REQUIRE(intersector.first_intersecting(61) == 3);
+
+  // Out of order lookups
+  REQUIRE(intersector.first_intersecting(35) == 1);
+  REQUIRE(intersector.first_intersecting(5) == 0);
+  REQUIRE(intersector.first_intersecting(1000) == 3);
+
+  intersector.reset_cursor();
+  REQUIRE(intersector.first_intersecting(45) == 2);
+}
+
+TEST_CASE("RegionIntersector: Overlapping regions", "[tiledbvcf][region]") {
+  // Regions [10,100], [20,30], [40,50], [60,200], [70,80]
+  RegionIntersector intersector({100, 30, 50, 200, 80});
+  REQUIRE(intersector.has_overlaps());
+
+  // The first region contains everything up to 100
+  REQUIRE(intersector.first_intersecting(25) == 0);
+  REQUIRE(intersector.first_intersecting(100) == 0);
+  REQUIRE(intersector.first_intersecting(101) == 3);
+  REQUIRE(intersector.first_intersecting(200) == 3);
+  REQUIRE(intersector.first_intersecting(201) == 5);
+  REQUIRE(intersector.first_intersecting(75) == 0);
+}
+
+TEST_CASE("RegionIntersector: Random lookups", "[tiledbvcf][region]") {
+  std::mt19937 gen(1234);
+  auto max_width = GENERATE(0u, 50u, 5000u);
+  auto region_ends = random_region_ends(2000, max_width, gen);
+  auto super_regions = build_super_regions(region_ends);
+  std::unordered_map<std::string, std::vector<SuperRegion>> super_region_map =
+      {{"1", super_regions}};
+
+  std::uniform_int_distribution<uint32_t> pos(0, region_ends.back() + 10);
+  std::vector<uint32_t> starts;
+  for (int i = 0; i < 5000; i++)
+    starts.push_back(pos(gen));
+
+  SECTION("- Unsorted") {
+  }
+
+  SECTION("- Sorted") {
+    std::sort(starts.begin(), starts.end());
+  }
+
+  RegionIntersector intersector(region_ends);
+  for (auto real_start : starts) {
+    size_t expected = first_intersecting_linear(region_ends, real_start);
+    REQUIRE(intersector.first_intersecting(real_start) == expected);
+
+    // The previous lookup may return an earlier region, but never one past
+    // the first intersecting region.
+    size_t legacy =
+        first_intersecting_legacy(super_region_map, "1", real_start);
+    if (expected == region_ends.size())
+      REQUIRE(legacy == SIZE_MAX);
+    else
+      REQUIRE(legacy <= expected);
+  }
+}
+
+TEST_CASE(
+    "RegionIntersector: Benchmark against super region lookup",
+    "[.][region][benchmark]") {
+  std::mt19937 gen(1234);
+  const size_t num_regions = 100000;
+  auto region_ends = random_region_ends(num_regions, 500, gen);
+  std::unordered_map<std::string, std::vector<SuperRegion>> super_region_map =
+      {{"1", build_super_regions(region_ends)}};
+
+  std::uniform_int_distribution<uint32_t> pos(0, region_ends.back());
+  std::vector<uint32_t> starts;
+  for (int i = 0; i < 1000; i++)
+    starts.push_back(pos(gen));
+  std::sort(starts.begin(), starts.end());
+
+  BENCHMARK("Super region lookup") {
+    size_t sum = 0;
+    for (auto real_start : starts)
+      sum += first_intersecting_legacy(super_region_map, "1", real_start);
+    return sum;
+  };
+
+  BENCHMARK("Binary search") {
+    size_t sum = 0;
+    for (auto real_start : starts)
+      sum += std::lower_bound(
+                 region_ends.begin(), region_ends.end(), real_start) -
+             region_ends.begin();
+    return sum;
+  };
+
+  RegionIntersector intersector(region_ends);
+  BENCHMARK("Sweep") {
+    size_t sum = 0;
+    intersector.reset_cursor();
+    for (auto real_start : starts)
+      sum += intersector.first_intersecting(real_start);
+    return sum;
+  };
+}
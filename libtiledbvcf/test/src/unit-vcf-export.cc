@@ -381,6 +381,26 @@ TEST_CASE("TileDB-VCF: Test export", "[tiledbvcf][export]") {
     REQUIRE(dtype == AttrDatatype::INT32);
     REQUIRE(var_len);
     REQUIRE(nullable);
+
+    // Dictionary-encoded attributes are reported as their indices.
+    REQUIRE_THROWS(reader.set_dictionary_encoding("pos_end", true));
+    reader.set_dictionary_encoding("sample_name", true);
+    reader.set_dictionary_encoding("alleles", true);
+    reader.attribute_datatype(
+        "sample_name", &dtype, &var_len, &nullable, &list);
+    REQUIRE(dtype == AttrDatatype::INT32);
+    REQUIRE(!var_len);
+    REQUIRE(!nullable);
+    REQUIRE(!list);
+    reader.attribute_datatype("alleles", &dtype, &var_len, &nullable, &list);
+    REQUIRE(dtype == AttrDatatype::INT32);
+    REQUIRE(var_len);
+    REQUIRE(!nullable);
+    REQUIRE(!list);
+    reader.set_dictionary_encoding("alleles", false);
+    reader.attribute_datatype("alleles", &dtype, &var_len, &nullable, &list);
+    REQUIRE(dtype == AttrDatatype::CHAR);
+    REQUIRE(list);
   }
 
   if (vfs.is_dir(dataset_uri))
@@ -745,6 +765,16 @@ TEST_CASE("TileDB-VCF: Test export to BCF", "[tiledbvcf][export]") {
     REQUIRE(reader.num_records_exported() == 7);
   }
 
+  // Each exported file has a header for its own sample
+  for (const std::string sample : {"HG00280", "HG01762"}) {
+    SafeBCFHdr hdr(
+        VCFUtils::hdr_read_header(output_dir + "/" + sample + ".bcf"),
+        bcf_hdr_destroy);
+    REQUIRE(hdr != nullptr);
+    REQUIRE(bcf_hdr_nsamples(hdr.get()) == 1);
+    REQUIRE(std::string(hdr->samples[0]) == sample);
+  }
+
   if (vfs.is_dir(dataset_uri))
     vfs.remove_dir(dataset_uri);
   if (vfs.is_dir(output_dir))
@@ -0,0 +1,125 @@
+/**
+ * @file   unit-vcf-header-cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Tests for VCFHeaderCache.
+ */
+
+#include "catch.hpp"
+
+#include "dataset/vcf_header_cache.h"
+
+using namespace tiledb::vcf;
+
+namespace {
+
+SharedBCFHdr new_header() {
+  return SharedBCFHdr(bcf_hdr_init("r"), bcf_hdr_destroy);
+}
+
+}  // namespace
+
+TEST_CASE("VCFHeaderCache: Disabled", "[tiledbvcf][header-cache]") {
+  VCFHeaderCache cache;
+  REQUIRE(!cache.enabled());
+
+  cache.put("s1", 1, new_header(), 100);
+  REQUIRE(cache.get("s1", 1) == nullptr);
+  REQUIRE(cache.stats().num_entries == 0);
+  REQUIRE(cache.stats().misses == 1);
+}
+
+TEST_CASE("VCFHeaderCache: Hits and misses", "[tiledbvcf][header-cache]") {
+  VCFHeaderCache cache(1024 * 1024);
+  REQUIRE(cache.enabled());
+
+  auto hdr = new_header();
+  cache.put("s1", 1, hdr, 100);
+  REQUIRE(cache.get("s1", 1) == hdr);
+  REQUIRE(cache.get("s2", 1) == nullptr);
+
+  // A header cached at another timestamp is dropped.
+  REQUIRE(cache.get("s1", 2) == nullptr);
+  REQUIRE(cache.get("s1", 1) == nullptr);
+
+  auto stats = cache.stats();
+  REQUIRE(stats.hits == 1);
+  REQUIRE(stats.misses == 3);
+  REQUIRE(stats.num_entries == 0);
+  REQUIRE(stats.size_bytes == 0);
+}
+
+TEST_CASE("VCFHeaderCache: Shared headers", "[tiledbvcf][header-cache]") {
+  VCFHeaderCache cache(1024 * 1024);
+
+  auto hdr = new_header();
+  cache.put("s1", 1, hdr, 1000);
+  uint64_t one_entry = cache.stats().size_bytes;
+  cache.put("s2", 1, hdr, 1000);
+
+  // The header text is charged once.
+  auto stats = cache.stats();
+  REQUIRE(stats.num_entries == 2);
+  REQUIRE(stats.size_bytes < 2 * one_entry);
+
+  cache.clear();
+  stats = cache.stats();
+  REQUIRE(stats.num_entries == 0);
+  REQUIRE(stats.size_bytes == 0);
+  REQUIRE(cache.get("s1", 1) == nullptr);
+}
+
+TEST_CASE("VCFHeaderCache: LRU eviction", "[tiledbvcf][header-cache]") {
+  VCFHeaderCache cache(4000);
+
+  cache.put("s1", 1, new_header(), 1000);
+  cache.put("s2", 1, new_header(), 1000);
+  cache.put("s3", 1, new_header(), 1000);
+  REQUIRE(cache.stats().evictions == 0);
+
+  // Touch s1 so that s2 is the least recently used.
+  REQUIRE(cache.get("s1", 1) != nullptr);
+  cache.put("s4", 1, new_header(), 1000);
+
+  auto stats = cache.stats();
+  REQUIRE(stats.evictions == 1);
+  REQUIRE(stats.num_entries == 3);
+  REQUIRE(stats.size_bytes <= 4000);
+  REQUIRE(cache.get("s2", 1) == nullptr);
+  REQUIRE(cache.get("s1", 1) != nullptr);
+  REQUIRE(cache.get("s4", 1) != nullptr);
+
+  // Shrinking the cap evicts down to it.
+  cache.set_max_bytes(1500);
+  REQUIRE(cache.stats().num_entries == 1);
+  REQUIRE(cache.get("s4", 1) != nullptr);
+
+  cache.set_max_bytes(0);
+  REQUIRE(!cache.enabled());
+  REQUIRE(cache.stats().num_entries == 0);
+}
@@ -187,6 +187,126 @@ TEST_CASE("TileDB-VCF: Test ingest", "[tiledbvcf][ingest]") {
     vfs.remove_dir(dataset_uri);
 }
 
+TEST_CASE("TileDB-VCF: Test sample directory", "[tiledbvcf][ingest]") {
+  tiledb::Context ctx;
+  tiledb::VFS vfs(ctx);
+
+  std::string dataset_uri = "test_dataset";
+  if (vfs.is_dir(dataset_uri))
+    vfs.remove_dir(dataset_uri);
+
+  CreationParams create_args;
+  create_args.uri = dataset_uri;
+  create_args.tile_capacity = 10000;
+  TileDBVCFDataset::create(create_args);
+
+  // Ingest in two batches, the second one re-ingesting a sample
+  std::vector<std::vector<std::string>> batches = {
+      {input_dir + "/small.bcf"},
+      {input_dir + "/small2.bcf", input_dir + "/small.bcf"}};
+  for (const auto& batch : batches) {
+    Writer writer;
+    IngestionParams params;
+    params.uri = dataset_uri;
+    params.sample_uris = batch;
+    writer.set_all_params(params);
+    writer.ingest_samples();
+  }
+
+  TileDBVCFDataset ds(std::make_shared<tiledb::Context>(ctx));
+  ds.open(dataset_uri);
+
+  std::vector<std::string> samples;
+  REQUIRE(ds.load_sample_directory(&samples));
+  REQUIRE(samples == std::vector<std::string>{"HG00280", "HG01762"});
+  REQUIRE(ds.get_all_samples_from_vcf_headers() == samples);
+  REQUIRE(ds.sample_names().size() == 2);
+  REQUIRE(ds.metadata().sample_ids.at("HG01762") == 1);
+
+  if (vfs.is_dir(dataset_uri))
+    vfs.remove_dir(dataset_uri);
+}
+
+TEST_CASE(
+    "TileDB-VCF: Test sample directory with several batches",
+    "[tiledbvcf][ingest]") {
+  tiledb::Context ctx;
+  tiledb::VFS vfs(ctx);
+
+  std::string dataset_uri = "test_dataset";
+  if (vfs.is_dir(dataset_uri))
+    vfs.remove_dir(dataset_uri);
+
+  CreationParams create_args;
+  create_args.uri = dataset_uri;
+  create_args.tile_capacity = 10000;
+  TileDBVCFDataset::create(create_args);
+
+  // Ingest one sample per batch
+  {
+    Writer writer;
+    IngestionParams params;
+    params.uri = dataset_uri;
+    params.sample_uris = {
+        input_dir + "/small.bcf",
+        input_dir + "/small2.bcf",
+        input_dir + "/overlapping.bcf",
+        input_dir + "/v2-DjrIAzkP-downsampled.vcf.gz"};
+    params.sample_batch_size = 1;
+    writer.set_all_params(params);
+    writer.ingest_samples();
+  }
+
+  const std::vector<std::string> expected = {
+      "HG00096", "HG00280", "HG01762", "v2-DjrIAzkP"};
+  std::vector<std::string> samples;
+  {
+    TileDBVCFDataset ds(std::make_shared<tiledb::Context>(ctx));
+    ds.open(dataset_uri);
+    REQUIRE(ds.load_sample_directory(&samples));
+    REQUIRE(samples == expected);
+    REQUIRE(ds.get_all_samples_from_vcf_headers() == samples);
+
+    // Consolidating the array metadata merges the directory items of all
+    // batches into a single metadata fragment
+    UtilsParams utils_params;
+    ds.consolidate_vcf_header_array_metadata(utils_params);
+    ds.vacuum_vcf_header_array_metadata(utils_params);
+    auto meta_uri = utils::uri_join(
+        TileDBVCFDataset::vcf_headers_uri(dataset_uri), "__meta");
+    REQUIRE(vfs.ls(meta_uri).size() == 1);
+    REQUIRE(ds.load_sample_directory(&samples));
+    REQUIRE(samples == expected);
+  }
+
+  // A header fragment without a directory item, as written by an older
+  // version or an interrupted ingestion, is found by scanning the array
+  {
+    tiledb::Array array(
+        ctx, TileDBVCFDataset::vcf_headers_uri(dataset_uri), TILEDB_WRITE);
+    tiledb::Query query(ctx, array);
+    std::string sample = "extra";
+    std::string header = "##fileformat=VCFv4.2\n";
+    std::vector<uint64_t> sample_offsets = {0}, header_offsets = {0};
+    query.set_layout(TILEDB_UNORDERED);
+    query.set_buffer("sample", sample_offsets, sample);
+    query.set_buffer("header", header_offsets, header);
+    REQUIRE(query.submit() == tiledb::Query::Status::COMPLETE);
+  }
+  {
+    TileDBVCFDataset ds(std::make_shared<tiledb::Context>(ctx));
+    ds.open(dataset_uri);
+    REQUIRE(!ds.load_sample_directory(&samples));
+    REQUIRE(
+        ds.get_all_samples_from_vcf_headers() ==
+        std::vector<std::string>{
+            "HG00096", "HG00280", "HG01762", "extra", "v2-DjrIAzkP"});
+  }
+
+  if (vfs.is_dir(dataset_uri))
+    vfs.remove_dir(dataset_uri);
+}
+
 TEST_CASE("TileDB-VCF: Test ingest annotation VCF", "[tiledbvcf][ingest]") {
   tiledb::Context ctx;
   tiledb::VFS vfs(ctx);